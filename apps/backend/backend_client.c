@@ -71,6 +71,10 @@
 #include "backend_handle.h"
 #include "backend_get.h"
 #include "backend_client.h"
+#include "backend_histogram.h"
+#include "backend_trace.h"
+#include "backend_notify.h"
+#include "backend_push.h"
 
 /*! Find client by session-id 
  *
@@ -130,7 +134,7 @@ ce_client_descr(struct client_entry *ce,
  *
  * @param[in]  h     Clixon handle
  * @param[in]  op    0:event, 1:rm
- * @param[in]  event Event as XML
+ * @param[in]  event Event as XML, or NULL if not parsed
  * @param[in]  arg   Extra argument provided in stream_ss_add
  * @retval     0     OK
  * @retval    -1     Error
@@ -142,9 +146,10 @@ ce_event_cb(clixon_handle h,
             cxobj        *event,
             void         *arg)
 {
-    int                  retval = -1;
-    struct client_entry *ce = (struct client_entry *)arg;
-    cbuf                *cbce = NULL;
+    int                    retval = -1;
+    struct client_entry   *ce = (struct client_entry *)arg;
+    stream_notification_t *sn;
+    stream_notification_t *snlocal = NULL;
 
     clixon_debug(CLIXON_DBG_BACKEND, "op:%d", op);
     switch (op){
@@ -154,22 +159,23 @@ ce_event_cb(clixon_handle h,
             backend_client_rm(h, ce);
         break;
     default:
-        if (ce_client_descr(ce, &cbce) < 0)
-            goto done;
-        if (send_msg_notify_xml(h, ce->ce_s, cbuf_get(cbce), event) < 0){
-            if (errno == ECONNRESET || errno == EPIPE){
-                clixon_log(h, LOG_WARNING, "client %d reset", ce->ce_nr);
-            }
-            break;
+        /* Framed message is serialized once and shared by all subscribers,
+         * except eg replay */
+        if ((sn = stream_notification_get(h, event)) == NULL){
+            if ((snlocal = stream_notification_new(event)) == NULL)
+                goto done;
+            sn = snlocal;
         }
-        /* note there may be other notifications than RFC5277 streams */
-        ce->ce_out_notifications++;
-        netconf_monitoring_counter_inc(h, "out-notifications");
+        /* Sent without blocking, or queued. Note there may be other notifications than RFC5277 streams */
+        if (backend_notify_enqueue(h, ce, sn, event) < 0)
+            goto done;
     }
     retval = 0;
  done:
-    if (cbce)
-        cbuf_free(cbce);
+    if (snlocal){
+        snlocal->sn_xml = NULL; /* Owned by caller */
+        stream_notification_free(snlocal);
+    }
     return retval;
 }
 
@@ -348,6 +354,9 @@ backend_client_rm(clixon_handle        h,
     clixon_debug(CLIXON_DBG_BACKEND, "");
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+    /* Drop queued notifications and writable socket callback */
+    backend_notify_free(ce);
+    backend_push_client_rm(ce);
     c0 = backend_client_list(h);
     ce_prev = &c0; /* this points to stack and is not real backpointer */
     for (c = *ce_prev; c; c = c->ce_next){
@@ -387,6 +396,10 @@ clixon_stats_datastore_get(clixon_handle h,
     size_t    sz = 0;
     cxobj    *xn = NULL;
     int       ret;
+#ifdef XML_EXPLICIT_INDEX
+    uint64_t  inr = 0;
+    uint64_t  ien = 0;
+#endif
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "%s", dbname);
     /* This is the db cache */
@@ -403,8 +416,16 @@ clixon_stats_datastore_get(clixon_handle h,
         if (xml_stats(xt, &nr, &sz) < 0)
             goto done;
         cprintf(cb, "<datastore><name>%s</name><nr>%" PRIu64 "</nr>"
-                "<size>%zu</size></datastore>",
+                "<size>%zu</size>",
                 dbname, nr, sz);
+#ifdef XML_EXPLICIT_INDEX
+        if (xml_search_index_stats(xt, &inr, &ien) < 0)
+            goto done;
+        cprintf(cb, "<indexes>%" PRIu64 "</indexes>"
+                "<index-entries>%" PRIu64 "</index-entries>",
+                inr, ien);
+#endif
+        cprintf(cb, "</datastore>");
     }
  ok:
     retval = 0;
@@ -519,6 +540,142 @@ do_lock(clixon_handle h,
     goto done;
 }
 
+/*! Write deferred candidate edits to file, see CLICON_XMLDB_EDIT_COALESCE
+ *
+ * Called as timeout callback when the backend has been idle, and directly before any
+ * other operation that may depend on the candidate file.
+ * @param[in]  fd    Dummy argument per the event callback semantics
+ * @param[in]  arg   Clixon handle
+ * @retval     0     OK
+ * @retval    -1    Error
+ * @see edit_coalesce_defer
+ */
+static int
+edit_coalesce_flush(int   fd,
+                    void *arg)
+{
+    int             retval = -1;
+    clixon_handle   h = (clixon_handle)arg;
+    cxobj          *xt;
+    struct timeval *t0 = NULL;
+
+    if (clicon_ptr_get(h, "edit-coalesce-time", (void**)&t0) == 0 && t0 != NULL){
+        clicon_ptr_del(h, "edit-coalesce-time");
+        free(t0);
+    }
+    if (clicon_data_int_get(h, "edit-coalesce") != 1)
+        goto ok;
+    clicon_data_int_del(h, "edit-coalesce");
+    if (xmldb_volatile_set(h, "candidate", 0) < 0)
+        goto done;
+    if ((xt = xmldb_cache_get(h, "candidate")) != NULL){
+        clixon_debug(CLIXON_DBG_DATASTORE, "Flush coalesced candidate edits");
+        if (xmldb_write_cache2file(h, "candidate") < 0)
+            goto done;
+        if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CACHE_DIRTY) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Defer writing candidate to file on edit-config, see CLICON_XMLDB_EDIT_COALESCE
+ *
+ * Mark candidate cache as volatile so that xmldb_put only modifies the cache, and
+ * schedule a flush. Timeouts only fire when no input is pending, so edits that arrive
+ * while the backend is busy are written to file in one step.
+ * Since the timeout does not fire under steady load, pending edits are also written here
+ * once the first of them is older than the coalesce interval.
+ * Only done if the candidate cache already exists and is not volatile for other reasons.
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+edit_coalesce_defer(clixon_handle h)
+{
+    int             retval = -1;
+    uint32_t        ms;
+    struct timeval  t;
+    struct timeval  t1;
+    struct timeval *t0 = NULL; /* time of first deferred edit */
+
+    if ((ms = clicon_option_int(h, "CLICON_XMLDB_EDIT_COALESCE")) == 0)
+        goto ok;
+    if (clicon_data_int_get(h, "edit-coalesce") == 1){
+        if (clicon_ptr_get(h, "edit-coalesce-time", (void**)&t0) < 0 || t0 == NULL)
+            goto ok;
+        gettimeofday(&t, NULL);
+        timersub(&t, t0, &t1);
+        if (t1.tv_sec*1000 + t1.tv_usec/1000 < ms)
+            goto ok;
+        /* Write pending edits and defer this edit anew */
+        clixon_event_unreg_timeout(edit_coalesce_flush, h);
+        if (edit_coalesce_flush(0, h) < 0)
+            goto done;
+    }
+    if (xmldb_cache_get(h, "candidate") == NULL ||
+        xmldb_volatile_get(h, "candidate") != 0)
+        goto ok;
+    if ((t0 = malloc(sizeof(*t0))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    gettimeofday(t0, NULL);
+    if (clicon_ptr_set(h, "edit-coalesce-time", t0) < 0){
+        free(t0);
+        goto done;
+    }
+    if (xmldb_volatile_set(h, "candidate", 1) < 0)
+        goto done;
+    if (clicon_data_int_set(h, "edit-coalesce", 1) < 0)
+        goto done;
+    t1.tv_sec = ms/1000;
+    t1.tv_usec = (ms%1000)*1000;
+    timeradd(t0, &t1, &t);
+    if (clixon_event_reg_timeout(t, edit_coalesce_flush, h, "edit-config coalesce") < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if rpc may be processed while candidate edits are deferred
+ *
+ * These operations only access the datastore cache, not the candidate file
+ * @param[in]  rpc   RPC name
+ * @retval     1     Yes, keep deferring
+ * @retval     0     No, write pending edits to file first
+ */
+static int
+edit_coalesce_rpc(char *rpc)
+{
+    return strcmp(rpc, "edit-config") == 0 ||
+        strcmp(rpc, "get-config") == 0 ||
+        strcmp(rpc, "get") == 0 ||
+        strcmp(rpc, "lock") == 0 ||
+        strcmp(rpc, "unlock") == 0 ||
+        strcmp(rpc, "close-session") == 0;
+}
+
+/*! Write deferred candidate edits to file now and cancel scheduled flush
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+backend_edit_coalesce_flush(clixon_handle h)
+{
+    if (clicon_data_int_get(h, "edit-coalesce") != 1)
+        return 0;
+    clixon_event_unreg_timeout(edit_coalesce_flush, h);
+    return edit_coalesce_flush(0, h);
+}
+
 /*! Loads all or part of a specified configuration to target configuration
  * 
  * @param[in]  h       Clixon handle 
@@ -563,6 +720,7 @@ from_client_edit_config(clixon_handle h,
     char               *val = NULL;
     cvec               *nsc = NULL;
     char               *prefix = NULL;
+    struct timeval      t0;
 
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -687,7 +845,14 @@ from_client_edit_config(clixon_handle h,
             goto done;
         goto ok;
     }
-    if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
+    /* Coalesce back-to-back candidate edits into one file write */
+    if (strcmp(target, "candidate") == 0 &&
+        edit_coalesce_defer(h) < 0)
+        goto done;
+    gettimeofday(&t0, NULL);
+    ret = xmldb_put(h, target, operation, xc, username, cbret);
+    backend_trace_phase(h, TRACE_DS_WRITE, &t0);
+    if (ret < 0){
         if (netconf_operation_failed(cbret, "protocol", clixon_err_reason())< 0)
             goto done;
         goto ok;
@@ -1193,6 +1358,7 @@ from_client_create_subscription(clixon_handle h,
     struct timeval       start;
     struct timeval       stop;
     cvec                *nsc = NULL;
+    struct stream_subscription *ss;
 
     /* XXX should use prefix cf edit_config */
     if ((nsc = xml_nsctx_init(NULL, EVENT_RFC5277_NAMESPACE)) == NULL)
@@ -1238,10 +1404,12 @@ from_client_create_subscription(clixon_handle h,
         goto ok;
     }
     /* Add subscriber to stream - to make notifications for this client */
-    if (stream_ss_add(h, stream, selector,
-                      starttime?&start:NULL, stoptime?&stop:NULL,
-                      ce_event_cb, (void*)ce) < 0)
+    if ((ss = stream_ss_add(h, stream, selector,
+                            starttime?&start:NULL, stoptime?&stop:NULL,
+                            ce_event_cb, (void*)ce)) == NULL)
         goto done;
+    /* Events are sent as text, XML is only needed to coalesce queued events */
+    ss->ss_text = backend_notify_text(h);
     /* Replay of this stream to specific subscription according to start and
      * stop (if present). 
      * RFC 5277: If <startTime> is not present, this is not a replay
@@ -1444,6 +1612,44 @@ from_client_ping(clixon_handle h,
     return 0;
 }
 
+/*! Get generation of a datastore
+ *
+ * The generation changes when the content of the datastore may have changed, which
+ * lets a client check if data it has read earlier is still valid without reading it again.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_generation_get
+ */
+static int
+from_client_datastore_generation(clixon_handle h,
+                                 cxobj        *xe,
+                                 cbuf         *cbret,
+                                 void         *arg,
+                                 void         *regarg)
+{
+    int   retval = -1;
+    char *db;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL){
+        if (netconf_missing_element(cbret, "protocol", "datastore", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<generation xmlns=\"%s\">%" PRIu64 "</generation>",
+            CLIXON_LIB_NS, xmldb_generation_get(h, db));
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Check liveness of backend daemon,  just send a reply
  *
  * @param[in]  h       Clixon handle
@@ -1475,6 +1681,9 @@ from_client_stats(clixon_handle h,
     int        inext;
     int        inext2;
     int        inext3;
+    int        i;
+    const char *pname;
+    uint64_t   hits;
 
     if ((str = xml_find_body(xe, "modules")) != NULL)
         modules = strcmp(str, "true") == 0;
@@ -1525,6 +1734,19 @@ from_client_stats(clixon_handle h,
         }
     }
     cprintf(cbret, "</module-sets>");
+    cprintf(cbret, "<timers xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (backend_histogram_cbuf(h, cbret) < 0)
+        goto done;
+    cprintf(cbret, "</timers>");
+    cprintf(cbret, "<xpath-optimize xmlns=\"%s\">", CLIXON_LIB_NS);
+    for (i=0; xpath_list_optimize_pattern(i, &pname, &hits) == 1; i++)
+        cprintf(cbret, "<pattern><name>%s</name><hits>%" PRIu64 "</hits></pattern>",
+                pname, hits);
+    cprintf(cbret, "</xpath-optimize>");
+    cprintf(cbret, "<notify-queues xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (backend_notify_stats(h, cbret) < 0)
+        goto done;
+    cprintf(cbret, "</notify-queues>");
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1533,6 +1755,47 @@ from_client_stats(clixon_handle h,
     return retval;
 }
 
+/*! Dump slowest of recent RPC traces
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see CLICON_BACKEND_TRACE_SIZE
+ */
+static int
+from_client_trace(clixon_handle h,
+                  cxobj        *xe,
+                  cbuf         *cbret,
+                  void         *arg,
+                  void         *regarg)
+{
+    int       retval = -1;
+    char     *str;
+    uint32_t  n = 10;
+    int       ret;
+
+    if ((str = xml_find_body(xe, "slowest")) != NULL){
+        if ((ret = netconf_parse_uint32("slowest", str, NULL, 0, cbret, &n)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<traces xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (backend_trace_cbuf(h, n, cbret) < 0)
+        goto done;
+    cprintf(cbret, "</traces>");
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Request restart of specific plugins
  *
  * @param[in]  h       Clixon handle
@@ -1697,8 +1960,12 @@ from_client_msg(clixon_handle        h,
     char                *namespace = NULL;
     int                  nr = 0;
     cbuf                *cbce = NULL;
+    struct timeval       t0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    if (backend_trace_begin(h, ce->ce_id, strlen(msg)) < 0)
+        goto done;
+    gettimeofday(&t0, NULL);
     yspec = clicon_dbspec_yang(h);
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
@@ -1738,6 +2005,7 @@ from_client_msg(clixon_handle        h,
     }
     rpcname = xml_name(x);
     rpcprefix = xml_prefix(x);
+    backend_trace_rpc(h, rpcname);
 #ifdef NOTACTIVE /* May need to re-activate */
     /* Sanity check:
      * op_id from internal message can be out-of-sync from client's sessions-id for the following reasons:
@@ -1815,6 +2083,7 @@ from_client_msg(clixon_handle        h,
         netconf_monitoring_counter_inc(h, "in-bad-rpcs");
         goto reply;
     }
+    backend_trace_phase(h, TRACE_PARSE, &t0);
     ce->ce_in_rpcs++; /* Track all RPCs */
     netconf_monitoring_counter_inc(h, "in-rpcs");
 
@@ -1838,6 +2107,8 @@ from_client_msg(clixon_handle        h,
         module = yang_argument_get(ymod);
         clixon_debug(CLIXON_DBG_BACKEND, "module:%s rpc:%s ce_id:%u s:%d", module,
                      rpc, ce->ce_id, ce->ce_s);
+        backend_trace_rpc(h, rpc);
+        gettimeofday(&t0, NULL);
         /* Pre-NACM access step */
         xnacm = NULL;
 
@@ -1873,6 +2144,11 @@ from_client_msg(clixon_handle        h,
                 goto reply;
             }
         }
+        backend_trace_phase(h, TRACE_NACM, &t0);
+        /* Other operations may read candidate from file */
+        if (!edit_coalesce_rpc(rpc) &&
+            backend_edit_coalesce_flush(h) < 0)
+            goto done;
         clixon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
             if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
@@ -1909,8 +2185,12 @@ from_client_msg(clixon_handle        h,
     // XXX    clixon_debug(CLIXON_DBG_MSG, "Reply:%s", cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
+    gettimeofday(&t0, NULL);
     if (ce_client_descr(ce, &cbce) < 0)
         goto done;
+    /* Send queued notifications before the reply, do not interleave them */
+    if (backend_notify_flush(h, ce) < 0)
+        goto done;
     if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
         switch (errno){
         case EPIPE:
@@ -1928,10 +2208,12 @@ from_client_msg(clixon_handle        h,
             goto done;
         }
     }
+    backend_trace_phase(h, TRACE_REPLY, &t0);
     // ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    backend_trace_end(h, cbret?cbuf_len(cbret):0);
     if (xnacm){
         xml_free(xnacm);
         if (clicon_nacm_cache_set(h, NULL) < 0)
@@ -2071,15 +2353,27 @@ backend_rpc_init(clixon_handle h)
     if (rpc_callback_register(h, from_client_ping, NULL,
                               CLIXON_LIB_NS, "ping") < 0)
         goto done;
+    if (rpc_callback_register(h, from_client_datastore_generation, NULL,
+                              CLIXON_LIB_NS, "datastore-generation") < 0)
+        goto done;
     if (rpc_callback_register(h, from_client_stats, NULL,
                               CLIXON_LIB_NS, "stats") < 0)
         goto done;
+    if (rpc_callback_register(h, from_client_trace, NULL,
+                              CLIXON_LIB_NS, "trace") < 0)
+        goto done;
     if (rpc_callback_register(h, from_client_restart_plugin, NULL,
                               CLIXON_LIB_NS, "restart-plugin") < 0)
         goto done;
     if (rpc_callback_register(h, from_client_process_control, NULL,
                               CLIXON_LIB_NS, "process-control") < 0)
         goto done;
+    if (rpc_callback_register(h, from_client_create_push_subscription, NULL,
+                              CLIXON_LIB_NS, "create-push-subscription") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_delete_push_subscription, NULL,
+                              CLIXON_LIB_NS, "delete-push-subscription") < 0)
+        goto done;
     retval =0;
  done:
     return retval;
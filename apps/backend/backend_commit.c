@@ -71,6 +71,9 @@
 #include "backend_handle.h"
 #include "clixon_backend_commit.h"
 #include "backend_client.h"
+#include "backend_histogram.h"
+#include "backend_trace.h"
+#include "backend_push.h"
 
 /*! Key values are checked for validity independent of user-defined callbacks
  *
@@ -546,9 +549,10 @@ validate_common(clixon_handle       h,
                 transaction_data_t *td,
                 cxobj             **xret)
 {
-    int         retval = -1;
-    yang_stmt  *yspec;
-    int         ret;
+    int            retval = -1;
+    yang_stmt     *yspec;
+    int            ret;
+    struct timeval t0;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
@@ -574,14 +578,17 @@ validate_common(clixon_handle       h,
         goto done;
     if (ret == 0)
         goto fail;
+    gettimeofday(&t0, NULL);
     if (compute_diffs(h, td) < 0)
         goto done;
+    backend_histogram_since(h, "phase/diff", &t0);
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
         goto done;
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
+    gettimeofday(&t0, NULL);
     if ((ret = generic_validate(h, yspec, td, xret)) < 0)
         goto done;
     if (ret == 0)
@@ -594,6 +601,7 @@ validate_common(clixon_handle       h,
     /* 7. Call plugin transaction complete callbacks */
     if (plugin_transaction_complete_all(h, td) < 0)
         goto done;
+    backend_histogram_since(h, "phase/validate", &t0);
     retval = 1;
  done:
     return retval;
@@ -698,8 +706,12 @@ candidate_commit(clixon_handle  h,
     int                 ret;
     cxobj              *xret = NULL;
     yang_stmt          *yspec;
+    struct timeval      t0;
+    struct timeval      t1;
+    cvec               *pushes = NULL;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "db: %s", db);
+    gettimeofday(&t0, NULL);
     /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
         goto done;
@@ -736,15 +748,26 @@ candidate_commit(clixon_handle  h,
         goto fail;
     }
     /* 7. Call plugin transaction commit callbacks */
+    gettimeofday(&t1, NULL);
     if (plugin_transaction_commit_all(h, td) < 0)
         goto done;
     /* After commit, make a post-commit call (sure that all plugins have committed) */
     if (plugin_transaction_commit_done_all(h, td) < 0)
         goto done;
+    backend_histogram_since(h, "phase/commit", &t1);
+    /* Changes of on-change datastore subscriptions, while source tree is valid.
+     * The plugins have committed, so failure here does not fail the commit */
+    if (backend_push_commit(h, td, &pushes) < 0){
+        clixon_log(h, LOG_WARNING, "%s: push-change-update: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+    }
     /* 8. Success: Copy candidate to running 
      */
+    gettimeofday(&t1, NULL);
     if (xmldb_copy(h, db, "running") < 0)
         goto done;
+    backend_trace_phase(h, TRACE_DS_WRITE, &t1);
+    backend_histogram_since(h, "phase/persist", &t1);
     /* Remove system-only-config data from destination cache */
     if (clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")){
         xmldb_clear(h, "running");
@@ -753,6 +776,11 @@ candidate_commit(clixon_handle  h,
 #endif
     }
     xmldb_modified_set(h, db, 0); /* reset dirty bit */
+    /* Running is written, send changes to on-change datastore subscriptions */
+    if (pushes && backend_push_commit_send(h, pushes) < 0){
+        clixon_log(h, LOG_WARNING, "%s: push-change-update: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+    }
     /* Here pointers to old (source) tree are obsolete */
     if (td->td_dvec){
         td->td_dlen = 0;
@@ -765,6 +793,7 @@ candidate_commit(clixon_handle  h,
     }
     /* 9. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
+    backend_histogram_since(h, "phase/total", &t0);
     retval = 1;
  done:
     /* In case of failure (or error), call plugin transaction termination callbacks */
@@ -775,6 +804,8 @@ candidate_commit(clixon_handle  h,
     }
     if (xret)
         xml_free(xret);
+    if (pushes)
+        cvec_free(pushes);
     return retval;
  fail:
     retval = 0;
@@ -1073,6 +1104,9 @@ from_client_restart_one(clixon_handle    h,
     /* Call commit callback in this plugin */
     if (plugin_transaction_commit_one(cp, h, td) < 0)
         goto fail;
+    /* Wait for asynchronous commit of this plugin */
+    if (plugin_transaction_commit_wait_one(cp, h, td) < 0)
+        goto fail;
     if (plugin_transaction_commit_done_one(cp, h, td) < 0)
         goto fail;
     /* Finalize */
@@ -71,6 +71,7 @@
 #include "backend_client.h"
 #include "backend_handle.h"
 #include "backend_get.h"
+#include "backend_trace.h"
 
 /*! Restconf get capabilities
  *
@@ -380,6 +381,44 @@ filter_xpath_again(clixon_handle h,
     return retval;
 }
 
+/*! Remove nodes not output with the given with-defaults mode
+ *
+ * Subtree filtering is made as if with-defaults had been applied, so that content
+ * match nodes only match data that is part of the reply.
+ * @param[in]  x     XML tree
+ * @param[in]  wdef  With-defaults parameter
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml2output_wdef
+ */
+static int
+get_wdef_prune(cxobj            *x,
+               withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *xc;
+    cxobj *xprev;
+    int    ret;
+
+    xprev = xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if ((ret = xml2output_wdef(xc, wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            if (xml_purge(xc) < 0)
+                goto done;
+            xc = xprev;
+            continue;
+        }
+        if (get_wdef_prune(xc, wdef) < 0)
+            goto done;
+        xprev = xc;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Help function for NACM access and return message
  *
  * @param[in]  h        Clixon handle
@@ -391,6 +430,7 @@ filter_xpath_again(clixon_handle h,
  * @param[in]  username User name for NACM access
  * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
  * @param[in]  wdef     With-defaults parameter
+ * @param[in]  xfilter  Subtree filter applied after NACM, or NULL
  * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
  * @retval     0        OK
  * @retval    -1        Error
@@ -405,6 +445,7 @@ get_nacm_and_reply(clixon_handle        h,
                    char                *username,
                    int32_t              depth,
                    withdefaults_type    wdef,
+                   cxobj               *xfilter,
                    cbuf                *cbret)
 {
     int     retval = -1;
@@ -417,6 +458,14 @@ get_nacm_and_reply(clixon_handle        h,
         if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0)
             goto done;
     }
+    /* Subtree filter on what is left after NACM, as if applied to the reply */
+    if (xfilter != NULL && xret != NULL){
+        if (wdef != WITHDEFAULTS_REPORT_ALL && wdef != WITHDEFAULTS_REPORT_ALL_TAGGED)
+            if (get_wdef_prune(xret, wdef) < 0)
+                goto done;
+        if (xml_filter(xfilter, xret) < 0)
+            goto done;
+    }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
         cprintf(cbret, "<data/>");
@@ -605,6 +654,7 @@ get_pagination_state_partial(clixon_handle        h,
  * @param[in]  nsc     Namespace context of xpath
  * @param[in]  username
  * @param[in]  wdef    With-defaults parameter, see RFC 6243
+ * @param[in]  xfilter Subtree filter applied to the page, or NULL
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
  * @retval     0       OK
  * @retval    -1       Error
@@ -631,6 +681,7 @@ get_list_pagination(clixon_handle        h,
                     cvec                *nsc,
                     char                *username,
                     withdefaults_type    wdef,
+                    cxobj               *xfilter,
                     cbuf                *cbret
                     )
 {
@@ -905,7 +956,7 @@ get_list_pagination(clixon_handle        h,
             cbuf_free(cba);
     }
 #endif /* LIST_PAGINATION_REMAINING */
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, xfilter, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -947,6 +998,8 @@ get_common(clixon_handle        h,
 {
     int               retval = -1;
     cxobj            *xfilter;
+    cxobj            *xsubtree = NULL; /* Subtree filter */
+    char             *ftype;
     char             *xpath = NULL;
     cxobj            *xret = NULL;
     char             *username;
@@ -968,6 +1021,7 @@ get_common(clixon_handle        h,
     cxobj            *xlpg2 = NULL;
     withdefaults_type wdef;
     char             *wdefstr;
+    struct timeval    t0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     wdef = WITHDEFAULTS_EXPLICIT;
@@ -976,7 +1030,15 @@ get_common(clixon_handle        h,
         clixon_err(OE_YANG, ENOENT, "No yang spec9");
         goto done;
     }
-    if ((xfilter = xml_find(xe, "filter")) != NULL){
+    if ((xfilter = xml_find(xe, "filter")) != NULL &&
+        ((ftype = xml_find_value(xfilter, "type")) == NULL || strcmp(ftype, "subtree") == 0) &&
+        xml_find_value(xfilter, "select") == NULL){
+        /* Subtree filter: read a superset selected by xpath, then filter the result */
+        if (xml_filter2xpath(xfilter, yspec, &xpath, &nsc) < 0)
+            goto done;
+        xsubtree = xfilter;
+    }
+    else if (xfilter != NULL){
         if ((xpath0 = xml_find_value(xfilter, "select"))==NULL)
             xpath0 = "/";
         if (xml_chardata_decode(&xpath01, "%s", xpath0) < 0)
@@ -1027,12 +1089,13 @@ get_common(clixon_handle        h,
                                     xlpg,
                                     content, db,
                                     depth, yspec, xpath, nsc, username, wdef,
-                                    cbret) < 0)
+                                    xsubtree, cbret) < 0)
                 goto done;
             goto ok;
         }
     }
     /* Read configuration */
+    gettimeofday(&t0, NULL);
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
         /* specific xpath. with-default gets masked in get_nacm_and_reply */
@@ -1095,6 +1158,7 @@ get_common(clixon_handle        h,
             goto done;
         break;
     }/* switch content */
+    backend_trace_phase(h, TRACE_DS_READ, &t0);
     /* If not only config,
      * get state data from plugins as defined by plugin_statedata(), if any
      */
@@ -1104,7 +1168,10 @@ get_common(clixon_handle        h,
         break;
     case CONTENT_ALL:       /* both config and state */
     case CONTENT_NONCONFIG: /* state data only */
-        if ((ret = get_state_data(h, xpath?xpath:"/", nsc, &xret)) < 0)
+        gettimeofday(&t0, NULL);
+        ret = get_state_data(h, xpath?xpath:"/", nsc, &xret);
+        backend_trace_phase(h, TRACE_STATE, &t0);
+        if (ret < 0)
             goto done;
         if (ret == 0){ /* Error from callback (error in xret) */
             if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
@@ -1158,7 +1225,7 @@ get_common(clixon_handle        h,
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, xsubtree, cbret) < 0)
         goto done;
  ok:
     retval = 0;
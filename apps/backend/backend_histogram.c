@@ -0,0 +1,305 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Latency histograms for commit phases and plugin transaction callbacks
+ * Log-linear buckets in the style of HDR histograms: each power of two of microseconds
+ * is split in HISTOGRAM_SUB linear sub-buckets, giving a fixed relative precision.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "backend_histogram.h"
+
+/* Linear sub-buckets per power of two, 4 gives 25% precision */
+#define HISTOGRAM_SUB     4
+
+/* Number of buckets to cover all uint64 values */
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB*64)
+
+/* Handle data key of histogram list */
+#define HISTOGRAM_KEY     "backend-histograms"
+
+/*! Latency histogram of one named measurement point
+ */
+struct histogram {
+    qelem_t     hg_qelem;    /* List header */
+    char       *hg_name;     /* Name, eg phase/diff or plugin/<name>/<callback> */
+    uint64_t    hg_count;    /* Number of samples */
+    uint64_t    hg_sum;      /* Sum of samples in us */
+    uint64_t    hg_min;      /* Min sample in us */
+    uint64_t    hg_max;      /* Max sample in us */
+    uint64_t    hg_buckets[HISTOGRAM_BUCKETS];
+};
+typedef struct histogram histogram;
+
+/*! Map a value to its bucket
+ *
+ * Values below HISTOGRAM_SUB have one bucket each. Above that, bucket is given by the
+ * highest bit set and the HISTOGRAM_SUB bits below it.
+ * @param[in]  v   Value
+ * @retval     i   Bucket index
+ */
+static int
+histogram_index(uint64_t v)
+{
+    int k = 0;
+
+    if (v < HISTOGRAM_SUB)
+        return v;
+    while (v >> (k+1))
+        k++;
+    return (k-1)*HISTOGRAM_SUB + ((v >> (k-2)) & (HISTOGRAM_SUB-1));
+}
+
+/*! Lowest value of a bucket
+ *
+ * @param[in]  i   Bucket index
+ * @retval     v   Lowest value mapping to bucket i
+ * @see histogram_index  the inverse
+ */
+static uint64_t
+histogram_lowest(int i)
+{
+    int k;
+
+    if (i < HISTOGRAM_SUB)
+        return i;
+    k = i/HISTOGRAM_SUB + 1;
+    return (uint64_t)(HISTOGRAM_SUB + i%HISTOGRAM_SUB) << (k-2);
+}
+
+/*! Highest value of a bucket
+ *
+ * @param[in]  i   Bucket index
+ * @retval     v   Highest value mapping to bucket i
+ */
+static uint64_t
+histogram_highest(int i)
+{
+    if (i >= HISTOGRAM_BUCKETS-1)
+        return UINT64_MAX;
+    return histogram_lowest(i+1) - 1;
+}
+
+/*! Value at percentile, as highest value of the bucket where it is reached
+ *
+ * @param[in]  hg  Histogram
+ * @param[in]  p   Percentile 0-100
+ * @retval     v   Value, never larger than max sample
+ */
+static uint64_t
+histogram_percentile(histogram *hg,
+                     int        p)
+{
+    uint64_t target;
+    uint64_t n = 0;
+    uint64_t v;
+    int      i;
+
+    if (hg->hg_count == 0)
+        return 0;
+    target = (hg->hg_count*p + 99)/100;
+    for (i=0; i<HISTOGRAM_BUCKETS; i++){
+        n += hg->hg_buckets[i];
+        if (n >= target)
+            break;
+    }
+    if (i == HISTOGRAM_BUCKETS)
+        return hg->hg_max;
+    v = histogram_highest(i);
+    return v < hg->hg_max ? v : hg->hg_max;
+}
+
+/*! Add a sample to a named histogram, create it if it does not exist
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Name of measurement point
+ * @param[in]  us    Sample in microseconds
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+backend_histogram_add(clixon_handle h,
+                      const char   *name,
+                      uint64_t      us)
+{
+    int        retval = -1;
+    histogram *hlist = NULL;
+    histogram *hg;
+
+    if (clicon_ptr_get(h, HISTOGRAM_KEY, (void**)&hlist) < 0)
+        hlist = NULL;
+    if ((hg = hlist) != NULL){
+        do {
+            if (strcmp(hg->hg_name, name) == 0)
+                goto found;
+            hg = NEXTQ(histogram *, hg);
+        } while (hg && hg != hlist);
+    }
+    if ((hg = malloc(sizeof(*hg))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(hg, 0, sizeof(*hg));
+    if ((hg->hg_name = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(hg);
+        goto done;
+    }
+    hg->hg_min = UINT64_MAX;
+    ADDQ(hg, hlist);
+    if (clicon_ptr_set(h, HISTOGRAM_KEY, hlist) < 0)
+        goto done;
+ found:
+    hg->hg_count++;
+    hg->hg_sum += us;
+    if (us < hg->hg_min)
+        hg->hg_min = us;
+    if (us > hg->hg_max)
+        hg->hg_max = us;
+    hg->hg_buckets[histogram_index(us)]++;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add time elapsed since t0 to a named histogram
+ *
+ * Statistics only: never fails, an error is logged and reset
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Name of measurement point
+ * @param[in]  t0    Start time
+ * @code
+ *   struct timeval t0;
+ *   gettimeofday(&t0, NULL);
+ *   ...
+ *   backend_histogram_since(h, "phase/diff", &t0);
+ * @endcode
+ */
+void
+backend_histogram_since(clixon_handle   h,
+                        const char     *name,
+                        struct timeval *t0)
+{
+    struct timeval t1;
+    struct timeval td;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &td);
+    if (td.tv_sec < 0) /* Clock moved backwards */
+        return;
+    if (backend_histogram_add(h, name, (uint64_t)td.tv_sec*1000000 + td.tv_usec) < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s: %s", __FUNCTION__, name, clixon_err_reason());
+        clixon_err_reset();
+    }
+}
+
+/*! Print all histograms as XML according to the clixon-lib stats rpc
+ *
+ * @param[in]     h    Clixon handle
+ * @param[in,out] cb   CLIgen buffer
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+int
+backend_histogram_cbuf(clixon_handle h,
+                       cbuf         *cb)
+{
+    histogram *hlist = NULL;
+    histogram *hg;
+    int        i;
+
+    if (clicon_ptr_get(h, HISTOGRAM_KEY, (void**)&hlist) < 0)
+        hlist = NULL;
+    if ((hg = hlist) == NULL)
+        return 0;
+    do {
+        cprintf(cb, "<timer><name>%s</name>", hg->hg_name);
+        cprintf(cb, "<count>%" PRIu64 "</count>", hg->hg_count);
+        cprintf(cb, "<sum>%" PRIu64 "</sum>", hg->hg_sum);
+        cprintf(cb, "<min>%" PRIu64 "</min>", hg->hg_count?hg->hg_min:0);
+        cprintf(cb, "<max>%" PRIu64 "</max>", hg->hg_max);
+        cprintf(cb, "<p50>%" PRIu64 "</p50>", histogram_percentile(hg, 50));
+        cprintf(cb, "<p90>%" PRIu64 "</p90>", histogram_percentile(hg, 90));
+        cprintf(cb, "<p99>%" PRIu64 "</p99>", histogram_percentile(hg, 99));
+        for (i=0; i<HISTOGRAM_BUCKETS; i++){
+            if (hg->hg_buckets[i] == 0)
+                continue;
+            cprintf(cb, "<bucket><le>%" PRIu64 "</le><count>%" PRIu64 "</count></bucket>",
+                    histogram_highest(i), hg->hg_buckets[i]);
+        }
+        cprintf(cb, "</timer>");
+        hg = NEXTQ(histogram *, hg);
+    } while (hg && hg != hlist);
+    return 0;
+}
+
+/*! Free all histograms
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ */
+int
+backend_histogram_free(clixon_handle h)
+{
+    histogram *hlist = NULL;
+    histogram *hg;
+
+    if (clicon_ptr_get(h, HISTOGRAM_KEY, (void**)&hlist) < 0)
+        return 0;
+    while ((hg = hlist) != NULL){
+        DELQ(hg, hlist, histogram *);
+        if (hg->hg_name)
+            free(hg->hg_name);
+        free(hg);
+    }
+    clicon_ptr_del(h, HISTOGRAM_KEY);
+    return 0;
+}
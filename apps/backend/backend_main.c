@@ -72,6 +72,8 @@
 #include "backend_socket.h"
 #include "clixon_backend_client.h"
 #include "backend_client.h"
+#include "backend_histogram.h"
+#include "backend_trace.h"
 #include "clixon_backend_plugin.h"
 #include "clixon_backend_commit.h"
 #include "backend_handle.h"
@@ -102,6 +104,8 @@ backend_terminate(clixon_handle h)
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((ss = clicon_socket_get(h)) != -1)
         close(ss);
+    /* Write deferred candidate edits before disconnecting datastore */
+    backend_edit_coalesce_flush(h);
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -129,6 +133,8 @@ backend_terminate(clixon_handle h)
 
     xpath_optimize_exit();
     clixon_pagination_free(h);
+    backend_histogram_free(h);
+    backend_trace_free(h);
     
     if (pidfile)
         unlink(pidfile);   
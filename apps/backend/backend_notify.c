@@ -0,0 +1,450 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Per-client queues of outgoing notifications
+ * A notification is sent with a non-blocking write. What cannot be written
+ * is queued and sent when the client socket becomes writable, so that a slow
+ * subscriber does not block the backend. The queue is bounded by
+ * CLICON_STREAM_QUEUE_SIZE, on overflow CLICON_STREAM_QUEUE_POLICY applies.
+ * Queue entries share the framed message of the notification, see stream_notification_msg.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_client.h"
+#include "backend_handle.h"
+#include "backend_notify.h"
+
+/*! Queued outgoing notification of a client
+ */
+struct backend_notify{
+    qelem_t                bn_q;    /* queue header */
+    stream_notification_t *bn_sn;   /* Notification, holds framed message */
+    char                  *bn_type; /* Event type as <namespace>:<name>, for coalesce */
+};
+
+/*! Queue overflow policy, see CLICON_STREAM_QUEUE_POLICY
+ */
+enum notify_policy{
+    NOTIFY_DROP_OLDEST, /* Drop oldest queued notification */
+    NOTIFY_DISCONNECT,  /* Disconnect client */
+    NOTIFY_COALESCE,    /* Drop oldest queued notification of same event type */
+};
+
+static const map_str2int notify_policy_map[] = {
+    {"drop-oldest", NOTIFY_DROP_OLDEST},
+    {"disconnect",  NOTIFY_DISCONNECT},
+    {"coalesce",    NOTIFY_COALESCE},
+    {NULL,          -1}
+};
+
+static int backend_notify_send(clixon_handle h, struct client_entry *ce);
+
+/*! Free queue entry
+ */
+static int
+notify_entry_free(struct backend_notify *bn)
+{
+    if (bn->bn_sn)
+        stream_notification_free(bn->bn_sn);
+    if (bn->bn_type)
+        free(bn->bn_type);
+    free(bn);
+    return 0;
+}
+
+/*! Remove entry from client queue and free it
+ */
+static int
+notify_entry_rm(struct client_entry   *ce,
+                struct backend_notify *bn)
+{
+    DELQ(bn, ce->ce_notify_q, struct backend_notify *);
+    ce->ce_notify_len--;
+    return notify_entry_free(bn);
+}
+
+/*! Get event type of notification as <namespace>:<name> of the event element
+ *
+ * @param[in]  xev   Notification
+ * @param[out] type  Event type, malloced, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+notify_event_type(cxobj *xev,
+                  char **type)
+{
+    int    retval = -1;
+    cxobj *x = NULL;
+    char  *ns = NULL;
+    size_t len;
+
+    while ((x = xml_child_each(xev, x, CX_ELMNT)) != NULL)
+        if (strcmp(xml_name(x), "eventTime") != 0)
+            break;
+    if (x == NULL)
+        goto ok;
+    if (xml2ns(x, xml_prefix(x), &ns) < 0)
+        goto done;
+    len = (ns?strlen(ns):0) + strlen(xml_name(x)) + 2;
+    if ((*type = malloc(len)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    snprintf(*type, len, "%s:%s", ns?ns:"", xml_name(x));
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Register or unregister for writable client socket depending on queue
+ */
+static int
+notify_wait(struct client_entry *ce);
+
+/*! Client socket writable callback, send queued notifications
+ *
+ * @param[in]  s    Client socket
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+notify_writable(int   s,
+                void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    return backend_notify_send(ce->ce_handle, ce);
+}
+
+static int
+notify_wait(struct client_entry *ce)
+{
+    if (ce->ce_notify_q != NULL && ce->ce_notify_wait == 0){
+        if (clixon_event_reg_fd_write(ce->ce_s, notify_writable, ce, "client notify") < 0)
+            return -1;
+        ce->ce_notify_wait = 1;
+    }
+    else if (ce->ce_notify_q == NULL && ce->ce_notify_wait){
+        clixon_event_unreg_fd(ce->ce_s, notify_writable);
+        ce->ce_notify_wait = 0;
+    }
+    return 0;
+}
+
+/*! First notification in queue has been completely sent
+ */
+static int
+notify_sent(clixon_handle        h,
+            struct client_entry *ce)
+{
+    ce->ce_notify_off = 0;
+    ce->ce_out_notifications++;
+    netconf_monitoring_counter_inc(h, "out-notifications");
+    return notify_entry_rm(ce, ce->ce_notify_q);
+}
+
+/*! Write error on client socket, drop queue
+ *
+ * The client is removed when its socket is closed, see from_client
+ */
+static int
+notify_write_err(clixon_handle        h,
+                 struct client_entry *ce)
+{
+    if (errno == ECONNRESET || errno == EPIPE)
+        clixon_log(h, LOG_WARNING, "client %d reset", ce->ce_nr);
+    else
+        clixon_log(h, LOG_WARNING, "client %d notification write: %s", ce->ce_nr, strerror(errno));
+    ce->ce_notify_closed = 1;
+    return backend_notify_free(ce);
+}
+
+/*! Send queued notifications to client without blocking
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  ce  Client entry
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+backend_notify_send(clixon_handle        h,
+                    struct client_entry *ce)
+{
+    int                    retval = -1;
+    struct backend_notify *bn;
+    cbuf                  *msg;
+    ssize_t                n;
+
+    while ((bn = ce->ce_notify_q) != NULL){
+        msg = bn->bn_sn->sn_msg;
+        if ((n = send(ce->ce_s, cbuf_get(msg) + ce->ce_notify_off,
+                      cbuf_len(msg) - ce->ce_notify_off, MSG_DONTWAIT)) < 0){
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+            if (notify_write_err(h, ce) < 0)
+                goto done;
+            goto ok;
+        }
+        ce->ce_notify_off += n;
+        if (ce->ce_notify_off < cbuf_len(msg))
+            break; /* Partial write, wait for writable */
+        clixon_debug(CLIXON_DBG_MSG, "Send notification [%d] len: %lu", ce->ce_nr, cbuf_len(msg));
+        if (notify_sent(h, ce) < 0)
+            goto done;
+    }
+    if (notify_wait(ce) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Queue notification to client and send as much as possible without blocking
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  sn   Notification, a reference is kept while queued
+ * @param[in]  xev  Notification as XML, or NULL if only serialized
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_STREAM_QUEUE_SIZE
+ * @see CLICON_STREAM_QUEUE_POLICY
+ */
+int
+backend_notify_enqueue(clixon_handle          h,
+                       struct client_entry   *ce,
+                       stream_notification_t *sn,
+                       cxobj                 *xev)
+{
+    int                    retval = -1;
+    struct backend_notify *bn = NULL;
+    struct backend_notify *bo;
+    uint32_t               size;
+    int                    policy;
+
+    if (ce->ce_s == 0 || ce->ce_notify_closed)
+        goto ok;
+    size = clicon_option_int(h, "CLICON_STREAM_QUEUE_SIZE");
+    if ((policy = clicon_str2int(notify_policy_map,
+                                 clicon_option_str(h, "CLICON_STREAM_QUEUE_POLICY"))) < 0)
+        policy = NOTIFY_DROP_OLDEST;
+    /* Serialize while XML is valid */
+    if (stream_notification_msg(sn) == NULL)
+        goto done;
+    if ((bn = malloc(sizeof(*bn))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(bn, 0, sizeof(*bn));
+    stream_notification_hold(sn);
+    bn->bn_sn = sn;
+    if (policy == NOTIFY_COALESCE && xev != NULL &&
+        notify_event_type(xev, &bn->bn_type) < 0)
+        goto done;
+    if (size > 0 && ce->ce_notify_len >= size){
+        ce->ce_notify_drops++;
+        /* Oldest entry that is not partially sent */
+        if ((bo = ce->ce_notify_q) != NULL && ce->ce_notify_off > 0)
+            if ((bo = NEXTQ(struct backend_notify *, bo)) == ce->ce_notify_q)
+                bo = NULL;
+        switch (policy){
+        case NOTIFY_DISCONNECT:
+            clixon_log(h, LOG_WARNING, "client %d notification queue full, disconnecting", ce->ce_nr);
+            /* Client is removed on EOF, see from_client */
+            shutdown(ce->ce_s, SHUT_RDWR);
+            ce->ce_notify_closed = 1;
+            if (backend_notify_free(ce) < 0)
+                goto done;
+            goto ok;
+            break;
+        case NOTIFY_COALESCE:
+            while (bo != NULL){
+                if (bo->bn_type && bn->bn_type && strcmp(bo->bn_type, bn->bn_type) == 0)
+                    break;
+                if ((bo = NEXTQ(struct backend_notify *, bo)) == ce->ce_notify_q)
+                    bo = NULL;
+            }
+            if (bo == NULL && (bo = ce->ce_notify_q) != NULL && ce->ce_notify_off > 0)
+                if ((bo = NEXTQ(struct backend_notify *, bo)) == ce->ce_notify_q)
+                    bo = NULL;
+            break;
+        default:
+            break;
+        }
+        if (bo == NULL) /* Only a partially sent notification: drop new */
+            goto ok;
+        if (notify_entry_rm(ce, bo) < 0)
+            goto done;
+    }
+    ADDQ(bn, ce->ce_notify_q);
+    bn = NULL;
+    if (++ce->ce_notify_len > ce->ce_notify_max)
+        ce->ce_notify_max = ce->ce_notify_len;
+    /* If waiting for writable, the queue is sent from the event loop */
+    if (ce->ce_notify_wait == 0)
+        if (backend_notify_send(h, ce) < 0)
+            goto done;
+ ok:
+    retval = 0;
+ done:
+    if (bn)
+        notify_entry_free(bn);
+    return retval;
+}
+
+/*! Send all queued notifications, blocking
+ *
+ * Must be called before anything else is written on the client socket, such as
+ * an RPC reply, to not interleave messages, and so that notifications queued
+ * before the reply, eg push-change-update of a commit, are received before it.
+ * The client reads the reply on the same socket, the blocking writes are as the
+ * write of the reply.
+ * @param[in]  h   Clixon handle
+ * @param[in]  ce  Client entry
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_notify_flush(clixon_handle        h,
+                     struct client_entry *ce)
+{
+    int                    retval = -1;
+    struct backend_notify *bn;
+    cbuf                  *msg;
+    ssize_t                n;
+
+    while ((bn = ce->ce_notify_q) != NULL){
+        msg = bn->bn_sn->sn_msg;
+        while (ce->ce_notify_off < cbuf_len(msg)){
+            if ((n = write(ce->ce_s, cbuf_get(msg) + ce->ce_notify_off,
+                           cbuf_len(msg) - ce->ce_notify_off)) < 0){
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+                if (notify_write_err(h, ce) < 0)
+                    goto done;
+                goto ok;
+            }
+            ce->ce_notify_off += n;
+        }
+        clixon_debug(CLIXON_DBG_MSG, "Send notification [%d] len: %lu", ce->ce_nr, cbuf_len(msg));
+        if (notify_sent(h, ce) < 0)
+            goto done;
+    }
+    if (notify_wait(ce) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free notification queue of client
+ *
+ * @param[in]  ce  Client entry
+ * @retval     0   OK
+ */
+int
+backend_notify_free(struct client_entry *ce)
+{
+    while (ce->ce_notify_q != NULL)
+        notify_entry_rm(ce, ce->ce_notify_q);
+    ce->ce_notify_off = 0;
+    return notify_wait(ce);
+}
+
+/*! Check if notifications may be queued as serialized events only
+ *
+ * The coalesce policy needs the event type from the XML of the event
+ * @param[in]  h    Clixon handle
+ * @retval     1    Yes, XML of event is not needed
+ * @retval     0    No
+ * @see stream_subscription.ss_text
+ */
+int
+backend_notify_text(clixon_handle h)
+{
+    return clicon_str2int(notify_policy_map,
+                          clicon_option_str(h, "CLICON_STREAM_QUEUE_POLICY")) != NOTIFY_COALESCE;
+}
+
+/*! Get notification queue stats of clients
+ *
+ * @param[in]     h   Clixon handle
+ * @param[in,out] cb  Stats as XML
+ * @retval        0   OK
+ */
+int
+backend_notify_stats(clixon_handle h,
+                     cbuf         *cb)
+{
+    struct client_entry *ce;
+
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+        if (ce->ce_out_notifications == 0 &&
+            ce->ce_notify_len == 0 &&
+            ce->ce_notify_drops == 0)
+            continue;
+        cprintf(cb, "<session>");
+        cprintf(cb, "<session-id>%u</session-id>", ce->ce_id);
+        cprintf(cb, "<depth>%u</depth>", ce->ce_notify_len);
+        cprintf(cb, "<max-depth>%u</max-depth>", ce->ce_notify_max);
+        cprintf(cb, "<sent>%u</sent>", ce->ce_out_notifications);
+        cprintf(cb, "<drops>%u</drops>", ce->ce_notify_drops);
+        cprintf(cb, "</session>");
+    }
+    return 0;
+}
@@ -51,6 +51,7 @@
 #include <syslog.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 
@@ -63,6 +64,7 @@
 #include "clixon_backend_transaction.h"
 #include "clixon_backend_plugin.h"
 #include "clixon_backend_commit.h"
+#include "backend_histogram.h"
 
 /*! Request plugins to reset system state
  *
@@ -593,6 +595,19 @@ transaction_free1(transaction_data_t *td,
     return 0;
 }
 
+/*! Call a plugin transaction callback and record its latency
+ *
+ * Latency is recorded in histogram plugin/<plugin>/<callback>, where callback is fnname
+ * without plugin_transaction_ prefix and _one suffix, eg plugin/example/commit
+ * Only successful callbacks are recorded, and a recording failure is only logged
+ * @param[in]  h       Clixon handle
+ * @param[in]  cp      Plugin handle
+ * @param[in]  fn      Transaction callback
+ * @param[in]  fnname  Name of calling function
+ * @param[in]  td      Transaction data
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
 static int
 plugin_transaction_call_one(clixon_handle       h,
 			    clixon_plugin_t    *cp,
@@ -600,13 +615,19 @@ plugin_transaction_call_one(clixon_handle       h,
 			    const char         *fnname,
 			    transaction_data_t *td)
 {
-    int  retval = -1;
-    int  rv;
-    void *wh = NULL;
+    int            retval = -1;
+    int            rv;
+    void          *wh = NULL;
+    struct timeval t0;
+    char           hname[128];
+    const char    *prefix = "plugin_transaction_";
+    const char    *cbname;
+    size_t         len;
 
     wh = NULL;
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
+    gettimeofday(&t0, NULL);
     rv = fn(h, (transaction_data)td);
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
@@ -616,6 +637,14 @@ plugin_transaction_call_one(clixon_handle       h,
                        fnname, clixon_plugin_name_get(cp));
         goto done;
     }
+    cbname = fnname;
+    if (strncmp(cbname, prefix, strlen(prefix)) == 0)
+        cbname += strlen(prefix);
+    len = strlen(cbname);
+    if (len > 4 && strcmp(cbname+len-4, "_one") == 0)
+        len -= 4;
+    snprintf(hname, sizeof(hname), "plugin/%s/%.*s", clixon_plugin_name_get(cp), (int)len, cbname);
+    backend_histogram_since(h, hname, &t0);
     retval = 0;
  done:
     return retval;
@@ -760,22 +789,28 @@ plugin_transaction_complete_all(clixon_handle       h,
  *
  * @param[in]  h   CLICON handle
  * @param[in]  td  Transaction data
- * @param[in]  nr  The plugin where an error occured. 
+ * @param[in]  nr  The number of plugins whose commit callbacks were called
+ * @param[in]  fv  Vector of plugins that failed, these are not reverted
  * @retval     0       OK
  * @retval    -1       Error
- * The revert is made in plugin before this one. Eg if error occurred in
- * plugin 2, then the revert will be made in plugins 1 and 0.
+ * The revert is made in reverse order. Eg if error occurred in plugin 2, then the revert
+ * will be made in plugins 1 and 0.
  */
 static int
 plugin_transaction_revert_all(clixon_handle       h,
                               transaction_data_t *td,
-                              int                 nr)
+                              int                 nr,
+                              char               *fv)
 {
     int              retval = 0;
     clixon_plugin_t *cp = NULL;
     trans_cb_t      *fn;
+    int              i = nr;
 
     while ((cp = clixon_plugin_each_revert(h, cp, nr)) != NULL) {
+        i--;
+        if (fv[i])
+            continue;
         if ((fn = clixon_plugin_api_get(cp)->ca_trans_revert) == NULL)
             continue;
 
@@ -823,36 +858,102 @@ plugin_transaction_commit_one(clixon_plugin_t      *cp,
     return 0;
 }
 
+/*! Call single plugin transaction_commit_wait() in a commit transaction
+ *
+ * Wait for completion of a commit started asynchronously by transaction_commit()
+ * @param[in]  cp      Plugin handle
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+plugin_transaction_commit_wait_one(clixon_plugin_t    *cp,
+                                   clixon_handle       h,
+                                   transaction_data_t *td)
+{
+    trans_cb_t *fn;
+
+    if ((fn = clixon_plugin_api_get(cp)->ca_trans_commit_wait) != NULL)
+        return plugin_transaction_call_one(h, cp, fn, __FUNCTION__, td);
+    return 0;
+}
+
 /*! Call transaction_commit callbacks in all backend plugins
  *
+ * Plugins that register a transaction_commit_wait() callback may start their commit
+ * asynchronously in transaction_commit(), eg send a request to a daemon and return without
+ * waiting for the reply. The commits of such plugins then run concurrently with the
+ * commits of subsequent plugins.
+ * When all commit callbacks have been called, the wait callbacks are called in plugin
+ * order. This is a barrier: all plugins have completed their commit before
+ * transaction_commit_done() is called.
  * @param[in]  h       Clixon handle
  * @param[in]  td      Transaction data
  * @retval     0       OK
  * @retval    -1       Error: one of the plugin callbacks returned error
- * If any of the commit callbacks fail by returning -1, a revert of the 
- * transaction is tried by calling the commit callbacsk with reverse arguments
- * and in reverse order.
+ * If any of the commit or wait callbacks fail by returning -1, outstanding commits are
+ * waited for, transaction_commit_failed() is called in the failed plugins, and a revert of
+ * the transaction is tried in reverse order in the other plugins that have committed.
  */
 int
 plugin_transaction_commit_all(clixon_handle       h,
                               transaction_data_t *td)
 {
-    int            retval = -1;
+    int              retval = -1;
     clixon_plugin_t *cp = NULL;
-    int            i=0;
-
+    int              nr = 0;
+    int              i;
+    int              called;
+    int              failed = 0;
+    char            *fv = NULL; /* Vector of failed plugins */
+
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        nr++;
+    if ((fv = calloc(nr+1, sizeof(char))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Call commit callbacks, stop at first failure */
+    called = 0;
+    cp = NULL;
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        i++;
         if (plugin_transaction_commit_one(cp, h, td) < 0){
-            /* First make an effort ro revert transaction for the failed plugin */
-            plugin_transaction_commit_failed(cp, h, td);
-            /* Make an effort to revert transaction */
-            plugin_transaction_revert_all(h, td, i-1);
-            goto done;
+            fv[called] = 1;
+            failed++;
+            called++;
+            break;
+        }
+        called++;
+    }
+    /* Barrier: wait for all started commits to complete */
+    i = 0;
+    cp = NULL;
+    while (i < called && (cp = clixon_plugin_each(h, cp)) != NULL) {
+        if (fv[i] == 0 &&
+            plugin_transaction_commit_wait_one(cp, h, td) < 0){
+            fv[i] = 1;
+            failed++;
         }
+        i++;
+    }
+    if (failed){
+        /* First make an effort to revert transaction for the failed plugins */
+        i = 0;
+        cp = NULL;
+        while (i < called && (cp = clixon_plugin_each(h, cp)) != NULL) {
+            if (fv[i])
+                plugin_transaction_commit_failed(cp, h, td);
+            i++;
+        }
+        /* Make an effort to revert transaction in the others */
+        plugin_transaction_revert_all(h, td, called, fv);
+        goto done;
     }
     retval = 0;
  done:
+    if (fv)
+        free(fv);
     return retval;
 }
 
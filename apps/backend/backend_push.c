@@ -0,0 +1,827 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * YANG-Push style datastore subscriptions, see RFC 8641
+ * A subscription selects data of a datastore with an xpath and is either periodic or on-change.
+ * Periodic: the selected data is read as a <get> or <get-config> of the subscriber would,
+ * including NACM, and sent in a push-update notification.
+ * On-change: on commit, the changes of running within the selection are computed from the
+ * diff vectors of the transaction and sent in a push-change-update notification.
+ * Notifications are queued to the session of the subscriber, see backend_notify.c
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_client.h"
+#include "clixon_backend_plugin.h"
+#include "backend_handle.h"
+#include "backend_get.h"
+#include "backend_notify.h"
+#include "backend_push.h"
+
+/*! Datastore subscription of a client
+ */
+struct push_subscription{
+    qelem_t              ps_q;           /* queue header */
+    uint32_t             ps_id;          /* Subscription id */
+    struct client_entry *ps_ce;          /* Subscriber session */
+    char                *ps_username;    /* User of subscriber, for NACM */
+    char                *ps_xpath;       /* Canonical xpath selecting data */
+    cvec                *ps_nsc;         /* Canonical namespace context of xpath */
+    int                  ps_operational; /* Config and state data, else running */
+    uint32_t             ps_period;      /* Period in ms, 0 if on-change */
+};
+
+/* All datastore subscriptions */
+static struct push_subscription *_push_list = NULL;
+
+/* Last subscription id */
+static uint32_t _push_id = 0;
+
+static int push_periodic_timeout(int fd, void *arg);
+
+/*! Register next periodic timeout of subscription
+ */
+static int
+push_periodic_reg(struct push_subscription *ps)
+{
+    struct timeval t;
+    struct timeval t1;
+
+    gettimeofday(&t, NULL);
+    t1.tv_sec = ps->ps_period/1000;
+    t1.tv_usec = (ps->ps_period%1000)*1000;
+    timeradd(&t, &t1, &t);
+    return clixon_event_reg_timeout(t, push_periodic_timeout, ps, "push periodic");
+}
+
+/*! Remove subscription from list and free it
+ */
+static int
+push_subscription_free(struct push_subscription *ps)
+{
+    DELQ(ps, _push_list, struct push_subscription *);
+    if (ps->ps_period)
+        clixon_event_unreg_timeout(push_periodic_timeout, ps);
+    if (ps->ps_username)
+        free(ps->ps_username);
+    if (ps->ps_xpath)
+        free(ps->ps_xpath);
+    if (ps->ps_nsc)
+        cvec_free(ps->ps_nsc);
+    free(ps);
+    return 0;
+}
+
+/*! Queue notification of subscription to its session
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  ps    Subscription
+ * @param[in]  name  Name of notification in clixon-lib
+ * @param[in]  body  Notification content after id
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_notify(clixon_handle             h,
+            struct push_subscription *ps,
+            const char               *name,
+            const char               *body)
+{
+    int                    retval = -1;
+    cbuf                  *cb = NULL;
+    stream_notification_t *sn = NULL;
+    char                   timestr[28];
+    struct timeval         tv;
+
+    gettimeofday(&tv, NULL);
+    if (time2str(&tv, timestr, sizeof(timestr)) < 0){
+        clixon_err(OE_UNIX, errno, "time2str");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>",
+            NETCONF_NOTIFICATION_NAMESPACE, timestr);
+    cprintf(cb, "<%s xmlns=\"%s\"><id>%u</id>%s</%s>", name, CLIXON_LIB_NS, ps->ps_id, body, name);
+    cprintf(cb, "</notification>");
+    /* The notification is only sent as text, never as XML */
+    if ((sn = stream_notification_new(NULL)) == NULL)
+        goto done;
+    sn->sn_xmlstr = cb;
+    cb = NULL;
+    if (backend_notify_enqueue(h, ps->ps_ce, sn, NULL) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (sn)
+        stream_notification_free(sn);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get data of a get or get-config reply
+ *
+ * @param[in]  reply  Reply as text
+ * @param[out] data   Start of data content in reply
+ * @param[out] len    Length of data content
+ * @retval     1      OK
+ * @retval     0      Not a data reply, eg an rpc-error
+ */
+static int
+push_reply_data(char   *reply,
+                char  **data,
+                size_t *len)
+{
+    char  *head = "<rpc-reply xmlns=\"" NETCONF_BASE_NAMESPACE "\">";
+    char  *tail = "</data></rpc-reply>";
+    size_t hlen = strlen(head);
+    size_t tlen = strlen(tail);
+    size_t rlen;
+
+    if (strncmp(reply, head, hlen) != 0)
+        return 0;
+    reply += hlen;
+    if (strcmp(reply, "<data/></rpc-reply>") == 0){
+        *data = reply;
+        *len = 0;
+        return 1;
+    }
+    rlen = strlen(reply);
+    if (strncmp(reply, "<data>", 6) != 0 || rlen < 6 + tlen ||
+        strcmp(reply + rlen - tlen, tail) != 0)
+        return 0;
+    *data = reply + 6;
+    *len = rlen - 6 - tlen;
+    return 1;
+}
+
+/*! Periodic timeout of subscription: get selected data and send push-update
+ *
+ * The data is read with the get or get-config rpc handler as the subscriber, which
+ * means that NACM read access of the subscriber applies.
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Subscription
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+push_periodic_timeout(int   fd,
+                      void *arg)
+{
+    int                       retval = -1;
+    struct push_subscription *ps = (struct push_subscription *)arg;
+    struct client_entry      *ce = ps->ps_ce;
+    clixon_handle             h = ce->ce_handle;
+    cbuf                     *cb = NULL;
+    cbuf                     *cbret = NULL;
+    cxobj                    *xt = NULL;
+    cxobj                    *xe;
+    cxobj                    *xnacm = NULL;
+    char                     *data;
+    size_t                    len;
+    int                       ret;
+
+    clixon_debug(CLIXON_DBG_STREAM, "id:%u", ps->ps_id);
+    if (ce->ce_notify_closed)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL ||
+        (cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (ps->ps_operational)
+        cprintf(cb, "<get xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    else
+        cprintf(cb, "<get-config xmlns=\"%s\"><source><running/></source>", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, "<filter type=\"xpath\" select=\"");
+    if (xml_chardata_cbuf_append(cb, 1, ps->ps_xpath) < 0)
+        goto done;
+    cprintf(cb, "\"");
+    if (xml_nsctx_cbuf(cb, ps->ps_nsc) < 0)
+        goto done;
+    cprintf(cb, "/></%s>", ps->ps_operational?"get":"get-config");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xe = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, EFAULT, "No get request");
+        goto done;
+    }
+    /* NACM of subscriber as in from_client_msg */
+    if ((ret = nacm_access_pre(h, ce->ce_username, ps->ps_username, &xnacm, cbret)) < 0)
+        goto done;
+    if (ret == 2){
+        clixon_log(h, LOG_WARNING, "push subscription %u: %s", ps->ps_id, cbuf_get(cbret));
+        goto resched;
+    }
+    if (clicon_nacm_cache_set(h, xnacm) < 0)
+        goto done;
+    clicon_username_set(h, ps->ps_username);
+    if (ps->ps_operational)
+        ret = from_client_get(h, xe, cbret, ce, NULL);
+    else
+        ret = from_client_get_config(h, xe, cbret, ce, NULL);
+    clicon_username_set(h, NULL);
+    if (clicon_nacm_cache_set(h, NULL) < 0)
+        goto done;
+    if (ret < 0) /* Error is logged, keep subscription */
+        goto resched;
+    if (push_reply_data(cbuf_get(cbret), &data, &len) == 0){
+        clixon_log(h, LOG_WARNING, "push subscription %u: %s", ps->ps_id, cbuf_get(cbret));
+        goto resched;
+    }
+    cbuf_reset(cb);
+    cprintf(cb, "<datastore-contents>");
+    if (cbuf_append_buf(cb, data, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    cprintf(cb, "</datastore-contents>");
+    if (push_notify(h, ps, "push-update", cbuf_get(cb)) < 0)
+        goto done;
+ resched:
+    if (push_periodic_reg(ps) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xnacm)
+        xml_free(xnacm);
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Compare xml object pointers, for sorting and searching selected nodes
+ */
+static int
+push_xml_cmp(const void *a,
+             const void *b)
+{
+    cxobj *xa = *(cxobj **)a;
+    cxobj *xb = *(cxobj **)b;
+
+    return xa < xb ? -1 : xa > xb ? 1 : 0;
+}
+
+/*! Check if node or one of its ancestors is selected
+ *
+ * @param[in]  x     XML node
+ * @param[in]  vec   Selected nodes, sorted by pointer
+ * @param[in]  len   Length of vec
+ * @retval     1     x is in a selected subtree
+ * @retval     0     x is not selected
+ */
+static int
+push_selected(cxobj  *x,
+              cxobj **vec,
+              size_t  len)
+{
+    if (len == 0)
+        return 0;
+    for (; x != NULL; x = xml_parent(x))
+        if (bsearch(&x, vec, len, sizeof(cxobj *), push_xml_cmp) != NULL)
+            return 1;
+    return 0;
+}
+
+/*! Append an edit of a changed node to a push-change-update
+ *
+ * @param[in]     x     Changed node, in target tree unless deleted
+ * @param[in]     op    Operation: create, delete or replace
+ * @param[in]     nsc   Namespace context for the target path
+ * @param[in,out] id    Edit id, incremented
+ * @param[in,out] cb    Edits
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+push_edit(cxobj      *x,
+          const char *op,
+          cvec       *nsc,
+          uint32_t   *id,
+          cbuf       *cb)
+{
+    int    retval = -1;
+    char  *path = NULL;
+    char  *ns = NULL;
+    char  *prefix;
+    cxobj *xd = NULL;
+
+    if (xml2xpath(x, nsc, 0, 1, &path) < 0)
+        goto done;
+    cprintf(cb, "<edit><edit-id>%u</edit-id><operation>%s</operation><target>", ++(*id), op);
+    if (xml_chardata_cbuf_append(cb, 0, path) < 0)
+        goto done;
+    cprintf(cb, "</target>");
+    if (strcmp(op, "delete") != 0){
+        /* The value is printed out of its tree: declare its namespace */
+        prefix = xml_prefix(x);
+        if (xml2ns(x, prefix, &ns) < 0)
+            goto done;
+        if ((xd = xml_dup(x)) == NULL)
+            goto done;
+        if (ns != NULL &&
+            xml_find_type(xd, prefix?"xmlns":NULL, prefix?prefix:"xmlns", CX_ATTR) == NULL &&
+            xmlns_set(xd, prefix, ns) < 0)
+            goto done;
+        cprintf(cb, "<value>");
+        if (clixon_xml2cbuf(cb, xd, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        cprintf(cb, "</value>");
+    }
+    cprintf(cb, "</edit>");
+    retval = 0;
+ done:
+    if (xd)
+        xml_free(xd);
+    if (path)
+        free(path);
+    return retval;
+}
+
+/*! Compute changes of a commit within the selection of an on-change subscription
+ *
+ * A changed node (added, deleted or changed leaf) in a selected subtree is sent as is.
+ * A selected node in an added or deleted subtree, where the changed node is not selected,
+ * is sent by itself, eg an xpath selecting a leaf of a created list entry.
+ * The selection is evaluated on the source tree for deleted nodes, and the target tree
+ * for others.
+ * @param[in]  td    Transaction data, with flags and vectors set by compute_diffs
+ * @param[in]  ps    Subscription
+ * @param[in]  nsc   Namespace context for target paths
+ * @param[out] cb    Edits, empty if no changes are selected
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_changes(transaction_data_t       *td,
+             struct push_subscription *ps,
+             cvec                     *nsc,
+             cbuf                     *cb)
+{
+    int     retval = -1;
+    cxobj **tvec = NULL;
+    size_t  tlen = 0;
+    cxobj **svec = NULL;
+    size_t  slen = 0;
+    cxobj  *x;
+    cxobj  *xp;
+    uint32_t id = 0;
+    int     i;
+
+    if (td->td_target &&
+        xpath_vec(td->td_target, ps->ps_nsc, "%s", &tvec, &tlen, ps->ps_xpath) < 0)
+        goto done;
+    if (td->td_src &&
+        xpath_vec(td->td_src, ps->ps_nsc, "%s", &svec, &slen, ps->ps_xpath) < 0)
+        goto done;
+    if (tlen == 0 && slen == 0)
+        goto ok;
+    if (tlen)
+        qsort(tvec, tlen, sizeof(cxobj *), push_xml_cmp);
+    if (slen)
+        qsort(svec, slen, sizeof(cxobj *), push_xml_cmp);
+    for (i=0; i<td->td_dlen; i++)
+        if (push_selected(td->td_dvec[i], svec, slen) &&
+            push_edit(td->td_dvec[i], "delete", nsc, &id, cb) < 0)
+            goto done;
+    for (i=0; i<td->td_alen; i++)
+        if (push_selected(td->td_avec[i], tvec, tlen) &&
+            push_edit(td->td_avec[i], "create", nsc, &id, cb) < 0)
+            goto done;
+    for (i=0; i<td->td_clen; i++)
+        if (push_selected(td->td_tcvec[i], tvec, tlen) &&
+            push_edit(td->td_tcvec[i], "replace", nsc, &id, cb) < 0)
+            goto done;
+    /* Selected nodes inside deleted or added subtrees whose root is not selected */
+    for (i=0; i<slen; i++){
+        x = svec[i];
+        if (xml_type(x) == CX_ELMNT && xml_flag(x, XML_FLAG_DEL) &&
+            (xp = xml_parent(x)) != NULL && xml_flag(xp, XML_FLAG_DEL) &&
+            !push_selected(xp, svec, slen) &&
+            push_edit(x, "delete", nsc, &id, cb) < 0)
+            goto done;
+    }
+    for (i=0; i<tlen; i++){
+        x = tvec[i];
+        if (xml_type(x) == CX_ELMNT && xml_flag(x, XML_FLAG_ADD) &&
+            (xp = xml_parent(x)) != NULL && xml_flag(xp, XML_FLAG_ADD) &&
+            !push_selected(xp, tvec, tlen) &&
+            push_edit(x, "create", nsc, &id, cb) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (tvec)
+        free(tvec);
+    if (svec)
+        free(svec);
+    return retval;
+}
+
+/*! Compute push-change-update notifications of a commit to on-change subscribers
+ *
+ * Called after the commit callbacks and before running is written, when the diff
+ * vectors of the transaction still refer to the source and target trees.
+ * The notifications are sent with backend_push_commit_send once running is written.
+ * Target paths of edits use YANG module prefixes.
+ * @param[in]  h        Clixon handle
+ * @param[in]  td       Transaction data
+ * @param[out] pending  Notification contents, name is subscription id. Free with cvec_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see candidate_commit
+ */
+int
+backend_push_commit(clixon_handle       h,
+                    transaction_data_t *td,
+                    cvec              **pending)
+{
+    int                       retval = -1;
+    struct push_subscription *ps;
+    struct push_subscription *ps1;
+    cvec                     *nsc = NULL;
+    cbuf                     *cb = NULL;
+    cbuf                     *cbret = NULL;
+    cxobj                    *xnacm;
+    cg_var                   *cv;
+    char                      idstr[16];
+    int                       ret;
+
+    if ((ps = _push_list) == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL ||
+        (cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    do {
+        ps1 = NEXTQ(struct push_subscription *, ps);
+        if (ps->ps_period != 0 || ps->ps_ce->ce_notify_closed)
+            continue;
+        /* NACM data rules are not applied to edits, skip if they apply to subscriber */
+        xnacm = NULL;
+        cbuf_reset(cbret);
+        if ((ret = nacm_access_pre(h, ps->ps_ce->ce_username, ps->ps_username, &xnacm, cbret)) < 0)
+            goto done;
+        if (xnacm)
+            xml_free(xnacm);
+        if (ret != 1){
+            clixon_debug(CLIXON_DBG_STREAM, "id:%u skipped by NACM", ps->ps_id);
+            continue;
+        }
+        if (nsc == NULL &&
+            xml_nsctx_yangspec(clicon_dbspec_yang(h), &nsc) < 0)
+            goto done;
+        cbuf_reset(cb);
+        if (push_changes(td, ps, nsc, cb) < 0)
+            goto done;
+        if (cbuf_len(cb) == 0)
+            continue;
+        if (*pending == NULL &&
+            (*pending = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        cbuf_reset(cbret);
+        cprintf(cbret, "<datastore-changes>%s</datastore-changes>", cbuf_get(cb));
+        snprintf(idstr, sizeof(idstr), "%u", ps->ps_id);
+        if ((cv = cvec_add(*pending, CGV_STRING)) == NULL ||
+            cv_name_set(cv, idstr) == NULL ||
+            cv_string_set(cv, cbuf_get(cbret)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add");
+            goto done;
+        }
+    } while ((ps = ps1) != _push_list);
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (cb)
+        cbuf_free(cb);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Send push-change-update notifications of a commit
+ *
+ * Called when running has been written.
+ * Subscriptions removed after backend_push_commit are skipped.
+ * @param[in]  h        Clixon handle
+ * @param[in]  pending  Notification contents from backend_push_commit
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+backend_push_commit_send(clixon_handle h,
+                         cvec         *pending)
+{
+    int                       retval = -1;
+    struct push_subscription *ps;
+    cg_var                   *cv = NULL;
+    uint32_t                  id;
+
+    while ((cv = cvec_each(pending, cv)) != NULL){
+        if (parse_uint32(cv_name_get(cv), &id, NULL) != 1)
+            continue;
+        if ((ps = _push_list) == NULL)
+            break;
+        do {
+            if (ps->ps_id == id)
+                break;
+            ps = NEXTQ(struct push_subscription *, ps);
+        } while (ps != _push_list);
+        if (ps->ps_id != id || ps->ps_ce->ce_notify_closed)
+            continue;
+        if (push_notify(h, ps, "push-change-update", cv_string_get(cv)) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create a datastore subscription of the client session
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+from_client_create_push_subscription(clixon_handle h,
+                                     cxobj        *xe,
+                                     cbuf         *cbret,
+                                     void         *arg,
+                                     void         *regarg)
+{
+    int                       retval = -1;
+    struct client_entry      *ce = (struct client_entry *)arg;
+    struct push_subscription *ps = NULL;
+    yang_stmt                *yspec;
+    cxobj                    *xp;
+    char                     *str;
+    char                     *username;
+    cvec                     *nsc0 = NULL;
+    char                     *xpath = NULL;
+    cvec                     *nsc = NULL;
+    cbuf                     *cbreason = NULL;
+    char                     *reason = NULL;
+    uint32_t                  period = 0;
+    int                       pmin;
+    int                       operational;
+    int                       ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    operational = (str = xml_find_body(xe, "datastore")) != NULL && strcmp(str, "operational") == 0;
+    if ((xp = xml_find_type(xe, NULL, "xpath", CX_ELMNT)) == NULL ||
+        (str = xml_body(xp)) == NULL){
+        if (netconf_missing_element(cbret, "application", "xpath", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    /* The namespace declarations in scope of the xpath element */
+    if (xml_nsctx_node(xp, &nsc0) < 0)
+        goto done;
+    if ((ret = xpath2canonical(str, nsc0, yspec, &xpath, &nsc, &cbreason)) < 0)
+        goto done;
+    if (ret == 0){
+        if (netconf_bad_element(cbret, "application", "xpath", cbuf_get(cbreason)) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((str = xml_find_body(xe, "period")) != NULL){
+        if ((ret = parse_uint32(str, &period, &reason)) < 0){
+            clixon_err(OE_XML, errno, "parse_uint32");
+            goto done;
+        }
+        if (ret == 0 || period == 0){
+            if (netconf_bad_element(cbret, "application", "period", "Expected period in ms") < 0)
+                goto done;
+            goto ok;
+        }
+        if ((pmin = clicon_option_int(h, "CLICON_STREAM_PUSH_PERIOD_MIN")) > 0 &&
+            period < (uint32_t)pmin){
+            if (cbreason == NULL && (cbreason = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cbuf_reset(cbreason);
+            cprintf(cbreason, "Period less than minimum %d ms", pmin);
+            if (netconf_bad_element(cbret, "application", "period", cbuf_get(cbreason)) < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    else if (xml_find_type(xe, NULL, "on-change", CX_ELMNT) == NULL){
+        if (netconf_missing_element(cbret, "application", "period", "Expected period or on-change") < 0)
+            goto done;
+        goto ok;
+    }
+    else if (operational){
+        if (netconf_operation_not_supported(cbret, "application", "on-change of operational datastore not supported") < 0)
+            goto done;
+        goto ok;
+    }
+    else if (clicon_nacm_cache(h) != NULL){
+        /* NACM data rules apply to subscriber, see backend_push_commit */
+        if (netconf_access_denied(cbret, "application", "on-change not supported with NACM data access rules") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ps = malloc(sizeof(*ps))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ps, 0, sizeof(*ps));
+    ps->ps_id = ++_push_id;
+    ps->ps_ce = ce;
+    if ((username = clicon_username_get(h)) != NULL &&
+        (ps->ps_username = strdup(username)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    ps->ps_xpath = xpath;
+    xpath = NULL;
+    ps->ps_nsc = nsc;
+    nsc = NULL;
+    ps->ps_operational = operational;
+    ps->ps_period = period;
+    ADDQ(ps, _push_list);
+    if (period && push_periodic_reg(ps) < 0){
+        push_subscription_free(ps);
+        ps = NULL;
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_STREAM, "id:%u xpath:%s period:%u", ps->ps_id, ps->ps_xpath, period);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><id xmlns=\"%s\">%u</id></rpc-reply>",
+            NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, ps->ps_id);
+    ps = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (ps)
+        free(ps);
+    if (reason)
+        free(reason);
+    if (cbreason)
+        cbuf_free(cbreason);
+    if (xpath)
+        free(xpath);
+    if (nsc)
+        cvec_free(nsc);
+    if (nsc0)
+        cvec_free(nsc0);
+    return retval;
+}
+
+/*! Delete a datastore subscription of the client session
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+from_client_delete_push_subscription(clixon_handle h,
+                                     cxobj        *xe,
+                                     cbuf         *cbret,
+                                     void         *arg,
+                                     void         *regarg)
+{
+    int                       retval = -1;
+    struct client_entry      *ce = (struct client_entry *)arg;
+    struct push_subscription *ps;
+    char                     *str;
+    char                     *reason = NULL;
+    uint32_t                  id = 0;
+    int                       ret;
+
+    if ((str = xml_find_body(xe, "id")) == NULL){
+        if (netconf_missing_element(cbret, "application", "id", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = parse_uint32(str, &id, &reason)) < 0){
+        clixon_err(OE_XML, errno, "parse_uint32");
+        goto done;
+    }
+    if ((ps = _push_list) != NULL && ret == 1){
+        do {
+            if (ps->ps_id == id && ps->ps_ce == ce)
+                break;
+            ps = NEXTQ(struct push_subscription *, ps);
+        } while (ps != _push_list);
+        if (ps->ps_id != id || ps->ps_ce != ce)
+            ps = NULL;
+    }
+    else
+        ps = NULL;
+    /* Only subscriptions of own session */
+    if (ps == NULL){
+        if (netconf_invalid_value(cbret, "application", "No such subscription") < 0)
+            goto done;
+        goto ok;
+    }
+    clixon_debug(CLIXON_DBG_STREAM, "id:%u", id);
+    push_subscription_free(ps);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+/*! Remove all datastore subscriptions of a client session
+ *
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ */
+int
+backend_push_client_rm(struct client_entry *ce)
+{
+    struct push_subscription *ps;
+    int                       found;
+
+    do {
+        found = 0;
+        if ((ps = _push_list) != NULL)
+            do {
+                if (ps->ps_ce == ce){
+                    push_subscription_free(ps);
+                    found++;
+                    break;
+                }
+                ps = NEXTQ(struct push_subscription *, ps);
+            } while (ps != _push_list);
+    } while (found);
+    return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Ring buffer of recent backend RPC traces with per-phase latency
+ * Always on, sized by CLICON_BACKEND_TRACE_SIZE. Accounting is only a few gettimeofday
+ * calls per RPC, the ring is only sorted when dumped.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "backend_trace.h"
+
+/* Handle data key of trace ring */
+#define TRACE_KEY "backend-trace"
+
+/*! Trace of one RPC
+ */
+struct backend_trace {
+    uint64_t       bt_seq;       /* Sequence number, 0 if unused */
+    int            bt_done;      /* Trace is completed */
+    uint32_t       bt_session;   /* Session id */
+    char           bt_rpc[32];   /* RPC name (truncated) */
+    struct timeval bt_start;     /* Start time */
+    size_t         bt_in;        /* Request bytes */
+    size_t         bt_out;       /* Reply bytes */
+    uint64_t       bt_total;     /* Total time in us */
+    uint64_t       bt_phase[TRACE_PHASE_MAX]; /* Time per phase in us */
+};
+typedef struct backend_trace backend_trace;
+
+/* Names of phases as in clixon-lib trace rpc */
+static const char *_trace_phase_names[TRACE_PHASE_MAX] = {
+    "parse",
+    "nacm",
+    "datastore-read",
+    "datastore-write",
+    "state",
+    "reply"
+};
+
+/*! Ring buffer of traces, kept as handle data, allocated on first trace
+ */
+struct backend_trace_ring {
+    backend_trace *tr_vec;       /* Ring buffer */
+    uint32_t       tr_size;      /* Size of ring buffer */
+    uint64_t       tr_seq;       /* Last sequence number */
+    backend_trace *tr_current;   /* Trace of ongoing RPC, or NULL */
+};
+typedef struct backend_trace_ring backend_trace_ring;
+
+/*! Get trace ring of handle
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     tr    Trace ring
+ * @retval     NULL  No trace ring, ie no RPC traced yet or tracing disabled
+ */
+static backend_trace_ring *
+trace_ring_get(clixon_handle h)
+{
+    backend_trace_ring *tr = NULL;
+
+    if (clicon_ptr_get(h, TRACE_KEY, (void**)&tr) < 0)
+        return NULL;
+    return tr;
+}
+
+/*! Elapsed time in us since t0
+ */
+static uint64_t
+trace_elapsed(struct timeval *t0)
+{
+    struct timeval t1;
+    struct timeval td;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &td);
+    if (td.tv_sec < 0) /* Clock moved backwards */
+        return 0;
+    return (uint64_t)td.tv_sec*1000000 + td.tv_usec;
+}
+
+/*! Start trace of an incoming RPC, reusing the oldest slot in the ring
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  session Session id
+ * @param[in]  inlen   Request length in bytes
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+backend_trace_begin(clixon_handle h,
+                    uint32_t      session,
+                    size_t        inlen)
+{
+    int                 retval = -1;
+    backend_trace_ring *tr;
+    backend_trace      *bt;
+    uint32_t            size;
+
+    if ((tr = trace_ring_get(h)) == NULL){
+        if ((size = clicon_option_int(h, "CLICON_BACKEND_TRACE_SIZE")) == 0)
+            goto ok;
+        if ((tr = calloc(1, sizeof(*tr))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((tr->tr_vec = calloc(size, sizeof(backend_trace))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            free(tr);
+            goto done;
+        }
+        tr->tr_size = size;
+        if (clicon_ptr_set(h, TRACE_KEY, tr) < 0){
+            free(tr->tr_vec);
+            free(tr);
+            goto done;
+        }
+    }
+    bt = &tr->tr_vec[tr->tr_seq % tr->tr_size];
+    memset(bt, 0, sizeof(*bt));
+    bt->bt_seq = ++tr->tr_seq;
+    bt->bt_session = session;
+    bt->bt_in = inlen;
+    gettimeofday(&bt->bt_start, NULL);
+    tr->tr_current = bt;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set RPC name of ongoing trace
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  rpc     RPC name
+ * @retval     0       OK
+ */
+int
+backend_trace_rpc(clixon_handle h,
+                  const char   *rpc)
+{
+    backend_trace_ring *tr;
+    backend_trace      *bt;
+
+    if ((tr = trace_ring_get(h)) != NULL &&
+        (bt = tr->tr_current) != NULL)
+        strncpy(bt->bt_rpc, rpc, sizeof(bt->bt_rpc)-1);
+    return 0;
+}
+
+/*! Account time since t0 to a phase of ongoing trace
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  phase   Phase
+ * @param[in]  t0      Start time of phase
+ * @retval     0       OK
+ * @code
+ *   struct timeval t0;
+ *   gettimeofday(&t0, NULL);
+ *   ...
+ *   backend_trace_phase(h, TRACE_DS_READ, &t0);
+ * @endcode
+ */
+int
+backend_trace_phase(clixon_handle    h,
+                    enum trace_phase phase,
+                    struct timeval  *t0)
+{
+    backend_trace_ring *tr;
+    backend_trace      *bt;
+
+    if ((tr = trace_ring_get(h)) != NULL &&
+        (bt = tr->tr_current) != NULL)
+        bt->bt_phase[phase] += trace_elapsed(t0);
+    return 0;
+}
+
+/*! End ongoing trace
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  outlen  Reply length in bytes
+ * @retval     0       OK
+ */
+int
+backend_trace_end(clixon_handle h,
+                  size_t        outlen)
+{
+    backend_trace_ring *tr;
+    backend_trace      *bt;
+
+    if ((tr = trace_ring_get(h)) != NULL &&
+        (bt = tr->tr_current) != NULL){
+        bt->bt_out = outlen;
+        bt->bt_total = trace_elapsed(&bt->bt_start);
+        bt->bt_done = 1;
+        tr->tr_current = NULL;
+    }
+    return 0;
+}
+
+/*! Sort traces by total time, slowest first
+ */
+static int
+trace_cmp(const void *a,
+          const void *b)
+{
+    backend_trace *bt1 = *(backend_trace **)a;
+    backend_trace *bt2 = *(backend_trace **)b;
+
+    if (bt1->bt_total < bt2->bt_total)
+        return 1;
+    if (bt1->bt_total > bt2->bt_total)
+        return -1;
+    return bt1->bt_seq < bt2->bt_seq ? 1 : -1;
+}
+
+/*! Print slowest completed traces as XML according to clixon-lib trace rpc
+ *
+ * @param[in]     h    Clixon handle
+ * @param[in]     n    Max number of traces, slowest first
+ * @param[in,out] cb   CLIgen buffer
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+int
+backend_trace_cbuf(clixon_handle h,
+                   uint32_t      n,
+                   cbuf         *cb)
+{
+    int                 retval = -1;
+    backend_trace_ring *tr;
+    backend_trace     **vec = NULL;
+    backend_trace      *bt;
+    uint32_t            len = 0;
+    uint32_t            i;
+    int                 j;
+    char                timestr[28];
+
+    if ((tr = trace_ring_get(h)) == NULL)
+        goto ok;
+    if ((vec = calloc(tr->tr_size, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<tr->tr_size; i++){
+        bt = &tr->tr_vec[i];
+        if (bt->bt_seq != 0 && bt->bt_done)
+            vec[len++] = bt;
+    }
+    qsort(vec, len, sizeof(*vec), trace_cmp);
+    for (i=0; i<len && i<n; i++){
+        bt = vec[i];
+        cprintf(cb, "<trace>");
+        cprintf(cb, "<seq>%" PRIu64 "</seq>", bt->bt_seq);
+        cprintf(cb, "<session-id>%u</session-id>", bt->bt_session);
+        if (strlen(bt->bt_rpc))
+            cprintf(cb, "<rpc>%s</rpc>", bt->bt_rpc);
+        if (time2str(&bt->bt_start, timestr, sizeof(timestr)) < 0){
+            clixon_err(OE_UNIX, errno, "time2str");
+            goto done;
+        }
+        cprintf(cb, "<start>%s</start>", timestr);
+        cprintf(cb, "<bytes-in>%zu</bytes-in>", bt->bt_in);
+        cprintf(cb, "<bytes-out>%zu</bytes-out>", bt->bt_out);
+        cprintf(cb, "<total>%" PRIu64 "</total>", bt->bt_total);
+        for (j=0; j<TRACE_PHASE_MAX; j++)
+            cprintf(cb, "<%s>%" PRIu64 "</%s>",
+                    _trace_phase_names[j], bt->bt_phase[j], _trace_phase_names[j]);
+        cprintf(cb, "</trace>");
+    }
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Free trace ring buffer
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ */
+int
+backend_trace_free(clixon_handle h)
+{
+    backend_trace_ring *tr;
+
+    if ((tr = trace_ring_get(h)) == NULL)
+        return 0;
+    if (tr->tr_vec)
+        free(tr->tr_vec);
+    free(tr);
+    clicon_ptr_del(h, TRACE_KEY);
+    return 0;
+}
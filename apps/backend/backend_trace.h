@@ -0,0 +1,65 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Ring buffer of recent backend RPC traces with per-phase latency
+ */
+
+#ifndef _BACKEND_TRACE_H_
+#define _BACKEND_TRACE_H_
+
+/*
+ * Types
+ */
+/*! Phases of an RPC where time is accounted
+ */
+enum trace_phase {
+    TRACE_PARSE,         /* Parse and validate request */
+    TRACE_NACM,          /* NACM rpc access control */
+    TRACE_DS_READ,       /* Datastore read */
+    TRACE_DS_WRITE,      /* Datastore write */
+    TRACE_STATE,         /* State data callbacks */
+    TRACE_REPLY,         /* Reply serialization and send */
+    TRACE_PHASE_MAX
+};
+
+/*
+ * Prototypes
+ */
+int backend_trace_begin(clixon_handle h, uint32_t session, size_t inlen);
+int backend_trace_rpc(clixon_handle h, const char *rpc);
+int backend_trace_phase(clixon_handle h, enum trace_phase phase, struct timeval *t0);
+int backend_trace_end(clixon_handle h, size_t outlen);
+int backend_trace_cbuf(clixon_handle h, uint32_t n, cbuf *cb);
+int backend_trace_free(clixon_handle h);
+
+#endif  /* _BACKEND_TRACE_H_ */
@@ -45,6 +45,8 @@
 /*
  * Types
  */
+struct backend_notify; /* Queued notification, see backend_notify.c */
+
 /* Backend client entry.
  * Keep state about every connected client.
  * References from RFC 6022, ietf-netconf-monitoring.yang sessions container
@@ -73,6 +75,13 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    struct backend_notify *ce_notify_q;   /* Queue of outgoing notifications */
+    uint32_t              ce_notify_len;  /* Length of notification queue */
+    uint32_t              ce_notify_max;  /* Max length of notification queue */
+    uint32_t              ce_notify_drops;/* Notifications dropped on full queue */
+    size_t                ce_notify_off;  /* Bytes sent of first queued notification */
+    int                   ce_notify_wait; /* Registered for writable socket */
+    int                   ce_notify_closed; /* Disconnected, notifications ignored */
 };
 typedef struct client_entry client_entry;
 
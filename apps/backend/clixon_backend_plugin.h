@@ -123,6 +123,7 @@ int plugin_transaction_complete_one(clixon_plugin_t *cp, clixon_handle h, transa
 int plugin_transaction_complete_all(clixon_handle h, transaction_data_t *td);
 
 int plugin_transaction_commit_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
+int plugin_transaction_commit_wait_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_all(clixon_handle h, transaction_data_t *td);
 
 int plugin_transaction_commit_done_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
@@ -67,6 +67,7 @@
 #include "cli_plugin.h"
 #include "cli_handle.h"
 #include "cli_generate.h"
+#include "cli_common.h"
 
 /*
  * Constants
@@ -742,6 +743,7 @@ clicon_cliread(clixon_handle h,
         free(promptstr);
     }
     clixon_err_reset();
+    expand_dbvar_cache_line(h);
     if (cliread(cli_cligen(h), stringp) < 0){
         cli_handler_err(stdout);
         if (clixon_err_subnr() == ESHUTDOWN)
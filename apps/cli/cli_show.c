@@ -72,6 +72,22 @@
 #include "cli_autocli.h"
 #include "cli_common.h" /* internal functions */
 
+/*
+ * Types
+ */
+/*! Completion cache entry of expand_dbvar
+ *
+ * The get-config reply of an expansion, keyed on datastore and xpath. An entry is
+ * valid as long as the generation of the datastore in the backend is unchanged.
+ * @see CLICON_CLI_EXPAND_CACHE
+ */
+struct expand_cache {
+    qelem_t  ec_qelem;  /* List header, most recently used first */
+    char    *ec_key;    /* Datastore and xpath */
+    uint64_t ec_gen;    /* Datastore generation of reply */
+    cxobj   *ec_xt;     /* Get-config reply */
+};
+
 /*! Given an xpath encoded in a cbuf, append a second xpath into the first (unless absolute path)
  *
  * The method reuses prefixes from xpath1 if they exist, otherwise the module prefix
@@ -290,6 +306,225 @@ expand_dbvar_insert(clixon_handle h,
     return retval;
 }
 
+/*! Free completion cache entry
+ *
+ * @param[in]  ec   Cache entry
+ */
+static void
+expand_cache_free(struct expand_cache *ec)
+{
+    if (ec->ec_key)
+        free(ec->ec_key);
+    if (ec->ec_xt)
+        xml_free(ec->ec_xt);
+    free(ec);
+}
+
+/*! Free the completion cache of expand_dbvar
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+expand_dbvar_cache_exit(clixon_handle h)
+{
+    struct expand_cache *ec0 = NULL;
+    struct expand_cache *ec;
+
+    if (clicon_ptr_get(h, "cli-expand-cache", (void**)&ec0) < 0 || ec0 == NULL)
+        return 0;
+    while ((ec = ec0) != NULL){
+        DELQ(ec, ec0, struct expand_cache *);
+        expand_cache_free(ec);
+    }
+    clicon_ptr_del(h, "cli-expand-cache");
+    clicon_data_cvec_del(h, "cli-expand-gen");
+    return 0;
+}
+
+/*! Start of new command line, datastore generations need to be checked again
+ *
+ * Within one command line, the datastore generation is only read once per datastore
+ * since the line is not executed until it is completed.
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+expand_dbvar_cache_line(clixon_handle h)
+{
+    if (clicon_data_cvec_get(h, "cli-expand-gen") != NULL)
+        clicon_data_cvec_del(h, "cli-expand-gen");
+    return 0;
+}
+
+/*! Get datastore generation, read from backend at most once per command line
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Name of datastore
+ * @param[out] gen  Datastore generation, 0 if not supported or datastore not loaded
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see expand_dbvar_cache_line
+ */
+static int
+expand_dbvar_gen(clixon_handle h,
+                 char         *db,
+                 uint64_t     *gen)
+{
+    int     retval = -1;
+    cvec   *cvv;
+    cg_var *cv;
+    int     ret;
+
+    if ((cvv = clicon_data_cvec_get(h, "cli-expand-gen")) == NULL){
+        if ((cvv = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (clicon_data_cvec_set(h, "cli-expand-gen", cvv) < 0){
+            cvec_free(cvv);
+            goto done;
+        }
+    }
+    if ((cv = cvec_find(cvv, db)) == NULL){
+        if ((ret = clicon_rpc_datastore_generation(h, db, gen)) < 0)
+            goto done;
+        if (ret == 0) /* Backend not supporting it */
+            *gen = 0;
+        if ((cv = cvec_add(cvv, CGV_UINT64)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add");
+            goto done;
+        }
+        if (cv_name_set(cv, db) == NULL){
+            clixon_err(OE_UNIX, errno, "cv_name_set");
+            goto done;
+        }
+        cv_uint64_set(cv, *gen);
+    }
+    *gen = cv_uint64_get(cv);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get configuration for expansion, using the completion cache if enabled
+ *
+ * A cached reply is used if the generation of the datastore is the same as when read.
+ * The generation is read from the backend once per command line.
+ * Otherwise the configuration is read and replaces the cached reply.
+ * If the cache has more than CLICON_CLI_EXPAND_CACHE entries, the least recently used
+ * entry is removed.
+ * Error replies are not cached.
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Name of datastore
+ * @param[in]  xpath   XPath of get-config
+ * @param[in]  nsc     Namespace context of xpath
+ * @param[out] xtp     Get-config reply
+ * @param[out] cached  If set, xtp is owned by the cache, otherwise free with xml_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+expand_dbvar_get(clixon_handle h,
+                 char         *db,
+                 char         *xpath,
+                 cvec         *nsc,
+                 cxobj       **xtp,
+                 int          *cached)
+{
+    int                  retval = -1;
+    int                  max;
+    struct expand_cache *ec0 = NULL; /* list head */
+    struct expand_cache *ec = NULL;  /* found */
+    struct expand_cache *ecl;
+    cbuf                *cbkey = NULL;
+    cxobj               *xt = NULL;
+    uint64_t             gen = 0;
+    int                  n;
+
+    *cached = 0;
+    if ((max = clicon_option_int(h, "CLICON_CLI_EXPAND_CACHE")) <= 0)
+        goto nocache;
+    if (expand_dbvar_gen(h, db, &gen) < 0)
+        goto done;
+    if (gen == 0) /* Backend not supporting it or datastore not loaded */
+        goto nocache;
+    if ((cbkey = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbkey, "%s %s", db, xpath);
+    clicon_ptr_get(h, "cli-expand-cache", (void**)&ec0);
+    if ((ecl = ec0) != NULL){
+        do {
+            if (strcmp(ecl->ec_key, cbuf_get(cbkey)) == 0){
+                ec = ecl;
+                break;
+            }
+            ecl = NEXTQ(struct expand_cache *, ecl);
+        } while (ecl != ec0);
+    }
+    if (ec == NULL || ec->ec_gen != gen){
+        if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, NULL, &xt) < 0)
+            goto done;
+        if (xpath_first(xt, NULL, "/rpc-error") != NULL){
+            *xtp = xt;
+            goto ok;
+        }
+        if (ec == NULL){
+            if ((ec = malloc(sizeof(*ec))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memset(ec, 0, sizeof(*ec));
+            if ((ec->ec_key = strdup(cbuf_get(cbkey))) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                free(ec);
+                goto done;
+            }
+        }
+        else{
+            DELQ(ec, ec0, struct expand_cache *);
+            xml_free(ec->ec_xt);
+        }
+        ec->ec_xt = xt;
+        xt = NULL;
+        ec->ec_gen = gen;
+    }
+    else
+        DELQ(ec, ec0, struct expand_cache *);
+    /* Most recently used first */
+    INSQ(ec, ec0);
+    /* Remove least recently used */
+    n = 0;
+    ecl = ec0;
+    do {
+        n++;
+        ecl = NEXTQ(struct expand_cache *, ecl);
+    } while (ecl != ec0);
+    while (n-- > max){
+        ecl = PREVQ(struct expand_cache *, ec0);
+        DELQ(ecl, ec0, struct expand_cache *);
+        expand_cache_free(ecl);
+    }
+    if (clicon_ptr_set(h, "cli-expand-cache", ec0) < 0)
+        goto done;
+    *xtp = ec0->ec_xt;
+    *cached = 1;
+ ok:
+    retval = 0;
+ done:
+    if (cbkey)
+        cbuf_free(cbkey);
+    if (xt)
+        xml_free(xt);
+    return retval;
+ nocache:
+    if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, NULL, xtp) < 0)
+        goto done;
+    goto ok;
+}
+
 /*! Completion callback of variable for configured data and automatically generated data model
  *
  * Returns an expand-type list of commands as used by cligen 'expand' 
@@ -348,6 +583,7 @@ expand_dbvar(void   *h,
     char            *str;
     int              grouping_treeref;
     cvec            *callback_cvv;
+    int              cached = 0;
 
     if (argv == NULL || (cvec_len(argv) != 2 && cvec_len(argv) != 3)){
         clixon_err(OE_PLUGIN, EINVAL, "requires arguments: <db> <apipathfmt> [<mountpt>]");
@@ -481,8 +717,8 @@ expand_dbvar(void   *h,
         if (xpath_append(cbxpath, yang_argument_get(ypath), y, nsc) < 0)
             goto done;
     }
-    /* Get configuration based on cbxpath */
-    if (clicon_rpc_get_config(h, NULL, dbstr, cbuf_get(cbxpath), nsc, NULL, &xt) < 0)
+    /* Get configuration based on cbxpath, possibly cached */
+    if (expand_dbvar_get(h, dbstr, cbuf_get(cbxpath), nsc, &xt, &cached) < 0)
         goto done;
     if ((xe = xpath_first(xt, NULL, "/rpc-error")) != NULL){
         clixon_err_netconf(h, OE_NETCONF, 0, xe, "Get configuration");
@@ -514,7 +750,7 @@ expand_dbvar(void   *h,
         free(xvec);
     if (xtop)
         xml_free(xtop);
-    if (xt)
+    if (xt && !cached)
         xml_free(xt);
     if (xpath)
         free(xpath);
@@ -2043,6 +2279,10 @@ cli_show_statistics(clixon_handle h,
     char       *unit;
     int         inext;
     int         inext2;
+    char       *count;
+    char       *p50;
+    char       *p99;
+    char       *max;
 
     if (argv == NULL || (cvec_len(argv) < 1 || cvec_len(argv) > 2)){
         clixon_err(OE_PLUGIN, EINVAL, "Expected arguments: [(cli|backend|all) [detail]]");
@@ -2224,6 +2464,118 @@ cli_show_statistics(clixon_handle h,
             cligen_output(stdout, "%-25s %" PRIu64 "%-10s\n", "YANG Total", u64, unit);
             translatenumber(tsz0+tsz, &u64, &unit);
             cligen_output(stdout, "%-25s %" PRIu64 "%-10s\n", "Mem Total", u64, unit);
+            if ((xp = xml_find_type(xret, NULL, "timers", CX_ELMNT)) != NULL &&
+                xml_child_nr_type(xp, CX_ELMNT) > 0){
+                cligen_output(stdout, "\n%-40s %10s %10s %10s %10s\n",
+                              "Timer (us)", "Count", "p50", "p99", "Max");
+                x = NULL;
+                while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL) {
+                    if (strcmp(xml_name(x), "timer") != 0)
+                        continue;
+                    if ((name = xml_find_body(x, "name")) == NULL)
+                        continue;
+                    /* Missing values, eg from an older backend, are shown as - */
+                    if ((count = xml_find_body(x, "count")) == NULL)
+                        count = "-";
+                    if ((p50 = xml_find_body(x, "p50")) == NULL)
+                        p50 = "-";
+                    if ((p99 = xml_find_body(x, "p99")) == NULL)
+                        p99 = "-";
+                    if ((max = xml_find_body(x, "max")) == NULL)
+                        max = "-";
+                    cligen_output(stdout, "%-40s %10s %10s %10s %10s\n", name,
+                                  count, p50, p99, max);
+                }
+            }
+        }
+    }
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! CLI callback show slowest of recent backend RPCs
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables, may contain "slowest"
+ * @param[in]  argv  Arguments given at the callback: [<slowest>]
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   trace("Show slowest backend requests"), cli_show_trace("10");
+ * @endcode
+ * @see CLICON_BACKEND_TRACE_SIZE
+ */
+int
+cli_show_trace(clixon_handle h,
+               cvec         *cvv,
+               cvec         *argv)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cxobj  *xret = NULL;
+    cxobj  *xerr;
+    cxobj  *xp;
+    cxobj  *x;
+    cg_var *cv;
+    char   *slowest = NULL;
+    char   *rpc;
+    char   *val[10];
+    int     i;
+    /* Columns after RPC, as trace fields */
+    const char *fields[] = {"total", "parse", "nacm", "datastore-read", "datastore-write",
+                            "state", "reply", "bytes-in", "bytes-out"};
+
+    if (argv != NULL && cvec_len(argv) > 1){
+        clixon_err(OE_PLUGIN, EINVAL, "Expected arguments: [<slowest>]");
+        goto done;
+    }
+    if ((cv = cvec_find(cvv, "slowest")) != NULL)
+        slowest = cv_string_get(cv);
+    else if (argv != NULL && cvec_len(argv) == 1)
+        slowest = cv_string_get(cvec_i(argv, 0));
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR); /* XXX: use incrementing sequence */
+    cprintf(cb, ">");
+    cprintf(cb, "<trace xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (slowest)
+        cprintf(cb, "<slowest>%s</slowest>", slowest);
+    cprintf(cb, "</trace>");
+    cprintf(cb, "</rpc>");
+    if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get trace");
+        goto done;
+    }
+    cligen_output(stdout, "%-8s %-20s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n",
+                  "Session", "RPC", "Total", "Parse", "NACM",
+                  "DsRead", "DsWrite", "State", "Reply", "BytesIn", "BytesOut");
+    if ((xp = xpath_first(xret, NULL, "rpc-reply")) != NULL &&
+        (xp = xml_find_type(xp, NULL, "traces", CX_ELMNT)) != NULL){
+        x = NULL;
+        while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(x), "trace") != 0)
+                continue;
+            if ((rpc = xml_find_body(x, "rpc")) == NULL)
+                rpc = "";
+            /* Missing values, eg from an older backend, are shown as - */
+            if ((val[0] = xml_find_body(x, "session-id")) == NULL)
+                val[0] = "-";
+            for (i=0; i<sizeof(fields)/sizeof(*fields); i++)
+                if ((val[i+1] = xml_find_body(x, fields[i])) == NULL)
+                    val[i+1] = "-";
+            cligen_output(stdout, "%-8s %-20s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n",
+                          val[0], rpc, val[1], val[2], val[3], val[4],
+                          val[5], val[6], val[7], val[8], val[9]);
         }
     }
     retval = 0;
@@ -0,0 +1,456 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Resident NETCONF daemon and per-session shim
+ * The daemon loads config, YANG and plugins once and listens on a UNIX socket.
+ * A shim started per SSH session passes its stdin and stdout over the socket
+ * (SCM_RIGHTS). The daemon forks a session process with the schema already loaded.
+ *
+ *   ssh --> shim (clixon_netconf -s <sock>) --fd 0,1--> daemon (clixon_netconf -S)
+ *                                                         |
+ *                                                         +--fork--> session
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pwd.h>
+#include <grp.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "netconf_daemon.h"
+
+/* Number of file descriptors passed from shim: stdin and stdout */
+#define NETCONF_DAEMON_NFD 2
+
+/* Max time in seconds for the session process to receive the shim message */
+#define NETCONF_DAEMON_RECV_TIMEOUT 10
+
+/*! Shim: pass stdin and stdout to resident daemon and wait for session to end
+ *
+ * Done before config and YANG is loaded to make session startup cheap.
+ * @param[in]  sockpath  UNIX socket path of daemon
+ * @retval     1         Session served by daemon and has ended
+ * @retval     0         Daemon not reachable, run session in this process
+ * @retval    -1         Error
+ */
+int
+netconf_daemon_shim(char *sockpath)
+{
+    int                retval = -1;
+    int                s = -1;
+    struct sockaddr_un addr = {0,};
+    struct msghdr      msg = {0,};
+    struct cmsghdr    *cmsg;
+    struct iovec       iov;
+    char               cbuf[CMSG_SPACE(NETCONF_DAEMON_NFD*sizeof(int))];
+    int                fds[NETCONF_DAEMON_NFD] = {0, 1};
+    char               c = 0;
+    ssize_t            n;
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)){
+        clixon_err(OE_UNIX, ENAMETOOLONG, "%s", sockpath);
+        goto done;
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockpath, sizeof(addr.sun_path)-1);
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0){
+        clixon_err(OE_UNIX, errno, "socket");
+        goto done;
+    }
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+        clixon_debug(CLIXON_DBG_NETCONF, "connect %s: %s, fallback", sockpath, strerror(errno));
+        retval = 0;
+        goto done;
+    }
+    /* At least one byte of data is needed to carry ancillary data on stream sockets */
+    iov.iov_base = &c;
+    iov.iov_len = 1;
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    if (sendmsg(s, &msg, 0) < 0){
+        clixon_err(OE_UNIX, errno, "sendmsg");
+        goto done;
+    }
+    /* The session owns stdin/stdout now, so that EOF is seen by ssh when it closes */
+    close(0);
+    close(1);
+    /* Block until session process closes the socket */
+    while ((n = read(s, &c, 1)) != 0){
+        if (n < 0 && errno != EINTR){
+            clixon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+    }
+    retval = 1;
+ done:
+    if (s != -1)
+        close(s);
+    return retval;
+}
+
+/*! Receive stdin and stdout of a shim on an accepted socket
+ *
+ * If the message is invalid, any file descriptors received are closed.
+ * @param[in]  s    Accepted socket
+ * @param[out] fds  Received file descriptors
+ * @retval     1    OK
+ * @retval     0    Invalid message, fds not set
+ * @retval    -1    Error
+ */
+static int
+netconf_daemon_recv(int  s,
+                    int *fds)
+{
+    struct msghdr   msg = {0,};
+    struct cmsghdr *cmsg;
+    struct iovec    iov;
+    char            cbuf[CMSG_SPACE(NETCONF_DAEMON_NFD*sizeof(int))];
+    char            c;
+    ssize_t         n;
+    int             nfd;
+    int             fd;
+    int             i;
+
+    iov.iov_base = &c;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    while ((n = recvmsg(s, &msg, 0)) < 0 && errno == EINTR)
+        ;
+    if (n < 0){
+        clixon_err(OE_UNIX, errno, "recvmsg");
+        return -1;
+    }
+    if (n == 0)
+        return 0;
+    if ((msg.msg_flags & MSG_CTRUNC) ||
+        (cmsg = CMSG_FIRSTHDR(&msg)) == NULL ||
+        cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(NETCONF_DAEMON_NFD*sizeof(int))){
+        /* Close descriptors of an invalid or truncated message */
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            nfd = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (i=0; i<nfd; i++){
+                memcpy(&fd, CMSG_DATA(cmsg) + i*sizeof(int), sizeof(int));
+                close(fd);
+            }
+        }
+        return 0;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), NETCONF_DAEMON_NFD*sizeof(int));
+    return 1;
+}
+
+/*! Get user of peer on UNIX socket
+ *
+ * @param[in]  s     Connected socket
+ * @param[out] uid   User id of peer
+ * @param[out] gid   Group id of peer
+ * @param[out] name  User name, free with free()
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_accept_client
+ */
+static int
+netconf_daemon_peer(int    s,
+                    uid_t *uid,
+                    gid_t *gid,
+                    char **name)
+{
+    int          retval = -1;
+#if defined(HAVE_SO_PEERCRED)
+    socklen_t    clen;
+    struct ucred cr = {0,};
+
+    clen = sizeof(cr);
+    if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &clen) < 0){
+        clixon_err(OE_UNIX, errno, "getsockopt");
+        goto done;
+    }
+    *uid = cr.uid;
+    *gid = cr.gid;
+#elif defined(HAVE_GETPEEREID)
+    if (getpeereid(s, uid, gid) < 0){
+        clixon_err(OE_UNIX, errno, "getpeereid");
+        goto done;
+    }
+#else
+#error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
+#endif
+    if (uid2name(*uid, name) < 0)
+        goto done;
+    if (*name == NULL){
+        clixon_err(OE_UNIX, ENOENT, "Peer user not found");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Run session process as user of peer
+ *
+ * If the daemon runs as root, set groups, group and user of the peer permanently.
+ * Otherwise, only a peer with the same user as the daemon is served.
+ * @param[in]  uid   User id of peer
+ * @param[in]  gid   Group id of peer
+ * @param[in]  name  User name of peer
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+netconf_daemon_setuser(uid_t uid,
+                       gid_t gid,
+                       char *name)
+{
+    int retval = -1;
+
+    if (geteuid() != 0){
+        if (uid != geteuid()){
+            clixon_err(OE_UNIX, EPERM, "Daemon not running as root cannot serve user %s", name);
+            goto done;
+        }
+        goto ok;
+    }
+    if (initgroups(name, gid) < 0){
+        clixon_err(OE_UNIX, errno, "initgroups(%s)", name);
+        goto done;
+    }
+    if (setgid(gid) < 0){
+        clixon_err(OE_UNIX, errno, "setgid(%u)", gid);
+        goto done;
+    }
+    if (setuid(uid) < 0){
+        clixon_err(OE_UNIX, errno, "setuid(%u)", uid);
+        goto done;
+    }
+    if (getuid() != uid || geteuid() != uid ||
+        getgid() != gid || getegid() != gid){
+        clixon_err(OE_UNIX, EPERM, "Non-matching uid/gid after setuid");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set up forked session process from accepted shim socket
+ *
+ * Receive stdin and stdout of the shim, make them stdin and stdout of this process and
+ * run as the user of the shim.
+ * Done in the session process so that a shim that does not send its message only
+ * blocks its own session.
+ * @param[in]  h   Clixon handle
+ * @param[in]  s   Accepted socket
+ * @retval     0   OK
+ * @retval    -1   Error, do not serve session
+ */
+static int
+netconf_daemon_session(clixon_handle h,
+                       int           s)
+{
+    int            retval = -1;
+    int            fds[NETCONF_DAEMON_NFD] = {-1, -1};
+    struct timeval tv = {NETCONF_DAEMON_RECV_TIMEOUT, 0};
+    char          *name = NULL;
+    uid_t          uid;
+    gid_t          gid;
+    int            i;
+    int            ret;
+
+    if (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0){
+        clixon_err(OE_UNIX, errno, "setsockopt SO_RCVTIMEO");
+        goto done;
+    }
+    if ((ret = netconf_daemon_recv(s, fds)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_PROTO, EINVAL, "Invalid shim message");
+        goto done;
+    }
+    if (netconf_daemon_peer(s, &uid, &gid, &name) < 0)
+        goto done;
+    if (netconf_daemon_setuser(uid, gid, name) < 0)
+        goto done;
+    if (dup2(fds[0], 0) < 0 || dup2(fds[1], 1) < 0){
+        clixon_err(OE_UNIX, errno, "dup2");
+        goto done;
+    }
+    if (clicon_username_set(h, name) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_NETCONF, "session %u user:%s", getpid(), name);
+    retval = 0;
+ done:
+    if (name)
+        free(name);
+    for (i=0; i<NETCONF_DAEMON_NFD; i++)
+        if (fds[i] > 1)
+            close(fds[i]);
+    return retval;
+}
+
+/*! Run as resident NETCONF daemon, return in forked session process
+ *
+ * Accept shims on the UNIX socket in a loop. For each shim, fork a session process
+ * where stdin and stdout are the ones of the shim, and which runs as the user of the
+ * peer. The daemon itself never returns unless on error or termination.
+ * The session process keeps the shim socket open until it exits.
+ * @param[in]  h         Clixon handle
+ * @param[in]  sockpath  UNIX socket path
+ * @retval     1         Returns in session process, continue with session
+ * @retval     0         Daemon terminated
+ * @retval    -1         Error
+ */
+int
+netconf_daemon_serve(clixon_handle h,
+                     char         *sockpath)
+{
+    int                retval = -1;
+    int                ss = -1;
+    int                s = -1;
+    struct sockaddr_un addr = {0,};
+    pid_t              pid;
+    char              *group;
+    gid_t              gid;
+    mode_t             old_mask;
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)){
+        clixon_err(OE_UNIX, ENAMETOOLONG, "%s", sockpath);
+        goto done;
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockpath, sizeof(addr.sun_path)-1);
+    if ((ss = socket(AF_UNIX, SOCK_STREAM, 0)) < 0){
+        clixon_err(OE_UNIX, errno, "socket");
+        goto done;
+    }
+    /* Users of CLICON_SOCK_GROUP may connect, as to the backend socket.
+     * The session runs as the peer user */
+    if ((group = clicon_sock_group(h)) == NULL){
+        clixon_err(OE_FATAL, 0, "clicon_sock_group option not set");
+        goto done;
+    }
+    if (group_name2gid(group, &gid) < 0)
+        goto done;
+    unlink(sockpath);
+    old_mask = umask(S_IRWXO | S_IXGRP | S_IXUSR);
+    if (bind(ss, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+        clixon_err(OE_UNIX, errno, "bind %s", sockpath);
+        umask(old_mask);
+        goto done;
+    }
+    umask(old_mask);
+    if (lchown(sockpath, -1, gid) < 0){
+        clixon_err(OE_UNIX, errno, "lchown(%s, %s)", sockpath, group);
+        goto done;
+    }
+    if (listen(ss, 64) < 0){
+        clixon_err(OE_UNIX, errno, "listen");
+        goto done;
+    }
+    /* Session processes are not waited for */
+    if (set_signal(SIGCHLD, SIG_IGN, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "Setting SIGCHLD signal");
+        goto done;
+    }
+    clixon_log(h, LOG_NOTICE, "%s: %u listening on %s", __PROGRAM__, getpid(), sockpath);
+    while (clixon_exit_get() == 0){
+        if ((s = accept(ss, NULL, NULL)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "accept");
+            goto done;
+        }
+        if ((pid = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            goto done;
+        }
+        if (pid == 0){ /* Session process */
+            close(ss);
+            ss = -1;
+            if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0){
+                clixon_err(OE_UNIX, errno, "Setting SIGCHLD signal");
+                goto done;
+            }
+            if (netconf_daemon_session(h, s) < 0)
+                goto done;
+            /* s is intentionally left open: closed on exit which releases the shim */
+            s = -1;
+            retval = 1;
+            goto done;
+        }
+        clixon_debug(CLIXON_DBG_NETCONF, "session process %u", pid);
+        close(s);
+        s = -1;
+    }
+    retval = 0;
+ done:
+    if (s != -1)
+        close(s);
+    if (ss != -1)
+        close(ss);
+    return retval;
+}
@@ -68,9 +68,10 @@
 
 //#include "clixon_netconf.h"
 #include "netconf_rpc.h"
+#include "netconf_daemon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:eo:"
+#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:es:So:"
 
 #define NETCONF_LOGFILE "/tmp/clixon_netconf.log"
 
@@ -652,6 +653,8 @@ usage(clixon_handle h,
             "\t-U <user>\tOver-ride unix user with a pseudo user for NACM.\n"
             "\t-t <sec>\tTimeout in seconds. Quit after this time.\n"
             "\t-e \t\tDont ignore errors on packet input.\n"
+            "\t-s <sock>\tShim: pass session to resident netconf daemon on UNIX socket, if running\n"
+            "\t-S \t\tRun as resident netconf daemon on CLICON_NETCONF_DAEMON_SOCK\n"
             "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
             argv0,
             clicon_netconf_dir(h)
@@ -687,6 +690,9 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int              print_version = 0;
     int32_t          d;
+    char            *shimsock = NULL;
+    int              resident = 0;
+    int              ret;
 
     /* Create handle */
     if ((h = clixon_handle_init()) == NULL)
@@ -744,6 +750,11 @@ main(int    argc,
             }
             logdst = d;
             break;
+        case 's': /* Shim to resident daemon */
+            if (!strlen(optarg))
+                usage(h, argv[0]);
+            shimsock = optarg;
+            break;
         }
     }
 
@@ -752,6 +763,17 @@ main(int    argc,
      */
     clixon_log_init(h, __PROGRAM__, dbg?LOG_DEBUG:LOG_INFO, logdst);
     clixon_debug_init(h, dbg);
+
+    /* Pass session to resident daemon before config and YANG is loaded,
+     * if not reachable, continue as a regular netconf process */
+    if (shimsock != NULL){
+        if ((ret = netconf_daemon_shim(shimsock)) != 0){
+            clixon_handle_exit(h);
+            clixon_err_exit();
+            clixon_log_exit();
+            return ret < 0 ? -1 : 0;
+        }
+    }
     yang_init(h);
 
     /* Find, read and parse configfile */
@@ -769,7 +791,11 @@ main(int    argc,
         case 'f' :  /* config file */
         case 'E' : /* extra config dir */
         case 'l' :  /* log  */
+        case 's' :  /* shim */
             break; /* see above */
+        case 'S' :  /* resident daemon */
+            resident++;
+            break;
         case 'C' : /* Explicitly dump configuration */
             if ((config_dump_format = format_str2int(optarg)) ==  (enum format_enum)-1){
                 fprintf(stderr, "Unrecognized dump format: %s(expected: xml|json|text)\n", argv[0]);
@@ -933,6 +959,19 @@ main(int    argc,
     /* Debug dump of config options */
     clicon_option_dump(h, CLIXON_DBG_INIT);
 
+    /* Resident daemon: returns in a forked session process with stdin/stdout
+     * and user of a shim */
+    if (resident){
+        if ((str = clicon_option_str(h, "CLICON_NETCONF_DAEMON_SOCK")) == NULL){
+            clixon_err(OE_CFG, EINVAL, "-S requires CLICON_NETCONF_DAEMON_SOCK");
+            goto done;
+        }
+        if ((ret = netconf_daemon_serve(h, str)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+
     /* Send hello request to backend to get session-id back
      * This is done once at the beginning of the session and then this is
      * used by the client, even though new TCP sessions are created for
@@ -70,7 +70,6 @@
 /* clixon */
 #include <clixon/clixon.h>
 
-#include "netconf_filter.h"
 #include "netconf_rpc.h"
 
 /*
@@ -79,33 +78,6 @@
     </rpc> 
  */
 
-static int
-netconf_get_config_subtree(clixon_handle h,
-                           cxobj        *xfilter,
-                           cxobj       **xret)
-{
-    int    retval = -1;
-    cxobj *xdata;
-
-    /* a subtree filter is comprised of zero or more element subtrees*/
-    if ((xdata = xpath_first(*xret, NULL, "/rpc-reply/data")) == NULL)
-        goto ok;
-    if (xml_filter(xfilter, xdata) < 0){
-        clixon_xml_parse_va(YB_NONE, NULL, xret, NULL, "<rpc-reply xmlns=\"%s\"><rpc-error>"
-                            "<error-tag>operation-failed</error-tag>"
-                            "<error-type>application</error-type>"
-                            "<error-severity>error</error-severity>"
-                            "<error-info>filtering</error-info>"
-                            "</rpc-error></rpc-reply>",
-                            NETCONF_BASE_NAMESPACE
-                            );
-    }
-ok:
-    retval = 0;
-    // done:
-    return retval;
-}
-
 /*! Get configuration
  *
  * @param[in]  h       Clixon handle
@@ -113,8 +85,7 @@ ok:
  * @param[out] xret    Return XML, error or OK
  * @retval     0       OK
  * @retval    -1       Error
- * @note filter type subtree and xpath is supported, but xpath is preferred, and
- *              better performance and tested. Please use xpath.
+ * @note filter type subtree and xpath is supported, both are evaluated in the backend
  *
  *     <get-config> 
  *       <source> 
@@ -179,18 +150,11 @@ netconf_get_config(clixon_handle h,
      /* ie <filter>...</filter> */
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
-    if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config first, then filter. This is suboptimal
-         */
+    /* Subtree filters are applied by the backend */
+    if (xfilter == NULL || ftype == NULL ||
+        strcmp(ftype, "subtree") == 0 || strcmp(ftype, "xpath") == 0) {
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
-        /* Now filter on whole tree */
-        if (netconf_get_config_subtree(h, xfilter, xret) < 0)
-            goto done;
-    } else if (strcmp(ftype, "xpath") == 0) {
-        if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0) {
-            goto done;
-        }
     } else {
         clixon_xml_parse_va(YB_NONE, NULL, xret, NULL, "<rpc-reply xmlns=\"%s\"><rpc-error>"
                                                        "<error-tag>operation-failed</error-tag>"
@@ -363,8 +327,7 @@ netconf_edit_config(clixon_handle h,
  * @param[out] xret    Return XML, error or OK
  * @retval     0       OK
  * @retval    -1       Error
- * @note filter type subtree and xpath is supported, but xpath is preferred, and
- *              better performance and tested. Please use xpath.
+ * @note filter type subtree and xpath is supported, both are evaluated in the backend
  *
  * @example
  *    <rpc><get><filter type="xpath" select="//SenderTwampIpv4"/>
@@ -392,15 +355,9 @@ netconf_get(clixon_handle h,
        /* ie <filter>...</filter> */
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
-    if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config + state first, then filter. This is suboptimal
-         */
-        if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
-            goto done;
-        /* Now filter on whole tree */
-        if (netconf_get_config_subtree(h, xfilter, xret) < 0)
-            goto done;
-    } else if (strcmp(ftype, "xpath") == 0) {
+    /* Subtree filters are applied by the backend */
+    if (xfilter == NULL || ftype == NULL ||
+        strcmp(ftype, "subtree") == 0 || strcmp(ftype, "xpath") == 0) {
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
     } else {
@@ -420,6 +377,67 @@ netconf_get(clixon_handle h,
     return retval;
 }
 
+/*! Send batched notifications to client on stdout
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_STREAM_BATCH_DELAY
+ */
+static int
+netconf_notification_batch_send(clixon_handle h)
+{
+    int             retval = -1;
+    cbuf           *cb = NULL;
+    struct timeval *t0 = NULL;
+
+    if (clicon_ptr_get(h, "netconf-notification-batch-time", (void**)&t0) == 0 && t0 != NULL){
+        clicon_ptr_del(h, "netconf-notification-batch-time");
+        free(t0);
+    }
+    if (clicon_ptr_get(h, "netconf-notification-batch", (void**)&cb) < 0 || cb == NULL)
+        goto ok;
+    clicon_ptr_del(h, "netconf-notification-batch");
+    if (netconf_output(1, cb, "notification") < 0){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+        goto done;
+    }
+    fflush(stdout);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+static int netconf_notification_cb(int s, void *arg);
+
+/*! Timeout of notification batch, send batched notifications
+ *
+ * A failure to send closes the notification socket of the batch, not the session
+ * @param[in]  s    Ignored
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ */
+static int
+netconf_notification_batch_timeout(int   s,
+                                   void *arg)
+{
+    clixon_handle h = (clixon_handle)arg;
+    int           sn;
+
+    if (netconf_notification_batch_send(h) < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        if ((sn = clicon_data_int_get(h, "netconf-notification-batch-socket")) >= 0){
+            clixon_event_unreg_fd(sn, netconf_notification_cb);
+            close(sn);
+        }
+    }
+    return 0;
+}
+
 /*! Called when a notification has happened on backend
  *
  * and this session has registered for that event.
@@ -458,6 +476,11 @@ netconf_notification_cb(int   s,
     int           ret;
     cxobj        *xerr = NULL;
     cbuf         *cbmsg = NULL;
+    cbuf         *cbb = NULL; /* batch */
+    int           delay;
+    struct timeval t;
+    struct timeval t1;
+    struct timeval *t0 = NULL;  /* time of first event in batch */
 
     clixon_debug(CLIXON_DBG_NETCONF, "");
     yspec = clicon_dbspec_yang(h);
@@ -465,6 +488,12 @@ netconf_notification_cb(int   s,
         goto done;
     /* handle close from remote end: this will exit the client */
     if (eof){
+        /* Send notifications received before close */
+        clixon_event_unreg_timeout(netconf_notification_batch_timeout, h);
+        if (netconf_notification_batch_send(h) < 0){
+            clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+            clixon_err_reset();
+        }
         clixon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
         close(s);
         errno = ESHUTDOWN;
@@ -488,18 +517,58 @@ netconf_notification_cb(int   s,
     }
     if (clixon_xml2cbuf(cb, xn, 0, 0, NULL, -1, 0) < 0)
         goto done;
-    /* Send it to listening client on stdout */
     if (netconf_output_encap(clicon_data_int_get(h, NETCONF_FRAMING_TYPE), cb) < 0){
         goto done;
     }
-    if (netconf_output(1, cb, "notification") < 0){
-        clixon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+    /* Append framed message to batch, messages are kept in order */
+    delay = clicon_option_int(h, "CLICON_STREAM_BATCH_DELAY");
+    if (clicon_ptr_get(h, "netconf-notification-batch", (void**)&cbb) < 0 || cbb == NULL){
+        if (clicon_ptr_set(h, "netconf-notification-batch", cb) < 0)
+            goto done;
+        clicon_data_int_set(h, "netconf-notification-batch-socket", s);
+        cbb = cb;
+        cb = NULL;
+        if (delay > 0){
+            if ((t0 = malloc(sizeof(*t0))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            gettimeofday(t0, NULL);
+            if (clicon_ptr_set(h, "netconf-notification-batch-time", t0) < 0){
+                free(t0);
+                goto done;
+            }
+            t1.tv_sec = delay/1000;
+            t1.tv_usec = (delay%1000)*1000;
+            timeradd(t0, &t1, &t);
+            if (clixon_event_reg_timeout(t, netconf_notification_batch_timeout, h,
+                                         "notification batch") < 0)
+                goto done;
+        }
+    }
+    else if (cbuf_append_buf(cbb, cbuf_get(cb), cbuf_len(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    /* Send when batch delay expires, unless no delay or batch is full.
+     * The timeout is not run while events keep arriving, so also check the delay here */
+    if (delay > 0 &&
+        cbuf_len(cbb) < clicon_option_int(h, "CLICON_STREAM_BATCH_SIZE")){
+        if (clicon_ptr_get(h, "netconf-notification-batch-time", (void**)&t0) < 0 || t0 == NULL)
+            goto ok;
+        gettimeofday(&t, NULL);
+        timersub(&t, t0, &t1);
+        if (t1.tv_sec*1000 + t1.tv_usec/1000 < delay)
+            goto ok;
+    }
+    clixon_event_unreg_timeout(netconf_notification_batch_timeout, h);
+    /* Send it to listening client on stdout */
+    if (netconf_notification_batch_send(h) < 0){
         close(s);
         errno = ESHUTDOWN;
         clixon_event_unreg_fd(s, netconf_notification_cb);
         goto done;
     }
-    fflush(stdout);
  ok:
     retval = 0;
  done:
@@ -46,6 +46,9 @@ int restconf_reply_header(void *req, const char *name, const char *vfmt, ...)  _
 /* note cb is consumed dont free */
 int restconf_reply_send(void *req, int code, cbuf *cb, int head);
 
+/* xt is not consumed, JSON body is streamed */
+int restconf_reply_send_json(void *req, int code, cxobj *xt, int pretty);
+
 cbuf *restconf_get_indata(void *req);
 
 #endif /* _RESTCONF_API_H_ */
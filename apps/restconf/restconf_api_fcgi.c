@@ -229,6 +229,64 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! JSON sink writing to the fastcgi output stream
+ *
+ * @param[in]  arg  Fastcgi request handle
+ * @param[in]  buf  JSON chunk
+ * @param[in]  len  Length of chunk
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+fcgi_json_sink(void  *arg,
+               char  *buf,
+               size_t len)
+{
+    FCGX_Request *req = (FCGX_Request *)arg;
+
+    if (FCGX_PutStr(buf, len, req->out) < 0){
+        clixon_err(OE_RESTCONF, errno, "FCGX_PutStr");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Reply with an XML tree encoded as JSON
+ *
+ * The JSON body is not built in memory first but streamed with clixon_json2sink
+ * @param[in]  req     Fastcgi request handle
+ * @param[in]  code    Status code
+ * @param[in]  xt      XML tree, top object is skipped
+ * @param[in]  pretty  Set if output is pretty-printed
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see restconf_reply_send
+ */
+int
+restconf_reply_send_json(void  *req0,
+                         int    code,
+                         cxobj *xt,
+                         int    pretty)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+    int           retval = -1;
+    const char   *reason_phrase;
+
+    FCGX_SetExitStatus(code, req->out);
+    if ((reason_phrase = restconf_code2reason(code)) == NULL)
+        reason_phrase="";
+    if (restconf_reply_header(req, "Status", "%d %s", code, reason_phrase) < 0)
+        goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    if (clixon_json2sink(xt, pretty, 0, 0, 0, fcgi_json_sink, req) < 0)
+        goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    FCGX_FFlush(req->out);
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Fastcgi request handle
@@ -63,6 +63,9 @@
 #include "restconf_lib.h"
 #include "restconf_api.h"  /* Virtual api */
 #include "restconf_native.h"
+#ifdef HAVE_HTTP1
+#include "restconf_http1.h"
+#endif
 
 /*! Add HTTP header field name and value to reply
  *
@@ -185,6 +188,147 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! JSON sink appending to a reply body
+ *
+ * @param[in]  arg  Body as cbuf
+ * @param[in]  buf  JSON chunk
+ * @param[in]  len  Length of chunk
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+native_json_body_sink(void  *arg,
+                      char  *buf,
+                      size_t len)
+{
+    cbuf *cb = (cbuf *)arg;
+
+    if (cbuf_append_buf(cb, buf, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef HAVE_HTTP1
+/*! JSON sink writing a HTTP/1.1 chunk directly to the socket
+ *
+ * If the peer has closed, remaining chunks are dropped and the connection is closed
+ * after the request
+ * @param[in]  arg  Restconf stream data
+ * @param[in]  buf  JSON chunk
+ * @param[in]  len  Length of chunk
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+native_json_chunk_sink(void  *arg,
+                       char  *buf,
+                       size_t len)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)arg;
+    restconf_conn        *rc = sd->sd_conn;
+    char                  size[32];
+    int                   ret;
+
+    if (len == 0 || rc->rc_exit)
+        return 0;
+    snprintf(size, sizeof(size), "%zx\r\n", len);
+    if ((ret = native_buf_write(rc->rc_h, size, strlen(size), rc, __FUNCTION__)) < 0)
+        return -1;
+    if (ret == 1 &&
+        (ret = native_buf_write(rc->rc_h, buf, len, rc, __FUNCTION__)) < 0)
+        return -1;
+    if (ret == 1 &&
+        (ret = native_buf_write(rc->rc_h, "\r\n", 2, rc, __FUNCTION__)) < 0)
+        return -1;
+    if (ret == 0)
+        rc->rc_exit = 1;
+    return 0;
+}
+#endif /* HAVE_HTTP1 */
+
+/*! Reply with an XML tree encoded as JSON
+ *
+ * The JSON body is not built in memory first but streamed with clixon_json2sink.
+ * On HTTP/1.1 the headers are sent directly and the body is written to the socket as
+ * chunks using chunked transfer-encoding. Otherwise the chunks are appended to the reply
+ * body, eg to be read by the HTTP/2 data provider.
+ * @param[in]  req     http request handle
+ * @param[in]  code    Status code
+ * @param[in]  xt      XML tree, top object is skipped
+ * @param[in]  pretty  Set if output is pretty-printed
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see restconf_reply_send
+ */
+int
+restconf_reply_send_json(void  *req0,
+                         int    code,
+                         cxobj *xt,
+                         int    pretty)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+    cbuf                 *cb = NULL;
+#ifdef HAVE_HTTP1
+    restconf_conn        *rc;
+    int                   ret;
+#endif
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "code:%d", code);
+    if (sd == NULL){
+        clixon_err(OE_CFG, EINVAL, "sd is NULL");
+        goto done;
+    }
+#ifdef HAVE_HTTP1
+    rc = sd->sd_conn;
+    if (rc->rc_proto == HTTP_11){
+        sd->sd_code = code;
+        sd->sd_body_len = 0;
+        if (restconf_reply_header(sd, "Transfer-Encoding", "chunked") < 0)
+            goto done;
+        if (restconf_http1_reply(rc, sd) < 0)
+            goto done;
+        ret = native_buf_write(rc->rc_h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
+                               rc, __FUNCTION__);
+        cvec_reset(sd->sd_outp_hdrs);
+        cbuf_reset(sd->sd_outp_buf);
+        sd->sd_code = 0; /* Reply is sent */
+        if (ret < 0)
+            goto done;
+        if (ret == 0){
+            rc->rc_exit = 1;
+            goto ok;
+        }
+        if (clixon_json2sink(xt, pretty, 0, 0, 0, native_json_chunk_sink, sd) < 0)
+            goto done;
+        /* Last chunk */
+        if (!rc->rc_exit &&
+            (ret = native_buf_write(rc->rc_h, "0\r\n\r\n", 5, rc, __FUNCTION__)) < 0)
+            goto done;
+        if (ret == 0)
+            rc->rc_exit = 1;
+        goto ok;
+    }
+#endif /* HAVE_HTTP1 */
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_json2sink(xt, pretty, 0, 0, 0, native_json_body_sink, cb) < 0)
+        goto done;
+    if (restconf_reply_send(sd, code, cb, 0) < 0)
+        goto done;
+    cb = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Request handle
@@ -295,8 +295,14 @@ http1_upgrade_http2(clixon_handle         h,
 #endif /* HAVE_LIBNGHTTP2 */
 
 /*! Construct an HTTP/1 reply (dont actually send it)
+ *
+ * @param[in]  rc   Restconf connection
+ * @param[in]  sd   Restconf stream data (for http1 only stream 0)
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @note No Content-Length if a Transfer-Encoding header is set, body is then sent separately
  */
-static int
+int
 restconf_http1_reply(restconf_conn        *rc,
                      restconf_stream_data *sd)
 {
@@ -311,7 +317,8 @@ restconf_http1_reply(restconf_conn        *rc,
      * (Successful) response to a CONNECT request (Section 4.3.6 of
      * [RFC7231]).
      */
-    if (sd->sd_code != 204 && sd->sd_code > 199 && !rc->rc_event_stream)
+    if (sd->sd_code != 204 && sd->sd_code > 199 && !rc->rc_event_stream &&
+        cvec_find(sd->sd_outp_hdrs, "Transfer-Encoding") == NULL)
         if (restconf_reply_header(sd, "Content-Length", "%zu", sd->sd_body_len) < 0)
             goto done;
     /* Create reply and write headers */
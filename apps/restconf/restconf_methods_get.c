@@ -226,6 +226,16 @@ api_data_get2(clixon_handle  h,
         goto ok;
     }
     /* Normal return, no error */
+    if ((xpath==NULL || strcmp(xpath,"/")==0) &&
+        media_out == YANG_DATA_JSON && !head){ /* Data root as JSON: stream body */
+        if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+            goto done;
+        if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+            goto done;
+        if (restconf_reply_send_json(req, 200, xret, pretty) < 0)
+            goto done;
+        goto ok;
+    }
     if ((cbx = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -172,6 +172,7 @@ restconf_stream_free(restconf_stream_data *sd)
         free(sd->sd_settings2);
     if (sd->sd_qvec)
         cvec_free(sd->sd_qvec);
+    stream_batch_free(sd);
     free(sd);
     return 0;
 }
@@ -92,6 +92,8 @@ typedef struct  {
     void                 *sd_req;       /* Lib-specific request */
     int                   sd_upgrade2;  /* Upgrade to http/2 */
     uint8_t              *sd_settings2; /* Settings for upgrade to http/2 request */
+    cbuf                 *sd_batch;     /* Notifications not yet sent, see CLICON_STREAM_BATCH_DELAY */
+    struct timeval        sd_batch_t;   /* Time of first notification in sd_batch */
 } restconf_stream_data;
 
 typedef struct restconf_socket restconf_socket;
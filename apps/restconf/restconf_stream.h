@@ -45,6 +45,7 @@ int restconf_subscription(clixon_handle h, void *req, char *name, cvec *qvec, in
 int api_stream(clixon_handle h, void *req, cvec *qvec, int timeout, int *finish);
 int stream_sockets_setup(clixon_handle h, void *req, int timeout, int besock, int *finish);
 int stream_close(clixon_handle h, void *req); // only native
+int stream_batch_free(void *req); // only native
 int stream_child_free(clixon_handle h, int pid); // only fcgi
 int stream_child_freeall(clixon_handle h); // only fcgi
 
@@ -118,6 +118,107 @@ restconf_http2_send_notification(clixon_handle         h,
 }
 #endif // NGHTTP2
 
+/*! Send batched notifications to client
+ *
+ * @param[in]  sd   Restconf stream data
+ * @retval     1    OK
+ * @retval     0    OK, but socket write returned error, caller should close rc
+ * @retval    -1    Error
+ */
+static int
+stream_native_batch_send(restconf_stream_data *sd)
+{
+    int            retval = -1;
+    restconf_conn *rc = sd->sd_conn;
+    clixon_handle  h = rc->rc_h;
+    cbuf          *cb;
+    int            ret;
+#ifdef HAVE_LIBNGHTTP2
+    nghttp2_error  ngerr;
+#endif
+
+    if ((cb = sd->sd_batch) == NULL)
+        goto ok;
+    sd->sd_batch = NULL;
+#ifdef HAVE_LIBNGHTTP2
+    if (rc->rc_proto == HTTP_2){
+        if (restconf_reply_send(sd, 200, cb, 0) < 0)
+            goto done;
+        if (restconf_http2_send_notification(h, sd, rc) < 0)
+            goto done;
+        if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0)
+            goto done;
+        if (sd->sd_body){
+            cbuf_free(sd->sd_body);
+            sd->sd_body = NULL;
+        }
+    }
+    else
+#endif // HAVE_LIBNGHTTP2
+    {
+        ret = native_buf_write(h, cbuf_get(cb), cbuf_len(cb), rc, "native stream");
+        cbuf_free(cb);
+        if (ret < 0)
+            goto done;
+        if (ret == 0)
+            goto closed;
+    }
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
+
+/*! Timeout of notification batch, send batched notifications
+ *
+ * A failure to send closes the connection of this stream only
+ * @param[in]  s    Ignored
+ * @param[in]  arg  Restconf stream data
+ * @retval     0    OK
+ * @see CLICON_STREAM_BATCH_DELAY
+ */
+static int
+stream_native_batch_timeout(int   s,
+                            void *arg)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)arg;
+    restconf_conn        *rc = sd->sd_conn;
+    clixon_handle         h = rc->rc_h;
+    int                   ret;
+
+    if ((ret = stream_native_batch_send(sd)) < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+    }
+    if (ret < 1 &&
+        restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+    }
+    return 0;
+}
+
+/*! Free notifications not yet sent
+ *
+ * @param[in]  req  Restconf stream data
+ * @retval     0    OK
+ */
+int
+stream_batch_free(void *req)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req;
+
+    if (sd->sd_batch){
+        clixon_event_unreg_timeout(stream_native_batch_timeout, sd);
+        cbuf_free(sd->sd_batch);
+        sd->sd_batch = NULL;
+    }
+    return 0;
+}
+
 /*! Callback when stream notifications arrive from backend
  *
  * @param[in]  s    Socket
@@ -142,9 +243,9 @@ stream_native_backend_cb(int   s,
     int                   ret;
     restconf_conn        *rc = sd->sd_conn;
     clixon_handle         h = rc->rc_h;
-#ifdef HAVE_LIBNGHTTP2
-    nghttp2_error         ngerr;
-#endif
+    int                   delay;
+    struct timeval        t;
+    struct timeval        t1;
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
     pretty = restconf_pretty_get(h);
@@ -154,6 +255,14 @@ stream_native_backend_cb(int   s,
     /* handle close from remote end: this will exit the client */
     if (eof){
         clixon_debug(CLIXON_DBG_STREAM, "eof");
+        if (sd->sd_batch){
+            clixon_event_unreg_timeout(stream_native_batch_timeout, sd);
+            /* Socket is closed below also if send fails */
+            if (stream_native_batch_send(sd) < 0){
+                clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+                clixon_err_reset();
+            }
+        }
         restconf_close_ssl_socket(rc, __FUNCTION__, 0);
         goto ok;
     }
@@ -179,24 +288,41 @@ stream_native_backend_cb(int   s,
         goto done;
     cprintf(cb, "\r\n");
     cprintf(cb, "\r\n");
-#ifdef HAVE_LIBNGHTTP2
-    if (rc->rc_proto == HTTP_2){
-        if (restconf_reply_send(sd, 200, cb, 0) < 0)
-            goto done;
+    /* Append event to batch, events are kept in order */
+    delay = clicon_option_int(h, "CLICON_STREAM_BATCH_DELAY");
+    if (sd->sd_batch == NULL){
+        sd->sd_batch = cb;
         cb = NULL;
-        if (restconf_http2_send_notification(h, sd, rc) < 0)
-            goto done;
-        if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0)
-            goto done;
-        if (sd->sd_body){
-            cbuf_free(sd->sd_body);
-            sd->sd_body = NULL;
+        gettimeofday(&sd->sd_batch_t, NULL);
+        if (delay > 0){
+            t1.tv_sec = delay/1000;
+            t1.tv_usec = (delay%1000)*1000;
+            timeradd(&sd->sd_batch_t, &t1, &t);
+            if (clixon_event_reg_timeout(t, stream_native_batch_timeout, sd,
+                                         "stream notification batch") < 0)
+                goto done;
         }
     }
-    else
-#endif // HAVE_LIBNGHTTP2
-        if ((ret = native_buf_write(h, cbuf_get(cb), cbuf_len(cb), rc, "native stream")) < 0)
+    else if (cbuf_append_buf(sd->sd_batch, cbuf_get(cb), cbuf_len(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    /* Send when batch delay expires, unless no delay or batch is full.
+     * The timeout is not run while events keep arriving, so also check the delay here */
+    if (delay > 0 &&
+        cbuf_len(sd->sd_batch) < clicon_option_int(h, "CLICON_STREAM_BATCH_SIZE")){
+        gettimeofday(&t, NULL);
+        timersub(&t, &sd->sd_batch_t, &t1);
+        if (t1.tv_sec*1000 + t1.tv_usec/1000 < delay)
+            goto ok;
+    }
+    clixon_event_unreg_timeout(stream_native_batch_timeout, sd);
+    if ((ret = stream_native_batch_send(sd)) < 0)
         goto done;
+    if (ret == 0){
+        restconf_close_ssl_socket(rc, __FUNCTION__, 0);
+        goto ok;
+    }
  ok:
     retval = 0;
  done:
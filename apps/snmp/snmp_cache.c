@@ -0,0 +1,1047 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2022 Olof Hagsand and Kristofer Hallin
+  Sponsored by Siklu Communications LTD
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * SNMP table cache
+ * A table is read from the backend with one get of the whole table and kept until it
+ * is invalid. The columns of all rows are sorted on OID, so that a GETNEXT is a binary
+ * search. GETBULK is translated to successive GETNEXTs by net-snmp, which are all
+ * answered from the same read.
+ * Rows are also indexed on index OID, so that a GET or SET of any column is a direct
+ * lookup, and all varbinds of a multi-varbind GET are answered from the same read.
+ * Column OIDs and the RowStatus column are computed once when the table is registered.
+ * A table may also be read asynchronously on a separate socket to the backend, so that
+ * other SNMP requests are served while the read is in progress. Callers waiting for the
+ * read are called when the reply arrives. Scalars are read on the same socket, see
+ * snmp_cache_get_async.
+ * A cached table is invalid if:
+ * - running has changed. Changes are notified by an on-change push subscription of all
+ *   config tables, and by SET commits of clixon_snmp itself.
+ * - it has state data, and is older than CLICON_SNMP_CACHE_TTL
+ * If the subscription cannot be made, all tables are invalid after CLICON_SNMP_CACHE_TTL.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* net-snmp */
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "snmp_lib.h"
+#include "snmp_cache.h"
+
+/*! Column of a table with OID from YANG smiv2:oid
+ */
+struct snmp_cache_ycol {
+    yang_stmt *cy_ys;               /* Column leaf */
+    oid        cy_oid[MAX_OID_LEN]; /* Column OID */
+    size_t     cy_oidlen;
+};
+
+/*! Row of a cached table
+ */
+struct snmp_cache_row {
+    oid    *cr_oid;    /* Index OID */
+    size_t  cr_oidlen; /* Length of cr_oid */
+    cxobj  *cr_xrow;   /* List entry in cached XML */
+};
+
+/*! Caller waiting for a read of a table
+ */
+struct snmp_cache_wait {
+    qelem_t             cw_q;   /* queue header */
+    snmp_cache_read_cb *cw_fn;  /* Called when read is done */
+    void               *cw_arg; /* Argument to cw_fn */
+};
+
+/*! Cached table
+ */
+struct snmp_table_cache {
+    qelem_t                 tc_q;      /* queue header */
+    yang_stmt              *tc_ylist;  /* YANG list of table */
+    char                   *tc_xpath;  /* XPath of table container */
+    cvec                   *tc_nsc;    /* Namespace context of xpath */
+    int                     tc_state;  /* Table has state data */
+    struct snmp_cache_ycol *tc_ycols;  /* Columns with OID */
+    int                     tc_nycols; /* Length of tc_ycols */
+    yang_stmt              *tc_yrowst; /* RowStatus column, if any */
+    yang_stmt              *tc_yrowst_restype; /* Resolved type of RowStatus column */
+    cxobj                  *tc_xml;    /* Reply of get of table, NULL if not read */
+    struct snmp_cache_col  *tc_vec;    /* Columns of all rows, sorted on OID */
+    size_t                  tc_len;    /* Length of tc_vec */
+    struct snmp_cache_row  *tc_rows;   /* Rows, sorted on index OID */
+    size_t                  tc_nrows;  /* Length of tc_rows */
+    struct timeval          tc_time;   /* Time of read */
+    uint64_t                tc_gen;    /* Change generation at read */
+    int                     tc_reading; /* Asynchronous read in progress */
+    struct snmp_cache_wait *tc_waits;  /* Callers waiting for read */
+};
+
+/*! Outstanding asynchronous read, replies come in the order of requests
+ */
+struct snmp_cache_read {
+    qelem_t            rd_q;   /* queue header */
+    snmp_table_cache  *rd_tc;  /* Table read, or NULL if other get */
+    uint64_t           rd_gen; /* Change generation when requested */
+    snmp_cache_get_cb *rd_fn;  /* Called with reply if not table read */
+    void              *rd_arg; /* Argument to rd_fn */
+};
+
+/* Cached tables */
+static snmp_table_cache *_table_cache = NULL;
+
+/* Change generation, incremented when running changes */
+static uint64_t _cache_gen = 0;
+
+/* Socket of on-change subscription, -1 if none */
+static int _cache_socket = -1;
+
+/* Socket of asynchronous reads, -1 if not connected */
+static int _read_socket = -1;
+
+/* Outstanding asynchronous reads in order of request */
+static struct snmp_cache_read *_reads = NULL;
+
+/* Table whose waiting callers are being called, its read is valid for them */
+static snmp_table_cache *_serving = NULL;
+
+static int snmp_cache_reply_cb(int s, void *arg);
+
+/*! Free read data of cached table
+ */
+static int
+table_cache_clear(snmp_table_cache *tc)
+{
+    size_t i;
+
+    if (tc->tc_vec){
+        for (i=0; i<tc->tc_len; i++)
+            free(tc->tc_vec[i].cc_oid);
+        free(tc->tc_vec);
+        tc->tc_vec = NULL;
+    }
+    tc->tc_len = 0;
+    if (tc->tc_rows){
+        for (i=0; i<tc->tc_nrows; i++)
+            free(tc->tc_rows[i].cr_oid);
+        free(tc->tc_rows);
+        tc->tc_rows = NULL;
+    }
+    tc->tc_nrows = 0;
+    if (tc->tc_xml){
+        xml_free(tc->tc_xml);
+        tc->tc_xml = NULL;
+    }
+    return 0;
+}
+
+/*! Find cached table of YANG list
+ */
+static snmp_table_cache *
+table_cache_find(yang_stmt *ylist)
+{
+    snmp_table_cache *tc;
+
+    if ((tc = _table_cache) != NULL)
+        do {
+            if (tc->tc_ylist == ylist)
+                return tc;
+            tc = NEXTQ(snmp_table_cache *, tc);
+        } while (tc != _table_cache);
+    return NULL;
+}
+
+/*! Add table to cache, table is read on first access
+ *
+ * Column OIDs of the table are computed once here
+ * @param[in]  h      Clixon handle
+ * @param[in]  ylist  YANG list of table, parent is table container
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+snmp_table_cache_add(clixon_handle h,
+                     yang_stmt    *ylist)
+{
+    int                     retval = -1;
+    snmp_table_cache       *tc = NULL;
+    struct snmp_cache_ycol *cy;
+    yang_stmt              *ys;
+    yang_stmt              *yc;
+    yang_stmt              *yrestype;
+    char                   *origtype = NULL;
+    int                     inext;
+    int                     ret;
+
+    if (table_cache_find(ylist) != NULL)
+        goto ok;
+    if ((ys = yang_parent_get(ylist)) == NULL ||
+        yang_keyword_get(ys) != Y_CONTAINER){
+        clixon_err(OE_YANG, EINVAL, "ylist parent is not list");
+        goto done;
+    }
+    if ((tc = calloc(1, sizeof(*tc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    tc->tc_ylist = ylist;
+    if (xml_nsctx_yang(ys, &tc->tc_nsc) < 0)
+        goto done;
+    if (snmp_yang2xpath(ys, NULL, &tc->tc_xpath) < 0)
+        goto done;
+    tc->tc_state = !yang_config_ancestor(ylist);
+    inext = 0;
+    while ((yc = yn_iter(ylist, &inext)) != NULL) {
+        if (yang_keyword_get(yc) != Y_LEAF)
+            continue;
+        if ((tc->tc_ycols = realloc(tc->tc_ycols, (tc->tc_nycols+1)*sizeof(*cy))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        cy = &tc->tc_ycols[tc->tc_nycols];
+        cy->cy_oidlen = MAX_OID_LEN;
+        if ((ret = yangext_oid_get(yc, cy->cy_oid, &cy->cy_oidlen, NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        cy->cy_ys = yc;
+        tc->tc_nycols++;
+        if (yang_config(yc) == 0)
+            tc->tc_state = 1;
+        yrestype = NULL;
+        if (snmp_yang_type_get(yc, NULL, &origtype, &yrestype, NULL) < 0)
+            goto done;
+        if (origtype && strcmp(origtype, "RowStatus") == 0){
+            tc->tc_yrowst = yc;
+            tc->tc_yrowst_restype = yrestype;
+        }
+        if (origtype){
+            free(origtype);
+            origtype = NULL;
+        }
+    }
+    ADDQ(tc, _table_cache);
+    tc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (origtype)
+        free(origtype);
+    if (tc){
+        if (tc->tc_nsc)
+            xml_nsctx_free(tc->tc_nsc);
+        if (tc->tc_xpath)
+            free(tc->tc_xpath);
+        if (tc->tc_ycols)
+            free(tc->tc_ycols);
+        free(tc);
+    }
+    return retval;
+}
+
+/*! Compare cached columns on OID, for sorting
+ */
+static int
+cache_col_cmp(const void *a,
+              const void *b)
+{
+    const struct snmp_cache_col *ca = (const struct snmp_cache_col *)a;
+    const struct snmp_cache_col *cb = (const struct snmp_cache_col *)b;
+
+    return oid_eq(ca->cc_oid, ca->cc_oidlen, cb->cc_oid, cb->cc_oidlen);
+}
+
+/*! Compare cached rows on index OID, for sorting and search
+ */
+static int
+cache_row_cmp(const void *a,
+              const void *b)
+{
+    const struct snmp_cache_row *ra = (const struct snmp_cache_row *)a;
+    const struct snmp_cache_row *rb = (const struct snmp_cache_row *)b;
+
+    return oid_eq(ra->cr_oid, ra->cr_oidlen, rb->cr_oid, rb->cr_oidlen);
+}
+
+/*! Build OID-sorted column and row vectors of read table
+ *
+ * @param[in]  tc     Cached table
+ * @param[in]  xtable Table container in read XML
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+table_cache_build(snmp_table_cache *tc,
+                  cxobj            *xtable)
+{
+    int                    retval = -1;
+    cvec                  *cvk_name;
+    cxobj                 *xrow;
+    cxobj                 *xcol;
+    yang_stmt             *ycol;
+    struct snmp_cache_col *cc;
+    struct snmp_cache_row *cr;
+    oid                    oidk[MAX_OID_LEN] = {0,}; /* Key oid */
+    size_t                 oidklen;
+    size_t                 n = 0;
+    size_t                 nrows = 0;
+    int                    i;
+    int                    ret;
+
+    if ((cvk_name = yang_cvec_get(tc->tc_ylist)) == NULL){
+        clixon_err(OE_YANG, 0, "No keys");
+        goto done;
+    }
+    xrow = NULL;
+    while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL){
+        n += xml_child_nr_type(xrow, CX_ELMNT);
+        nrows++;
+    }
+    if (nrows == 0)
+        goto ok;
+    if ((tc->tc_rows = calloc(nrows, sizeof(*tc->tc_rows))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (n && (tc->tc_vec = calloc(n, sizeof(*tc->tc_vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xrow = NULL;
+    while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL) {
+        /* Get key part of OID from XML list entry */
+        oidklen = MAX_OID_LEN;
+        if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, oidk, &oidklen)) < 0)
+            goto done;
+        if (ret == 0)
+            continue; /* skip row, not all indexes */
+        cr = &tc->tc_rows[tc->tc_nrows];
+        if ((cr->cr_oid = malloc(oidklen*sizeof(oid))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memcpy(cr->cr_oid, oidk, oidklen*sizeof(oid));
+        cr->cr_oidlen = oidklen;
+        cr->cr_xrow = xrow;
+        tc->tc_nrows++;
+        xcol = NULL;
+        while ((xcol = xml_child_each(xrow, xcol, CX_ELMNT)) != NULL) {
+            if ((ycol = xml_spec(xcol)) == NULL)
+                continue;
+            for (i=0; i<tc->tc_nycols; i++)
+                if (tc->tc_ycols[i].cy_ys == ycol)
+                    break;
+            if (i == tc->tc_nycols)
+                continue;
+            cc = &tc->tc_vec[tc->tc_len];
+            cc->cc_oidlen = tc->tc_ycols[i].cy_oidlen + oidklen;
+            if ((cc->cc_oid = malloc(cc->cc_oidlen*sizeof(oid))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memcpy(cc->cc_oid, tc->tc_ycols[i].cy_oid, tc->tc_ycols[i].cy_oidlen*sizeof(oid));
+            memcpy(cc->cc_oid + tc->tc_ycols[i].cy_oidlen, oidk, oidklen*sizeof(oid));
+            cc->cc_xcol = xcol;
+            cc->cc_ycol = ycol;
+            tc->tc_len++;
+        }
+    }
+    qsort(tc->tc_vec, tc->tc_len, sizeof(*tc->tc_vec), cache_col_cmp);
+    qsort(tc->tc_rows, tc->tc_nrows, sizeof(*tc->tc_rows), cache_row_cmp);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if read table is valid, ie can be used without reading it again
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  tc   Cached table
+ * @retval     1    Valid
+ * @retval     0    Not valid
+ */
+int
+snmp_table_cache_valid(clixon_handle     h,
+                       snmp_table_cache *tc)
+{
+    struct timeval now;
+    struct timeval td;
+    uint64_t       ms;
+
+    if (tc->tc_xml == NULL)
+        return 0;
+    /* Read was made after waiting callers requested it */
+    if (tc == _serving)
+        return 1;
+    if (tc->tc_gen != _cache_gen)
+        return 0;
+    /* Config is valid until changed */
+    if (_cache_socket != -1 && !tc->tc_state)
+        return 1;
+    gettimeofday(&now, NULL);
+    timersub(&now, &tc->tc_time, &td);
+    ms = td.tv_sec*1000 + td.tv_usec/1000;
+    return ms < clicon_option_int(h, "CLICON_SNMP_CACHE_TTL");
+}
+
+/*! Set read reply of table
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  tc   Cached table
+ * @param[in]  xt   Reply of get, consumed
+ * @param[in]  gen  Change generation when read was requested
+ * @retval     1    OK
+ * @retval     0    Reply is an error, set as clixon error
+ * @retval    -1    Error
+ */
+static int
+table_cache_set(clixon_handle     h,
+                snmp_table_cache *tc,
+                cxobj            *xt,
+                uint64_t          gen)
+{
+    int    retval = -1;
+    cxobj *xerr;
+    cxobj *xtable;
+
+    table_cache_clear(tc);
+    tc->tc_gen = gen;
+    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+        xml_free(xt);
+        goto fail;
+    }
+    gettimeofday(&tc->tc_time, NULL);
+    tc->tc_xml = xt;
+    if ((xtable = xpath_first(tc->tc_xml, tc->tc_nsc, "%s", tc->tc_xpath)) != NULL &&
+        table_cache_build(tc, xtable) < 0){
+        table_cache_clear(tc);
+        goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find cached table, add it if not found, do not read it
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ylist  YANG list of table
+ * @param[out] tcp    Cached table
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see snmp_table_cache_get  Read table if not valid
+ */
+int
+snmp_table_cache_find(clixon_handle      h,
+                      yang_stmt         *ylist,
+                      snmp_table_cache **tcp)
+{
+    int               retval = -1;
+    snmp_table_cache *tc;
+
+    if ((tc = table_cache_find(ylist)) == NULL){
+        if (snmp_table_cache_add(h, ylist) < 0)
+            goto done;
+        if ((tc = table_cache_find(ylist)) == NULL){
+            clixon_err(OE_SNMP, ENOENT, "Table %s not cached", yang_argument_get(ylist));
+            goto done;
+        }
+    }
+    *tcp = tc;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get cached table, read it from backend if not valid
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ylist  YANG list of table
+ * @param[out] tcp    Cached table
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+snmp_table_cache_get(clixon_handle      h,
+                     yang_stmt         *ylist,
+                     snmp_table_cache **tcp)
+{
+    int               retval = -1;
+    snmp_table_cache *tc;
+    cxobj            *xt = NULL;
+    int               ret;
+
+    if (snmp_table_cache_find(h, ylist, &tc) < 0)
+        goto done;
+    if (!snmp_table_cache_valid(h, tc)){
+        clixon_debug(CLIXON_DBG_SNMP, "get %s", tc->tc_xpath);
+        if (clicon_rpc_get(h, tc->tc_xpath, tc->tc_nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
+            goto done;
+        ret = table_cache_set(h, tc, xt, _cache_gen);
+        xt = NULL;
+        if (ret < 1) /* Error from backend is set as clixon error */
+            goto done;
+    }
+    *tcp = tc;
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Call callers waiting for read of table
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  tc      Cached table
+ * @param[in]  status  1: table is read, 0: read failed
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+table_cache_wait_done(clixon_handle     h,
+                      snmp_table_cache *tc,
+                      int               status)
+{
+    int                     retval = -1;
+    struct snmp_cache_wait *cw;
+
+    tc->tc_reading = 0;
+    _serving = tc;
+    while ((cw = tc->tc_waits) != NULL){
+        DELQ(cw, tc->tc_waits, struct snmp_cache_wait *);
+        if (cw->cw_fn(h, status, cw->cw_arg) < 0){
+            free(cw);
+            goto done;
+        }
+        free(cw);
+    }
+    retval = 0;
+ done:
+    _serving = NULL;
+    return retval;
+}
+
+/*! Close socket of asynchronous reads and fail all outstanding reads
+ */
+static int
+table_cache_read_close(clixon_handle h)
+{
+    int                     retval = -1;
+    struct snmp_cache_read *rd;
+
+    if (_read_socket != -1){
+        clixon_event_unreg_fd(_read_socket, snmp_cache_reply_cb);
+        close(_read_socket);
+        _read_socket = -1;
+    }
+    while ((rd = _reads) != NULL){
+        DELQ(rd, _reads, struct snmp_cache_read *);
+        if (rd->rd_tc == NULL){
+            if (rd->rd_fn(h, NULL, rd->rd_arg) < 0){
+                free(rd);
+                goto done;
+            }
+        }
+        else if (table_cache_wait_done(h, rd->rd_tc, 0) < 0){
+            free(rd);
+            goto done;
+        }
+        free(rd);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Connect socket of asynchronous reads if not connected
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+table_cache_read_connect(clixon_handle h)
+{
+    if (_read_socket != -1)
+        return 0;
+    if (clicon_rpc_connect(h, &_read_socket) < 0)
+        return -1;
+    if (clixon_event_reg_fd(_read_socket, snmp_cache_reply_cb, h, "snmp cache read") < 0){
+        close(_read_socket);
+        _read_socket = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/*! Reply of asynchronous read of table or other get
+ *
+ * @param[in]  s    Socket
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snmp_cache_reply_cb(int   s,
+                    void *arg)
+{
+    int                     retval = -1;
+    clixon_handle           h = (clixon_handle)arg;
+    struct snmp_cache_read *rd;
+    snmp_table_cache       *tc;
+    cxobj                  *xt = NULL;
+    int                     eof = 0;
+    int                     ret;
+
+    if (clicon_rpc_get_recv(h, s, 1, &xt, &eof) < 0)
+        goto done;
+    if (eof){
+        clixon_log(h, LOG_WARNING, "SNMP cache read socket closed");
+        if (table_cache_read_close(h) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((rd = _reads) == NULL){
+        clixon_debug(CLIXON_DBG_SNMP, "Unexpected reply");
+        goto ok;
+    }
+    DELQ(rd, _reads, struct snmp_cache_read *);
+    if ((tc = rd->rd_tc) == NULL){
+        ret = rd->rd_fn(h, xt, rd->rd_arg);
+        free(rd);
+        if (ret < 0)
+            goto done;
+        goto ok;
+    }
+    clixon_debug(CLIXON_DBG_SNMP, "reply %s", tc->tc_xpath);
+    ret = table_cache_set(h, tc, xt, rd->rd_gen);
+    xt = NULL;
+    free(rd);
+    if (ret < 0)
+        goto done;
+    if (ret == 0){
+        clixon_log(h, LOG_WARNING, "SNMP cache read of %s: %s", tc->tc_xpath, clixon_err_reason());
+        clixon_err_reset();
+    }
+    if (table_cache_wait_done(h, tc, ret) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Read table asynchronously and call back when read
+ *
+ * If a read of the table is already in progress, wait for that read.
+ * When the callback is called with status 1, the table is valid for the duration of the
+ * callback, and may be accessed with eg snmp_table_cache_get without blocking.
+ * @param[in]  h    Clixon handle
+ * @param[in]  tc   Cached table
+ * @param[in]  fn   Called when read is done
+ * @param[in]  arg  Argument to fn
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see snmp_table_cache_get  Blocking read
+ */
+int
+snmp_table_cache_read(clixon_handle       h,
+                      snmp_table_cache   *tc,
+                      snmp_cache_read_cb *fn,
+                      void               *arg)
+{
+    int                     retval = -1;
+    struct snmp_cache_wait *cw = NULL;
+    struct snmp_cache_read *rd = NULL;
+
+    if ((cw = calloc(1, sizeof(*cw))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    cw->cw_fn = fn;
+    cw->cw_arg = arg;
+    if (!tc->tc_reading){
+        if (table_cache_read_connect(h) < 0)
+            goto done;
+        if ((rd = calloc(1, sizeof(*rd))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        rd->rd_tc = tc;
+        rd->rd_gen = _cache_gen;
+        clixon_debug(CLIXON_DBG_SNMP, "get %s", tc->tc_xpath);
+        if (clicon_rpc_get_send(h, _read_socket, tc->tc_xpath, tc->tc_nsc, CONTENT_ALL, -1, NULL) < 0)
+            goto done;
+        ADDQ(rd, _reads);
+        rd = NULL;
+        tc->tc_reading = 1;
+    }
+    ADDQ(cw, tc->tc_waits);
+    cw = NULL;
+    retval = 0;
+ done:
+    if (rd)
+        free(rd);
+    if (cw)
+        free(cw);
+    return retval;
+}
+
+/*! Get data asynchronously on the socket of table reads and call back with the reply
+ *
+ * Replies are in order of requests, so a get made while a table is read is replied to
+ * after the table.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xpath  XPath of get
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  fn     Called with reply, or NULL reply if the socket is closed
+ * @param[in]  arg    Argument to fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see snmp_table_cache_read
+ */
+int
+snmp_cache_get_async(clixon_handle      h,
+                     char              *xpath,
+                     cvec              *nsc,
+                     snmp_cache_get_cb *fn,
+                     void              *arg)
+{
+    int                     retval = -1;
+    struct snmp_cache_read *rd = NULL;
+
+    if (table_cache_read_connect(h) < 0)
+        goto done;
+    if ((rd = calloc(1, sizeof(*rd))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    rd->rd_fn = fn;
+    rd->rd_arg = arg;
+    clixon_debug(CLIXON_DBG_SNMP, "get %s", xpath);
+    if (clicon_rpc_get_send(h, _read_socket, xpath, nsc, CONTENT_ALL, -1, NULL) < 0)
+        goto done;
+    ADDQ(rd, _reads);
+    rd = NULL;
+    retval = 0;
+ done:
+    if (rd)
+        free(rd);
+    return retval;
+}
+
+/*! Get first cached column with OID larger than given OID
+ *
+ * @param[in]  tc       Cached table
+ * @param[in]  oids     OID
+ * @param[in]  oidslen  OID length
+ * @retval     cc       Next column
+ * @retval     NULL     No next column in table
+ */
+struct snmp_cache_col *
+snmp_table_cache_next(snmp_table_cache *tc,
+                      oid              *oids,
+                      size_t            oidslen)
+{
+    size_t lo = 0;
+    size_t hi = tc->tc_len;
+    size_t mid;
+
+    while (lo < hi){
+        mid = (lo + hi)/2;
+        if (oid_eq(tc->tc_vec[mid].cc_oid, tc->tc_vec[mid].cc_oidlen, oids, oidslen) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < tc->tc_len ? &tc->tc_vec[lo] : NULL;
+}
+
+/*! Get column of table from OID of a column value
+ *
+ * @param[in]  tc       Cached table
+ * @param[in]  oids     OID of column value: column OID followed by index OID
+ * @param[in]  oidslen  OID length
+ * @param[out] keyoff   Offset of index OID in oids
+ * @retval     ycol     YANG of column leaf
+ * @retval     NULL     No column with OID
+ */
+yang_stmt *
+snmp_table_cache_column(snmp_table_cache *tc,
+                        oid              *oids,
+                        size_t            oidslen,
+                        size_t           *keyoff)
+{
+    struct snmp_cache_ycol *cy;
+    int                     i;
+
+    for (i=0; i<tc->tc_nycols; i++){
+        cy = &tc->tc_ycols[i];
+        if (cy->cy_oidlen <= oidslen &&
+            memcmp(cy->cy_oid, oids, cy->cy_oidlen*sizeof(oid)) == 0){
+            *keyoff = cy->cy_oidlen;
+            return cy->cy_ys;
+        }
+    }
+    return NULL;
+}
+
+/*! Get RowStatus column of table
+ *
+ * @param[in]  tc       Cached table
+ * @param[out] yrestype Resolved type of RowStatus column
+ * @retval     yrowst   YANG of RowStatus column leaf
+ * @retval     NULL     Table has no RowStatus column
+ */
+yang_stmt *
+snmp_table_cache_rowstatus(snmp_table_cache *tc,
+                           yang_stmt       **yrestype)
+{
+    if (yrestype)
+        *yrestype = tc->tc_yrowst_restype;
+    return tc->tc_yrowst;
+}
+
+/*! Get row of read table from index OID
+ *
+ * @param[in]  tc       Cached table, read with snmp_table_cache_get
+ * @param[in]  oidk     Index OID
+ * @param[in]  oidklen  Index OID length
+ * @retval     xrow     List entry
+ * @retval     NULL     No such row
+ */
+cxobj *
+snmp_table_cache_row(snmp_table_cache *tc,
+                     oid              *oidk,
+                     size_t            oidklen)
+{
+    struct snmp_cache_row  key;
+    struct snmp_cache_row *cr;
+
+    if (tc->tc_nrows == 0)
+        return NULL;
+    key.cr_oid = oidk;
+    key.cr_oidlen = oidklen;
+    if ((cr = bsearch(&key, tc->tc_rows, tc->tc_nrows, sizeof(*tc->tc_rows), cache_row_cmp)) == NULL)
+        return NULL;
+    return cr->cr_xrow;
+}
+
+/*! Invalidate all cached tables, eg after commit
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+snmp_cache_invalidate(clixon_handle h)
+{
+    _cache_gen++;
+    return 0;
+}
+
+/*! Notification on change subscription socket: running has changed
+ *
+ * @param[in]  s    Socket
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snmp_cache_change_cb(int   s,
+                     void *arg)
+{
+    int           retval = -1;
+    clixon_handle h = (clixon_handle)arg;
+    cbuf         *cbmsg = NULL;
+    int           eof = 0;
+
+    if (clixon_msg_rcv11(s, NULL, 0, &cbmsg, &eof) < 0)
+        goto done;
+    snmp_cache_invalidate(h);
+    if (eof){
+        /* Fall back to TTL for all tables */
+        clixon_log(h, LOG_WARNING, "SNMP cache change subscription closed");
+        clixon_event_unreg_fd(s, snmp_cache_change_cb);
+        close(s);
+        _cache_socket = -1;
+    }
+    retval = 0;
+ done:
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return retval;
+}
+
+/*! Subscribe to changes of config tables in running
+ *
+ * Make an on-change push subscription with an xpath of all cached config tables
+ * If it fails, eg due to NACM, tables are invalidated by CLICON_SNMP_CACHE_TTL only.
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see snmp_table_cache_add  Call this after all tables are added
+ */
+int
+snmp_cache_subscribe(clixon_handle h)
+{
+    int               retval = -1;
+    snmp_table_cache *tc;
+    cbuf             *cb = NULL;
+    cbuf             *cbx = NULL;
+    cvec             *nsc = NULL;
+    cg_var           *cv = NULL;
+    cxobj            *xret = NULL;
+    int               s = -1;
+
+    if ((cb = cbuf_new()) == NULL ||
+        (cbx = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((tc = _table_cache) != NULL)
+        do {
+            if (yang_config_ancestor(tc->tc_ylist))
+                cprintf(cbx, "%s%s", cbuf_len(cbx)?" | ":"", tc->tc_xpath);
+            tc = NEXTQ(snmp_table_cache *, tc);
+        } while (tc != _table_cache);
+    if (cbuf_len(cbx) == 0)
+        goto ok;
+    if (xml_nsctx_yangspec(clicon_dbspec_yang(h), &nsc) < 0)
+        goto done;
+    cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\" %s>",
+            NETCONF_BASE_NAMESPACE,
+            clicon_username_get(h),
+            NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<create-push-subscription xmlns=\"%s\"><xpath", CLIXON_LIB_NS);
+    while ((cv = cvec_each(nsc, cv)) != NULL)
+        if (cv_name_get(cv) != NULL)
+            cprintf(cb, " xmlns:%s=\"%s\"", cv_name_get(cv), cv_string_get(cv));
+    cprintf(cb, ">");
+    if (xml_chardata_cbuf_append(cb, 0, cbuf_get(cbx)) < 0)
+        goto done;
+    cprintf(cb, "</xpath><on-change/></create-push-subscription></rpc>]]>]]>");
+    if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, &s) < 0)
+        goto done;
+    if (xpath_first(xret, NULL, "rpc-reply/rpc-error") != NULL){
+        clixon_log(h, LOG_NOTICE, "SNMP cache change subscription failed, using CLICON_SNMP_CACHE_TTL");
+        if (s != -1)
+            close(s);
+        goto ok;
+    }
+    if (clixon_event_reg_fd(s, snmp_cache_change_cb, h, "snmp cache") < 0){
+        close(s);
+        goto done;
+    }
+    _cache_socket = s;
+ ok:
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (cb)
+        cbuf_free(cb);
+    if (cbx)
+        cbuf_free(cbx);
+    return retval;
+}
+
+/*! Free all cached tables and close subscription
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+snmp_cache_exit(clixon_handle h)
+{
+    snmp_table_cache       *tc;
+    struct snmp_cache_read *rd;
+    struct snmp_cache_wait *cw;
+
+    if (_cache_socket != -1){
+        clixon_event_unreg_fd(_cache_socket, snmp_cache_change_cb);
+        close(_cache_socket);
+        _cache_socket = -1;
+    }
+    if (_read_socket != -1){
+        clixon_event_unreg_fd(_read_socket, snmp_cache_reply_cb);
+        close(_read_socket);
+        _read_socket = -1;
+    }
+    while ((rd = _reads) != NULL){
+        DELQ(rd, _reads, struct snmp_cache_read *);
+        free(rd);
+    }
+    while ((tc = _table_cache) != NULL){
+        DELQ(tc, _table_cache, snmp_table_cache *);
+        while ((cw = tc->tc_waits) != NULL){
+            DELQ(cw, tc->tc_waits, struct snmp_cache_wait *);
+            free(cw);
+        }
+        table_cache_clear(tc);
+        if (tc->tc_nsc)
+            xml_nsctx_free(tc->tc_nsc);
+        if (tc->tc_xpath)
+            free(tc->tc_xpath);
+        if (tc->tc_ycols)
+            free(tc->tc_ycols);
+        free(tc);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2022 Olof Hagsand and Kristofer Hallin
+  Sponsored by Siklu Communications LTD
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * SNMP table cache
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _SNMP_CACHE_H_
+#define _SNMP_CACHE_H_
+
+/*
+ * Types
+ */
+/*! Cached column value of a table row
+ *
+ * The OID is the column OID followed by the row index OID
+ */
+struct snmp_cache_col {
+    oid       *cc_oid;    /* Column and index OID */
+    size_t     cc_oidlen; /* Length of cc_oid */
+    cxobj     *cc_xcol;   /* Column leaf in cached XML */
+    yang_stmt *cc_ycol;   /* YANG of column leaf */
+};
+
+typedef struct snmp_table_cache snmp_table_cache;
+
+/*! Called when an asynchronous read of a table is done
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: table is read, 0: read failed
+ * @param[in]  arg     Argument given to snmp_table_cache_read
+ */
+typedef int (snmp_cache_read_cb)(clixon_handle h, int status, void *arg);
+
+/*! Called with the reply of an asynchronous get
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      Reply of get, freed after the call, or NULL if the read failed
+ * @param[in]  arg     Argument given to snmp_cache_get_async
+ */
+typedef int (snmp_cache_get_cb)(clixon_handle h, cxobj *xt, void *arg);
+
+/*
+ * Prototypes
+ */
+int    snmp_table_cache_add(clixon_handle h, yang_stmt *ylist);
+int    snmp_table_cache_get(clixon_handle h, yang_stmt *ylist, snmp_table_cache **tcp);
+int    snmp_table_cache_find(clixon_handle h, yang_stmt *ylist, snmp_table_cache **tcp);
+int    snmp_table_cache_valid(clixon_handle h, snmp_table_cache *tc);
+int    snmp_table_cache_read(clixon_handle h, snmp_table_cache *tc, snmp_cache_read_cb *fn, void *arg);
+int    snmp_cache_get_async(clixon_handle h, char *xpath, cvec *nsc, snmp_cache_get_cb *fn, void *arg);
+struct snmp_cache_col *snmp_table_cache_next(snmp_table_cache *tc, oid *oids, size_t oidslen);
+yang_stmt *snmp_table_cache_column(snmp_table_cache *tc, oid *oids, size_t oidslen, size_t *keyoff);
+yang_stmt *snmp_table_cache_rowstatus(snmp_table_cache *tc, yang_stmt **yrestype);
+cxobj *snmp_table_cache_row(snmp_table_cache *tc, oid *oidk, size_t oidklen);
+int    snmp_cache_invalidate(clixon_handle h);
+int    snmp_cache_subscribe(clixon_handle h);
+int    snmp_cache_exit(clixon_handle h);
+
+#endif /* _SNMP_CACHE_H_ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -59,12 +59,7 @@
 #include "snmp_lib.h"
 #include "snmp_register.h"
 #include "snmp_handler.h"
-
-struct snmp_getnext_cache {
-    cxobj         *sg_xml;
-    char          *sg_xpath;
-    struct timeval sg_timer;
-};
+#include "snmp_cache.h"
 
 /*! Common code for handling incoming SNMP request
  * 
@@ -216,12 +211,13 @@ snmp_scalar_return(cxobj                      *xs,
     return retval;
 }
 
-/*! Scalar handler, set a value to clixon 
+/*! Set value of scalar GET request from XML
  *
- * get xpath: see yang2api_path_fmt / api_path2xpath
- * @param[in]  h          Clixon handle
+ * The xml to snmp value conversion is done in two steps:
+ * 1. From XML to SNMP string, there is a special case for enumeration, and for default value
+ * 2. From SNMP string to SNMP binary value which invloves parsing
  * @param[in]  ys         Yang node
- * @param[in]  cvk        Vector of index/Key variables, if any
+ * @param[in]  x          XML of scalar, or NULL if not found
  * @param[in]  defaultval Default value
  * @param[in]  reqinfo    Agent transaction request structure
  * @param[in]  request    The netsnmp request info structure.
@@ -229,19 +225,13 @@ snmp_scalar_return(cxobj                      *xs,
  * @retval    -1          Error
  */
 static int
-snmp_scalar_get(clixon_handle               h,
-                yang_stmt                  *ys,
-                cvec                       *cvk,
-                char                       *defaultval,
-                netsnmp_agent_request_info *reqinfo,
-                netsnmp_request_info       *request)
+snmp_scalar_value(yang_stmt                  *ys,
+                  cxobj                      *x,
+                  char                       *defaultval,
+                  netsnmp_agent_request_info *reqinfo,
+                  netsnmp_request_info       *request)
 {
     int     retval = -1;
-    cvec   *nsc = NULL;
-    char   *xpath = NULL;
-    cxobj  *xt = NULL;
-    cxobj  *xerr;
-    cxobj  *x = NULL;
     char   *xmlstr = NULL;
     u_char *snmpval = NULL;
     size_t  snmplen = 0;
@@ -249,37 +239,10 @@ snmp_scalar_get(clixon_handle               h,
     int     asn1type;
     char   *reason = NULL;
     netsnmp_variable_list *requestvb = request->requestvb;
-    cxobj  *xcache = NULL;
     char   *body = NULL;
 
-    clixon_debug(CLIXON_DBG_SNMP, "");
-    /* Prepare backend call by constructing namespace context */
-    if (xml_nsctx_yang(ys, &nsc) < 0)
-        goto done;
-    /* Create xpath from yang */
-    if (snmp_yang2xpath(ys, cvk, &xpath) < 0)
-        goto done;
     if (type_yang2asn1(ys, &asn1type, 1) < 0)
         goto done;
-    /* First try cache */
-    clicon_ptr_get(h, "snmp-rowstatus-tree", (void**)&xcache);
-    if (xcache==NULL || (x = xpath_first(xcache, nsc, "%s", xpath)) == NULL){
-        /* If not found do the backend call */
-        if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
-            goto done;
-        /* Detect error XXX Error handling could improve */
-        if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-            if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
-                goto done;
-            goto done;
-        }
-        x = xpath_first(xt, nsc, "%s", xpath);
-    }
-    /*
-     * The xml to snmp value conversion is done in two steps:
-     * 1. From XML to SNMP string, there is a special case for enumeration, and for default value
-     * 2. From SNMP string to SNMP binary value which invloves parsing
-     */
     if (x != NULL && (body = xml_body(x)) != NULL){
         if ((ret = type_xml2snmp_pre(body, ys, &xmlstr)) < 0)
             goto done;
@@ -329,6 +292,63 @@ snmp_scalar_get(clixon_handle               h,
         free(xmlstr);
     if (snmpval)
         free(snmpval);
+    return retval;
+}
+
+/*! Scalar handler, get a value from clixon
+ *
+ * get xpath: see yang2api_path_fmt / api_path2xpath
+ * @param[in]  h          Clixon handle
+ * @param[in]  ys         Yang node
+ * @param[in]  cvk        Vector of index/Key variables, if any
+ * @param[in]  defaultval Default value
+ * @param[in]  reqinfo    Agent transaction request structure
+ * @param[in]  request    The netsnmp request info structure.
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see snmp_scalar_delegated_cb  Asynchronous get
+ */
+static int
+snmp_scalar_get(clixon_handle               h,
+                yang_stmt                  *ys,
+                cvec                       *cvk,
+                char                       *defaultval,
+                netsnmp_agent_request_info *reqinfo,
+                netsnmp_request_info       *request)
+{
+    int     retval = -1;
+    cvec   *nsc = NULL;
+    char   *xpath = NULL;
+    cxobj  *xt = NULL;
+    cxobj  *xerr;
+    cxobj  *x = NULL;
+    cxobj  *xcache = NULL;
+
+    clixon_debug(CLIXON_DBG_SNMP, "");
+    /* Prepare backend call by constructing namespace context */
+    if (xml_nsctx_yang(ys, &nsc) < 0)
+        goto done;
+    /* Create xpath from yang */
+    if (snmp_yang2xpath(ys, cvk, &xpath) < 0)
+        goto done;
+    /* First try cache */
+    clicon_ptr_get(h, "snmp-rowstatus-tree", (void**)&xcache);
+    if (xcache==NULL || (x = xpath_first(xcache, nsc, "%s", xpath)) == NULL){
+        /* If not found do the backend call */
+        if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
+            goto done;
+        /* Detect error XXX Error handling could improve */
+        if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+            if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
+                goto done;
+            goto done;
+        }
+        x = xpath_first(xt, nsc, "%s", xpath);
+    }
+    if (snmp_scalar_value(ys, x, defaultval, reqinfo, request) < 0)
+        goto done;
+    retval = 0;
+ done:
     if (xt)
         xml_free(xt);
     if (xpath)
@@ -761,6 +781,7 @@ clixon_snmp_scalar_handler1(netsnmp_mib_handler          *handler,
     case MODE_SET_COMMIT:   /* 3 */
         if ((ret = clicon_rpc_commit(sh->sh_h, 0, 0, 0, NULL, NULL)) < 0)
             goto done;
+        snmp_cache_invalidate(sh->sh_h);
         if (ret == 0){
             /* Note that error given in commit is not propagated to the snmp client,
              * therefore validation is in the ACTION instead
@@ -784,8 +805,70 @@ clixon_snmp_scalar_handler1(netsnmp_mib_handler          *handler,
     return retval;
 }
 
+/*! Asynchronous get of scalar is done, answer delegated requests
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      Reply of get, or NULL if the read failed
+ * @param[in]  arg     Delegated requests
+ * If the read failed, requests are answered with genErr, as a failed blocking get.
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_snmp_scalar_handler where requests are delegated
+ */
+static int
+snmp_scalar_delegated_cb(clixon_handle h,
+                         cxobj        *xt,
+                         void         *arg)
+{
+    netsnmp_delegated_cache *dc;
+    netsnmp_request_info    *req;
+    clixon_snmp_handle      *sh;
+    cvec                    *nsc = NULL;
+    char                    *xpath = NULL;
+    cxobj                   *xerr;
+    cxobj                   *x = NULL;
+    int                      status = 0;
+
+    clixon_debug(CLIXON_DBG_SNMP, "");
+    /* Requests may be gone, eg timed out */
+    if ((dc = netsnmp_handler_check_cache((netsnmp_delegated_cache *)arg)) == NULL){
+        netsnmp_free_delegated_cache((netsnmp_delegated_cache *)arg);
+        goto ok;
+    }
+    sh = (clixon_snmp_handle*)dc->handler->myvoid;
+    if (xt == NULL)
+        clixon_err(OE_SNMP, 0, "Read socket closed");
+    else if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL)
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+    else if (xml_nsctx_yang(sh->sh_ys, &nsc) == 0 &&
+             snmp_yang2xpath(sh->sh_ys, sh->sh_cvk_orig, &xpath) == 0){
+        x = xpath_first(xt, nsc, "%s", xpath);
+        status = 1;
+    }
+    for (req = dc->requests; req; req = req->next){
+        req->delegated = 0;
+        if (status == 1 &&
+            snmp_scalar_value(sh->sh_ys, x, sh->sh_default, dc->reqinfo, req) == 0)
+            continue;
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        netsnmp_request_set_error(req, SNMP_ERR_GENERR);
+    }
+    netsnmp_free_delegated_cache(dc);
+    /* Send replies of completed requests */
+    netsnmp_check_outstanding_agent_requests();
+ ok:
+    if (xpath)
+        free(xpath);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return 0;
+}
+
 /*! Top level scalar request handler, loop over individual request
  *
+ * A GET that is not in the rowstatus cache is delegated, and the scalar is read
+ * asynchronously, so that other requests are served while the backend is busy.
  * @param[in]  handler      Registered MIB handler structure
  * @param[in]  nhreg        Root registration info.
  * @param[in]  reqinfo      Agent transaction request structure
@@ -800,11 +883,40 @@ clixon_snmp_scalar_handler(netsnmp_mib_handler          *handler,
                            netsnmp_agent_request_info   *reqinfo,
                            netsnmp_request_info         *requests)
 {
-    int                   retval = -1;
-    netsnmp_request_info *req;
-    int                   ret;
+    int                      retval = -1;
+    netsnmp_request_info    *req;
+    int                      ret;
+    clixon_snmp_handle      *sh;
+    netsnmp_delegated_cache *dc;
+    cvec                    *nsc = NULL;
+    char                    *xpath = NULL;
+    cxobj                   *xcache = NULL;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
+    if (reqinfo->mode == MODE_GET &&
+        (sh = (clixon_snmp_handle*)handler->myvoid) != NULL &&
+        sh->sh_ys != NULL){
+        if (xml_nsctx_yang(sh->sh_ys, &nsc) < 0)
+            goto done;
+        if (snmp_yang2xpath(sh->sh_ys, sh->sh_cvk_orig, &xpath) < 0)
+            goto done;
+        clicon_ptr_get(sh->sh_h, "snmp-rowstatus-tree", (void**)&xcache);
+        if (xcache == NULL || xpath_first(xcache, nsc, "%s", xpath) == NULL){
+            if ((dc = netsnmp_create_delegated_cache(handler, nhreg, reqinfo, requests, NULL)) == NULL){
+                clixon_err(OE_SNMP, 0, "netsnmp_create_delegated_cache");
+                goto done;
+            }
+            for (req = requests; req; req = req->next)
+                req->delegated = 1;
+            if (snmp_cache_get_async(sh->sh_h, xpath, nsc, snmp_scalar_delegated_cb, dc) < 0){
+                for (req = requests; req; req = req->next)
+                    req->delegated = 0;
+                netsnmp_free_delegated_cache(dc);
+                goto done;
+            }
+            goto ok;
+        }
+    }
     for (req = requests; req; req = req->next){
         ret = clixon_snmp_scalar_handler1(handler, nhreg, reqinfo, req);
         if (ret != SNMP_ERR_NOERROR){
@@ -813,20 +925,23 @@ clixon_snmp_scalar_handler(netsnmp_mib_handler          *handler,
             break;
         }
     }
+ ok:
     retval = SNMP_ERR_NOERROR;
  done:
+    if (xpath)
+        free(xpath);
+    if (nsc)
+        xml_nsctx_free(nsc);
     return retval;
 }
 
-/*! Create xpath from YANG table OID + 1 + n + cvk/key = requestvb->name 
+/*! Get value in table from YANG table OID + 1 + n + cvk/key = requestvb->name 
  *
  * Get yang of leaf from first part of OID
- * Create xpath with right keys from later part of OID
- * Query clixon if object exists, if so return value
+ * Look up row in cached table from later part of OID, if found return value
+ * Otherwise create xpath with right keys and query rowstatus cache and clixon
  * @param[in]  h        Clixon handle
  * @param[in]  yt       Yang of table (of list type)
- * @param[in]  oidt     OID of registered top container object (above list), may be different from yt
- * @param[in]  oidtlen  OID length of list object OID
  * @param[in]  oids     OID of ultimate scalar value
  * @param[in]  oidslen  OID length of scalar
  * @param[in]  reqinfo  Agent transaction request structure
@@ -834,54 +949,48 @@ clixon_snmp_scalar_handler(netsnmp_mib_handler          *handler,
  * @retval     1        OK
  * @retval     0        Object not found
  * @retval    -1        Error
+ * @see snmp_table_cache_row
  */
 static int
 snmp_table_get(clixon_handle               h,
                yang_stmt                  *yt,
-               oid                        *oidt,
-               size_t                      oidtlen,
                oid                        *oids,
                size_t                      oidslen,
                netsnmp_agent_request_info *reqinfo,
                netsnmp_request_info       *request)
 {
-    int        retval = -1;
-    oid        oidleaf[MAX_OID_LEN] = {0,}; /* Leaf */
-    size_t     oidleaflen = MAX_OID_LEN;
-    oid       *oidi;
-    size_t     oidilen;
-    yang_stmt *ys;
-    yang_stmt *yk;
-    char      *xpath = NULL;
-    cvec      *cvk_orig;
-    cvec      *cvk_val = NULL;
-    int        i;
-    cg_var    *cv;
-    char      *defaultval = NULL;
-    int        inext;
-    int        ret;
+    int               retval = -1;
+    snmp_table_cache *tc = NULL;
+    size_t            keyoff = 0;
+    oid              *oidi;
+    size_t            oidilen;
+    yang_stmt        *ys;
+    yang_stmt        *yk;
+    cxobj            *xrow;
+    cxobj            *xcol;
+    cvec             *cvk_orig;
+    cvec             *cvk_val = NULL;
+    int               i;
+    cg_var           *cv;
+    char             *defaultval = NULL;
 
+    /* Read table, all varbinds of a request are looked up in the same read */
+    if (snmp_table_cache_get(h, yt, &tc) < 0)
+        goto done;
     /* Get yang of leaf from first part of OID */
-    inext = 0;
-    while ((ys = yn_iter(yt, &inext)) != NULL) {
-        if (yang_keyword_get(ys) != Y_LEAF)
-            continue;
-        /* reset oid */
-        oidleaflen = MAX_OID_LEN;
-        if ((ret = yangext_oid_get(ys, oidleaf, &oidleaflen, NULL)) < 0)
-            goto done;
-        if (ret == 0)
-            continue;
-        if (oidtlen + 1 != oidleaflen) /* Indexes may be from other OID scope, skip those */
-            continue;
-        if (oids[oidleaflen-1] == oidleaf[oidleaflen-1])
-            break;
-    }
-    if (ys == NULL){
+    if ((ys = snmp_table_cache_column(tc, oids, oidslen, &keyoff)) == NULL){
         /* No leaf with matching OID */
         goto fail;
     }
-    /* SMI default value, How is this different from yang defaults?
+    /* Get row from later part of OID */
+    if ((xrow = snmp_table_cache_row(tc, oids+keyoff, oidslen-keyoff)) != NULL){
+        xcol = xml_find_type(xrow, NULL, yang_argument_get(ys), CX_ELMNT);
+        if (snmp_scalar_return(xcol, ys, oids, oidslen, reqinfo, request) < 0)
+            goto done;
+        goto ok;
+    }
+    /* Row not in backend, may be in rowstatus cache, see snmp_cache_set
+     * SMI default value, How is this different from yang defaults?
      */
     if (yang_extension_value_opt(ys, "smiv2:defval", NULL, &defaultval) < 0)
         goto done;
@@ -898,8 +1007,8 @@ snmp_table_get(clixon_handle               h,
         goto done;
     }
     /* read through keys and create cvk */
-    oidilen = oidslen-(oidtlen+1);
-    oidi = oids+oidtlen+1;
+    oidilen = oidslen-keyoff;
+    oidi = oids+keyoff;
     /* Add keys */
     for (i=0; i<cvec_len(cvk_val); i++){
         cv = cvec_i(cvk_val, i);
@@ -920,13 +1029,11 @@ snmp_table_get(clixon_handle               h,
                         reqinfo,
                         request) < 0)
         goto done;
-    // ok:
+ ok:
     retval = 1;
  done:
     if (cvk_val)
         cvec_free(cvk_val);
-    if (xpath)
-        free(xpath);
     return retval;
  fail:
     retval = 0;
@@ -958,66 +1065,32 @@ snmp_table_set(clixon_handle               h,
                netsnmp_request_info       *request,
                int                        *err)
 {
-    int        retval = -1;
-    oid        oidt[MAX_OID_LEN] = {0,}; /* Table / list oid */
-    size_t     oidtlen = MAX_OID_LEN;
-    oid        oidleaf[MAX_OID_LEN] = {0,}; /* Leaf */
-    size_t     oidleaflen = MAX_OID_LEN;
-    oid       *oidi;
-    size_t     oidilen;
-    yang_stmt *yi;
-    yang_stmt *ys;
-    yang_stmt *yrowst;
-    yang_stmt *yk;
-    yang_stmt *yrestype = NULL;
-    char      *xpath = NULL;
-    cvec      *cvk_orig;
-    cvec      *cvk_val = NULL;
-    int        i;
-    cg_var    *cv;
-    int        ret;
-    int        asn1_type;
-    netsnmp_variable_list  *requestvb;
-    int        rowstatus = 0;
-    char      *origtype;
-    int        inext;
+    int                    retval = -1;
+    snmp_table_cache      *tc = NULL;
+    size_t                 keyoff = 0;
+    oid                   *oidi;
+    size_t                 oidilen;
+    yang_stmt             *ys;
+    yang_stmt             *yrowst;
+    yang_stmt             *yk;
+    yang_stmt             *yrestype = NULL;
+    char                  *xpath = NULL;
+    cvec                  *cvk_orig;
+    cvec                  *cvk_val = NULL;
+    int                    i;
+    cg_var                *cv;
+    int                    ret;
+    int                    asn1_type;
+    netsnmp_variable_list *requestvb;
+    int                    rowstatus = 0;
 
-    /* Get OID from table /list  */
-    if ((ret = yangext_oid_get(yt, oidt, &oidtlen, NULL)) < 0)
-        goto done;
-    if (ret == 0)
-        goto done;
     /* Get yang of leaf from first part of OID
-     * and also leaf with rowstatus type
+     * and also leaf with rowstatus type, both computed at table registration
      */
-    ys = NULL;
-    yrowst = NULL;
-    inext = 0;
-    while ((yi = yn_iter(yt, &inext)) != NULL) {
-        if (yang_keyword_get(yi) != Y_LEAF)
-            continue;
-        /* reset oid */
-        oidleaflen = MAX_OID_LEN;
-        if ((ret = yangext_oid_get(yi, oidleaf, &oidleaflen, NULL)) < 0)
-            goto done;
-        if (ret == 0)
-            continue;
-        if (oidtlen + 1 != oidleaflen) /* Indexes may be from other OID scope, skip those */
-            continue;
-        if (oids[oidleaflen-1] == oidleaf[oidleaflen-1]){
-            ys = yi;
-        }
-        origtype = NULL;
-        if (snmp_yang_type_get(yi, NULL, &origtype, &yrestype, NULL) < 0)
-            goto done;
-        if (strcmp(origtype, "RowStatus") == 0){
-            yrowst = yi;
-        }
-        if (origtype){
-            free(origtype);
-            origtype = NULL;
-        }
-    }
+    if (snmp_table_cache_find(h, yt, &tc) < 0)
+        goto done;
+    ys = snmp_table_cache_column(tc, oids, oidslen, &keyoff);
+    yrowst = snmp_table_cache_rowstatus(tc, &yrestype);
     if (ys == NULL){
         /* No leaf with matching OID */
         *err = SNMP_NOSUCHOBJECT;
@@ -1063,8 +1136,8 @@ snmp_table_set(clixon_handle               h,
         goto done;
     }
     /* read through keys and create cvk */
-    oidilen = oidslen-(oidtlen+1);
-    oidi = oids+oidtlen+1;
+    oidilen = oidslen-keyoff;
+    oidi = oids+keyoff;
     /* Add keys */
     for (i=0; i<cvec_len(cvk_val); i++){
         cv = cvec_i(cvk_val, i);
@@ -1141,92 +1214,12 @@ snmp_table_set(clixon_handle               h,
         cvec_free(cvk_val);
     if (xpath)
         free(xpath);
-    if (origtype)
-        free(origtype);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
-/*! Use a cache for getnext tables instead of an RPC to the backend every time
- *
- * The cache works as follows:
- * It has three parts:
- * - xpath     Of the requested YANG
- * - xml tree  Saved from previous rpc to this xpath
- * - timestamp Time of last rpc call for this xpath
- * On a new call, the cache is used if:
- * - the cache exist, and
- * - the xpath is the same as the requested xpath, and
- * - the age of the cache entry is less than a threshold
- * @param[in]  h      Clixon handle
- * @param[in]  xpath  XPath of requetsed YANG
- * @param[in]  nsc    Namespace context
- * @param[out] xt     XML, either cached or new, dont free
- * @retval     0      OK
- * @retval    -1      Error
- */
-#define GETNEXT_THRESHOLD_US 1000000
-static int
-table_getnext_cache(clixon_handle h,
-                    char         *xpath,
-                    cvec         *nsc,
-                    cxobj       **xtp)
-{
-    int                        retval = -1;
-    cxobj                     *xerr;
-    cxobj                     *xt = NULL;
-    int64_t                    tdiff_us = 0;
-    struct timeval             now;
-    struct timeval             td;
-    struct snmp_getnext_cache *sg = NULL;
-
-    clicon_ptr_get(h, "snmp-getnext-cache", (void**)&sg);
-    if (sg == NULL){
-        if ((sg = calloc(1, sizeof(*sg))) == NULL){
-            clixon_err(OE_UNIX, errno, "calloc");
-            goto done;
-        }
-        clicon_ptr_set(h, "snmp-getnext-cache", sg);
-    }
-    if (timerisset(&sg->sg_timer)){
-        gettimeofday(&now, NULL);
-        timersub(&now, &sg->sg_timer, &td);
-        tdiff_us = 1000000*td.tv_sec + td.tv_usec;
-    }
-    if (sg->sg_xml == NULL || sg->sg_xpath == NULL ||
-        strcmp(xpath, sg->sg_xpath) != 0 || tdiff_us > 1000000){ // gettime
-        if (sg->sg_xml){
-            xml_free(sg->sg_xml);
-            sg->sg_xml = NULL;
-        }
-        if (sg->sg_xpath){
-            free(sg->sg_xpath);
-            sg->sg_xpath = NULL;
-        }
-        if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
-            goto done;
-        if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-            clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
-            goto done;
-        }
-        gettimeofday(&sg->sg_timer, NULL);
-        if ((sg->sg_xpath = strdup(xpath)) == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
-            goto done;
-        }
-        sg->sg_xml = xt;
-        xt = NULL;
-    }
-    *xtp = sg->sg_xml;
-    retval = 0;
- done:
-    if (xt)
-        xml_free(xt);
-    return retval;
-}
-
 /*! Find "next" object from oids minus key and return that.
  *
  * @param[in]  h        Clixon handle
@@ -1238,7 +1231,7 @@ table_getnext_cache(clixon_handle h,
  * @retval     1        OK
  * @retval     0        Failed
  * @retval    -1        Error
- * XXX: merge with cache
+ * @see snmp_table_cache_next
  */
 static int
 snmp_table_getnext(clixon_handle               h,
@@ -1248,97 +1241,31 @@ snmp_table_getnext(clixon_handle               h,
                    netsnmp_agent_request_info *reqinfo,
                    netsnmp_request_info       *request)
 {
-    int        retval = -1;
-    cvec      *nsc = NULL;
-    char      *xpath = NULL;
-    cxobj     *xt = NULL;
-    cxobj     *xtable;
-    cxobj     *xrow;
-    cxobj     *xcol;
-    yang_stmt *ycol;
-    yang_stmt *ys;
-    int        ret;
-    cvec      *cvk_name;
-    oid        oidc[MAX_OID_LEN] = {0,}; /* Table / list oid */
-    size_t     oidclen = MAX_OID_LEN;
-    oid        oidk[MAX_OID_LEN] = {0,}; /* Key oid */
-    size_t     oidklen = MAX_OID_LEN;
-    oid        oidnext[MAX_OID_LEN] = {0x7fffffff,}; /* Next oid: start with high value */
-    size_t     oidnextlen = MAX_OID_LEN;
-    int        found = 0;
-    cxobj     *xnext = NULL;
-    yang_stmt *ynext = NULL;
-    cbuf      *cb = NULL;
+    int                    retval = -1;
+    snmp_table_cache      *tc = NULL;
+    struct snmp_cache_col *cc;
+    cbuf                  *cb = NULL;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
-    if ((ys = yang_parent_get(ylist)) == NULL ||
-        yang_keyword_get(ys) != Y_CONTAINER){
-        clixon_err(OE_YANG, EINVAL, "ylist parent is not list");
+    /* Get next via cache */
+    if (snmp_table_cache_get(h, ylist, &tc) < 0)
         goto done;
-    }
-    if (xml_nsctx_yang(ys, &nsc) < 0)
+    if ((cc = snmp_table_cache_next(tc, oids, oidslen)) == NULL){
+        retval = 0;
         goto done;
-    if (snmp_yang2xpath(ys, NULL, &xpath) < 0)
+    }
+    if (snmp_scalar_return(cc->cc_xcol, cc->cc_ycol, cc->cc_oid, cc->cc_oidlen, reqinfo, request) < 0)
         goto done;
-    /* Get next via cache */
-    if (table_getnext_cache(h, xpath, nsc, &xt) < 0)
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
-    if ((xtable = xpath_first(xt, nsc, "%s", xpath)) != NULL) {
-        /* Make a clone of key-list, but replace names with values */
-        if ((cvk_name = yang_cvec_get(ylist)) == NULL){
-            clixon_err(OE_YANG, 0, "No keys");
-            goto done;
-        }
-        xrow = NULL;
-        while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL) {
-            /* Get key part of OID from XML list entry */
-            if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, /*&cvk_oid,*/ oidk, &oidklen)) < 0)
-                goto done;
-            if (ret == 0)
-                continue; /* skip row, not all indexes */
-            xcol = NULL;
-            while ((xcol = xml_child_each(xrow, xcol, CX_ELMNT)) != NULL) {
-                if ((ycol = xml_spec(xcol)) == NULL)
-                    continue;
-                if (yang_keyword_get(ycol) != Y_LEAF)
-                    continue;
-                if ((ret = yangext_oid_get(ycol, oidc, &oidclen, NULL)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Append key oid */
-                if (oid_append(oidc, &oidclen, oidk, oidklen) < 0)
-                    goto done;
-                /* Get smallest larger */
-                if (oid_eq(oidc, oidclen, oids, oidslen) > 0 &&
-                    oid_eq(oidc, oidclen, oidnext, oidnextlen) < 0){
-                    memcpy(oidnext, oidc, oidclen*sizeof(*oidnext));
-                    oidnextlen = oidclen;
-                    xnext = xcol;
-                    ynext = ycol;
-                    found++;
-                }
-            } /* while xcol */
-        } /* while xrow */
-    }
-    if (found){
-        if (snmp_scalar_return(xnext, ynext, oidnext, oidnextlen, reqinfo, request) < 0)
-            goto done;
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_UNIX, errno, "cbuf_new");
-            goto done;
-        }
-        oid_cbuf(cb, oidnext, oidnextlen);
-        clixon_debug(CLIXON_DBG_SNMP, "next: %s", cbuf_get(cb));
     }
-    retval = found;
+    oid_cbuf(cb, cc->cc_oid, cc->cc_oidlen);
+    clixon_debug(CLIXON_DBG_SNMP, "next: %s", cbuf_get(cb));
+    retval = 1;
  done:
-    if (xpath)
-        free(xpath);
     if (cb)
         cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
 }
 
@@ -1379,7 +1306,6 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
         /* Create xpath from YANG table OID + 1 + n + cvk/key = requestvb->name 
          */
         if ((ret = snmp_table_get(sh->sh_h, sh->sh_ys,
-                                  sh->sh_oid2, sh->sh_oid2len,
                                   requestvb->name, requestvb->name_length,
                                   reqinfo, request)) < 0)
             goto done;
@@ -1443,6 +1369,7 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
     case MODE_SET_COMMIT:   // 3
         if ((ret = clicon_rpc_commit(sh->sh_h, 0, 0, 0, NULL, NULL)) < 0)
             goto done;
+        snmp_cache_invalidate(sh->sh_h);
         if (ret == 0){
             clicon_rpc_discard_changes(sh->sh_h);
             netsnmp_request_set_error(request, SNMP_ERR_COMMITFAILED);
@@ -1468,6 +1395,54 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
     return retval;
 }
 
+/*! Asynchronous read of table is done, answer delegated requests
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: table is read, 0: read failed
+ * @param[in]  arg     Delegated requests
+ * If the read failed, requests are answered with noSuchInstance (GET) or
+ * noSuchObject (GETNEXT), as for a missing entry.
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_snmp_table_handler where requests are delegated
+ */
+static int
+snmp_table_delegated_cb(clixon_handle h,
+                        int           status,
+                        void         *arg)
+{
+    netsnmp_delegated_cache *dc;
+    netsnmp_request_info    *req;
+    int                      ret;
+
+    clixon_debug(CLIXON_DBG_SNMP, "status:%d", status);
+    /* Requests may be gone, eg timed out */
+    if ((dc = netsnmp_handler_check_cache((netsnmp_delegated_cache *)arg)) == NULL){
+        netsnmp_free_delegated_cache((netsnmp_delegated_cache *)arg);
+        goto ok;
+    }
+    for (req = dc->requests; req; req = req->next){
+        req->delegated = 0;
+        if (status == 1){
+            ret = clixon_snmp_table_handler1(dc->handler, dc->reginfo, dc->reqinfo, req);
+            if (ret == SNMP_ERR_NOERROR)
+                continue;
+            clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+            clixon_err_reset();
+        }
+        /* Same as a non-existing entry in clixon_snmp_table_handler1 */
+        if (dc->reqinfo->mode == MODE_GET)
+            netsnmp_request_set_error(req, SNMP_NOSUCHINSTANCE);
+        else
+            netsnmp_request_set_error(req, SNMP_NOSUCHOBJECT);
+    }
+    netsnmp_free_delegated_cache(dc);
+    /* Send replies of completed requests */
+    netsnmp_check_outstanding_agent_requests();
+ ok:
+    return 0;
+}
+
 /*! Top level table request handler, loop over individual requests
  *
  * @param[in]  handler      Registered MIB handler structure
@@ -1484,11 +1459,39 @@ clixon_snmp_table_handler(netsnmp_mib_handler          *handler,
                           netsnmp_agent_request_info   *reqinfo,
                           netsnmp_request_info         *requests)
 {
-    int                   retval = -1;
-    netsnmp_request_info *req;
-    int                   ret;
+    int                      retval = -1;
+    netsnmp_request_info    *req;
+    int                      ret;
+    clixon_snmp_handle      *sh;
+    snmp_table_cache        *tc = NULL;
+    netsnmp_delegated_cache *dc;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
+    /* If table is not cached, delegate requests and read table asynchronously,
+     * so that other requests are served meanwhile.
+     * GETBULK arrives here as GETNEXT.
+     */
+    if ((reqinfo->mode == MODE_GET || reqinfo->mode == MODE_GETNEXT) &&
+        (sh = (clixon_snmp_handle*)handler->myvoid) != NULL &&
+        sh->sh_ys != NULL){
+        if (snmp_table_cache_find(sh->sh_h, sh->sh_ys, &tc) < 0)
+            goto done;
+        if (!snmp_table_cache_valid(sh->sh_h, tc)){
+            if ((dc = netsnmp_create_delegated_cache(handler, nhreg, reqinfo, requests, NULL)) == NULL){
+                clixon_err(OE_SNMP, 0, "netsnmp_create_delegated_cache");
+                goto done;
+            }
+            for (req = requests; req; req = req->next)
+                req->delegated = 1;
+            if (snmp_table_cache_read(sh->sh_h, tc, snmp_table_delegated_cb, dc) < 0){
+                for (req = requests; req; req = req->next)
+                    req->delegated = 0;
+                netsnmp_free_delegated_cache(dc);
+                goto done;
+            }
+            goto ok;
+        }
+    }
     for (req = requests; req; req = req->next){
         ret = clixon_snmp_table_handler1(handler, nhreg, reqinfo, req);
         if (ret != SNMP_ERR_NOERROR){
@@ -1497,24 +1500,8 @@ clixon_snmp_table_handler(netsnmp_mib_handler          *handler,
             break;
         }
     }
+ ok:
     retval = SNMP_ERR_NOERROR;
  done:
     return retval;
 }
-
-/*! Clear cache
- */
-int
-clixon_snmp_table_exit(clixon_handle h)
-{
-    struct snmp_getnext_cache *sg = NULL;
-
-    if (clicon_ptr_get(h, "snmp-getnext-cache", (void**)&sg) == 0 && sg){
-        if (sg->sg_xml)
-            xml_free(sg->sg_xml);
-        if (sg->sg_xpath)
-            free(sg->sg_xpath);
-        free(sg);
-    }
-    return 0;
-}
@@ -70,6 +70,7 @@
 #include "snmp_register.h"
 #include "snmp_stream.h"
 #include "snmp_handler.h"
+#include "snmp_cache.h"
 
 /* Command line options to be passed to getopt(3) */
 #define SNMP_OPTS "hVD:f:l:C:o:z"
@@ -121,7 +122,7 @@ snmp_terminate(clixon_handle h)
         xml_free(x);
         x = NULL;
     }
-    clixon_snmp_table_exit(h);
+    snmp_cache_exit(h);
     clicon_rpc_close_session(h);
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
@@ -597,6 +598,9 @@ main(int    argc,
     /* Init and traverse mib-translated yangs and register callbacks */
     if (clixon_snmp_traverse_mibyangs(h) < 0)
         goto done;
+    /* Invalidate table cache on changes in running */
+    if (snmp_cache_subscribe(h) < 0)
+        goto done;
     /* init snmp stream (traps) */
     if (clixon_snmp_stream_init(h) < 0)
         goto done;
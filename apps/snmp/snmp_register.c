@@ -78,6 +78,7 @@
 #include "snmp_lib.h"
 #include "snmp_register.h"
 #include "snmp_handler.h"
+#include "snmp_cache.h"
 
 /*! Parse smiv2 extensions for YANG leaf
  *
@@ -328,6 +329,9 @@ mibyang_table_register(clixon_handle h,
         goto done;
     }
     sh->sh_table_info = table_info; /* Keep to free at exit */
+    /* Column OIDs for getnext, table is read on first access */
+    if (snmp_table_cache_add(h, ylist) < 0)
+        goto done;
     clixon_debug(CLIXON_DBG_SNMP, "register: %s %s", name, oidstr);
  ok:
     retval = 0;
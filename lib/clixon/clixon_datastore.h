@@ -56,6 +56,8 @@ struct db_elmnt {
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    uint64_t       de_gen;      /* Generation, new value on every content change, see
+                                 * xmldb_generation_get */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -67,6 +69,7 @@ db_elmnt *clicon_db_elmnt_get(clixon_handle h, const char *db);
 int clicon_db_elmnt_set(clixon_handle h, const char *db, db_elmnt *xc);
 int xmldb_db2file(clixon_handle h, const char *db, char **filename);
 int xmldb_db2subdir(clixon_handle h, const char *db, char **dir);
+int xmldb_fingerprint(clixon_handle h, char **fpp);
 
 /* API */
 int xmldb_connect(clixon_handle h);
@@ -102,6 +105,8 @@ int xmldb_empty_get(clixon_handle h, const char *db);
 int xmldb_empty_set(clixon_handle h, const char *db, int value);
 int xmldb_volatile_get(clixon_handle h, const char   *db);
 int xmldb_volatile_set(clixon_handle h, const char *db, int value);
+uint64_t xmldb_generation_next(void);
+uint64_t xmldb_generation_get(clixon_handle h, const char *db);
 int xmldb_print(clixon_handle h, FILE *f);
 int xmldb_rename(clixon_handle h, const char *db, const char *newdb, const char *suffix);
 int xmldb_populate(clixon_handle h, const char *db);
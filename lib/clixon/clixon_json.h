@@ -40,11 +40,25 @@
 #ifndef _CLIXON_JSON_H
 #define _CLIXON_JSON_H
 
+/*
+ * Types
+ */
+/*! Sink callback for streaming JSON output
+ *
+ * @param[in]  arg  Sink argument as given to clixon_json2sink
+ * @param[in]  buf  Chunk of encoded JSON, null-terminated
+ * @param[in]  len  Length of chunk
+ * @retval     0    OK
+ * @retval    -1    Error, encoding is aborted
+ */
+typedef int (clixon_json_sink_fn)(void *arg, char *buf, size_t len);
+
 /*
  * Prototypes
  */
 int json2xml_decode(cxobj *x, cxobj **xerr);
 int clixon_json2cbuf(cbuf *cb, cxobj *x, int pretty, int skiptop, int autocliext, int system_only);
+int clixon_json2sink(cxobj *x, int pretty, int skiptop, int autocliext, int system_only, clixon_json_sink_fn *fn, void *arg);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty, int skiptop);
 int clixon_json2file(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn, int skiptop, int autocliext, int system_only);
 int json_print(FILE *f, cxobj *x);
@@ -36,12 +36,13 @@
  *
  *  netconf match & selection: get and edit operations
  *****************************************************************************/
-#ifndef _NETCONF_FILTER_H_
-#define _NETCONF_FILTER_H_
+#ifndef _CLIXON_NETCONF_FILTER_H_
+#define _CLIXON_NETCONF_FILTER_H_
 
 /*
  * Prototypes
  */
 int xml_filter(cxobj *xf, cxobj *xn);
+int xml_filter2xpath(cxobj *xfilter, yang_stmt *yspec, char **xpathp, cvec **nscp);
 
-#endif  /* _NETCONF_FILTER_H_ */
+#endif  /* _CLIXON_NETCONF_FILTER_H_ */
@@ -414,6 +414,7 @@ struct clixon_plugin_api{
             trans_cb_t       *cb_trans_end;      /* Transaction completed  */
             trans_cb_t       *cb_trans_abort;    /* Transaction aborted */
             datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+            trans_cb_t       *cb_trans_commit_wait; /* Wait for asynchronous commit, last for ABI */
         } cau_backend;
     } u;
 };
@@ -432,6 +433,7 @@ struct clixon_plugin_api{
 #define ca_trans_validate u.cau_backend.cb_trans_validate
 #define ca_trans_complete u.cau_backend.cb_trans_complete
 #define ca_trans_commit   u.cau_backend.cb_trans_commit
+#define ca_trans_commit_wait u.cau_backend.cb_trans_commit_wait
 #define ca_trans_commit_done u.cau_backend.cb_trans_commit_done
 #define ca_trans_commit_failed   u.cau_backend.cb_trans_commit_failed
 #define ca_trans_revert   u.cau_backend.cb_trans_revert
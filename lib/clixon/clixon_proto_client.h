@@ -56,6 +56,8 @@ int clicon_rpc_lock(clixon_handle h, char *db);
 int clicon_rpc_unlock(clixon_handle h, char *db);
 int clicon_rpc_get2(clixon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults, int bind, cxobj **xret);
 int clicon_rpc_get(clixon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults, cxobj **xret);
+int clicon_rpc_get_send(clixon_handle h, int s, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults);
+int clicon_rpc_get_recv(clixon_handle h, int s, int bind, cxobj **xt, int *eof);
 int clicon_rpc_get_pageable_list(clixon_handle h, char *datastore, char *xpath,
                                  cvec *nsc, netconf_content content, int32_t depth, char *defaults,
                                  uint32_t offset, uint32_t limit,
@@ -68,6 +70,7 @@ int clicon_rpc_commit(clixon_handle h, int confirmed, int cancel, uint32_t timeo
 int clicon_rpc_discard_changes(clixon_handle h);
 int clicon_rpc_create_subscription(clixon_handle h, char *stream, char *filter, int *s);
 int clicon_rpc_debug(clixon_handle h, int level);
+int clicon_rpc_datastore_generation(clixon_handle h, char *db, uint64_t *gen);
 int clicon_rpc_restconf_debug(clixon_handle h, int level);
 int clicon_hello_req(clixon_handle h, char *transport, char *source_host, uint32_t *id);
 int clicon_rpc_restart_plugin(clixon_handle h, char *plugin);
@@ -49,12 +49,16 @@
  *
  * @param[in]  h     Clicon handle
  * @param[in]  op    Operation: 0 OK, 1 Close
- * @param[in]  event Event as XML
+ * @param[in]  event Event as XML, or NULL if ss_text is set and the event is not parsed
  * @param[in]  arg   Extra argument provided in stream_ss_add
  * @see stream_ss_add
+ * @see stream_notification_get  Get event as text
  */
 typedef int (*stream_fn_t)(clixon_handle h, int op, cxobj *event, void *arg);
 
+struct stream_filter; /* Compiled subscription filter, see clixon_stream.c */
+struct stream_replay_log; /* Disk-backed replay log, see clixon_stream.c */
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
@@ -63,6 +67,10 @@ struct stream_subscription{
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
+    struct stream_filter       *ss_filter; /* Compiled xpath filter, or NULL */
+    uint64_t                    ss_serial; /* Serial of last matched event */
+    int                         ss_deleted; /* Removed, not to be called */
+    int                         ss_text;   /* Callback accepts NULL event, uses serialized event */
 };
 
 /* Replay time-series */
@@ -72,6 +80,20 @@ struct stream_replay{
     cxobj         *r_xml; /* event in xml form */
 };
 
+/*! Notification of an event shared by all subscribers
+ *
+ * The event is serialized at most once, on first use, and the result is
+ * shared by all subscribers of the event.
+ * @see stream_notification_get
+ */
+struct stream_notification{
+    cxobj *sn_xml;      /* Event as XML tree, only valid during notification */
+    cbuf  *sn_xmlstr;   /* Event serialized as XML, or NULL */
+    cbuf  *sn_msg;      /* Event as NETCONF 1.1 framed message, or NULL */
+    int    sn_refcount; /* Number of references, freed when 0 */
+};
+typedef struct stream_notification stream_notification_t;
+
 /* See RFC8040 9.3, stream list, no replay support for now
  */
 struct event_stream{
@@ -82,7 +104,12 @@ struct event_stream{
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
     struct stream_replay *es_replay;
-
+    struct stream_replay_log *es_replay_log; /* Replay on disk, see CLICON_STREAM_REPLAY_DIR */
+    clicon_hash_t       *es_index; /* Subscriptions indexed on filter, see stream_filter */
+    uint64_t             es_serial; /* Serial of last notified event */
+    int                  es_nstop;  /* Number of subscriptions with stoptime */
+    int                  es_notifying; /* Depth of subscription callbacks in progress */
+    struct stream_subscription *es_ss_deleted; /* Removed during callbacks, freed after */
 };
 typedef struct event_stream event_stream_t;
 
@@ -104,8 +131,15 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
 int stream_ss_delete_all(clixon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clixon_handle h, char *name, stream_fn_t fn, void *arg);
 
+stream_notification_t *stream_notification_new(cxobj *xev);
+int stream_notification_hold(stream_notification_t *sn);
+int stream_notification_free(stream_notification_t *sn);
+stream_notification_t *stream_notification_get(clixon_handle h, cxobj *xev);
+cbuf *stream_notification_str(stream_notification_t *sn);
+cbuf *stream_notification_msg(stream_notification_t *sn);
 int stream_notify_xml(clixon_handle h, char *stream, cxobj *xml);
 int stream_notify(clixon_handle h, char *stream, const char *event, ...)  __attribute__ ((format (printf, 3, 4)));
+int stream_notify_str(clixon_handle h, char *stream, const char *event);
 
 /* Replay */
 int stream_replay_add(event_stream_t *es, struct timeval *tv, cxobj *xv);
@@ -191,7 +191,8 @@ enum format_enum{
     FORMAT_CLI,
     FORMAT_NETCONF,  /* Last concrete format, used in code */
     FORMAT_DEFAULT,  /* Indirect: actual value in CLICON_CLI_OUTPUT_FORMAT */
-    FORMAT_PIPE_XML_DEFAULT /* Meta: If pipe, xml, if not default */
+    FORMAT_PIPE_XML_DEFAULT, /* Meta: If pipe, xml, if not default */
+    FORMAT_BINARY    /* Datastore only, see clixon_binary.h and format_datastore_str2int */
 };
 
 /*
@@ -237,6 +238,7 @@ int       xml_parent_candidate_set(cxobj *xn, cxobj *parent);
 uint16_t  xml_flag(cxobj *xn, uint16_t flag);
 int       xml_flag_set(cxobj *xn, uint16_t flag);
 int       xml_flag_reset(cxobj *xn, uint16_t flag);
+uint64_t  xml_stamp(cxobj *x);
 
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, char *val);
@@ -307,6 +309,9 @@ int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_list_insert(cxobj *xp);
+int       xml_search_list_rm(cxobj *xp);
+int       xml_search_index_stats(cxobj *xt, uint64_t *nrp, uint64_t *enp);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
 #endif
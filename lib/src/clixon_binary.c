@@ -0,0 +1,625 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compact binary encoding of XML trees, used as datastore format
+ *
+ * File layout. All integers are 32-bit unsigned in network byte order:
+ *   "CLXB" version flags fplen fingerprint\0     Header
+ *   nstr { len string\0 }*                       Interned names, prefixes and attribute values
+ *   node                                         Top-level node
+ * where a node is written in pre-order as:
+ *   type(1 byte) name prefix                     String table indexes, 0 means NULL
+ *   CX_ELMNT: nchildren node*
+ *   CX_ATTR:  value                              String table index
+ *   CX_BODY:  len value\0                        len is 0xffffffff if no value
+ * Strings are NULL-terminated in the file so that a memory-mapped file can be used directly.
+ * Nodes are written in their in-memory order. A datastore cache is yang-bound and sorted,
+ * and if the reader has the same schema fingerprint as the writer it does not need to re-sort.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_options.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_binary.h"
+
+/*
+ * Constants
+ */
+#define BINARY_FLAG_SORTED 0x01       /* Tree written sorted, valid if fingerprint matches */
+#define BINARY_NOVALUE     0xffffffff /* Body length of a body without value */
+#define BINARY_BUFLEN      4096       /* Start size of encode buffer */
+
+/*
+ * Types
+ */
+/*! Growable encode buffer
+ */
+typedef struct {
+    uint8_t *bb_buf;
+    size_t   bb_len;
+    size_t   bb_size;
+} binary_buf;
+
+/*! Encoder state
+ */
+typedef struct {
+    binary_buf        be_nodes;      /* Encoded nodes */
+    clicon_hash_t    *be_hash;       /* Interned string -> index */
+    char            **be_strv;       /* Interned strings in index order, owned by the tree */
+    uint32_t          be_strlen;     /* Number of interned strings, including NULL at 0 */
+    uint32_t          be_strsize;    /* Allocated length of be_strv */
+    withdefaults_type be_wdef;       /* With-defaults, as clixon_xml2file1 */
+    int               be_system_only; /* Skip system-only-config nodes */
+} binary_enc;
+
+/*! Decoder state
+ */
+typedef struct {
+    const uint8_t *bd_p;      /* Current position */
+    const uint8_t *bd_end;    /* End of input */
+    char         **bd_strv;   /* String table, pointing into input */
+    uint32_t       bd_strlen; /* Length of string table, including NULL at 0 */
+} binary_dec;
+
+/*! Append data to encode buffer, grow buffer if needed
+ */
+static int
+binary_buf_append(binary_buf *bb,
+                  const void *data,
+                  size_t      len)
+{
+    size_t size;
+
+    if (bb->bb_len + len > bb->bb_size){
+        size = bb->bb_size ? bb->bb_size : BINARY_BUFLEN;
+        while (bb->bb_len + len > size)
+            size *= 2;
+        if ((bb->bb_buf = realloc(bb->bb_buf, size)) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            return -1;
+        }
+        bb->bb_size = size;
+    }
+    memcpy(bb->bb_buf + bb->bb_len, data, len);
+    bb->bb_len += len;
+    return 0;
+}
+
+/*! Append 32-bit integer in network byte order to encode buffer
+ */
+static int
+binary_buf_u32(binary_buf *bb,
+               uint32_t    val)
+{
+    uint32_t n = htonl(val);
+
+    return binary_buf_append(bb, &n, sizeof(n));
+}
+
+/*! Intern a string and return its index in the string table
+ *
+ * @param[in]  be   Encoder state
+ * @param[in]  str  String, or NULL
+ * @param[out] idx  Index in string table, 0 if str is NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ * The string itself is not copied, it is owned by the tree being encoded
+ */
+static int
+binary_intern(binary_enc *be,
+              char       *str,
+              uint32_t   *idx)
+{
+    uint32_t *ip;
+
+    if (str == NULL){
+        *idx = 0;
+        return 0;
+    }
+    if ((ip = clicon_hash_value(be->be_hash, str, NULL)) != NULL){
+        *idx = *ip;
+        return 0;
+    }
+    if (be->be_strlen >= be->be_strsize){
+        be->be_strsize = be->be_strsize ? 2*be->be_strsize : 64;
+        if ((be->be_strv = realloc(be->be_strv, be->be_strsize*sizeof(char*))) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            return -1;
+        }
+    }
+    *idx = be->be_strlen++;
+    be->be_strv[*idx] = str;
+    if (clicon_hash_add(be->be_hash, str, idx, sizeof(*idx)) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Check if node should be written, same rules as the XML datastore writer
+ *
+ * @param[in]  be   Encoder state
+ * @param[in]  x    XML node
+ * @retval     1    Keep it
+ * @retval     0    Skip it
+ * @retval    -1    Error
+ */
+static int
+binary_keep(binary_enc *be,
+            cxobj      *x)
+{
+    yang_stmt *y;
+    int        exist = 0;
+
+    if ((y = xml_spec(x)) == NULL)
+        return 1;
+    if (be->be_system_only){
+        if (yang_extension_value(y, "system-only-config", CLIXON_LIB_NS, &exist, NULL) < 0)
+            return -1;
+        if (exist)
+            return 0;
+    }
+    return xml2output_wdef(x, be->be_wdef, NULL);
+}
+
+/*! Encode an XML node and its children in pre-order
+ *
+ * @param[in]  be   Encoder state
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+binary_encode(binary_enc *be,
+              cxobj      *x)
+{
+    int        retval = -1;
+    binary_buf *bb = &be->be_nodes;
+    uint8_t    type;
+    uint32_t   idx;
+    uint32_t   n = 0;
+    size_t     pos;
+    size_t     len;
+    cxobj     *xc;
+    char      *val;
+    int        ret;
+
+    type = xml_type(x);
+    if (binary_buf_append(bb, &type, sizeof(type)) < 0)
+        goto done;
+    if (binary_intern(be, xml_name(x), &idx) < 0 ||
+        binary_buf_u32(bb, idx) < 0)
+        goto done;
+    if (binary_intern(be, xml_prefix(x), &idx) < 0 ||
+        binary_buf_u32(bb, idx) < 0)
+        goto done;
+    switch (type){
+    case CX_ELMNT:
+        /* Number of children is not known until skipped children are excluded: patch it after */
+        pos = bb->bb_len;
+        if (binary_buf_u32(bb, 0) < 0)
+            goto done;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+            if ((ret = binary_keep(be, xc)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            if (binary_encode(be, xc) < 0)
+                goto done;
+            n++;
+        }
+        n = htonl(n);
+        memcpy(bb->bb_buf + pos, &n, sizeof(n));
+        break;
+    case CX_ATTR:
+        if (binary_intern(be, xml_value(x), &idx) < 0 ||
+            binary_buf_u32(bb, idx) < 0)
+            goto done;
+        break;
+    case CX_BODY:
+        if ((val = xml_value(x)) == NULL){
+            if (binary_buf_u32(bb, BINARY_NOVALUE) < 0)
+                goto done;
+        }
+        else {
+            len = strlen(val);
+            if (binary_buf_u32(bb, len) < 0 ||
+                binary_buf_append(bb, val, len+1) < 0)
+                goto done;
+        }
+        break;
+    default:
+        clixon_err(OE_XML, EINVAL, "Invalid type: %d", type);
+        goto done;
+        break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if an open file is in binary format
+ *
+ * @param[in]  fp   Open file, rewound to start on return
+ * @retval     1    File starts with the binary magic
+ * @retval     0    File does not start with the binary magic, eg XML, JSON or empty
+ * @retval    -1    Error
+ * Used to load a datastore written in another format than the configured one
+ */
+int
+clixon_binary_file_is(FILE *fp)
+{
+    char   magic[sizeof(CLIXON_BINARY_MAGIC)-1];
+    size_t n;
+
+    n = fread(magic, 1, sizeof(magic), fp);
+    if (ferror(fp)){
+        clixon_err(OE_XML, errno, "fread");
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_SET) < 0){
+        clixon_err(OE_XML, errno, "fseek");
+        return -1;
+    }
+    return (n == sizeof(magic) && memcmp(magic, CLIXON_BINARY_MAGIC, n) == 0);
+}
+
+/*! Write an XML tree to file in binary format
+ *
+ * @param[in]  f           Output file
+ * @param[in]  xt          Top of XML tree, eg datastore cache
+ * @param[in]  fingerprint Schema fingerprint, or NULL. If given, the tree is assumed to be sorted
+ * @param[in]  wdef        With-defaults parameter, as clixon_xml2file1
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @see clixon_binary_parse_file
+ */
+int
+clixon_binary2file(FILE             *f,
+                   cxobj            *xt,
+                   const char       *fingerprint,
+                   withdefaults_type wdef,
+                   int               system_only)
+{
+    int        retval = -1;
+    binary_enc be = {0,};
+    binary_buf bh = {0,}; /* Header and string table */
+    uint32_t   i;
+    size_t     len;
+
+    if (f == NULL || xt == NULL){
+        clixon_err(OE_XML, EINVAL, "f or xt is NULL");
+        goto done;
+    }
+    if ((be.be_hash = clicon_hash_init()) == NULL)
+        goto done;
+    be.be_wdef = wdef;
+    be.be_system_only = system_only;
+    be.be_strlen = 1; /* Index 0 is NULL */
+    if (binary_encode(&be, xt) < 0)
+        goto done;
+    if (binary_buf_append(&bh, CLIXON_BINARY_MAGIC, sizeof(CLIXON_BINARY_MAGIC)-1) < 0 ||
+        binary_buf_u32(&bh, CLIXON_BINARY_VERSION) < 0 ||
+        binary_buf_u32(&bh, fingerprint ? BINARY_FLAG_SORTED : 0) < 0)
+        goto done;
+    if (fingerprint == NULL)
+        fingerprint = "";
+    len = strlen(fingerprint);
+    if (binary_buf_u32(&bh, len) < 0 ||
+        binary_buf_append(&bh, fingerprint, len+1) < 0)
+        goto done;
+    if (binary_buf_u32(&bh, be.be_strlen-1) < 0)
+        goto done;
+    for (i = 1; i < be.be_strlen; i++){
+        len = strlen(be.be_strv[i]);
+        if (binary_buf_u32(&bh, len) < 0 ||
+            binary_buf_append(&bh, be.be_strv[i], len+1) < 0)
+            goto done;
+    }
+    if (fwrite(bh.bb_buf, 1, bh.bb_len, f) != bh.bb_len ||
+        fwrite(be.be_nodes.bb_buf, 1, be.be_nodes.bb_len, f) != be.be_nodes.bb_len){
+        clixon_err(OE_XML, errno, "fwrite");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (bh.bb_buf)
+        free(bh.bb_buf);
+    if (be.be_nodes.bb_buf)
+        free(be.be_nodes.bb_buf);
+    if (be.be_strv)
+        free(be.be_strv);
+    if (be.be_hash)
+        clicon_hash_free(be.be_hash);
+    return retval;
+}
+
+/*! Report malformed binary input
+ */
+static int
+binary_malformed(void)
+{
+    clixon_err(OE_XML, 0, "Malformed binary file");
+    return -1;
+}
+
+/*! Read 32-bit integer in network byte order from input
+ */
+static int
+binary_u32(binary_dec *bd,
+           uint32_t   *val)
+{
+    uint32_t n;
+
+    if ((size_t)(bd->bd_end - bd->bd_p) < sizeof(n))
+        return binary_malformed();
+    memcpy(&n, bd->bd_p, sizeof(n));
+    bd->bd_p += sizeof(n);
+    *val = ntohl(n);
+    return 0;
+}
+
+/*! Read a length-prefixed NULL-terminated string from input, return pointer into input
+ */
+static int
+binary_str(binary_dec *bd,
+           char      **str)
+{
+    uint32_t len;
+
+    if (binary_u32(bd, &len) < 0)
+        return -1;
+    if (len == BINARY_NOVALUE){
+        *str = NULL;
+        return 0;
+    }
+    if ((size_t)(bd->bd_end - bd->bd_p) <= len || bd->bd_p[len] != '\0')
+        return binary_malformed();
+    *str = (char*)bd->bd_p;
+    bd->bd_p += len+1;
+    return 0;
+}
+
+/*! Read string table index from input and return string
+ */
+static int
+binary_stridx(binary_dec *bd,
+              char      **str)
+{
+    uint32_t idx;
+
+    if (binary_u32(bd, &idx) < 0)
+        return -1;
+    if (idx >= bd->bd_strlen)
+        return binary_malformed();
+    *str = bd->bd_strv[idx];
+    return 0;
+}
+
+/*! Decode a node and its children in pre-order and add it to parent
+ *
+ * @param[in]  bd   Decoder state
+ * @param[in]  xp   XML parent
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+binary_decode(binary_dec *bd,
+              cxobj      *xp)
+{
+    int      retval = -1;
+    uint8_t  type;
+    char    *name;
+    char    *prefix;
+    char    *val;
+    uint32_t n;
+    uint32_t i;
+    cxobj   *x;
+
+    if (bd->bd_p >= bd->bd_end){
+        binary_malformed();
+        goto done;
+    }
+    type = *bd->bd_p++;
+    if (type != CX_ELMNT && type != CX_ATTR && type != CX_BODY){
+        binary_malformed();
+        goto done;
+    }
+    if (binary_stridx(bd, &name) < 0 ||
+        binary_stridx(bd, &prefix) < 0)
+        goto done;
+    if (name == NULL){
+        binary_malformed();
+        goto done;
+    }
+    if ((x = xml_new(name, xp, type)) == NULL)
+        goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+        goto done;
+    switch (type){
+    case CX_ELMNT:
+        if (binary_u32(bd, &n) < 0)
+            goto done;
+        for (i = 0; i < n; i++)
+            if (binary_decode(bd, x) < 0)
+                goto done;
+        break;
+    case CX_ATTR:
+        if (binary_stridx(bd, &val) < 0)
+            goto done;
+        if (val && xml_value_set(x, val) < 0)
+            goto done;
+        break;
+    case CX_BODY:
+        if (binary_str(bd, &val) < 0)
+            goto done;
+        if (val && xml_value_set(x, val) < 0)
+            goto done;
+        break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read an XML tree in binary format from file
+ *
+ * The file is memory-mapped and nodes are created directly from the mapped strings
+ * @param[in]     fp          Open file
+ * @param[in]     fingerprint Schema fingerprint of reader, or NULL
+ * @param[in,out] xt          Pointer to XML parse tree. If empty, create top named "top"
+ * @param[out]    sorted      If set, return 1 if tree is known to be sorted, otherwise 0
+ * @retval        0           OK
+ * @retval       -1           Error
+ * The tree is not bound to YANG, as clixon_xml_parse_file with YB_NONE.
+ * The tree is sorted if written with a fingerprint equal to the reader's.
+ * An empty file results in an empty top.
+ * @see clixon_binary2file
+ */
+int
+clixon_binary_parse_file(FILE       *fp,
+                         const char *fingerprint,
+                         cxobj     **xt,
+                         int        *sorted)
+{
+    int         retval = -1;
+    struct stat st;
+    void       *map = MAP_FAILED;
+    binary_dec  bd = {0,};
+    char        magic[sizeof(CLIXON_BINARY_MAGIC)-1];
+    uint32_t    version;
+    uint32_t    flags = 0;
+    uint32_t    nstr;
+    uint32_t    i;
+    char       *fp0 = NULL;
+    int         xtempty;
+
+    if (xt == NULL || fp == NULL){
+        clixon_err(OE_XML, EINVAL, "arg is NULL");
+        return -1;
+    }
+    xtempty = (*xt == NULL);
+    if (sorted)
+        *sorted = 0;
+    if (fstat(fileno(fp), &st) < 0){
+        clixon_err(OE_XML, errno, "fstat");
+        goto done;
+    }
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (st.st_size == 0)
+        goto ok;
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED){
+        clixon_err(OE_XML, errno, "mmap");
+        goto done;
+    }
+    bd.bd_p = map;
+    bd.bd_end = bd.bd_p + st.st_size;
+    if ((size_t)st.st_size < sizeof(magic) ||
+        memcmp(bd.bd_p, CLIXON_BINARY_MAGIC, sizeof(magic)) != 0){
+        clixon_err(OE_XML, 0, "Not a binary file");
+        goto done;
+    }
+    bd.bd_p += sizeof(magic);
+    if (binary_u32(&bd, &version) < 0)
+        goto done;
+    if (version != CLIXON_BINARY_VERSION){
+        clixon_err(OE_XML, 0, "Binary file version %u not supported, expected %u",
+                   version, CLIXON_BINARY_VERSION);
+        goto done;
+    }
+    if (binary_u32(&bd, &flags) < 0 ||
+        binary_str(&bd, &fp0) < 0 ||
+        binary_u32(&bd, &nstr) < 0)
+        goto done;
+    /* Each string needs at least length and terminator */
+    if (nstr > (bd.bd_end - bd.bd_p)/(sizeof(uint32_t)+1)){
+        binary_malformed();
+        goto done;
+    }
+    bd.bd_strlen = nstr + 1;
+    if ((bd.bd_strv = calloc(bd.bd_strlen, sizeof(char*))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        goto done;
+    }
+    for (i = 1; i < bd.bd_strlen; i++)
+        if (binary_str(&bd, &bd.bd_strv[i]) < 0)
+            goto done;
+    if (binary_decode(&bd, *xt) < 0)
+        goto done;
+    if (bd.bd_p != bd.bd_end){
+        binary_malformed();
+        goto done;
+    }
+    if (sorted && (flags & BINARY_FLAG_SORTED) &&
+        fingerprint && fp0 && strcmp(fingerprint, fp0) == 0)
+        *sorted = 1;
+ ok:
+    retval = 0;
+ done:
+    if (retval < 0 && *xt && xtempty){
+        xml_free(*xt);
+        *xt = NULL;
+    }
+    if (bd.bd_strv)
+        free(bd.bd_strv);
+    if (map != MAP_FAILED)
+        munmap(map, st.st_size);
+    return retval;
+}
@@ -81,10 +81,17 @@
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
 #include "clixon_json.h"
+#include "clixon_digest.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
 
+/*
+ * Variables
+ */
+/* Last datastore generation handed out, see xmldb_generation_next */
+static uint64_t _xmldb_generation = 0;
+
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
  * @param[in]  h    Clixon handle
@@ -235,6 +242,41 @@ xmldb_db2subdir(clixon_handle h,
     return retval;
 }
 
+/*! Get schema fingerprint of datastore files, a digest of the module-state
+ *
+ * Used by binary datastores to detect if a file was written with the same YANG modules.
+ * @param[in]   h        Clixon handle
+ * @param[out]  fpp      Fingerprint, NULL if no module-state. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_MODSTATE
+ */
+int
+xmldb_fingerprint(clixon_handle h,
+                  char        **fpp)
+{
+    int    retval = -1;
+    cxobj *xm;
+    cbuf  *cb = NULL;
+
+    *fpp = NULL;
+    if ((xm = clicon_modst_cache_get(h, 1)) != NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (clixon_xml2cbuf(cb, xm, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        if (clixon_digest_hex(cbuf_get(cb), fpp) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Connect to a datastore plugin, allocate resources to be used in API calls
  *
  * @param[in]  h    Clixon handle
@@ -342,6 +384,7 @@ xmldb_copy(clixon_handle h,
     if (de2)
         de0 = *de2;
     de0.de_xml = x2; /* The new tree */
+    de0.de_gen = xmldb_generation_next();
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, to, &subdir) < 0)
             goto done;
@@ -567,6 +610,7 @@ xmldb_clear(clixon_handle h,
         de->de_modified = 0;
         de->de_id = 0;
         memset(&de->de_tv, 0, sizeof(struct timeval));
+        de->de_gen = xmldb_generation_next();
     }
     return 0;
 }
@@ -663,6 +707,7 @@ xmldb_create(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_gen = xmldb_generation_next();
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
@@ -868,6 +913,47 @@ xmldb_volatile_set(clixon_handle h,
     return 0;
 }
 
+/*! Return a new datastore generation
+ *
+ * Generations are unique and increasing for the lifetime of the process.
+ * The first is seeded from the time of day so that values are not re-used after a
+ * restart, and a client holding an old value detects the change.
+ * @retval     gen   New generation
+ * @see xmldb_generation_get
+ */
+uint64_t
+xmldb_generation_next(void)
+{
+    struct timeval tv;
+
+    if (_xmldb_generation == 0){
+        gettimeofday(&tv, NULL);
+        _xmldb_generation = (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+    }
+    return ++_xmldb_generation;
+}
+
+/*! Get generation of datastore
+ *
+ * The generation changes whenever the content of the datastore may have changed, ie
+ * on load, edit, copy, clear, etc. It can be used by clients to check whether
+ * data read earlier from the datastore is still valid.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @retval     gen   Generation
+ * @retval     0     Datastore not loaded
+ */
+uint64_t
+xmldb_generation_get(clixon_handle h,
+                     const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return 0;
+    return de->de_gen;
+}
+
 /* Print the datastore meta-info to file
  */
 int
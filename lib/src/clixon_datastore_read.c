@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -80,6 +81,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
+#include "clixon_binary.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
@@ -524,6 +526,42 @@ xmldb_multi_read_applyfn(cxobj *x,
     return retval;
 }
 
+/*! Detect format of a datastore file if it differs from the configured format
+ *
+ * This makes it possible to change CLICON_XMLDB_FORMAT and keep existing datastores: they
+ * are read in their original format and converted when written next time.
+ * Only binary is detected if XML or JSON is configured.
+ * @param[in]     fp     Open datastore file, rewound to start on return
+ * @param[in,out] format Configured format on entry, actual format on exit
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+xmldb_format_detect(FILE             *fp,
+                    enum format_enum *format)
+{
+    int retval = -1;
+    int ret;
+    int c;
+
+    if ((ret = clixon_binary_file_is(fp)) < 0)
+        goto done;
+    if (ret == 1)
+        *format = FORMAT_BINARY;
+    else if (*format == FORMAT_BINARY){
+        while ((c = fgetc(fp)) != EOF && isspace(c))
+            ;
+        *format = (c == '{') ? FORMAT_JSON : FORMAT_XML;
+        if (fseek(fp, 0, SEEK_SET) < 0){
+            clixon_err(OE_XML, errno, "fseek");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Common read function that reads an XML tree from file
  *
  * @param[in]  th     Datastore text handle
@@ -569,6 +607,8 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
     struct xmldb_multi_read_arg mr = {0, };
+    char            *fingerprint = NULL;
+    int              sorted = 0;
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -584,7 +624,7 @@ xmldb_readfile(clixon_handle    h,
         clixon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
         goto done;
     }
-    if ((format = format_str2int(formatstr)) < 0){
+    if ((format = format_datastore_str2int(formatstr)) < 0){
         clixon_err(OE_XML, 0, "format not found %s", formatstr);
         goto done;
     }
@@ -600,6 +640,8 @@ xmldb_readfile(clixon_handle    h,
      *   config*
      * </config>
      * ret == 0 should not happen with YB_NONE. Binding is done later */
+    if (xmldb_format_detect(fp, &format) < 0)
+        goto done;
     switch (format){
     case FORMAT_JSON:
         if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x0, xerr) < 0)
@@ -609,6 +651,12 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (xmldb_fingerprint(h, &fingerprint) < 0)
+            goto done;
+        if (clixon_binary_parse_file(fp, fingerprint, &x0, &sorted) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
         goto done;
@@ -731,7 +779,8 @@ xmldb_readfile(clixon_handle    h,
             goto done;
         if (ret == 0)
             goto fail;
-        if (xml_sort_recurse(x0) < 0)
+        /* Binary file written sorted with same yang modules */
+        if (!sorted && xml_sort_recurse(x0) < 0)
             goto done;
     }
     if (xp){
@@ -745,6 +794,8 @@ xmldb_readfile(clixon_handle    h,
     }
     retval = 1;
  done:
+    if (fingerprint)
+        free(fingerprint);
     if (mr.mr_subdir)
         free(mr.mr_subdir);
     if (xmodfile)
@@ -810,6 +861,7 @@ xmldb_get_cache(clixon_handle     h,
          * No, argument against: we may want to have a semantically wrong file and wish to edit?
          */
         de0.de_xml = xt;
+        de0.de_gen = xmldb_generation_next();
         if (de)
             de0.de_id = de->de_id;
         clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
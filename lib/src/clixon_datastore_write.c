@@ -81,6 +81,7 @@
 #include "clixon_yang_schema_mount.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_io.h"
+#include "clixon_binary.h"
 #include "clixon_xml_bind.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
@@ -1460,6 +1461,8 @@ xmldb_put(clixon_handle       h,
             xml_free(x0);
             x0 = NULL;
         }
+        else if (de) /* Cached tree may be partially modified */
+            de->de_gen = xmldb_generation_next();
         goto fail;
     }
     /* Remove NONE nodes if all subs recursively are also NONE */
@@ -1494,6 +1497,7 @@ xmldb_put(clixon_handle       h,
     if (de0.de_xml == NULL)
         de0.de_xml = x0;
     de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
+    de0.de_gen = xmldb_generation_next();
     clicon_db_elmnt_set(h, db, &de0);
     /* Write cache to file unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
@@ -1629,6 +1633,7 @@ xmldb_dump(clixon_handle     h,
     struct xmldb_multi_write_arg mw = {0,};
     cxobj                       *xm;
     cxobj                       *xmodst = NULL;
+    char                        *fingerprint = NULL;
 
     /* Add modstate */
     if ((xm = clicon_modst_cache_get(h, 1)) != NULL){
@@ -1669,6 +1674,17 @@ xmldb_dump(clixon_handle     h,
                              clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (multi){
+            clixon_err(OE_CFG, EINVAL, "Binary+multi not supported");
+            goto done;
+        }
+        if (xmldb_fingerprint(h, &fingerprint) < 0)
+            goto done;
+        if (clixon_binary2file(f, xt, fingerprint, wdef,
+                               clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_XML, 0, "Format %s not supported", format_int2str(format));
         goto done;
@@ -1679,6 +1695,8 @@ xmldb_dump(clixon_handle     h,
         goto done;
     retval = 0;
  done:
+    if (fingerprint)
+        free(fingerprint);
     return retval;
 }
 
@@ -1711,7 +1729,7 @@ xmldb_write_cache2file(clixon_handle h,
     pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
     multi = clicon_option_bool(h, "CLICON_XMLDB_MULTI");
     if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) != NULL){
-        if ((format = format_str2int(formatstr)) < 0){
+        if ((format = format_datastore_str2int(formatstr)) < 0){
             clixon_err(OE_XML, 0, "Format %s invalid", formatstr);
             goto done;
         }
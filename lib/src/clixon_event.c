@@ -84,7 +84,7 @@
 struct event_data{
     struct event_data          *e_next;                 /* Next in list */
     int                       (*e_fn)(int, void*);      /* Callback function */
-    enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
+    enum {EVENT_FD, EVENT_FD_WRITE, EVENT_TIME} e_type; /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
     struct timeval              e_time;                 /* Timeout */
@@ -221,6 +221,30 @@ clixon_event_reg_fd(int   fd,
     return clixon_event_reg_fd_prio(fd, fn, arg, str, 0);
 }
 
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Used to drain output queued on a non-blocking write
+ * @param[in]  fd   File descriptor
+ * @param[in]  fn   Function to call when fd is writable
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @note Unregister when fd no longer has output pending, otherwise fn is called in every loop
+ * @see clixon_event_unreg_fd
+ */
+int
+clixon_event_reg_fd_write(int   fd,
+                          int (*fn)(int, void*),
+                          void *arg,
+                          char *str)
+{
+    if (clixon_event_reg_fd_prio(fd, fn, arg, str, 0) < 0)
+        return -1;
+    ee->e_type = EVENT_FD_WRITE;
+    return 0;
+}
+
 /*! Deregister a file descriptor callback
  *
  * @param[in]  s   File descriptor
@@ -408,11 +432,13 @@ clixon_event_loop(clixon_handle h)
     struct timeval     t0;
     struct timeval     tnull = {0,};
     fd_set             fdset;
+    fd_set             wfdset;
     int                retval = -1;
     struct event_data *e_next;
 
     while (clixon_exit_get() != 1){
         FD_ZERO(&fdset);
+        FD_ZERO(&wfdset);
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
@@ -422,16 +448,18 @@ clixon_event_loop(clixon_handle h)
         for (e=ee; e; e=e->e_next)
             if (e->e_type == EVENT_FD)
                 FD_SET(e->e_fd, &fdset);
+            else if (e->e_type == EVENT_FD_WRITE)
+                FD_SET(e->e_fd, &wfdset);
         if (ee_timers != NULL){
             gettimeofday(&t0, NULL);
             timersub(&ee_timers->e_time, &t0, &t);
             if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &tnull);
             else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &t);
         }
         else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+            n = select(FD_SETSIZE, &fdset, &wfdset, NULL, NULL);
         if (clixon_exit_get() == 1){
             break;
         }
@@ -506,7 +534,9 @@ clixon_event_loop(clixon_handle h)
             if (clixon_exit_get() == 1)
                 break;
             e_next = e->e_next;
-            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio==0){
+            if (((e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)) ||
+                 (e->e_type == EVENT_FD_WRITE && FD_ISSET(e->e_fd, &wfdset))) &&
+                e->e_prio==0){
                 clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
                 if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
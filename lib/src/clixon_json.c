@@ -89,6 +89,20 @@
 /* Name of xml top object created by parse functions */
 #define JSON_TOP_SYMBOL "top"
 
+/* Flush encoded json to sink when the internal buffer exceeds this size */
+#define JSON_SINK_THRESHOLD 16384
+
+/*! Streaming output sink
+ *
+ * Encoded JSON is accumulated in a cbuf and handed over to the sink callback in chunks
+ * whenever the buffer exceeds the threshold, thus bounding memory for large trees.
+ */
+typedef struct {
+    clixon_json_sink_fn *js_fn;        /* Sink callback */
+    void                *js_arg;       /* Sink callback argument */
+    size_t               js_threshold; /* Flush threshold in bytes */
+} json_sink;
+
 enum array_element_type{
     NO_ARRAY=0,
     FIRST_ARRAY,  /* [a, */
@@ -181,6 +195,39 @@ arraytype2str(enum array_element_type lt)
     return "";
 }
 
+/*! Check if sibling x2 belongs to the same JSON array as x
+ *
+ * If both are yang bound, the array boundary is given by the yang binding: same yang
+ * node means same name and namespace. This avoids name and xmlns comparisons for the
+ * common case of yang-bound trees.
+ * Otherwise fall back to compare name and namespace attributes.
+ * @param[in]  x     XML element
+ * @param[in]  ys    Yang spec of x, or NULL
+ * @param[in]  x2    Sibling XML element (previous or next)
+ * @retval     1     Same array
+ * @retval     0     Not same array
+ */
+static int
+array_sibling_eq(cxobj     *x,
+                 yang_stmt *ys,
+                 cxobj     *x2)
+{
+    yang_stmt *y2;
+    char      *nsx;
+    char      *ns2;
+
+    if (ys != NULL && (y2 = xml_spec(x2)) != NULL)
+        return ys == y2;
+    if (strcmp(xml_name(x), xml_name(x2)) != 0)
+        return 0;
+    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
+    ns2 = xml_find_type_value(x2, NULL, "xmlns", CX_ATTR);
+    if ((!nsx && !ns2)
+        || (nsx && ns2 && strcmp(nsx, ns2)==0))
+        return 1;
+    return 0;
+}
+
 /*! Check typeof x in array
  * 
  * Check if element is in an array, and if so, if it is in the start "[x,", in the middle: "[..,x,..]"
@@ -200,37 +247,23 @@ array_eval(cxobj *xprev,
     int                     eqprev=0;
     int                     eqnext=0;
     yang_stmt              *ys;
-    char                   *nsx; /* namespace of x */
-    char                   *ns2;
 
-    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
     if (xml_type(x) != CX_ELMNT){
         arraytype = BODY_ARRAY;
         goto done;
     }
-    if (xnext &&
-        xml_type(xnext)==CX_ELMNT &&
-        strcmp(xml_name(x), xml_name(xnext))==0){
-        ns2 = xml_find_type_value(xnext, NULL, "xmlns", CX_ATTR);
-        if ((!nsx && !ns2)
-            || (nsx && ns2 && strcmp(nsx,ns2)==0))
-            eqnext++;
-    }
-    if (xprev &&
-        xml_type(xprev)==CX_ELMNT &&
-        strcmp(xml_name(x),xml_name(xprev))==0){
-        ns2 = xml_find_type_value(xprev, NULL, "xmlns", CX_ATTR);
-        if ((!nsx && !ns2)
-            || (nsx && ns2 && strcmp(nsx,ns2)==0))
-            eqprev++;
-    }
+    ys = xml_spec(x);
+    if (xnext && xml_type(xnext)==CX_ELMNT)
+        eqnext = array_sibling_eq(x, ys, xnext);
+    if (xprev && xml_type(xprev)==CX_ELMNT)
+        eqprev = array_sibling_eq(x, ys, xprev);
     if (eqprev && eqnext)
         arraytype = MIDDLE_ARRAY;
     else if (eqprev)
         arraytype = LAST_ARRAY;
     else if (eqnext)
         arraytype = FIRST_ARRAY;
-    else if ((ys = xml_spec(x)) != NULL) {
+    else if (ys != NULL) {
         if (yang_keyword_get(ys) == Y_LIST || yang_keyword_get(ys) == Y_LEAF_LIST)
             arraytype = SINGLE_ARRAY;
         else
@@ -242,6 +275,25 @@ array_eval(cxobj *xprev,
     return arraytype;
 }
 
+/*! Flush encoded json in buffer to sink and reset buffer
+ *
+ * @param[in]  cb    Cligen buffer containing encoded json
+ * @param[in]  sink  Output sink
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+json_sink_flush(cbuf      *cb,
+                json_sink *sink)
+{
+    if (cbuf_len(cb) == 0)
+        return 0;
+    if ((*sink->js_fn)(sink->js_arg, cbuf_get(cb), cbuf_len(cb)) < 0)
+        return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+
 /*! Escape a json string as well as decode xml cdata
  *
  * @param[out] cb   cbuf   (encoded)
@@ -792,6 +844,7 @@ xml2json_encode_attr(cxobj     *xa,
  * @param[in]   system_only Enable checks for system-only-config extension
  * @param[in]   modname0
  * @param[out]  metacbp   Meta encoding of attribute
+ * @param[in]   sink      If set, flush cb to sink between children (streaming), or NULL
  * @retval      0         OK
  * @retval     -1         Error
  *
@@ -832,7 +885,8 @@ xml2json1_cbuf(cbuf                   *cb,
                int                     flat,
                int                     system_only,
                char                   *modname0,
-               cbuf                   *metacbp)
+               cbuf                   *metacbp,
+               json_sink              *sink)
 {
     int              retval = -1;
     int              i;
@@ -973,12 +1027,15 @@ xml2json1_cbuf(cbuf                   *cb,
                                xc,
                                xc_arraytype,
                                level+1, pretty, 0, system_only, modname0,
-                               metacbc) < 0)
+                               metacbc, sink) < 0)
                 goto done;
             if (commas > 0) {
                 cprintf(cb, ",%s", pretty?"\n":"");
                 --commas;
             }
+            if (sink && cbuf_len(cb) >= sink->js_threshold &&
+                json_sink_flush(cb, sink) < 0)
+                goto done;
         }
     }
     if (cbuf_len(metacbc)){
@@ -1058,6 +1115,7 @@ xml2json1_cbuf(cbuf                   *cb,
  * @param[in]     pretty      Set if output is pretty-printed
  * @param[in]     autocliext  How to handle autocli extensions: 0: ignore 1: follow
  * @param[in]     system_only Enable checks for system-only-config extension
+ * @param[in]     sink        Streaming output sink, or NULL
  * @retval        0           OK
  * @retval       -1           Error
  *
@@ -1065,11 +1123,12 @@ xml2json1_cbuf(cbuf                   *cb,
  * @see xml2json_cbuf_vec   Top symbol is list
  */
 static int
-xml2json_cbuf1(cbuf  *cb,
-               cxobj *x,
-               int    pretty,
-               int    autocliext,
-               int    system_only)
+xml2json_cbuf1(cbuf      *cb,
+               cxobj     *x,
+               int        pretty,
+               int        autocliext,
+               int        system_only,
+               json_sink *sink)
 {
     int                     retval = 1;
     int                     level = 0;
@@ -1107,7 +1166,8 @@ xml2json_cbuf1(cbuf  *cb,
                        0,
                        system_only,
                        NULL, /* ancestor modname / namespace */
-                       NULL) < 0)
+                       NULL,
+                       sink) < 0)
         goto done;
     cprintf(cb, "%s%*s}%s",
             pretty?"\n":"",
@@ -1119,6 +1179,49 @@ xml2json_cbuf1(cbuf  *cb,
     return retval;
 }
 
+/*! Translate an XML tree to JSON in a CLIgen buffer, optionally flushing to a sink
+ *
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xt          Top-level xml object
+ * @param[in]     pretty      Set if output is pretty-printed
+ * @param[in]     skiptop     0: Include top object 1: Skip top-object, only children,
+ * @param[in]     autocliext  How to handle autocli extensions: 0: ignore 1: follow
+ * @param[in]     system_only Enable checks for system-only-config extension
+ * @param[in]     sink        Streaming output sink, or NULL
+ * @retval        0           OK
+ * @retval       -1           Error
+ */
+static int
+json2cbuf_sink(cbuf      *cb,
+               cxobj     *xt,
+               int        pretty,
+               int        skiptop,
+               int        autocliext,
+               int        system_only,
+               json_sink *sink)
+{
+    int    retval = -1;
+    cxobj *xc;
+    int    i=0;
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
+            if (i++)
+                cprintf(cb, ",");
+            if (xml2json_cbuf1(cb, xc, pretty, autocliext, system_only, sink) < 0)
+                goto done;
+        }
+    }
+    else {
+        if (xml2json_cbuf1(cb, xt, pretty, autocliext, system_only, sink) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Translate an XML tree to JSON in a CLIgen buffer skip top-level object
  *
  * XML-style namespace notation in tree, but RFC7951 in output assume yang 
@@ -1139,6 +1242,7 @@ xml2json_cbuf1(cbuf  *cb,
  *   cbuf_free(cb);
  * @endcode
  * @see xml2json_cbuf where the top level object is included
+ * @see clixon_json2sink  Streaming variant
  */
 int
 clixon_json2cbuf(cbuf  *cb,
@@ -1148,25 +1252,61 @@ clixon_json2cbuf(cbuf  *cb,
                  int    autocliext,
                  int    system_only)
 {
-    int    retval = -1;
-    cxobj *xc;
-    int    i=0;
+    return json2cbuf_sink(cb, xt, pretty, skiptop, autocliext, system_only, NULL);
+}
 
-    if (skiptop){
-        xc = NULL;
-        while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
-            if (i++)
-                cprintf(cb, ",");
-            if (xml2json_cbuf1(cb, xc, pretty, autocliext, system_only) < 0)
-                goto done;
-        }
+/*! Translate an XML tree to JSON and stream it in chunks to a sink callback
+ *
+ * Instead of building the whole JSON text in memory, encoded output is handed to the sink
+ * in chunks of approximately JSON_SINK_THRESHOLD bytes. The sink may be a file, a socket,
+ * an SSL connection or a HTTP/2 data provider.
+ * @param[in]  xt          Top-level xml object
+ * @param[in]  pretty      Set if output is pretty-printed
+ * @param[in]  skiptop     0: Include top object 1: Skip top-object, only children,
+ * @param[in]  autocliext  How to handle autocli extensions: 0: ignore 1: follow
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @param[in]  fn          Sink callback, called one or several times
+ * @param[in]  arg         Sink callback argument
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @code
+ *   if (clixon_json2sink(xt, 0, 0, 0, 0, mysink, myarg) < 0)
+ *     goto err;
+ * @endcode
+ * @see clixon_json2cbuf
+ */
+int
+clixon_json2sink(cxobj               *xt,
+                 int                  pretty,
+                 int                  skiptop,
+                 int                  autocliext,
+                 int                  system_only,
+                 clixon_json_sink_fn *fn,
+                 void                *arg)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    json_sink sink = {0,};
+
+    if (fn == NULL){
+        clixon_err(OE_JSON, EINVAL, "fn is NULL");
+        goto done;
     }
-    else {
-        if (xml2json_cbuf1(cb, xt, pretty, autocliext, system_only) < 0)
-            goto done;
+    if ((cb = cbuf_new_alloc(JSON_SINK_THRESHOLD)) == NULL){
+        clixon_err(OE_JSON, errno, "cbuf_new");
+        goto done;
     }
+    sink.js_fn = fn;
+    sink.js_arg = arg;
+    sink.js_threshold = JSON_SINK_THRESHOLD;
+    if (json2cbuf_sink(cb, xt, pretty, skiptop, autocliext, system_only, &sink) < 0)
+        goto done;
+    if (json_sink_flush(cb, &sink) < 0)
+        goto done;
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -1235,7 +1375,7 @@ xml2json_cbuf_vec(cbuf      *cb,
                        NO_ARRAY,
                        level,
                        pretty,
-                       1, 0, NULL, NULL) < 0)
+                       1, 0, NULL, NULL, NULL) < 0)
         goto done;
 
     if (0){
@@ -1253,6 +1393,30 @@ xml2json_cbuf_vec(cbuf      *cb,
     return retval;
 }
 
+/* Argument to json_file_sink */
+struct json_file_arg {
+    FILE             *fa_f;  /* File to print to */
+    clicon_output_cb *fa_fn; /* File print function */
+};
+
+/*! Sink callback printing json chunks to file
+ *
+ * @param[in]  arg  File sink argument, struct json_file_arg
+ * @param[in]  buf  Encoded JSON chunk, null-terminated
+ * @param[in]  len  Length of chunk
+ * @retval     0    OK
+ */
+static int
+json_file_sink(void   *arg,
+               char   *buf,
+               size_t  len)
+{
+    struct json_file_arg *fa = (struct json_file_arg *)arg;
+
+    (*fa->fa_fn)(fa->fa_f, "%s", buf);
+    return 0;
+}
+
 /*! Translate from xml tree to JSON and print to file using a callback
  *
  * @param[in]  f           File to print to
@@ -1281,23 +1445,13 @@ clixon_json2file(FILE             *f,
                  int               autocliext,
                  int               system_only)
 {
-    int   retval = 1;
-    cbuf *cb = NULL;
+    struct json_file_arg fa = {0,};
 
     if (fn == NULL)
         fn = fprintf;
-    if ((cb = cbuf_new()) ==NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
-    if (clixon_json2cbuf(cb, xn, pretty, skiptop, autocliext, system_only) < 0)
-        goto done;
-    (*fn)(f, "%s", cbuf_get(cb));
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    fa.fa_f = f;
+    fa.fa_fn = fn;
+    return clixon_json2sink(xn, pretty, skiptop, autocliext, system_only, json_file_sink, &fa);
 }
 
 /*! Print an XML tree structure to an output stream as JSON
@@ -1353,77 +1507,11 @@ xml2json_vec(FILE             *f,
     return retval;
 }
 
-/*! Translate from JSON module:name to XML default ns: xmlns="uri" recursively
- *
- * Assume an xml tree where prefix:name have been split into "module":"name"
- * In other words, from JSON to XML namespace trees
- * 
- * @param[in]     yspec Yang spec
- * @param[in,out] x     XML tree. Translate it in-line
- * @param[out]    xerr  Reason for invalid tree returned as netconf err msg or NULL
- * @retval        1     OK 
- * @retval        0     Invalid, wrt namespace.  xerr set
- * @retval       -1     Error
- * @note the opposite - xml2ns is made inline in xml2json1_cbuf
- * Example: <top><module:input> --> <top><input xmlns="">
- * @see RFC7951 Sec 4
- */
-static int
-json_xmlns_translate(yang_stmt *yspec,
-                     cxobj     *x,
-                     cxobj    **xerr)
-{
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *namespace;
-    char      *modname = NULL;
-    cxobj     *xc;
-    int        ret;
-
-    if ((modname = xml_prefix(x)) != NULL){ /* prefix is here module name */
-        /* Special case for ietf-netconf -> ietf-restconf translation
-         * A special case is for return data on the form {"data":...}
-         * See also xml2json1_cbuf
-         */
-        if (strcmp(modname, "ietf-restconf") == 0)
-            modname = "ietf-netconf";
-        if ((ymod = yang_find_module_by_name(yspec, modname)) == NULL){
-            if (xerr &&
-                netconf_unknown_namespace_xml(xerr, "application",
-                                              modname,
-                                              "No yang module found corresponding to prefix") < 0)
-                goto done;
-            goto fail;
-        }
-        namespace = yang_find_mynamespace(ymod);
-        /* It would be possible to use canonical prefixes here, but probably not
-         * necessary or even right. Therefore, the namespace given by the JSON prefix / module
-         * is always the default namespace with prefix NULL.
-         * If not, this would be the prefix to pass instead of NULL
-         * prefix = yang_find_myprefix(ymod);
-         */
-        if (xml_namespace_change(x, namespace, NULL) < 0)
-            goto done;
-    }
-    xc = NULL;
-    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
-        if ((ret = json_xmlns_translate(yspec, xc, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-    }
-    retval = 1;
- done:
-    return retval;
- fail:
-    retval = 0;
-    goto done;
-}
-
 /*! Parse a string containing JSON and return an XML tree
  *
- * Parsing using yacc according to JSON syntax. Names with <prefix>:<id>
- * are split and interpreted as in RFC7951
+ * Parsing using a hand-written parser according to JSON syntax. Names with <prefix>:<id>
+ * are split and interpreted as in RFC7951, ie module names are translated to XML
+ * namespaces while parsing.
  *
  * @param[in]  str    Input string containing JSON
  * @param[in]  rfc7951 Do sanity checks according to RFC 7951 JSON Encoding of Data Modeled with YANG
@@ -1447,53 +1535,30 @@ _json_parse(char      *str,
             cxobj     *xt,
             cxobj    **xerr)
 {
-    int              retval = -1;
-    clixon_json_yacc jy = {0,};
-    int              ret;
-    cxobj           *x;
-    cbuf            *cberr = NULL;
-    int              i;
-    int              failed = 0; /* yang assignment */
+    int                retval = -1;
+    clixon_json_parser jp = {0,};
+    int                ret;
+    cxobj             *x;
+    int                i;
+    int                failed = 0; /* yang assignment */
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", str);
-    jy.jy_parse_string = str;
-    jy.jy_linenum = 1;
-    jy.jy_current = xt;
-    jy.jy_xtop = xt;
-    if (json_scan_init(&jy) < 0)
-        goto done;
-    if (json_parse_init(&jy) < 0)
-        goto done;
-    if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
-        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
-        if (clixon_err_category() == 0)
-            clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
+    jp.jp_parse_string = str;
+    jp.jp_linenum = 1;
+    jp.jp_rfc7951 = rfc7951;
+    jp.jp_yb = yb;
+    jp.jp_yspec = yspec;
+    jp.jp_xtop = xt;
+    jp.jp_xerr = xerr;
+    if ((ret = clixon_json_parse_buf(&jp)) < 0){
+        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jp.jp_linenum);
         goto done;
     }
+    if (ret == 0)
+        goto fail;
     /* Traverse new objects */
-    for (i = 0; i < jy.jy_xlen; i++) {
-        x = jy.jy_xvec[i];
-        /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all 
-         * members of a top-level JSON object 
-         */
-        if (rfc7951 && xml_prefix(x) == NULL){
-            /* XXX: For top-level config file: */
-            if (yb != YB_NONE || strcmp(xml_name(x),DATASTORE_TOP_SYMBOL)!=0){
-                if ((cberr = cbuf_new()) == NULL){
-                    clixon_err(OE_UNIX, errno, "cbuf_new");
-                    goto done;
-                }
-                cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", xml_name(x));
-                if (xerr && netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
-                    goto done;
-                goto fail;
-            }
-        }
-        /* Names are split into name/prefix, but now add namespace info */
-        if ((ret = json_xmlns_translate(yspec, x, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+    for (i = 0; i < jp.jp_xlen; i++) {
+        x = jp.jp_xvec[i];
         /* Now assign yang stmts to each XML node 
          * XXX should be xml_bind_yang0_parent() sometimes.
          */
@@ -1527,10 +1592,12 @@ _json_parse(char      *str,
         }
         /* Now find leafs with identityrefs (+transitive) and translate 
          * prefixes in values to XML namespaces */
-        if ((ret = json2xml_decode(x, xerr)) < 0)
-            goto done;
-        if (ret == 0) /* XXX necessary? */
-            goto fail;
+        if (yb != YB_NONE){
+            if ((ret = json2xml_decode(x, xerr)) < 0)
+                goto done;
+            if (ret == 0) /* XXX necessary? */
+                goto fail;
+        }
     }
     if (failed)
         goto fail;
@@ -1542,12 +1609,8 @@ _json_parse(char      *str,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
-    if (cberr)
-        cbuf_free(cberr);
-    json_parse_exit(&jy);
-    json_scan_exit(&jy);
-    if (jy.jy_xvec)
-        free(jy.jy_xvec);
+    if (jp.jp_xvec)
+        free(jp.jp_xvec);
     return retval;
  fail: /* invalid */
     retval = 0;
@@ -1641,11 +1704,9 @@ clixon_json_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *jsonbuf = NULL;
-    int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    jsonbuflen = BUFLEN; /* start size */
+    size_t    len = 0;
+    size_t    n;
 
     if (xt==NULL){
         clixon_err(OE_JSON, EINVAL, "xt is NULL");
@@ -1655,37 +1716,34 @@ clixon_json_parse_file(FILE      *fp,
         clixon_err(OE_JSON, errno, "malloc");
         goto done;
     }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
+    /* Read file in chunks, double buffer size when full */
     while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_JSON, errno, "read");
-            break;
-        }
-        if (ret != 0)
-            jsonbuf[len++] = ch;
-        if (ret == 0){
-            if (*xt == NULL)
-                if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _json_parse(ptr, rfc7951, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
         if (len >= jsonbuflen-1){ /* Space: one for the null character */
-            oldjsonbuflen = jsonbuflen;
             jsonbuflen *= 2;
             if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
                 clixon_err(OE_JSON, errno, "realloc");
                 goto done;
             }
-            memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-            ptr = jsonbuf;
         }
+        n = fread(jsonbuf+len, 1, jsonbuflen-1-len, fp);
+        len += n;
+        if (n == 0){
+            if (ferror(fp)){
+                clixon_err(OE_JSON, errno, "read");
+                goto done;
+            }
+            break;
+        }
+    }
+    jsonbuf[len] = '\0';
+    if (*xt == NULL)
+        if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _json_parse(jsonbuf, rfc7951, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
     retval = 1;
  done:
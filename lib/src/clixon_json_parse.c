@@ -0,0 +1,598 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written JSON parser building a cxobj tree directly
+ * @see http://www.ecma-international.org/publications/files/ECMA-ST/ECMA-404.pdf
+ *  and RFC 7951 JSON Encoding of Data Modeled with YANG
+ *
+ * Replaces a flex/bison grammar. The parser is a recursive-descent parser over the
+ * following grammar:
+ *
+ * value    ::= object | array | number | string | 'true' | 'false' | 'null' ;
+ * object   ::= '{' [pair {',' pair}] '}';
+ * pair     ::= string ':' value;
+ * array    ::= '[' [value {',' value}] ']';
+ *
+ * XML translation:
+ *   {"a":34}          <--> <a>34</a>
+ *   {"a":[1,2]}       <--> <a>1</a><a>2</a>
+ *   {"a":[]}          <--> <a/>
+ *   {"m:a":{"b":1}}   <--> <a xmlns="urn:m"><b>1</b></a>
+ * JSON member names on the form <module>:<name> are translated to XML namespaces
+ * in the same pass as the tree is built (RFC 7951 Sec 4).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_string.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_map.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_json_parse.h"
+
+/* Forward */
+static int json_parse_value(clixon_json_parser *jp, char *prefix, char *id);
+
+/*! Skip whitespace and count newlines
+ */
+static void
+json_skip_ws(clixon_json_parser *jp)
+{
+    char *p = jp->jp_ptr;
+
+    while (1){
+        switch (*p){
+        case '\n':
+            jp->jp_linenum++;
+            /* fall thru */
+        case ' ':
+        case '\t':
+        case '\r':
+            p++;
+            continue;
+        default:
+            break;
+        }
+        break;
+    }
+    jp->jp_ptr = p;
+}
+
+/*! Report syntax error at current position
+ */
+static int
+json_parse_error(clixon_json_parser *jp,
+                 char               *reason)
+{
+    clixon_err(OE_JSON, 0, "json_parse: line %d: %s at or before: '%.16s'",
+               jp->jp_linenum, reason, jp->jp_ptr);
+    return -1;
+}
+
+/*! Parse a quoted JSON string into the parser string buffer
+ *
+ * Unescaped control characters are not allowed in strings.
+ * On success jp_ptr is after the ending double quote.
+ * @param[in]  jp  JSON parser
+ * @retval     0   OK, string in jp->jp_cb
+ * @retval    -1   Error
+ */
+static int
+json_parse_string(clixon_json_parser *jp)
+{
+    char  *p;
+    char  *p0;
+    char   hex[5] = {0,};
+    char   utf[5];
+    cbuf  *cb = jp->jp_cb;
+
+    cbuf_reset(cb);
+    p = jp->jp_ptr;
+    if (*p != '"')
+        return json_parse_error(jp, "expected string");
+    p++;
+    while (1){
+        /* Fast scan of unescaped characters */
+        p0 = p;
+        while (*p != '"' && *p != '\\' && (unsigned char)*p >= 0x20)
+            p++;
+        if (p > p0 && cbuf_append_buf(cb, p0, p-p0) < 0){
+            clixon_err(OE_JSON, errno, "cbuf_append_buf");
+            return -1;
+        }
+        if (*p == '"')
+            break;
+        if (*p != '\\'){
+            jp->jp_ptr = p;
+            return json_parse_error(jp, *p?"control character in string":"unterminated string");
+        }
+        p++;
+        switch (*p){
+        case '"':
+        case '\\':
+        case '/':
+            cbuf_append(cb, *p);
+            break;
+        case 'b':
+            cbuf_append(cb, '\b');
+            break;
+        case 'f':
+            cbuf_append(cb, '\f');
+            break;
+        case 'n':
+            cbuf_append(cb, '\n');
+            break;
+        case 'r':
+            cbuf_append(cb, '\r');
+            break;
+        case 't':
+            cbuf_append(cb, '\t');
+            break;
+        case 'u':
+            if (strspn(p+1, "0123456789abcdefABCDEF") < 4){
+                jp->jp_ptr = p;
+                return json_parse_error(jp, "invalid unicode escape");
+            }
+            memcpy(hex, p+1, 4);
+            if (clixon_unicode2utf8(hex, utf, sizeof(utf)) < 0)
+                return -1;
+            cbuf_append_str(cb, utf);
+            p += 4;
+            break;
+        default:
+            jp->jp_ptr = p;
+            return json_parse_error(jp, "invalid escape");
+        }
+        p++;
+    }
+    jp->jp_ptr = p+1;
+    return 0;
+}
+
+/*! Translate JSON module name to XML namespace of a new element
+ *
+ * Uses a one-entry cache since consecutive members are most often in the same module.
+ * @param[in]  jp      JSON parser
+ * @param[in]  x       New XML element with prefix set to module name
+ * @param[in]  modname Module name
+ * @retval     1       OK
+ * @retval     0       Invalid, unknown module, jp_xerr set
+ * @retval    -1       Error
+ * @see xml2json1_cbuf for the reverse translation
+ */
+static int
+json_xmlns_translate1(clixon_json_parser *jp,
+                      cxobj              *x,
+                      char               *modname)
+{
+    yang_stmt *ymod;
+    char      *namespace;
+
+    /* Special case for ietf-netconf -> ietf-restconf translation
+     * A special case is for return data on the form {"data":...}
+     * See also xml2json1_cbuf
+     */
+    if (strcmp(modname, "ietf-restconf") == 0)
+        modname = "ietf-netconf";
+    if (jp->jp_modname && strcmp(jp->jp_modname, modname) == 0)
+        namespace = jp->jp_namespace;
+    else {
+        if ((ymod = yang_find_module_by_name(jp->jp_yspec, modname)) == NULL){
+            if (jp->jp_xerr &&
+                netconf_unknown_namespace_xml(jp->jp_xerr, "application",
+                                              modname,
+                                              "No yang module found corresponding to prefix") < 0)
+                return -1;
+            return 0;
+        }
+        namespace = yang_find_mynamespace(ymod);
+        jp->jp_modname = yang_argument_get(ymod);
+        jp->jp_namespace = namespace;
+    }
+    /* The namespace given by the JSON prefix / module is always the default namespace
+     * with prefix NULL.
+     */
+    if (xml_namespace_change(x, namespace, NULL) < 0)
+        return -1;
+    return 1;
+}
+
+/*! Create a new xml element from a JSON member name and make it current
+ *
+ * @param[in]  jp      JSON parser
+ * @param[in]  prefix  Module name or NULL
+ * @param[in]  id      Member name
+ * @retval     1       OK
+ * @retval     0       Invalid, jp_xerr set
+ * @retval    -1       Error
+ */
+static int
+json_current_new(clixon_json_parser *jp,
+                 char               *prefix,
+                 char               *id)
+{
+    cxobj *x;
+    int    top;
+    cbuf  *cberr = NULL;
+    int    ret;
+
+    top = (jp->jp_current == jp->jp_xtop);
+    /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all
+     * members of a top-level JSON object
+     * XXX: For top-level config file
+     */
+    if (top && jp->jp_rfc7951 && prefix == NULL &&
+        (jp->jp_yb != YB_NONE || strcmp(id, DATASTORE_TOP_SYMBOL) != 0)){
+        if ((cberr = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            return -1;
+        }
+        cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", id);
+        ret = 0;
+        if (jp->jp_xerr && netconf_malformed_message_xml(jp->jp_xerr, cbuf_get(cberr)) < 0)
+            ret = -1;
+        cbuf_free(cberr);
+        return ret;
+    }
+    if ((x = xml_new(id, jp->jp_current, CX_ELMNT)) == NULL)
+        return -1;
+    /* If topmost, add to top-list created list */
+    if (top && cxvec_append(x, &jp->jp_xvec, &jp->jp_xlen) < 0)
+        return -1;
+    jp->jp_current = x;
+    if (prefix){
+        if (xml_prefix_set(x, prefix) < 0)
+            return -1;
+        if ((ret = json_xmlns_translate1(jp, x, prefix)) <= 0)
+            return ret;
+    }
+    return 1;
+}
+
+/*! Add body to current element
+ *
+ * @param[in]  jp      JSON parser
+ * @param[in]  value   Body string, or NULL for JSON null
+ */
+static int
+json_current_body(clixon_json_parser *jp,
+                  char               *value)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", jp->jp_current, CX_BODY)) == NULL)
+        return -1;
+    if (value && xml_value_set(xb, value) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Parse a JSON object member: string ':' value
+ */
+static int
+json_parse_pair(clixon_json_parser *jp)
+{
+    int    retval = -1;
+    char  *name = NULL;
+    char  *prefix = NULL;
+    char  *id;
+    int    ret;
+
+    if (json_parse_string(jp) < 0)
+        goto done;
+    if ((name = strdup(cbuf_get(jp->jp_cb))) == NULL){
+        clixon_err(OE_JSON, errno, "strdup");
+        goto done;
+    }
+    /* Split name into prefix:name in place (extended JSON RFC7951) */
+    if ((id = strchr(name, ':')) != NULL){
+        *id++ = '\0';
+        prefix = name;
+    }
+    else
+        id = name;
+    json_skip_ws(jp);
+    if (*jp->jp_ptr != ':'){
+        json_parse_error(jp, "expected ':'");
+        goto done;
+    }
+    jp->jp_ptr++;
+    if ((ret = json_current_new(jp, prefix, id)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((ret = json_parse_value(jp, prefix, id)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    jp->jp_current = xml_parent(jp->jp_current);
+    retval = 1;
+ done:
+    if (name)
+        free(name);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Parse a JSON object: '{' [pair {',' pair}] '}'
+ */
+static int
+json_parse_object(clixon_json_parser *jp)
+{
+    int ret;
+
+    jp->jp_ptr++; /* { */
+    json_skip_ws(jp);
+    if (*jp->jp_ptr == '}'){
+        jp->jp_ptr++;
+        return 1;
+    }
+    while (1){
+        json_skip_ws(jp);
+        if ((ret = json_parse_pair(jp)) <= 0)
+            return ret;
+        json_skip_ws(jp);
+        if (*jp->jp_ptr == ','){
+            jp->jp_ptr++;
+            continue;
+        }
+        if (*jp->jp_ptr == '}'){
+            jp->jp_ptr++;
+            break;
+        }
+        return json_parse_error(jp, "expected ',' or '}'");
+    }
+    return 1;
+}
+
+/*! Parse a JSON array: '[' [value {',' value}] ']'
+ *
+ * Each value after the first creates a new sibling element with the same name as the
+ * member the array belongs to.
+ * @param[in]  jp      JSON parser
+ * @param[in]  prefix  Module name of member, or NULL
+ * @param[in]  id      Member name, or NULL if top-level
+ */
+static int
+json_parse_array(clixon_json_parser *jp,
+                 char               *prefix,
+                 char               *id)
+{
+    int ret;
+    int i = 0;
+
+    jp->jp_ptr++; /* [ */
+    json_skip_ws(jp);
+    if (*jp->jp_ptr == ']'){
+        jp->jp_ptr++;
+        return 1;
+    }
+    while (1){
+        if (i++ > 0){
+            if (id == NULL)
+                return json_parse_error(jp, "array of values at top-level");
+            jp->jp_current = xml_parent(jp->jp_current);
+            if ((ret = json_current_new(jp, prefix, id)) <= 0)
+                return ret;
+        }
+        if ((ret = json_parse_value(jp, prefix, id)) <= 0)
+            return ret;
+        json_skip_ws(jp);
+        if (*jp->jp_ptr == ','){
+            jp->jp_ptr++;
+            continue;
+        }
+        if (*jp->jp_ptr == ']'){
+            jp->jp_ptr++;
+            break;
+        }
+        return json_parse_error(jp, "expected ',' or ']'");
+    }
+    return 1;
+}
+
+/*! Parse a JSON number
+ *
+ * Number is kept as string in the XML body and not converted
+ * An integer part is required, and a fraction must have at least one digit (RFC 8259 Sec 6)
+ */
+static int
+json_parse_number(clixon_json_parser *jp)
+{
+    char *p = jp->jp_ptr;
+    char *p0 = p;
+    int   digits = 0;
+
+    if (*p == '-')
+        p++;
+    while (*p >= '0' && *p <= '9'){
+        digits++;
+        p++;
+    }
+    if (digits == 0)
+        return json_parse_error(jp, "invalid number");
+    if (*p == '.'){
+        p++;
+        if (*p < '0' || *p > '9')
+            return json_parse_error(jp, "invalid number fraction");
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+    if (*p == 'e' || *p == 'E'){
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        if (*p < '0' || *p > '9')
+            return json_parse_error(jp, "invalid number exponent");
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+    cbuf_reset(jp->jp_cb);
+    if (cbuf_append_buf(jp->jp_cb, p0, p-p0) < 0){
+        clixon_err(OE_JSON, errno, "cbuf_append_buf");
+        return -1;
+    }
+    jp->jp_ptr = p;
+    if (json_current_body(jp, cbuf_get(jp->jp_cb)) < 0)
+        return -1;
+    return 1;
+}
+
+/*! Parse a JSON value and add it to the current element
+ *
+ * Nesting of objects and arrays is limited by JSON_PARSE_DEPTH_MAX, since they are parsed
+ * recursively
+ * @param[in]  jp      JSON parser
+ * @param[in]  prefix  Module name of enclosing member, or NULL
+ * @param[in]  id      Name of enclosing member, or NULL if top-level
+ * @retval     1       OK
+ * @retval     0       Invalid, jp_xerr set
+ * @retval    -1       Error
+ */
+static int
+json_parse_value(clixon_json_parser *jp,
+                 char               *prefix,
+                 char               *id)
+{
+    char *p;
+    int   ret;
+
+    json_skip_ws(jp);
+    p = jp->jp_ptr;
+    switch (*p){
+    case '{':
+    case '[':
+        if (jp->jp_depth >= JSON_PARSE_DEPTH_MAX)
+            return json_parse_error(jp, "too deeply nested");
+        jp->jp_depth++;
+        if (*p == '{')
+            ret = json_parse_object(jp);
+        else
+            ret = json_parse_array(jp, prefix, id);
+        jp->jp_depth--;
+        return ret;
+    case '"':
+        if (json_parse_string(jp) < 0)
+            return -1;
+        if (json_current_body(jp, cbuf_get(jp->jp_cb)) < 0)
+            return -1;
+        return 1;
+    case 't':
+        if (strncmp(p, "true", 4) != 0)
+            break;
+        jp->jp_ptr += 4;
+        return json_current_body(jp, "true")<0?-1:1;
+    case 'f':
+        if (strncmp(p, "false", 5) != 0)
+            break;
+        jp->jp_ptr += 5;
+        return json_current_body(jp, "false")<0?-1:1;
+    case 'n':
+        if (strncmp(p, "null", 4) != 0)
+            break;
+        jp->jp_ptr += 4;
+        return json_current_body(jp, NULL)<0?-1:1;
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return json_parse_number(jp);
+    default:
+        break;
+    }
+    return json_parse_error(jp, "syntax error");
+}
+
+/*! Parse JSON string in jp_parse_string into XML tree under jp_xtop
+ *
+ * Module-qualified member names are translated to XML namespaces while parsing.
+ * @param[in]  jp   JSON parser, with jp_parse_string, jp_xtop and options set
+ * @retval     1    OK
+ * @retval     0    Invalid, jp_xerr set
+ * @retval    -1    Error, including syntax errors
+ */
+int
+clixon_json_parse_buf(clixon_json_parser *jp)
+{
+    int retval = -1;
+    int ret;
+
+    if ((jp->jp_cb = cbuf_new()) == NULL){
+        clixon_err(OE_JSON, errno, "cbuf_new");
+        goto done;
+    }
+    jp->jp_ptr = jp->jp_parse_string;
+    jp->jp_current = jp->jp_xtop;
+    jp->jp_depth = 0;
+    if ((ret = json_parse_value(jp, NULL, NULL)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    json_skip_ws(jp);
+    if (*jp->jp_ptr != '\0'){
+        json_parse_error(jp, "trailing characters");
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (jp->jp_cb){
+        cbuf_free(jp->jp_cb);
+        jp->jp_cb = NULL;
+    }
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -32,42 +32,43 @@
 
   ***** END LICENSE BLOCK *****
 
+ * Hand-written JSON parser, see clixon_json_parse.c
  */
 #ifndef _CLIXON_JSON_PARSE_H_
 #define _CLIXON_JSON_PARSE_H_
 
 /*
- * Types
+ * Constants
  */
-
-struct clixon_json_yacc {
-    int        jy_linenum;      /* Number of \n in parsed buffer */
-    char      *jy_parse_string; /* original (copy of) parse string */
-    void      *jy_lexbuf;       /* internal parse buffer from lex */
-    cxobj     *jy_xtop;         /* cxobj top element (fixed) */
-    cxobj     *jy_current;      /* cxobj active element (changes with parse context) */
-    cxobj    **jy_xvec;         /* Vector of created top-level nodes (to know which are created) */
-    int        jy_xlen;         /* Length of jy_xvec */
-    cbuf      *jy_cbuf_str;     /* cbuf used for strings, if error needs to be deallocated */
-};
-typedef struct clixon_json_yacc clixon_json_yacc;
+/* Max nesting of JSON objects and arrays, beyond which input is a syntax error */
+#define JSON_PARSE_DEPTH_MAX 1024
 
 /*
- * Variables
+ * Types
  */
-extern char *clixon_json_parsetext;
+
+struct clixon_json_parser {
+    int        jp_linenum;      /* Number of \n in parsed buffer */
+    char      *jp_parse_string; /* original parse string */
+    char      *jp_ptr;          /* current position in parse string */
+    int        jp_rfc7951;      /* Top-level members must be namespace-qualified */
+    yang_bind  jp_yb;           /* How yang will be bound to top-level nodes */
+    yang_stmt *jp_yspec;        /* Yang spec for module -> namespace translation */
+    cxobj     *jp_xtop;         /* cxobj top element (fixed) */
+    cxobj     *jp_current;      /* cxobj active element (changes with parse context) */
+    cxobj    **jp_xvec;         /* Vector of created top-level nodes (to know which are created) */
+    int        jp_xlen;         /* Length of jp_xvec */
+    cbuf      *jp_cb;           /* Reused buffer for strings */
+    char      *jp_modname;      /* Cache of last translated module name */
+    char      *jp_namespace;    /* Cache of namespace of jp_modname */
+    cxobj    **jp_xerr;         /* Reason for invalid returned as netconf err msg */
+    int        jp_depth;        /* Current nesting of objects and arrays */
+};
+typedef struct clixon_json_parser clixon_json_parser;
 
 /*
  * Prototypes
  */
-int json_scan_init(clixon_json_yacc *jy);
-int json_scan_exit(clixon_json_yacc *jy);
-
-int json_parse_init(clixon_json_yacc *jy);
-int json_parse_exit(clixon_json_yacc *jy);
-
-int clixon_json_parselex(void *);
-int clixon_json_parseparse(void *);
-void clixon_json_parseerror(void *, char*);
+int clixon_json_parse_buf(clixon_json_parser *jp);
 
 #endif  /* _CLIXON_JSON_PARSE_H_ */
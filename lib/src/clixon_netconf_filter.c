@@ -0,0 +1,445 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ *  netconf match & selection: get and edit operations
+ *  Subtree filtering, see RFC 6241 Section 6
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_string.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_yang_module.h"
+#include "clixon_netconf_filter.h"
+
+/* xf specifices a filter, and xn is an xml tree.
+ * Select the part of xn that matches xf and return it.
+ * Change xn destructively by removing the parts of the sub-tree that does 
+ * not match.
+ * Match according to Section 6 of RFC 4741.
+    NO_FILTER,       select all 
+    EMPTY_FILTER,    select nothing 
+    ATTRIBUTE_MATCH, select if attribute match 
+    SELECTION,       select this node 
+    CONTENT_MATCH,   select all siblings with matching content 
+    CONTAINMENT      select 
+ */
+
+/* return a string containing leafs value, NULL if no leaf or no value */
+static char*
+leafstring(cxobj *x)
+{
+    cxobj *c;
+
+    if (xml_type(x) != CX_ELMNT)
+        return NULL;
+    if (xml_child_nr(x) != 1)
+        return NULL;
+    c = xml_child_i(x, 0);
+    if (xml_child_nr(c) != 0)
+        return NULL;
+    if (xml_type(c) != CX_BODY)
+        return NULL;
+    return xml_value(c);
+}
+
+/*! Internal recursive part where configuration xml tree is pruned from filter
+ *
+ * assume parent has been selected and filter match (same name) as parent
+ * parent is pruned according to selection.
+ * @param[in]  xfilter  Filter xml
+ * @param[out] xconf    Configuration xml
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xml_filter_recursive(cxobj *xfilter,
+                     cxobj *xparent,
+                     int   *remove_me)
+{
+    cxobj *s;
+    cxobj *sprev;
+    cxobj *f;
+    cxobj *attr;
+    char *an;
+    char *af;
+    char *fstr;
+    char *sstr;
+    int   containments;
+    int   remove_s;
+
+    *remove_me = 0;
+    /* 1. Check selection */
+    if (xml_child_nr(xfilter) == 0)
+        goto match;
+
+    /* Count containment/selection nodes in filter */
+    f = NULL;
+    containments = 0;
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+        if (leafstring(f))
+            continue;
+        containments++;
+    }
+
+    /* 2. Check attribute match */
+    attr = NULL;
+    while ((attr = xml_child_each(xfilter, attr, CX_ATTR)) != NULL) {
+        af = xml_value(attr);
+        an = xml_find_value(xfilter, xml_name(attr));
+        if (af && an && strcmp(af, an)==0)
+            ; // match
+        else
+            goto nomatch;
+    }
+    /* 3. Check content match */
+    f = NULL;
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+        if ((fstr = leafstring(f)) == NULL)
+            continue;
+        if ((s = xml_find(xparent, xml_name(f))) == NULL)
+            goto nomatch;
+        if ((sstr = leafstring(s)) == NULL)
+            continue;
+        if (strcmp(fstr, sstr))
+            goto nomatch;
+    }
+    /* If filter has no further specifiers, accept */
+    if (!containments)
+        goto match;
+    /* Check recursively the rest of the siblings */
+    sprev = s = NULL;
+    while ((s = xml_child_each(xparent, s, CX_ELMNT)) != NULL) {
+        if ((f = xml_find(xfilter, xml_name(s))) == NULL){
+            xml_purge(s);
+            s = sprev;
+            continue;
+        }
+        if (leafstring(f)){
+            sprev = s;
+            continue; // unsure?sk=lf
+        }
+        // XXX: s can be removed itself in the recursive call !
+        remove_s = 0;
+        if (xml_filter_recursive(f, s, &remove_s) < 0)
+            return -1;
+        if (remove_s){
+            xml_purge(s);
+            s = sprev;
+        }
+        sprev = s;
+    }
+
+  match:
+    return 0;
+  nomatch: /* prune this parent node (maybe only children?) */
+    *remove_me = 1;
+    return 0;
+}
+
+/*! Remove parts of configuration xml tree that does not match filter xml tree
+ *
+ * @param[in]  xfilter  Filter xml
+ * @param[out] xconf    Configuration xml
+ * @retval  0  OK
+ * @retval -1  Error
+ * This is the top-level function, calls a recursive variant.
+ */
+int
+xml_filter(cxobj *xfilter,
+           cxobj *xconfig)
+{
+    int retval;
+    int remove_s;
+
+    /* Call recursive variant */
+    retval = xml_filter_recursive(xfilter,
+                                  xconfig,
+                                  &remove_s);
+    return retval;
+}
+
+/*! Append quoted literal to xpath, select quote character from value
+ *
+ * @param[in]  cb   XPath buffer
+ * @param[in]  val  Literal value
+ * @retval     1    OK
+ * @retval     0    Value contains both quote characters and cannot be expressed
+ */
+static int
+filter_xpath_literal(cbuf *cb,
+                     char *val)
+{
+    if (strchr(val, '\'') == NULL)
+        cprintf(cb, "'%s'", val);
+    else if (strchr(val, '"') == NULL)
+        cprintf(cb, "\"%s\"", val);
+    else
+        return 0;
+    return 1;
+}
+
+/*! Find YANG data node and namespace prefix of a subtree filter element
+ *
+ * @param[in]  xf     Filter element
+ * @param[in]  yp     YANG parent, or NULL if top-level
+ * @param[in]  yspec  YANG spec
+ * @param[in]  nsc    Namespace context, prefix of matching node is added
+ * @param[out] yfp    YANG data node
+ * @retval     1      OK, yfp set
+ * @retval     0      No YANG or namespace for this element, or prefix conflict
+ * @retval    -1      Error
+ */
+static int
+filter_xpath_yang(cxobj      *xf,
+                  yang_stmt  *yp,
+                  yang_stmt  *yspec,
+                  cvec       *nsc,
+                  yang_stmt **yfp)
+{
+    char      *ns = NULL;
+    char      *ns0;
+    char      *prefix;
+    yang_stmt *ymod;
+    yang_stmt *y;
+
+    if (xml2ns(xf, xml_prefix(xf), &ns) < 0)
+        return -1;
+    if (ns == NULL)
+        return 0;
+    if (yp == NULL){
+        if ((ymod = yang_find_module_by_namespace(yspec, ns)) == NULL)
+            return 0;
+        yp = ymod;
+    }
+    if ((y = yang_find_datanode(yp, xml_name(xf))) == NULL)
+        return 0;
+    if (yang_find_mynamespace(y) == NULL ||
+        strcmp(yang_find_mynamespace(y), ns) != 0)
+        return 0;
+    if ((prefix = yang_find_myprefix(y)) == NULL)
+        return 0;
+    if ((ns0 = xml_nsctx_get(nsc, prefix)) == NULL){
+        if (xml_nsctx_add(nsc, prefix, ns) < 0)
+            return -1;
+    }
+    else if (strcmp(ns0, ns) != 0)
+        return 0;
+    *yfp = y;
+    return 1;
+}
+
+/*! Translate subtree filter element to xpath, recursive part
+ *
+ * Descend through containment nodes without content match nodes. Stop at
+ * selection nodes and nodes with content match nodes, where content match
+ * leafs are translated to predicates.
+ * @param[in]  xf     Filter element
+ * @param[in]  yf     YANG of filter element
+ * @param[in]  yspec  YANG spec
+ * @param[in]  path   XPath of filter element, including xf
+ * @param[in]  nsc    Namespace context
+ * @param[out] cbx    XPath union, appended to
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+filter2xpath_recursive(cxobj     *xf,
+                       yang_stmt *yf,
+                       yang_stmt *yspec,
+                       cbuf      *path,
+                       cvec      *nsc,
+                       cbuf      *cbx)
+{
+    int        retval = -1;
+    cxobj     *f;
+    yang_stmt *y;
+    char      *fstr;
+    size_t     len;
+    int        content = 0;
+    int        containments = 0;
+    int        ret;
+
+    len = cbuf_len(path);
+    /* Content match nodes: add predicates */
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ELMNT)) != NULL) {
+        if ((fstr = leafstring(f)) == NULL){
+            containments++;
+            continue;
+        }
+        content++;
+        if ((ret = filter_xpath_yang(f, yf, yspec, nsc, &y)) < 0)
+            goto done;
+        if (ret == 0 ||
+            (yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST))
+            continue; /* No predicate is a superset */
+        cprintf(path, "[%s:%s=", yang_find_myprefix(y), xml_name(f));
+        if (filter_xpath_literal(path, fstr) == 0){
+            cbuf_trunc(path, len);
+            continue;
+        }
+        /* An empty leaf matches any content, see xml_filter_recursive */
+        if (yang_keyword_get(yf) != Y_LIST ||
+            yang_key_match(yf, xml_name(f), NULL) != 1)
+            cprintf(path, " or %s:%s=''", yang_find_myprefix(y), xml_name(f));
+        cprintf(path, "]");
+        len = cbuf_len(path);
+    }
+    if (content || containments == 0)
+        goto stop;
+    /* Pure containment node: all children must be translatable */
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ELMNT)) != NULL) {
+        if ((ret = filter_xpath_yang(f, yf, yspec, nsc, &y)) < 0)
+            goto done;
+        if (ret == 0)
+            goto stop;
+    }
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ELMNT)) != NULL) {
+        if (filter_xpath_yang(f, yf, yspec, nsc, &y) < 0)
+            goto done;
+        cprintf(path, "/%s:%s", yang_find_myprefix(y), xml_name(f));
+        if (filter2xpath_recursive(f, y, yspec, path, nsc, cbx) < 0)
+            goto done;
+        cbuf_trunc(path, len);
+    }
+    retval = 0;
+ done:
+    return retval;
+ stop:
+    if (cbuf_len(cbx))
+        cprintf(cbx, " | ");
+    cprintf(cbx, "%s", cbuf_get(path));
+    retval = 0;
+    goto done;
+}
+
+/*! Translate a subtree filter to an xpath selecting a superset of the result
+ *
+ * The xpath can be used to limit what is read from datastores and state callbacks
+ * before xml_filter is applied to the result for the exact subtree semantics.
+ * @param[in]  xfilter  Filter xml, ie <filter type="subtree">
+ * @param[in]  yspec    YANG spec
+ * @param[out] xpathp   XPath, or NULL if all is selected. Free with free()
+ * @param[out] nscp     Namespace context of xpath. Free with xml_nsctx_free()
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @code
+ *   <filter type="subtree"><table xmlns="urn:example:clixon"><parameter><name>a</name></parameter></table></filter>
+ * @endcode
+ * is translated to: /ex:table/ex:parameter[ex:name='a']
+ */
+int
+xml_filter2xpath(cxobj     *xfilter,
+                 yang_stmt *yspec,
+                 char     **xpathp,
+                 cvec     **nscp)
+{
+    int        retval = -1;
+    cvec      *nsc = NULL;
+    cbuf      *path = NULL;
+    cbuf      *cbx = NULL;
+    cxobj     *f;
+    yang_stmt *y;
+    int        ret;
+
+    *xpathp = NULL;
+    *nscp = NULL;
+    if ((nsc = xml_nsctx_init(NULL, NULL)) == NULL)
+        goto done;
+    if ((path = cbuf_new()) == NULL ||
+        (cbx = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (xml_child_nr_type(xfilter, CX_ELMNT) == 0)
+        goto ok;
+    /* Content match at top-level is unusual, select all */
+    f = NULL;
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+        if (leafstring(f) != NULL)
+            goto ok;
+        if ((ret = filter_xpath_yang(f, NULL, yspec, nsc, &y)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    f = NULL;
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+        if (filter_xpath_yang(f, NULL, yspec, nsc, &y) < 0)
+            goto done;
+        cbuf_reset(path);
+        cprintf(path, "/%s:%s", yang_find_myprefix(y), xml_name(f));
+        if (filter2xpath_recursive(f, y, yspec, path, nsc, cbx) < 0)
+            goto done;
+    }
+    if ((*xpathp = strdup(cbuf_get(cbx))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    *nscp = nsc;
+    nsc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (path)
+        cbuf_free(path);
+    if (cbx)
+        cbuf_free(cbx);
+    return retval;
+}
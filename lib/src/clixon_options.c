@@ -141,6 +141,15 @@ static const map_str2int _FORMATS[] = {
     {NULL,      -1}
 };
 
+/*! Formats only valid for datastore files, not as output formats
+ *
+ * @see format_datastore_str2int
+ */
+static const map_str2int _DATASTORE_FORMATS[] = {
+    {"binary",           FORMAT_BINARY},
+    {NULL,      -1}
+};
+
 /*! Translate from numeric format to string representation
  *
  * @param[in]  showas   Format value (see enum format_enum)
@@ -149,7 +158,11 @@ static const map_str2int _FORMATS[] = {
 char *
 format_int2str(enum format_enum showas)
 {
-    return (char*)clicon_int2str(_FORMATS, showas);
+    const char *str;
+
+    if ((str = clicon_int2str(_FORMATS, showas)) == NULL)
+        str = clicon_int2str(_DATASTORE_FORMATS, showas);
+    return (char*)str;
 }
 
 /*! Translate from string to numeric format representation
@@ -163,6 +176,23 @@ format_str2int(char *str)
     return clicon_str2int(_FORMATS, str);
 }
 
+/*! Translate from string to numeric datastore format representation
+ *
+ * As format_str2int but also accepts formats only valid for datastore files, eg binary
+ * @param[in]  str       String value
+ * @retval     enum      Format value (see enum format_enum)
+ * @see CLICON_XMLDB_FORMAT
+ */
+enum format_enum
+format_datastore_str2int(char *str)
+{
+    int format;
+
+    if ((format = clicon_str2int(_DATASTORE_FORMATS, str)) < 0)
+        format = clicon_str2int(_FORMATS, str);
+    return format;
+}
+
 /*! Debug dump config options
  *
  * @param[in] h        Clixon handle
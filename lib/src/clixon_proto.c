@@ -515,10 +515,12 @@ clixon_rpc10(int         sock,
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[in]   descr  Description of peer for logging
- * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[in]   cb     Message, chunked framing is added in place
+ * @retval      0      OK
+ * @retval     -1      Error
  * @see clixon_msg_send10  1.0 EOM
  */
-static int
+int
 clixon_msg_send11(int         s,
                   const char *descr,
                   cbuf       *cb)
@@ -778,6 +780,24 @@ send_msg_notify(int         s,
     return retval;
 }
 
+/*! Send an already framed NOTIFY message asynchronously to client
+ *
+ * The same message may be sent to several clients without copying
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  descr   Description of peer for logging
+ * @param[in]  msg     NETCONF 1.1 chunk-framed message
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see stream_notification_msg
+ */
+int
+send_msg_notify_msg(int         s,
+                    const char *descr,
+                    cbuf       *msg)
+{
+    return clixon_msg_send(s, descr, msg);
+}
+
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
  * @param[in]  h     Clixon handle
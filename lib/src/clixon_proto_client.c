@@ -966,71 +966,30 @@ clicon_rpc_get(clixon_handle   h,
     return clicon_rpc_get2(h, xpath, nsc, content, depth, defaults, 1, xt);
 }
 
-/*! Get database configuration and state data (please use instead of clicon_rpc_get)
+/*! Create get request
  *
  * @param[in]  h         Clixon handle
  * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
- * @param[in]  namespace Namespace associated w xpath
  * @param[in]  nsc       Namespace context for filter
  * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
  * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
  * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
- * @param[out] xt        XML tree. Free with xml_free. 
- *                       Either <config> or <rpc-error>. 
+ * @param[out] cb        Request
  * @retval     0         OK
- * @retval    -1         Error, fatal or xml
- * @note if xpath is set but namespace is NULL, the default, netconf base 
- *       namespace will be used which is most probably wrong.
- * @code
- *  cxobj *xt = NULL;
- *  cvec *nsc = NULL;
- *
- *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
- *     err;
- *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
- *     err;
- *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
- *     clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
- *     err;
- *  }
- *  if (xt)
- *     xml_free(xt);
- *  if (nsc)
- *     xml_nsctx_free(nsc);
- * @endcode
- * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
- * @see clixon_err_netconf
- * @note the netconf return message is yang populated, as well as the return data
+ * @retval    -1         Error
  */
-int
-clicon_rpc_get2(clixon_handle   h,
+static int
+rpc_get_request(clixon_handle   h,
                 char           *xpath,
-                cvec           *nsc, /* namespace context for filter */
+                cvec           *nsc,
                 netconf_content content,
                 int32_t         depth,
                 char           *defaults,
-                int             bind,
-                cxobj         **xt)
+                cbuf           *cb)
 {
-    int                retval = -1;
-    struct clicon_msg *msg = NULL;
-    cbuf              *cb = NULL;
-    cxobj             *xret = NULL;
-    cxobj             *xerr = NULL;
-    cxobj             *xd = NULL;
-    char              *username;
-    uint32_t           session_id;
-    int                ret;
-    yang_stmt         *yspec;
-    cvec              *nscd = NULL;
+    int   retval = -1;
+    char *username;
 
-    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
-    if (session_id_check(h, &session_id) < 0)
-        goto done;
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
     cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
     cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
     if ((username = clicon_username_get(h)) != NULL){
@@ -1068,11 +1027,33 @@ clicon_rpc_get2(clixon_handle   h,
                 IETF_NETCONF_WITH_DEFAULTS_YANG_NAMESPACE,
                 defaults);
     cprintf(cb, "</get></rpc>");
-    if ((msg = clicon_msg_encode(session_id,
-                                 "%s", cbuf_get(cb))) == NULL)
-        goto done;
-    if (clicon_rpc_msg(h, msg, &xret) < 0)
-        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Bind get reply to YANG and return data or error
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply from backend
+ * @param[in]  bind  Bind data to YANG
+ * @param[out] xt    XML tree. Free with xml_free. Either <data> or <rpc-error>.
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rpc_get_reply(clixon_handle h,
+              cxobj        *xret,
+              int           bind,
+              cxobj       **xt)
+{
+    int        retval = -1;
+    cxobj     *xerr = NULL;
+    cxobj     *xd = NULL;
+    int        ret;
+    yang_stmt *yspec;
+    cvec      *nscd = NULL;
+
     yspec = clicon_dbspec_yang(h);
     /* Send xml error back: first check error, then ok */
     if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL)
@@ -1113,19 +1094,179 @@ clicon_rpc_get2(clixon_handle   h,
     }
     retval = 0;
   done:
-    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (nscd)
         cvec_free(nscd);
-    if (cb)
-        cbuf_free(cb);
     if (xerr)
         xml_free(xerr);
+    if (xd && xml_parent(xd) == NULL)
+        xml_free(xd);
+    return retval;
+}
+
+/*! Get database configuration and state data (please use instead of clicon_rpc_get)
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  namespace Namespace associated w xpath
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @param[out] xt        XML tree. Free with xml_free. 
+ *                       Either <config> or <rpc-error>. 
+ * @retval     0         OK
+ * @retval    -1         Error, fatal or xml
+ * @note if xpath is set but namespace is NULL, the default, netconf base 
+ *       namespace will be used which is most probably wrong.
+ * @code
+ *  cxobj *xt = NULL;
+ *  cvec *nsc = NULL;
+ *
+ *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
+ *     err;
+ *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
+ *     err;
+ *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+ *     clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+ *     err;
+ *  }
+ *  if (xt)
+ *     xml_free(xt);
+ *  if (nsc)
+ *     xml_nsctx_free(nsc);
+ * @endcode
+ * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
+ * @see clixon_err_netconf
+ * @note the netconf return message is yang populated, as well as the return data
+ */
+int
+clicon_rpc_get2(clixon_handle   h,
+                char           *xpath,
+                cvec           *nsc, /* namespace context for filter */
+                netconf_content content,
+                int32_t         depth,
+                char           *defaults,
+                int             bind,
+                cxobj         **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    cxobj             *xret = NULL;
+    uint32_t           session_id;
+
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (rpc_get_request(h, xpath, nsc, content, depth, defaults, cb) < 0)
+        goto done;
+    if ((msg = clicon_msg_encode(session_id,
+                                 "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        goto done;
+    if (rpc_get_reply(h, xret, bind, xt) < 0)
+        goto done;
+    retval = 0;
+  done:
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (cb)
+        cbuf_free(cb);
     if (xret)
         xml_free(xret);
     if (msg)
         free(msg);
-    if (xd)
-        xml_free(xd);
+    return retval;
+}
+
+/*! Send get request on socket without waiting for reply
+ *
+ * Used by clients with several outstanding requests, eg from an event loop.
+ * The backend replies to the requests of a socket in order.
+ * @param[in]  h         Clixon handle
+ * @param[in]  s         Open socket to backend, eg from clicon_rpc_connect
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_rpc_get_recv  Read reply
+ * @see clicon_rpc_get2      Blocking variant
+ */
+int
+clicon_rpc_get_send(clixon_handle   h,
+                    int             s,
+                    char           *xpath,
+                    cvec           *nsc,
+                    netconf_content content,
+                    int32_t         depth,
+                    char           *defaults)
+{
+    int      retval = -1;
+    cbuf    *cb = NULL;
+    uint32_t session_id;
+
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (rpc_get_request(h, xpath, nsc, content, depth, defaults, cb) < 0)
+        goto done;
+    if (clixon_msg_send11(s, clicon_sock_str(h), cb) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Read reply of get request sent with clicon_rpc_get_send
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  s     Socket to backend
+ * @param[in]  bind  Bind data to YANG
+ * @param[out] xt    XML tree. Free with xml_free. Either <data> or <rpc-error>.
+ * @param[out] eof   Set if socket is closed, xt is not set
+ * @retval     0     OK, check eof
+ * @retval    -1     Error
+ * @see clicon_rpc_get_send
+ */
+int
+clicon_rpc_get_recv(clixon_handle h,
+                    int           s,
+                    int           bind,
+                    cxobj       **xt,
+                    int          *eof)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xret = NULL;
+
+    if (clixon_msg_rcv11(s, clicon_sock_str(h), 0, &cb, eof) < 0)
+        goto done;
+    if (*eof)
+        goto ok;
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xret, NULL) < 0)
+        goto done;
+    if (rpc_get_reply(h, xret, bind, xt) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
     return retval;
 }
 
@@ -1762,6 +1903,78 @@ clicon_rpc_debug(clixon_handle h,
     return retval;
 }
 
+/*! Get generation of a datastore from backend server
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Name of database
+ * @param[out] gen   Generation of datastore
+ * @retval     1     OK
+ * @retval     0     Backend returned error, eg rpc not supported, gen not set
+ * @retval    -1     Error and logged to syslog
+ * @see xmldb_generation_get
+ */
+int
+clicon_rpc_datastore_generation(clixon_handle h,
+                                char         *db,
+                                uint64_t     *gen)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    char              *username;
+    uint32_t           session_id;
+    cbuf              *cb = NULL;
+    char              *str;
+    char              *reason = NULL;
+    int                ret;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR); /* XXX: use incrementing sequence */
+    cprintf(cb, ">");
+    cprintf(cb, "<datastore-generation xmlns=\"%s\"><datastore>%s</datastore></datastore-generation>",
+            CLIXON_LIB_NS, db);
+    cprintf(cb, "</rpc>");
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        goto done;
+    if (xpath_first(xret, NULL, "//rpc-error") != NULL)
+        goto fail;
+    if ((str = xml_find_body(xpath_first(xret, NULL, "rpc-reply"), "generation")) == NULL)
+        goto fail;
+    if ((ret = parse_uint64(str, gen, &reason)) < 0){
+        clixon_err(OE_XML, errno, "parse_uint64");
+        goto done;
+    }
+    if (ret == 0)
+        goto fail;
+    retval = 1;
+ done:
+    if (reason)
+        free(reason);
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xret)
+        xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Send a debug request to backend server to set restconf debug
  *
  * @param[in] h        Clixon handle
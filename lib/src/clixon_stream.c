@@ -61,10 +61,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <syslog.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -82,6 +87,7 @@
 #include "clixon_event.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
+#include "clixon_json.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
@@ -91,6 +97,953 @@
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/*
+ * Subscription filter index
+ * A filter on the form [/]name or [/]name[leaf='value' and ...] is compiled and the
+ * subscription is indexed on the event element name and the value of the first
+ * predicate leaf. An event is then matched against all such subscriptions with
+ * one lookup per event element and child leaf, regardless of the number of
+ * subscriptions.
+ * Other filters are evaluated with xpath on every event.
+ * Names are compared including prefix, as xpath without namespace context.
+ */
+
+/* Key of subscriptions with no filter or a filter that cannot be indexed */
+#define STREAM_INDEX_OTHER ""
+
+/*! Subscription filter compiled for indexed matching
+ */
+struct stream_filter{
+    char  *sf_key;    /* Index key, see stream_index_key */
+    int    sf_len;    /* Number of equality predicates */
+    char **sf_leaf;   /* Predicate leaf names as [<prefix>:]<name> */
+    char **sf_value;  /* Predicate values */
+};
+
+/*! Subscriptions of a stream with same index key, value of hash entry
+ */
+struct stream_ss_vec{
+    struct stream_subscription **sv_vec;
+    int                          sv_len;
+};
+
+/*! Free compiled subscription filter
+ */
+static int
+stream_filter_free(struct stream_filter *sf)
+{
+    int i;
+
+    if (sf->sf_key)
+        free(sf->sf_key);
+    for (i=0; i<sf->sf_len; i++){
+        if (sf->sf_leaf[i])
+            free(sf->sf_leaf[i]);
+        if (sf->sf_value[i])
+            free(sf->sf_value[i]);
+    }
+    if (sf->sf_leaf)
+        free(sf->sf_leaf);
+    if (sf->sf_value)
+        free(sf->sf_value);
+    free(sf);
+    return 0;
+}
+
+/*! Create index key of event element or event element with leaf value
+ *
+ * The key is name[leaf='value'] where quotes and backslashes in value are
+ * escaped with a backslash, so that different values never give the same key
+ * @param[in]  cb     Key is written to cbuf, reset before
+ * @param[in]  name   Event element name as [<prefix>:]<name>
+ * @param[in]  leaf   Leaf name as [<prefix>:]<name>, or NULL
+ * @param[in]  value  Leaf value, if leaf is set
+ * @retval     key    Index key, owned by cb
+ */
+static char *
+stream_index_key(cbuf       *cb,
+                 const char *name,
+                 const char *leaf,
+                 const char *value)
+{
+    const char *v;
+
+    cbuf_reset(cb);
+    cprintf(cb, "%s", name);
+    if (leaf){
+        cprintf(cb, "[%s='", leaf);
+        for (v = value; *v; v++){
+            if (*v == '\'' || *v == '\\')
+                cprintf(cb, "\\");
+            cprintf(cb, "%c", *v);
+        }
+        cprintf(cb, "']");
+    }
+    return cbuf_get(cb);
+}
+
+/*! Get name of XML node as [<prefix>:]<name>, written to cbuf
+ */
+static char *
+stream_xml_name(cbuf  *cb,
+                cxobj *x)
+{
+    cbuf_reset(cb);
+    if (xml_prefix(x))
+        cprintf(cb, "%s:", xml_prefix(x));
+    cprintf(cb, "%s", xml_name(x));
+    return cbuf_get(cb);
+}
+
+/*! Scan an xpath name test on the form [<prefix>:]<name>
+ *
+ * @param[in,out] sp   String pointer, advanced past name
+ * @param[out]    cb   Name
+ * @retval        1    OK
+ * @retval        0    Not a name
+ */
+static int
+stream_filter_name(const char **sp,
+                   cbuf        *cb)
+{
+    const char *s = *sp;
+    int         i;
+
+    cbuf_reset(cb);
+    for (i=0; i<2; i++){
+        if (!isalpha(*s) && *s != '_')
+            return 0;
+        while (isalnum(*s) || *s == '_' || *s == '-' || *s == '.')
+            cprintf(cb, "%c", *s++);
+        if (*s != ':')
+            break;
+        cprintf(cb, "%c", *s++);
+    }
+    *sp = s;
+    return 1;
+}
+
+/*! Compile subscription xpath filter for indexed matching
+ *
+ * Accepts filters on the form [/]name and [/]name[leaf='value' and leaf2="value2"][...]
+ * @param[in]  xpath  Subscription filter
+ * @param[out] sfp    Compiled filter, or NULL if filter cannot be indexed
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+stream_filter_compile(const char            *xpath,
+                      struct stream_filter **sfp)
+{
+    int                   retval = -1;
+    struct stream_filter *sf = NULL;
+    cbuf                 *cbname = NULL;
+    cbuf                 *cbleaf = NULL;
+    cbuf                 *cbval = NULL;
+    const char           *s = xpath;
+    char                  q;
+
+    *sfp = NULL;
+    if ((cbname = cbuf_new()) == NULL ||
+        (cbleaf = cbuf_new()) == NULL ||
+        (cbval = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(sf, 0, sizeof(*sf));
+    while (isspace(*s))
+        s++;
+    if (*s == '/')
+        s++;
+    if (stream_filter_name(&s, cbname) == 0)
+        goto ok;
+    while (isspace(*s))
+        s++;
+    while (*s == '['){
+        s++;
+        while (1){
+            while (isspace(*s))
+                s++;
+            if (stream_filter_name(&s, cbleaf) == 0)
+                goto ok;
+            while (isspace(*s))
+                s++;
+            if (*s++ != '=')
+                goto ok;
+            while (isspace(*s))
+                s++;
+            if ((q = *s++) != '\'' && q != '"')
+                goto ok;
+            cbuf_reset(cbval);
+            while (*s && *s != q)
+                cprintf(cbval, "%c", *s++);
+            if (*s++ != q)
+                goto ok;
+            if ((sf->sf_leaf = realloc(sf->sf_leaf, (sf->sf_len+1)*sizeof(char*))) == NULL ||
+                (sf->sf_value = realloc(sf->sf_value, (sf->sf_len+1)*sizeof(char*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            sf->sf_leaf[sf->sf_len] = NULL;
+            sf->sf_value[sf->sf_len] = NULL;
+            sf->sf_len++;
+            if ((sf->sf_leaf[sf->sf_len-1] = strdup(cbuf_get(cbleaf))) == NULL ||
+                (sf->sf_value[sf->sf_len-1] = strdup(cbuf_get(cbval))) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+            while (isspace(*s))
+                s++;
+            if (strncmp(s, "and", 3) == 0 && isspace(s[3])){
+                s += 3;
+                continue;
+            }
+            if (*s++ != ']')
+                goto ok;
+            break;
+        }
+        while (isspace(*s))
+            s++;
+    }
+    if (*s != '\0')
+        goto ok;
+    if (sf->sf_len)
+        stream_index_key(cbleaf, cbuf_get(cbname), sf->sf_leaf[0], sf->sf_value[0]);
+    else
+        stream_index_key(cbleaf, cbuf_get(cbname), NULL, NULL);
+    if ((sf->sf_key = strdup(cbuf_get(cbleaf))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    *sfp = sf;
+    sf = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (sf)
+        stream_filter_free(sf);
+    if (cbname)
+        cbuf_free(cbname);
+    if (cbleaf)
+        cbuf_free(cbleaf);
+    if (cbval)
+        cbuf_free(cbval);
+    return retval;
+}
+
+/*! Add subscription to stream index
+ *
+ * @param[in]  es   Event stream
+ * @param[in]  ss   Subscription, filter compiled
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_index_add(event_stream_t             *es,
+                 struct stream_subscription *ss)
+{
+    int                   retval = -1;
+    char                 *key;
+    struct stream_ss_vec *sv;
+    struct stream_ss_vec  sv0 = {NULL, 0};
+
+    if (es->es_index == NULL &&
+        (es->es_index = clicon_hash_init()) == NULL)
+        goto done;
+    key = ss->ss_filter ? ss->ss_filter->sf_key : STREAM_INDEX_OTHER;
+    if ((sv = clicon_hash_value(es->es_index, key, NULL)) == NULL){
+        if (clicon_hash_add(es->es_index, key, &sv0, sizeof(sv0)) == NULL)
+            goto done;
+        if ((sv = clicon_hash_value(es->es_index, key, NULL)) == NULL)
+            goto done;
+    }
+    if ((sv->sv_vec = realloc(sv->sv_vec, (sv->sv_len+1)*sizeof(ss))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        goto done;
+    }
+    sv->sv_vec[sv->sv_len++] = ss;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove subscription from stream index
+ *
+ * @param[in]  es   Event stream
+ * @param[in]  ss   Subscription
+ * @retval     0    OK
+ */
+static int
+stream_index_rm(event_stream_t             *es,
+                struct stream_subscription *ss)
+{
+    char                 *key;
+    struct stream_ss_vec *sv;
+    int                   i;
+
+    if (es->es_index == NULL)
+        return 0;
+    key = ss->ss_filter ? ss->ss_filter->sf_key : STREAM_INDEX_OTHER;
+    if ((sv = clicon_hash_value(es->es_index, key, NULL)) == NULL)
+        return 0;
+    for (i=0; i<sv->sv_len; i++)
+        if (sv->sv_vec[i] == ss)
+            break;
+    if (i == sv->sv_len)
+        return 0;
+    memmove(&sv->sv_vec[i], &sv->sv_vec[i+1], (sv->sv_len-i-1)*sizeof(ss));
+    if (--sv->sv_len == 0){
+        free(sv->sv_vec);
+        clicon_hash_del(es->es_index, key);
+    }
+    return 0;
+}
+
+/*! Free stream index
+ */
+static int
+stream_index_free(event_stream_t *es)
+{
+    char                **keys = NULL;
+    size_t                klen = 0;
+    size_t                i;
+    struct stream_ss_vec *sv;
+
+    if (es->es_index == NULL)
+        return 0;
+    if (clicon_hash_keys(es->es_index, &keys, &klen) == 0)
+        for (i=0; i<klen; i++)
+            if ((sv = clicon_hash_value(es->es_index, keys[i], NULL)) != NULL && sv->sv_vec)
+                free(sv->sv_vec);
+    if (keys)
+        free(keys);
+    clicon_hash_free(es->es_index);
+    es->es_index = NULL;
+    return 0;
+}
+
+/*! Append subscription to match vector unless already matched by this event
+ */
+static int
+stream_match_add(struct stream_subscription   *ss,
+                 uint64_t                      serial,
+                 struct stream_subscription ***vec,
+                 int                          *len)
+{
+    if (ss->ss_serial == serial)
+        return 0;
+    ss->ss_serial = serial;
+    if ((*vec = realloc(*vec, (*len+1)*sizeof(ss))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    (*vec)[(*len)++] = ss;
+    return 0;
+}
+
+/*! Check remaining equality predicates of compiled filter
+ *
+ * The first predicate is checked by the index lookup
+ * @param[in]  sf   Compiled filter
+ * @param[in]  x    Event element
+ * @param[in]  cb   Work buffer
+ * @retval     1    Match
+ * @retval     0    No match
+ */
+static int
+stream_filter_match(struct stream_filter *sf,
+                    cxobj                *x,
+                    cbuf                 *cb)
+{
+    cxobj *xc;
+    char  *body;
+    int    i;
+
+    for (i=1; i<sf->sf_len; i++){
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+            if ((body = xml_body(xc)) != NULL &&
+                strcmp(body, sf->sf_value[i]) == 0 &&
+                strcmp(stream_xml_name(cb, xc), sf->sf_leaf[i]) == 0)
+                break;
+        }
+        if (xc == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Get all subscriptions of a stream whose filter matches an event
+ *
+ * @param[in]  es     Event stream
+ * @param[in]  xevent Notification, or NULL if not parsed
+ * @param[out] vecp   Vector of subscriptions, free with free()
+ * @param[out] lenp   Length of vector
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+stream_index_match(event_stream_t               *es,
+                   cxobj                        *xevent,
+                   struct stream_subscription ***vecp,
+                   int                          *lenp)
+{
+    int                         retval = -1;
+    struct stream_ss_vec       *sv;
+    struct stream_subscription *ss;
+    cxobj                      *x = NULL;
+    cxobj                      *xc;
+    cbuf                       *cbname = NULL;
+    cbuf                       *cbleaf = NULL;
+    cbuf                       *cbkey = NULL;
+    char                       *body;
+    uint64_t                    serial;
+    int                         i;
+
+    *vecp = NULL;
+    *lenp = 0;
+    if (es->es_index == NULL)
+        goto ok;
+    serial = ++es->es_serial;
+    if ((sv = clicon_hash_value(es->es_index, STREAM_INDEX_OTHER, NULL)) != NULL)
+        for (i=0; i<sv->sv_len; i++){
+            ss = sv->sv_vec[i];
+            if (ss->ss_xpath == NULL ||
+                strlen(ss->ss_xpath)==0 ||
+                (xevent != NULL && xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL))
+                if (stream_match_add(ss, serial, vecp, lenp) < 0)
+                    goto done;
+        }
+    if (xevent == NULL) /* Not parsed, only subscriptions without filter */
+        goto ok;
+    if ((cbname = cbuf_new()) == NULL ||
+        (cbleaf = cbuf_new()) == NULL ||
+        (cbkey = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((x = xml_child_each(xevent, x, CX_ELMNT)) != NULL){
+        stream_xml_name(cbname, x);
+        if ((sv = clicon_hash_value(es->es_index,
+                                    stream_index_key(cbkey, cbuf_get(cbname), NULL, NULL),
+                                    NULL)) != NULL)
+            for (i=0; i<sv->sv_len; i++)
+                if (stream_match_add(sv->sv_vec[i], serial, vecp, lenp) < 0)
+                    goto done;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+            if ((body = xml_body(xc)) == NULL)
+                continue;
+            stream_xml_name(cbleaf, xc);
+            if ((sv = clicon_hash_value(es->es_index,
+                                        stream_index_key(cbkey, cbuf_get(cbname), cbuf_get(cbleaf), body),
+                                        NULL)) == NULL)
+                continue;
+            for (i=0; i<sv->sv_len; i++){
+                ss = sv->sv_vec[i];
+                if (stream_filter_match(ss->ss_filter, x, cbkey) == 1)
+                    if (stream_match_add(ss, serial, vecp, lenp) < 0)
+                        goto done;
+            }
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cbname)
+        cbuf_free(cbname);
+    if (cbleaf)
+        cbuf_free(cbleaf);
+    if (cbkey)
+        cbuf_free(cbkey);
+    return retval;
+}
+
+/*
+ * Disk-backed replay log
+ * If CLICON_STREAM_REPLAY_DIR is set, replay events of a stream are appended as
+ * serialized XML to segment files in that directory instead of being kept as XML
+ * trees in memory. A segment consists of a data file <stream>-<nr>.log with the
+ * events and an index file <stream>-<nr>.idx with one fixed size entry per event
+ * in time order. A replay binary searches the index for the start time and then
+ * reads events one at a time.
+ * Only segment descriptors are kept in memory. A segment is removed when all its
+ * events have passed retention. The log is not kept across backend restarts.
+ */
+
+/* Start a new segment when the data file of the current exceeds this size [bytes] */
+#define STREAM_REPLAY_SEGMENT_SIZE (8*1024*1024)
+
+/*! Replay log index entry
+ */
+struct stream_replay_rec{
+    int64_t  rr_sec;   /* Timestamp seconds */
+    int64_t  rr_usec;  /* Timestamp microseconds */
+    uint64_t rr_off;   /* Offset of event in data file */
+    uint64_t rr_len;   /* Length of event */
+};
+
+/*! Replay log segment
+ */
+struct stream_replay_seg{
+    qelem_t        rs_q;     /* queue header */
+    uint32_t       rs_nr;    /* Segment number, part of file names */
+    struct timeval rs_first; /* Time of first event */
+    struct timeval rs_last;  /* Time of last event */
+    uint64_t       rs_len;   /* Number of events */
+    uint64_t       rs_size;  /* Size of data file */
+};
+
+/*! Replay log of a stream
+ */
+struct stream_replay_log{
+    char                     *rl_dir;    /* Directory of segment files */
+    char                     *rl_stream; /* Name of stream, prefix of segment files */
+    struct stream_replay_seg *rl_seg;    /* Segments, oldest first */
+    uint32_t                  rl_nr;     /* Number of next segment */
+    int                       rl_fd;     /* Data file of last segment open for append, or -1 */
+    int                       rl_ifd;    /* Index file of last segment open for append, or -1 */
+};
+
+/*! Get file name of replay log segment
+ *
+ * @param[in]  cb     File name is written to cbuf, reset before
+ * @param[in]  rl     Replay log
+ * @param[in]  nr     Segment number
+ * @param[in]  suffix "log" or "idx"
+ * @retval     path   File name, owned by cb
+ */
+static char *
+stream_replay_path(cbuf                     *cb,
+                   struct stream_replay_log *rl,
+                   uint32_t                  nr,
+                   const char               *suffix)
+{
+    cbuf_reset(cb);
+    cprintf(cb, "%s/%s-%010u.%s", rl->rl_dir, rl->rl_stream, nr, suffix);
+    return cbuf_get(cb);
+}
+
+/*! Close files of last segment open for append
+ */
+static int
+stream_replay_seg_close(struct stream_replay_log *rl)
+{
+    if (rl->rl_fd != -1){
+        close(rl->rl_fd);
+        rl->rl_fd = -1;
+    }
+    if (rl->rl_ifd != -1){
+        close(rl->rl_ifd);
+        rl->rl_ifd = -1;
+    }
+    return 0;
+}
+
+/*! Remove oldest replay log segment and its files
+ *
+ * @param[in]  rl   Replay log
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_replay_seg_rm(struct stream_replay_log *rl)
+{
+    int                       retval = -1;
+    struct stream_replay_seg *rs;
+    cbuf                     *cb = NULL;
+
+    if ((rs = rl->rl_seg) == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (NEXTQ(struct stream_replay_seg *, rs) == rs) /* Last segment */
+        stream_replay_seg_close(rl);
+    unlink(stream_replay_path(cb, rl, rs->rs_nr, "log"));
+    unlink(stream_replay_path(cb, rl, rs->rs_nr, "idx"));
+    DELQ(rs, rl->rl_seg, struct stream_replay_seg *);
+    free(rs);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Open replay log of a stream, remove segment files of a previous run
+ *
+ * @param[in]  dir     Directory of segment files
+ * @param[in]  stream  Name of stream
+ * @retval     rl      Replay log
+ * @retval     NULL    Error
+ */
+static struct stream_replay_log *
+stream_replay_log_open(const char *dir,
+                       const char *stream)
+{
+    struct stream_replay_log *rl = NULL;
+    DIR                      *dirp = NULL;
+    struct dirent            *dp;
+    cbuf                     *cb = NULL;
+    size_t                    len = strlen(stream);
+    uint32_t                  nr;
+    char                      suffix[4];
+
+    if ((rl = malloc(sizeof(*rl))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rl, 0, sizeof(*rl));
+    rl->rl_fd = -1;
+    rl->rl_ifd = -1;
+    if ((rl->rl_dir = strdup(dir)) == NULL ||
+        (rl->rl_stream = strdup(stream)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dirp = opendir(dir)) == NULL){
+        clixon_err(OE_UNIX, errno, "opendir(%s)", dir);
+        goto done;
+    }
+    while ((dp = readdir(dirp)) != NULL){
+        if (strncmp(dp->d_name, stream, len) != 0 || dp->d_name[len] != '-')
+            continue;
+        if (sscanf(dp->d_name + len + 1, "%10u.%3s", &nr, suffix) != 2 ||
+            (strcmp(suffix, "log") != 0 && strcmp(suffix, "idx") != 0))
+            continue;
+        unlink(stream_replay_path(cb, rl, nr, suffix));
+    }
+    closedir(dirp);
+    cbuf_free(cb);
+    return rl;
+ done:
+    if (dirp)
+        closedir(dirp);
+    if (cb)
+        cbuf_free(cb);
+    if (rl){
+        if (rl->rl_dir)
+            free(rl->rl_dir);
+        if (rl->rl_stream)
+            free(rl->rl_stream);
+        free(rl);
+    }
+    return NULL;
+}
+
+/*! Close replay log and remove its segment files
+ *
+ * @param[in]  rl   Replay log
+ * @retval     0    OK
+ */
+static int
+stream_replay_log_close(struct stream_replay_log *rl)
+{
+    while (rl->rl_seg != NULL)
+        stream_replay_seg_rm(rl);
+    stream_replay_seg_close(rl);
+    free(rl->rl_dir);
+    free(rl->rl_stream);
+    free(rl);
+    return 0;
+}
+
+/*! Write all of buffer to file
+ */
+static int
+stream_replay_write(int         fd,
+                    const void *buf,
+                    size_t      len)
+{
+    const char *p = buf;
+    ssize_t     n;
+
+    while (len > 0){
+        if ((n = write(fd, p, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write");
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Read all of buffer from file at offset
+ */
+static int
+stream_replay_read(int    fd,
+                   void  *buf,
+                   size_t len,
+                   off_t  off)
+{
+    char   *p = buf;
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = pread(fd, p, len, off)) <= 0){
+            if (n < 0 && errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, n<0?errno:EIO, "pread");
+            return -1;
+        }
+        p += n;
+        len -= n;
+        off += n;
+    }
+    return 0;
+}
+
+/*! Append event to replay log
+ *
+ * The index is kept sorted on time for binary search: an event with a timestamp
+ * earlier than the previous event, eg after a clock adjustment, is indexed with the
+ * time of the previous event. The event itself is not changed.
+ * @param[in]  rl   Replay log
+ * @param[in]  tv   Timestamp
+ * @param[in]  str  Event serialized as XML
+ * @param[in]  len  Length of str
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_replay_log_add(struct stream_replay_log *rl,
+                      struct timeval           *tv,
+                      const char               *str,
+                      size_t                    len)
+{
+    int                       retval = -1;
+    struct stream_replay_seg *rs = NULL;
+    struct stream_replay_rec  rr;
+    cbuf                     *cb = NULL;
+    struct timeval            ts = *tv;
+
+    if (rl->rl_seg){
+        rs = PREVQ(struct stream_replay_seg *, rl->rl_seg);
+        if (rs->rs_len && timercmp(&ts, &rs->rs_last, <))
+            ts = rs->rs_last;
+    }
+    if (rs == NULL || rl->rl_fd == -1 || rs->rs_size >= STREAM_REPLAY_SEGMENT_SIZE){
+        stream_replay_seg_close(rl);
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if ((rs = malloc(sizeof(*rs))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(rs, 0, sizeof(*rs));
+        rs->rs_nr = rl->rl_nr++;
+        rs->rs_first = ts;
+        ADDQ(rs, rl->rl_seg);
+        if ((rl->rl_fd = open(stream_replay_path(cb, rl, rs->rs_nr, "log"),
+                              O_WRONLY|O_CREAT|O_TRUNC|O_APPEND, S_IRUSR|S_IWUSR)) < 0){
+            clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+            goto done;
+        }
+        if ((rl->rl_ifd = open(stream_replay_path(cb, rl, rs->rs_nr, "idx"),
+                               O_WRONLY|O_CREAT|O_TRUNC|O_APPEND, S_IRUSR|S_IWUSR)) < 0){
+            clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+            goto done;
+        }
+    }
+    memset(&rr, 0, sizeof(rr));
+    rr.rr_sec = ts.tv_sec;
+    rr.rr_usec = ts.tv_usec;
+    rr.rr_off = rs->rs_size;
+    rr.rr_len = len;
+    if (stream_replay_write(rl->rl_fd, str, len) < 0)
+        goto done;
+    if (stream_replay_write(rl->rl_ifd, &rr, sizeof(rr)) < 0)
+        goto done;
+    rs->rs_size += len;
+    rs->rs_len++;
+    rs->rs_last = ts;
+    retval = 0;
+ done:
+    if (retval < 0)
+        stream_replay_seg_close(rl); /* Start new segment on next event */
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove replay log segments whose events all are older than a time
+ *
+ * @param[in]  rl   Replay log
+ * @param[in]  tret Retention limit
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_replay_log_expire(struct stream_replay_log *rl,
+                         struct timeval           *tret)
+{
+    while (rl->rl_seg != NULL &&
+           timercmp(&rl->rl_seg->rs_last, tret, <))
+        if (stream_replay_seg_rm(rl) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Replay events of a replay log segment to a subscription
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  rl    Replay log
+ * @param[in]  rs    Segment
+ * @param[in]  ss    Subscription with start and optional stop time
+ * @param[in]  tret  Skip events older than this, if set
+ * @retval     1     OK, continue with next segment
+ * @retval     0     OK, stop time reached
+ * @retval    -1     Error
+ */
+static int
+stream_replay_seg_notify(clixon_handle               h,
+                         struct stream_replay_log   *rl,
+                         struct stream_replay_seg   *rs,
+                         struct stream_subscription *ss,
+                         struct timeval             *tret)
+{
+    int                      retval = -1;
+    struct stream_replay_rec rr;
+    struct timeval           tv;
+    cbuf                    *cb = NULL;
+    int                      fd = -1;
+    int                      ifd = -1;
+    uint64_t                 lo;
+    uint64_t                 hi;
+    uint64_t                 mid;
+    char                    *str = NULL;
+    cxobj                   *xev = NULL;
+    yang_stmt               *yspec;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, 0, "No yang spec");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((fd = open(stream_replay_path(cb, rl, rs->rs_nr, "log"), O_RDONLY)) < 0 ||
+        (ifd = open(stream_replay_path(cb, rl, rs->rs_nr, "idx"), O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+        goto done;
+    }
+    /* Binary search first event not before start time */
+    lo = 0;
+    hi = rs->rs_len;
+    while (lo < hi){
+        mid = lo + (hi - lo)/2;
+        if (stream_replay_read(ifd, &rr, sizeof(rr), mid*sizeof(rr)) < 0)
+            goto done;
+        tv.tv_sec = rr.rr_sec;
+        tv.tv_usec = rr.rr_usec;
+        if (timercmp(&tv, &ss->ss_starttime, <))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    /* Then notify until stop */
+    for (; lo < rs->rs_len; lo++){
+        if (stream_replay_read(ifd, &rr, sizeof(rr), lo*sizeof(rr)) < 0)
+            goto done;
+        tv.tv_sec = rr.rr_sec;
+        tv.tv_usec = rr.rr_usec;
+        if (timerisset(&ss->ss_stoptime) &&
+            timercmp(&tv, &ss->ss_stoptime, >)){
+            retval = 0;
+            goto done;
+        }
+        if (tret && timercmp(&tv, tret, <))
+            continue;
+        if ((str = malloc(rr.rr_len + 1)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        if (stream_replay_read(fd, str, rr.rr_len, rr.rr_off) < 0)
+            goto done;
+        str[rr.rr_len] = '\0';
+        if (clixon_xml_parse_string(str, YB_MODULE, yspec, &xev, NULL) < 0)
+            goto done;
+        if (xml_rootchild(xev, 0, &xev) < 0)
+            goto done;
+        if ((*ss->ss_fn)(h, 0, xev, ss->ss_arg) < 0)
+            goto done;
+        xml_free(xev);
+        xev = NULL;
+        free(str);
+        str = NULL;
+    }
+    retval = 1;
+ done:
+    if (xev)
+        xml_free(xev);
+    if (str)
+        free(str);
+    if (fd != -1)
+        close(fd);
+    if (ifd != -1)
+        close(ifd);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Replay events of a replay log to a subscription
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  es   Event stream with replay log
+ * @param[in]  ss   Subscription with start and optional stop time
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see stream_replay_notify
+ */
+static int
+stream_replay_log_notify(clixon_handle               h,
+                         event_stream_t             *es,
+                         struct stream_subscription *ss)
+{
+    struct stream_replay_log *rl = es->es_replay_log;
+    struct stream_replay_seg *rs;
+    struct timeval            now;
+    struct timeval            tret;
+    int                       ret;
+
+    if ((rs = rl->rl_seg) == NULL)
+        return 0;
+    if (timerisset(&es->es_retention)){
+        gettimeofday(&now, NULL);
+        timersub(&now, &es->es_retention, &tret);
+    }
+    do {
+        /* Skip segments before start */
+        if (!timercmp(&rs->rs_last, &ss->ss_starttime, <)){
+            if ((ret = stream_replay_seg_notify(h, rl, rs, ss,
+                                                timerisset(&es->es_retention)?&tret:NULL)) < 0)
+                return -1;
+            if (ret == 0)
+                break;
+        }
+        rs = NEXTQ(struct stream_replay_seg *, rs);
+    } while (rs && rs != rl->rl_seg);
+    return 0;
+}
+
 /*! Find an event notification stream given name
  *
  * @param[in]  h    Clixon handle
@@ -126,6 +1079,9 @@ stream_delete(event_stream_t *es)
         free(es->es_name);
     if (es->es_description)
         free(es->es_description);
+    stream_index_free(es);
+    if (es->es_replay_log)
+        stream_replay_log_close(es->es_replay_log);
     free(es);
     return 0;
 }
@@ -149,6 +1105,7 @@ stream_add(clixon_handle   h,
 {
     int             retval = -1;
     event_stream_t *es = NULL;
+    char           *dir;
 
     if ((es = stream_find(h, name)) != NULL)
         goto ok;
@@ -168,6 +1125,10 @@ stream_add(clixon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
         es->es_retention = *retention;
+    if (replay_enabled &&
+        (dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_DIR")) != NULL &&
+        (es->es_replay_log = stream_replay_log_open(dir, name)) == NULL)
+        goto done;
     clicon_stream_append(h, es);
     es = NULL;
  ok:
@@ -308,6 +1269,12 @@ stream_timer_setup(int   fd,
                         ss = NEXTQ(struct stream_subscription *, ss);
                 } while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
+            if (timerisset(&es->es_retention) &&
+                es->es_replay_log != NULL){
+                timersub(&now, &es->es_retention, &tret);
+                if (stream_replay_log_expire(es->es_replay_log, &tret) < 0)
+                    goto done;
+            }
             if (timerisset(&es->es_retention) &&
                 (r = es->es_replay) != NULL){
                 timersub(&now, &es->es_retention, &tret);
@@ -339,6 +1306,21 @@ stream_timer_setup(int   fd,
     return retval;
 }
 
+/*! Free event stream subscription
+ */
+static int
+stream_ss_free(struct stream_subscription *ss)
+{
+    if (ss->ss_stream)
+        free(ss->ss_stream);
+    if (ss->ss_xpath)
+        free(ss->ss_xpath);
+    if (ss->ss_filter)
+        stream_filter_free(ss->ss_filter);
+    free(ss);
+    return 0;
+}
+
 /*! Add an event notification callback to a stream given a callback function
  *
  * @param[in]  h        Clixon handle
@@ -385,18 +1367,28 @@ stream_ss_add(clixon_handle     h,
         clixon_err(OE_CFG, errno, "strdup");
         goto done;
     }
+    if (xpath && strlen(xpath) &&
+        stream_filter_compile(xpath, &ss->ss_filter) < 0)
+        goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
+    if (stream_index_add(es, ss) < 0)
+        goto done;
+    if (stoptime)
+        es->es_nstop++;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
     if (ss)
-        free(ss);
+        stream_ss_free(ss);
     return NULL;
 }
 
 /*! Delete event stream subscription to a stream given a callback and arg
  *
+ * If subscription callbacks of the stream are in progress, eg a callback removes
+ * a subscription, the subscription is marked as deleted and freed after the
+ * callbacks, see stream_notify1
  * @param[in]  h      Clixon handle
  * @param[in]  stream Name of stream or NULL for all streams
  * @param[in]  fn     Callback when event occurs
@@ -412,14 +1404,18 @@ stream_ss_rm(clixon_handle                h,
 {
     clixon_debug(CLIXON_DBG_STREAM, "");
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    stream_index_rm(es, ss);
+    if (timerisset(&ss->ss_stoptime))
+        es->es_nstop--;
+    ss->ss_deleted = 1;
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
     if (force){
-        if (ss->ss_stream)
-            free(ss->ss_stream);
-        if (ss->ss_xpath)
-            free(ss->ss_xpath);
-        free(ss);
+        if (es->es_notifying){
+            ADDQ(ss, es->es_ss_deleted);
+        }
+        else
+            stream_ss_free(ss);
     }
     clixon_debug(CLIXON_DBG_STREAM, "retval: 0");
     return 0;
@@ -514,50 +1510,224 @@ stream_ss_delete(clixon_handle     h,
     return retval;
 }
 
+/*! Create notification shared by all subscribers of an event
+ *
+ * @param[in]  xev  Event as XML tree, not copied, or NULL
+ * @retval     sn   Notification, free with stream_notification_free
+ * @retval     NULL Error
+ */
+stream_notification_t *
+stream_notification_new(cxobj *xev)
+{
+    stream_notification_t *sn;
+
+    if ((sn = malloc(sizeof(*sn))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(sn, 0, sizeof(*sn));
+    sn->sn_xml = xev;
+    sn->sn_refcount = 1;
+    return sn;
+}
+
+/*! Keep notification after the subscription callback has returned
+ *
+ * The serialized forms remain valid, but not the XML tree
+ * @param[in]  sn   Notification
+ * @retval     0    OK
+ * @see stream_notification_free  Release notification
+ */
+int
+stream_notification_hold(stream_notification_t *sn)
+{
+    sn->sn_refcount++;
+    return 0;
+}
+
+/*! Release notification, free it when there are no more references
+ *
+ * @param[in]  sn   Notification
+ * @retval     0    OK
+ */
+int
+stream_notification_free(stream_notification_t *sn)
+{
+    if (--sn->sn_refcount > 0)
+        return 0;
+    if (sn->sn_xmlstr)
+        cbuf_free(sn->sn_xmlstr);
+    if (sn->sn_msg)
+        cbuf_free(sn->sn_msg);
+    free(sn);
+    return 0;
+}
+
+/*! Get the notification of an event being distributed to subscribers
+ *
+ * Use in a subscription callback to share serialized forms of the event with
+ * other subscribers.
+ * @param[in]  h    Clixon handle
+ * @param[in]  xev  Event as given to the subscription callback, or NULL if not parsed
+ * @retval     sn   Notification
+ * @retval     NULL No shared notification, eg replay
+ * @see stream_fn_t
+ */
+stream_notification_t *
+stream_notification_get(clixon_handle h,
+                        cxobj        *xev)
+{
+    stream_notification_t *sn = NULL;
+
+    if (clicon_ptr_get(h, "stream-notification", (void**)&sn) < 0)
+        return NULL;
+    if (sn == NULL || sn->sn_xml != xev)
+        return NULL;
+    return sn;
+}
+
+/*! Get notification serialized as XML, serialize on first call
+ *
+ * @param[in]  sn     Notification
+ * @retval     cb     Serialized event, owned by notification
+ * @retval     NULL   Error
+ */
+cbuf *
+stream_notification_str(stream_notification_t *sn)
+{
+    cbuf  *cb = NULL;
+
+    if (sn->sn_xmlstr != NULL)
+        return sn->sn_xmlstr;
+    if (sn->sn_xml == NULL){
+        clixon_err(OE_XML, EFAULT, "Notification has no XML");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, sn->sn_xml, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    sn->sn_xmlstr = cb;
+    return cb;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return NULL;
+}
+
+/*! Get notification as a NETCONF 1.1 chunk-framed message, create on first call
+ *
+ * The message can be sent as-is to every internal client
+ * @param[in]  sn     Notification
+ * @retval     cb     Framed message, owned by notification
+ * @retval     NULL   Error
+ * @see send_msg_notify_msg
+ */
+cbuf *
+stream_notification_msg(stream_notification_t *sn)
+{
+    cbuf *cb = NULL;
+    cbuf *cbx;
+
+    if (sn->sn_msg != NULL)
+        return sn->sn_msg;
+    if ((cbx = stream_notification_str(sn)) == NULL)
+        goto done;
+    if ((cb = cbuf_new_alloc(cbuf_len(cbx) + 32)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        goto done;
+    }
+    if (cbuf_append_buf(cb, cbuf_get(cbx), cbuf_len(cbx)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
+        goto done;
+    sn->sn_msg = cb;
+    return cb;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return NULL;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  *
  * @param[in]  h       Clixon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
  * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
- * @param[in]  event   Notification as xml tree
+ * @param[in]  sn      Notification, shared by all subscribers
  * @retval     0       OK
  * @retval    -1       Error
+ * Subscriptions are matched using the filter index, see stream_index_match
  * @see stream_notify
  * @see stream_ss_timeout where subscriptions are removed if stoptime<now
  */
 static int
-stream_notify1(clixon_handle   h,
-               event_stream_t *es,
-               struct timeval *tv,
-               cxobj          *xevent)
+stream_notify1(clixon_handle          h,
+               event_stream_t        *es,
+               struct timeval        *tv,
+               stream_notification_t *sn)
 {
-    int                         retval = -1;
-    struct stream_subscription *ss;
+    int                          retval = -1;
+    struct stream_subscription  *ss;
+    struct stream_subscription  *ss1;
+    struct stream_subscription **vec = NULL;
+    int                          len = 0;
+    int                          i;
+    cxobj                       *xevent = sn->sn_xml;
+    stream_notification_t       *sn0 = NULL;
+    int                          notifying = 0;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
-    /* Go thru all subscriptions and find matches */
-    if ((ss = es->es_subscription) != NULL)
+    /* Subscription callbacks may share serialized event, see stream_notification_get
+     * Save outer notification in case a callback notifies another event */
+    if (clicon_ptr_get(h, "stream-notification", (void**)&sn0) < 0)
+        sn0 = NULL;
+    if (clicon_ptr_set(h, "stream-notification", sn) < 0)
+        goto done;
+    /* Remove subscriptions whose stoptime has passed */
+    if (es->es_nstop > 0 && (ss = es->es_subscription) != NULL)
         do {
-            if (timerisset(&ss->ss_stoptime) && /* stoptime has passed */
+            if (timerisset(&ss->ss_stoptime) &&
                 timercmp(&ss->ss_stoptime, tv, <)){
-                struct stream_subscription *ss1;
                 ss1 = NEXTQ(struct stream_subscription *, ss);
                 /* Signal to remove stream for upper levels */
                 if (stream_ss_rm(h, es, ss, 1) < 0)
                     goto done;
                 ss = ss1;
             }
-            else{  /* xpath match */
-                if (ss->ss_xpath == NULL ||
-                    strlen(ss->ss_xpath)==0 ||
-                    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
-                    if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
-                        goto done;
+            else
                 ss = NEXTQ(struct stream_subscription *, ss);
-            }
         } while (es->es_subscription && ss != es->es_subscription);
+    /* Find matching subscriptions using filter index */
+    if (stream_index_match(es, xevent, &vec, &len) < 0)
+        goto done;
+    /* A callback may remove subscriptions of the vector, these are freed after */
+    es->es_notifying++;
+    notifying++;
+    for (i=0; i<len; i++){
+        ss = vec[i];
+        if (ss->ss_deleted)
+            continue;
+        if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
+            goto done;
+    }
     retval = 0;
   done:
+    if (notifying && --es->es_notifying == 0)
+        while ((ss = es->es_ss_deleted) != NULL){
+            DELQ(ss, es->es_ss_deleted, struct stream_subscription *);
+            stream_ss_free(ss);
+        }
+    if (vec)
+        free(vec);
+    if (sn0)
+        clicon_ptr_set(h, "stream-notification", sn0);
+    else
+        clicon_ptr_del(h, "stream-notification");
     return retval;
 }
 
@@ -572,6 +1742,7 @@ stream_notify1(clixon_handle   h,
  *  if (stream_notify(h, "NETCONF", "<event><event-class>fault</event-class><reportingEntity><card>Ethernet0</card></reportingEntity><severity>major</severity></event>") < 0)
  *    err;
  * @endcode
+ * @see  stream_notify_str  Without format string
  * @see  stream_notify_xml  Similar but with XML data
  */
 int
@@ -582,16 +1753,10 @@ stream_notify(clixon_handle h,
     int             retval = -1;
     va_list         args;
     int             len;
-    cxobj          *xev = NULL;
-    yang_stmt      *yspec = NULL;
     char           *str = NULL;
-    cbuf           *cb = NULL;
-    char            timestr[28];
-    struct timeval  tv;
-    event_stream_t *es;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
-    if ((es = stream_find(h, stream)) == NULL)
+    if (stream_find(h, stream) == NULL)
         goto ok;
     va_start(args, event);
     len = vsnprintf(NULL, 0, event, args) + 1;
@@ -604,6 +1769,74 @@ stream_notify(clixon_handle h,
     va_start(args, event);
     len = vsnprintf(str, len, event, args) + 1;
     va_end(args);
+    if (stream_notify_str(h, stream, str) < 0)
+        goto done;
+ ok:
+    retval = 0;
+  done:
+    if (str)
+        free(str);
+    return retval;
+}
+
+/*! Check if an event of a stream needs to be parsed to XML
+ *
+ * XML is needed by in-memory replay, by subscriptions with a filter, and by
+ * subscription callbacks that do not accept the event as text only
+ * @param[in]  es   Event stream
+ * @retval     1    Yes, parse event
+ * @retval     0    No, text is enough
+ * @see stream_subscription.ss_text
+ */
+static int
+stream_notify_xml_needed(event_stream_t *es)
+{
+    struct stream_subscription *ss;
+
+    if (es->es_replay_enabled && es->es_replay_log == NULL)
+        return 1;
+    if ((ss = es->es_subscription) != NULL)
+        do {
+            if (!ss->ss_text ||
+                (ss->ss_xpath != NULL && strlen(ss->ss_xpath)))
+                return 1;
+            ss = NEXTQ(struct stream_subscription *, ss);
+        } while (ss != es->es_subscription);
+    return 0;
+}
+
+/*! Stream notify event given as XML text and distribute to all registered callbacks
+ *
+ * The notification is not re-serialized: subscribers are sent the text as given,
+ * wrapped in a notification element.
+ * The text is only parsed if a subscription filter, callback or in-memory replay
+ * needs XML, otherwise callbacks are called with NULL event and get the text with
+ * stream_notification_get.
+ * @param[in]  h       Clixon handle
+ * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
+ * @param[in]  event   Notification content as XML text
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see  stream_notify  With format string
+ */
+int
+stream_notify_str(clixon_handle h,
+                  char         *stream,
+                  const char   *event)
+{
+    int                    retval = -1;
+    cxobj                 *xev = NULL;
+    yang_stmt             *yspec = NULL;
+    cbuf                  *cb = NULL;
+    char                   timestr[28];
+    struct timeval         tv;
+    event_stream_t        *es;
+    stream_notification_t *sn = NULL;
+    cbuf                  *cbx;
+
+    clixon_debug(CLIXON_DBG_STREAM, "");
+    if ((es = stream_find(h, stream)) == NULL)
+        goto ok;
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_YANG, 0, "No yang spec");
         goto done;
@@ -619,14 +1852,32 @@ stream_notify(clixon_handle h,
     }
     /* From RFC5277 */
     cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>%s</notification>",
-            NETCONF_NOTIFICATION_NAMESPACE, timestr, str);
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, &xev, NULL) < 0)
-        goto done;
-    if (xml_rootchild(xev, 0, &xev) < 0)
+            NETCONF_NOTIFICATION_NAMESPACE, timestr, event);
+    if (stream_notify_xml_needed(es)){
+        if (clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, &xev, NULL) < 0)
+            goto done;
+        if (xml_rootchild(xev, 0, &xev) < 0)
+            goto done;
+    }
+    if ((sn = stream_notification_new(xev)) == NULL)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    /* The text is the XML serialization of the event */
+    sn->sn_xmlstr = cb;
+    cb = NULL;
+    if (stream_notify1(h, es, &tv, sn) < 0)
         goto done;
-    if (es->es_replay_enabled){
+    if (es->es_replay_log){
+        /* Use serialized event */
+        if ((cbx = stream_notification_str(sn)) == NULL)
+            goto done;
+        if (stream_replay_log_add(es->es_replay_log, &tv, cbuf_get(cbx), cbuf_len(cbx)) < 0){
+            /* Event is delivered, only its replay is lost */
+            clixon_log(h, LOG_WARNING, "%s: replay log of stream %s: %s",
+                       __FUNCTION__, es->es_name, clixon_err_reason());
+            clixon_err_reset();
+        }
+    }
+    else if (es->es_replay_enabled){
         if (stream_replay_add(es, &tv, xev) < 0)
             goto done;
         xev = NULL; /* xml stored in replay_add and should not be freed */
@@ -634,12 +1885,14 @@ stream_notify(clixon_handle h,
  ok:
     retval = 0;
   done:
+    if (sn){
+        sn->sn_xml = NULL; /* Subscribers may still hold serialized event */
+        stream_notification_free(sn);
+    }
     if (cb)
         cbuf_free(cb);
     if (xev)
         xml_free(xev);
-    if (str)
-        free(str);
     return retval;
 }
 
@@ -666,6 +1919,8 @@ stream_notify_xml(clixon_handle h,
     char       timestr[28];
     struct timeval tv;
     event_stream_t *es;
+    stream_notification_t *sn = NULL;
+    cbuf      *cbx;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     if ((es = stream_find(h, stream)) == NULL)
@@ -694,9 +1949,22 @@ stream_notify_xml(clixon_handle h,
         goto done;
     if (xml_addsub(xev, xml2) < 0)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    if ((sn = stream_notification_new(xev)) == NULL)
+        goto done;
+    if (stream_notify1(h, es, &tv, sn) < 0)
         goto done;
-    if (es->es_replay_enabled){
+    if (es->es_replay_log){
+        /* Use serialized event */
+        if ((cbx = stream_notification_str(sn)) == NULL)
+            goto done;
+        if (stream_replay_log_add(es->es_replay_log, &tv, cbuf_get(cbx), cbuf_len(cbx)) < 0){
+            /* Event is delivered, only its replay is lost */
+            clixon_log(h, LOG_WARNING, "%s: replay log of stream %s: %s",
+                       __FUNCTION__, es->es_name, clixon_err_reason());
+            clixon_err_reset();
+        }
+    }
+    else if (es->es_replay_enabled){
         if (stream_replay_add(es, &tv, xev) < 0)
             goto done;
         xev = NULL; /* xml stored in replay_add and should not be freed */
@@ -704,6 +1972,10 @@ stream_notify_xml(clixon_handle h,
  ok:
     retval = 0;
   done:
+    if (sn){
+        sn->sn_xml = NULL;
+        stream_notification_free(sn);
+    }
     if (cb)
         cbuf_free(cb);
     if (xev)
@@ -752,6 +2024,11 @@ stream_replay_notify(clixon_handle               h,
         goto ok;
     if (!es->es_replay_enabled)
         goto ok;
+    if (es->es_replay_log){
+        if (stream_replay_log_notify(h, es, ss) < 0)
+            goto done;
+        goto ok;
+    }
     /* Get replay linked list */
     if ((r = es->es_replay) == NULL)
         goto ok;
@@ -782,9 +2059,10 @@ stream_replay_notify(clixon_handle               h,
  *
  * @param[in] es   Stream
  * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] xv   XML, consumed on success
  * @retval    0    OK
  * @retval   -1    Error
+ * @note With a replay log, see CLICON_STREAM_REPLAY_DIR, xv is serialized to disk and freed
  */
 int
 stream_replay_add(event_stream_t *es,
@@ -793,7 +2071,20 @@ stream_replay_add(event_stream_t *es,
 {
     int                   retval = -1;
     struct stream_replay *new;
+    cbuf                 *cb = NULL;
 
+    if (es->es_replay_log){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (clixon_xml2cbuf(cb, xv, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        if (stream_replay_log_add(es->es_replay_log, tv, cbuf_get(cb), cbuf_len(cb)) < 0)
+            goto done;
+        xml_free(xv);
+        goto ok;
+    }
     if ((new = malloc(sizeof *new)) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
@@ -802,8 +2093,11 @@ stream_replay_add(event_stream_t *es,
     new->r_tv = *tv;
     new->r_xml = xv;
     ADDQ(new, es->es_replay);
+ ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -187,6 +187,7 @@ struct xml{
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
                                        by reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+    uint64_t          x_stamp;      /* Content stamp, 0 if unknown, see xml_stamp */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
@@ -237,6 +238,13 @@ xml_type2str(enum cxobj_type type)
 /* Stats (too low-level to hang it on handle) */
 static uint64_t _stats_xml_nr = 0;
 
+/* Last content stamp given out, see xml_stamp */
+static uint64_t _xml_stamp_last = 0;
+
+/* Flags that are part of the content of a node: copied by xml_copy_one or used by xml_diff.
+ * Changing them clears content stamps, see xml_stamp_clear */
+#define XML_FLAG_STAMPED (XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_SKIP)
+
 /*! Get global statistics about XML objects
  *
  * @param[out]  nr  Number of existing XML objects (created - freed)
@@ -260,7 +268,10 @@ static int
 xml_stats_one(cxobj    *x,
               size_t   *szp)
 {
-    size_t sz = 0;
+    size_t               sz = 0;
+#ifdef XML_EXPLICIT_INDEX
+    struct search_index *si;
+#endif
 
     if (x->x_name)
         sz += strlen(x->x_name) + 1;
@@ -275,13 +286,15 @@ xml_stats_one(cxobj    *x,
         if (x->x_cv)
             sz += cv_size(x->x_cv);
 #ifdef XML_EXPLICIT_INDEX
-        if (x->x_search_index){
-            /* XXX: only one */
-            sz += sizeof(struct search_index);
-            if (x->x_search_index->si_name)
-                sz += strlen(x->x_search_index->si_name)+1;
-            if (x->x_search_index->si_xvec)
-                sz += clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*);
+        if ((si = x->x_search_index) != NULL){
+            do {
+                sz += sizeof(struct search_index);
+                if (si->si_name)
+                    sz += strlen(si->si_name)+1;
+                if (si->si_xvec)
+                    sz += clixon_xvec_len(si->si_xvec)*sizeof(struct cxobj*);
+                si = NEXTQ(struct search_index *, si);
+            } while (si && si != x->x_search_index);
         }
 #endif
         break;
@@ -353,6 +366,46 @@ xml_name(cxobj *xn)
     return xn->x_name;
 }
 
+/*! Get content stamp of XML element
+ *
+ * Two elements with the same non-zero stamp have identical subtrees, since
+ * one is an unmodified copy of the other (or both of a common source).
+ * Stamps are given out by xml_copy and cleared on the node and all its
+ * ancestors by any modification, see xml_stamp_clear.
+ * This is used by xml_diff to skip unchanged subtrees, eg between candidate
+ * and running at commit.
+ * @param[in]  x      XML node
+ * @retval     stamp  Content stamp
+ * @retval     0      Unknown: the node is not a copy, or it has been modified
+ */
+uint64_t
+xml_stamp(cxobj *x)
+{
+    if (!is_element(x))
+        return 0;
+    return x->x_stamp;
+}
+
+/*! Clear content stamp of XML node and its ancestors
+ *
+ * Invariant: if a node has no stamp, none of its ancestors have either. Therefore
+ * stop at the first ancestor without stamp, which makes repeated modifications
+ * of the same subtree cheap.
+ * @param[in]  x      XML node, if body or attribute start with its parent
+ */
+static void
+xml_stamp_clear(cxobj *x)
+{
+    while (x != NULL){
+        if (is_element(x)){
+            if (x->x_stamp == 0)
+                break;
+            x->x_stamp = 0;
+        }
+        x = x->x_up;
+    }
+}
+
 /*! Set name of xnode, name is copied
  *
  * @param[in]  xn    xml node
@@ -364,6 +417,7 @@ int
 xml_name_set(cxobj *xn,
              char  *name)
 {
+    xml_stamp_clear(xn);
     if (xn->x_name){
         free(xn->x_name);
         xn->x_name = NULL;
@@ -399,6 +453,7 @@ int
 xml_prefix_set(cxobj *xn,
                char  *prefix)
 {
+    xml_stamp_clear(xn);
     if (xn->x_prefix){
         free(xn->x_prefix);
         xn->x_prefix = NULL;
@@ -622,6 +677,8 @@ int
 xml_flag_set(cxobj   *xn,
              uint16_t flag)
 {
+    if (flag & XML_FLAG_STAMPED & ~xn->x_flags)
+        xml_stamp_clear(xn);
     xn->x_flags |= flag;
     return 0;
 }
@@ -635,6 +692,8 @@ int
 xml_flag_reset(cxobj   *xn,
                uint16_t flag)
 {
+    if (flag & XML_FLAG_STAMPED & xn->x_flags)
+        xml_stamp_clear(xn);
     xn->x_flags &= ~flag;
     return 0;
 }
@@ -665,6 +724,10 @@ xml_value_set(cxobj *xn,
 {
     int    retval = -1;
     size_t sz;
+    cxobj *xl;
+#ifdef XML_EXPLICIT_INDEX
+    int    index = 0;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,6 +735,18 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
+    xml_stamp_clear(xn);
+    if (xml_type(xn) == CX_BODY && (xl = xml_parent(xn)) != NULL){
+        /* Cached value of leaf is no longer valid */
+        if (xl->x_cv && xml_cv_set(xl, NULL) < 0)
+            goto done;
+#ifdef XML_EXPLICIT_INDEX
+        /* Re-sort list entry in search vector of index variable, a new value is inserted only */
+        if ((index = xml_search_index_p(xl)) != 0 && xn->x_value_cb != NULL)
+            if (xml_search_child_rm(xml_parent(xl), xl) < 0)
+                goto done;
+#endif
+    }
     sz = strlen(val)+1;
     if (xn->x_value_cb == NULL){
         if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
@@ -682,6 +757,11 @@ xml_value_set(cxobj *xn,
     else
         cbuf_reset(xn->x_value_cb);
     cbuf_append_str(xn->x_value_cb, val);
+#ifdef XML_EXPLICIT_INDEX
+    if (index)
+        if (xml_search_child_insert(xml_parent(xl), xl) < 0)
+            goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -707,6 +787,7 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
+    xml_stamp_clear(xn);
     sz = strlen(val)+1;
     if (xn->x_value_cb == NULL){
         if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
@@ -749,6 +830,8 @@ xml_type_set(cxobj          *xn,
 {
     enum cxobj_type old = xn->x_type;
 
+    if (old != type)
+        xml_stamp_clear(xn);
     xn->x_type = type;
     return old;
 }
@@ -879,6 +962,7 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
+    xml_stamp_clear(xt);
     if (i < xt->x_childvec_len)
         xt->x_childvec[i] = xc;
     return 0;
@@ -1038,6 +1122,7 @@ xml_child_append(cxobj *xp,
      */
     if (xml_type(xc) == CX_ELMNT)
         start = XML_CHILDVEC_SIZE_START_ELMNT;
+    xml_stamp_clear(xp);
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
         if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -1073,6 +1158,7 @@ xml_child_insert_pos(cxobj *xp,
 
     if (!is_element(xp))
         return 0;
+    xml_stamp_clear(xp);
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
         if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -1105,6 +1191,7 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
         return 0;
+    xml_stamp_clear(x);
     x->x_childvec_len = len;
     x->x_childvec_max = len;
     if (x->x_childvec)
@@ -1262,6 +1349,8 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+    if (x->x_spec != spec)
+        xml_stamp_clear(x);
     x->x_spec = spec;
     return 0;
 }
@@ -1392,8 +1481,12 @@ xml_addsub(cxobj *xp,
         /* clear namespace context cache of child */
         nscache_clear(xc);
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-            xml_search_child_insert(xp, xc);
+        if (xml_search_index_p(xc)){
+            if (xml_search_child_insert(xp, xc) < 0)
+                goto done;
+        }
+        else if (xml_search_list_insert(xc) < 0)
+            goto done;
 #endif
     }
     retval = 0;
@@ -1514,18 +1607,23 @@ xml_child_rm(cxobj *xp,
         clixon_err(OE_XML, 0, "Child not found");
         goto done;
     }
+#ifdef XML_EXPLICIT_INDEX
+    /* Before parent is reset since search vectors are found via parents */
+    if (xml_type(xc) == CX_ELMNT){
+        if (xml_search_index_p(xc)){
+            if (xml_search_child_rm(xp, xc) < 0)
+                goto done;
+        }
+        else if (xml_search_list_rm(xc) < 0)
+            goto done;
+    }
+#endif
+    xml_stamp_clear(xp);
     xml_parent_set(xc, NULL);
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
     if (i<xp->x_childvec_len)
         memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_type(xc) == CX_ELMNT){
-        if (xml_search_index_p(xc))
-            xml_search_child_rm(xp, xc);
-
-    }
-#endif
     retval = 0;
  done:
     return retval;
@@ -1960,6 +2058,7 @@ xml_free0(cxobj *x)
 
     if (x == NULL)
         return 0;
+    xml_stamp_clear(x); /* x may still be a child */
     if (x->x_name)
         free(x->x_name);
     if (x->x_prefix)
@@ -2063,6 +2162,7 @@ xml_copy_one(cxobj *x0,
  *
  * x1 should be a created placeholder. If x1 is non-empty,
  * the copied tree is appended to the existing tree.
+ * If x1 is empty, x0 and x1 are given the same content stamp, see xml_stamp
  * @param[in]  x0  Source XML tree
  * @param[in]  x1  Destination XML tree (must exist)
  * @retval     0   OK
@@ -2081,7 +2181,11 @@ xml_copy(cxobj *x0,
     int    retval = -1;
     cxobj *x;
     cxobj *xcopy;
+    int    stamp;
 
+    /* Only stamp if x1 becomes an exact copy of x0 */
+    stamp = is_element(x0) && xml_child_nr(x1) == 0 &&
+        xml_flag(x0, XML_FLAG_SKIP) == 0;
     if (xml_copy_one(x0, x1) <0)
         goto done;
     x = NULL;
@@ -2090,6 +2194,14 @@ xml_copy(cxobj *x0,
             goto done;
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
+        /* Unstamped element child, eg skipped: neither can parent be */
+        if (is_element(x) && x->x_stamp == 0)
+            stamp = 0;
+    }
+    if (stamp && is_element(x1)){
+        if (x0->x_stamp == 0)
+            x0->x_stamp = ++_xml_stamp_last;
+        x1->x_stamp = x0->x_stamp;
     }
     retval = 0;
   done:
@@ -2630,6 +2742,51 @@ xml_search_index_get(cxobj *x,
     return si;
 }
 
+/*! Find position of a list entry in a search vector
+ *
+ * First scan entries with equal index value around position i, then optionally revert to
+ * linear search, eg if the index value of xp has been changed
+ * @param[in] si      Search index
+ * @param[in] xp      XML list entry
+ * @param[in] i       Position given by binary search
+ * @param[in] eq      If set, i is an equal object
+ * @param[in] linear  If set revert to linear search
+ * @retval    i       Position of xp in search vector
+ * @retval   -1       Not found
+ */
+static int
+xml_search_index_pos(struct search_index *si,
+                     cxobj               *xp,
+                     int                  i,
+                     int                  eq,
+                     int                  linear)
+{
+    clixon_xvec *xv = si->si_xvec;
+    int          len;
+    int          j;
+
+    len = clixon_xvec_len(xv);
+    if (eq){
+        for (j=i; j>=0; j--){
+            if (clixon_xvec_i(xv, j) == xp)
+                return j;
+            if (xml_cmp(xp, clixon_xvec_i(xv, j), 0, 0, si->si_name) != 0)
+                break;
+        }
+        for (j=i+1; j<len; j++){
+            if (clixon_xvec_i(xv, j) == xp)
+                return j;
+            if (xml_cmp(xp, clixon_xvec_i(xv, j), 0, 0, si->si_name) != 0)
+                break;
+        }
+    }
+    if (linear)
+        for (j=0; j<len; j++)
+            if (clixon_xvec_i(xv, j) == xp)
+                return j;
+    return -1;
+}
+
 /*--------------------------------------------------*/
 
 /*! Get sorted index vector for list for variable "name"
@@ -2676,6 +2833,7 @@ xml_search_child_insert(cxobj *xp,
     cxobj               *xpp;
     int                  i;
     int                  len;
+    int                  eq = 0;
 
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2686,11 +2844,13 @@ xml_search_child_insert(cxobj *xp,
         if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
             goto done;
     }
-    /* Find element position using binary search and then remove */
+    /* Find element position using binary search and then insert */
     len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
         goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
+    /* Already indexed, eg both when bound and when inserted */
+    if (eq && xml_search_index_pos(si, xp, i, eq, 0) >= 0)
+        goto ok;
     if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
         goto done;
  ok:
@@ -2727,10 +2887,12 @@ xml_search_child_rm(cxobj *xp,
 
     /* Find element using binary search and then remove */
     len = clixon_xvec_len(si->si_xvec);
+    if (len == 0)
+        goto ok;
     if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
         goto done;
-        //    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
+    /* Equal index values are allowed: remove the exact object */
+    if ((i = xml_search_index_pos(si, xp, i, eq, 1)) >= 0)
         if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
             goto done;
  ok:
@@ -2790,4 +2952,97 @@ xml_child_index_each(cxobj           *xparent,
     return xn;
 }
 
+/*! Insert a list entry into the search vectors of all its index variables
+ *
+ * Use when a list entry with existing index variables is added to a parent
+ * @param[in] xp  XML list entry, with parent
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see xml_search_list_rm
+ */
+int
+xml_search_list_insert(cxobj *xp)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xi;
+
+    if ((y = xml_spec(xp)) == NULL ||
+        yang_keyword_get(y) != Y_LIST ||
+        xml_parent(xp) == NULL)
+        goto ok;
+    xi = NULL;
+    while ((xi = xml_child_each(xp, xi, CX_ELMNT)) != NULL) {
+        if (xml_search_index_p(xi) == 0)
+            continue;
+        if (xml_search_child_insert(xp, xi) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove a list entry from the search vectors of all its index variables
+ *
+ * Use before a list entry is removed from its parent
+ * @param[in] xp  XML list entry, with parent
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see xml_search_list_insert
+ */
+int
+xml_search_list_rm(cxobj *xp)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xi;
+
+    if ((y = xml_spec(xp)) == NULL ||
+        yang_keyword_get(y) != Y_LIST ||
+        xml_parent(xp) == NULL ||
+        xml_parent(xp)->x_search_index == NULL)
+        goto ok;
+    xi = NULL;
+    while ((xi = xml_child_each(xp, xi, CX_ELMNT)) != NULL) {
+        if (xml_search_index_p(xi) == 0)
+            continue;
+        if (xml_search_child_rm(xp, xi) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Return number of search vectors and indexed entries of an XML tree recursively
+ *
+ * @param[in]   xt   XML object
+ * @param[out]  nrp  Number of search vectors (incremented)
+ * @param[out]  enp  Number of entries in all search vectors (incremented)
+ * @retval      0    OK
+ */
+int
+xml_search_index_stats(cxobj    *xt,
+                       uint64_t *nrp,
+                       uint64_t *enp)
+{
+    struct search_index *si;
+    cxobj               *x;
+
+    if ((si = xt->x_search_index) != NULL) {
+        do {
+            *nrp += 1;
+            *enp += clixon_xvec_len(si->si_xvec);
+            si = NEXTQ(struct search_index *, si);
+        } while (si && si != xt->x_search_index);
+    }
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        xml_search_index_stats(x, nrp, enp);
+    return 0;
+}
+
 #endif /* XML_EXPLICIT_INDEX */
@@ -108,7 +108,7 @@ static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop)
  * @retval      0    Remove it
  * @retval     -1    Error
  */
-static int
+int
 xml2output_wdef(cxobj            *x,
                 withdefaults_type wdef,
                 int              *tag)
@@ -881,10 +881,8 @@ _xml_parse(const char *str,
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-        clixon_err(OE_XML, errno, "strdup");
-        return -1;
-    }
+    /* No need to copy, the scanner makes its own copy of the buffer */
+    xy.xy_parse_string = (char*)str;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
@@ -953,8 +951,6 @@ _xml_parse(const char *str,
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-        free(xy.xy_parse_string);
     if (xy.xy_xvec)
         free(xy.xy_xvec);
     return retval;
@@ -996,16 +992,14 @@ clixon_xml_parse_file(FILE      *fp,
                       cxobj    **xt,
                       cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
-    int   xtempty; /* empty on entry */
+    int    retval = -1;
+    int    ret;
+    size_t len = 0;
+    size_t n;
+    char  *xmlbuf = NULL;
+    size_t xmlbuflen = BUFLEN; /* start size */
+    int    failed = 0;
+    int    xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
         clixon_err(OE_XML, EINVAL, "arg is NULL");
@@ -1020,37 +1014,33 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, errno, "malloc");
         goto done;
     }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
+    /* Read file in chunks, double buffer size when full */
     while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0){
-            xmlbuf[len++] = ch;
-        }
-        if (ret == 0) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
         if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
             xmlbuflen *= 2;
             if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
                 clixon_err(OE_XML, errno, "realloc");
                 goto done;
             }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
         }
-    } /* while */
+        n = fread(xmlbuf+len, 1, xmlbuflen-1-len, fp);
+        len += n;
+        if (n == 0){
+            if (ferror(fp)){
+                clixon_err(OE_XML, errno, "read");
+                goto done;
+            }
+            break;
+        }
+    }
+    xmlbuf[len] = '\0';
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if ((ret = _xml_parse(xmlbuf, yb, yspec, *xt, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        failed++;
     retval = (failed==0) ? 1 : 0;
  done:
     if (retval < 0 && *xt && xtempty){
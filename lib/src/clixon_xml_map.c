@@ -342,6 +342,8 @@ xml_diff_ordered_by_user(cxobj     *x0,
  *         , get next (a,b)
  *   a < b : add a in x0, get next a 
  *   a > b : add b in x1, get next b
+ * If a and b have the same non-zero content stamp, they are unmodified copies and
+ * their subtrees are not traversed, see xml_stamp
  * (*) "comparing" a&b here is made by xml_cmp() which judges equality from a structural
  *     perspective, ie both have the same yang spec, if they are lists, they have the
  *     the same keys. NOT that the values are equal!
@@ -472,6 +474,8 @@ xml_diff1(cxobj     *x0,
             x1c = xml_child_each(x1, x1c, CX_ELMNT);
             continue;
         }
+        else if (xml_stamp(x0c) != 0 && xml_stamp(x0c) == xml_stamp(x1c))
+            ; /* equal and unmodified copies, skip subtree */
         else{ /* equal */
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continute compare children but without yang
@@ -558,6 +562,8 @@ xml_diff(cxobj     *x0,
             goto done;
         goto ok;
     }
+    if (xml_stamp(x0) != 0 && xml_stamp(x0) == xml_stamp(x1))
+        goto ok;
     if (xml_diff1(x0, x1,
                   first, firstlen,
                   second, secondlen,
@@ -635,6 +641,8 @@ xml_tree_equal(cxobj *x0,
         if ((eq = xml_cmp(x0c, x1c, 0, 0, NULL)) != 0){
             goto done;
         }
+        else if (xml_stamp(x0c) != 0 && xml_stamp(x0c) == xml_stamp(x1c))
+            ; /* equal and unmodified copies, skip subtree */
         else{ /* equal */
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continue compare children but without yang
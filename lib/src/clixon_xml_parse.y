@@ -162,7 +162,9 @@ xml_parse_whitespace(clixon_xml_yacc *xy,
      * For example, if xp is LEAF then a body child is OK, but if xp is CONTAINER
      * then the whitespace body is pretty-prints and should be stripped (later)
      */
-    for (i=0; i<xml_child_nr(xp); i++){
+    /* Scan backwards: elements are appended last, so this is O(1) for pretty-printed lists 
+     * instead of O(n) for each whitespace token */
+    for (i=xml_child_nr(xp)-1; i>=0; i--){
         if (xml_type(xml_child_i(xp, i)) == CX_ELMNT)
             goto ok; /* Skip if already element */
     }
@@ -628,6 +628,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
                          int           yangi,
                          int           mid,
                          int           skip1,
+                         char         *indexvar,
                          clixon_xvec  *xvec)
 {
     int        retval = -1;
@@ -643,7 +644,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
             goto done;
         if (yangi != yi) /* wrong yang */
             break;
-        if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+        if (xml_cmp(x1, xc, 0, skip1, indexvar) != 0)
             break;
         if (clixon_xvec_prepend(xvec, xc) < 0)
             goto done;
@@ -655,7 +656,7 @@ search_multi_equals_xvec(clixon_xvec  *childvec,
             goto done;
         if (yangi != yi) /* wrong yang */
             break;
-        if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+        if (xml_cmp(x1, xc, 0, skip1, indexvar) != 0)
             break;
         if (clixon_xvec_append(xvec, xc) < 0)
             goto done;
@@ -766,7 +767,7 @@ xml_search_indexvar(cxobj   *xp,
                 goto done;
             /* there may be more? */
             if (search_multi_equals_xvec(ivec, x1, yangi, pos,
-                                         0, xvec) < 0)
+                                         0, indexvar, xvec) < 0)
                 goto done;
         }
     }
@@ -1160,6 +1161,14 @@ xml_insert(cxobj           *xp,
     xml_parent_set(xi, xp);
     /* clear namespace context cache of child */
     nscache_clear(xi);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_p(xi)){
+        if (xml_search_child_insert(xp, xi) < 0)
+            goto done;
+    }
+    else if (xml_search_list_insert(xi) < 0)
+        goto done;
+#endif
 
     retval = 0;
  done:
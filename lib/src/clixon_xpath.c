@@ -655,6 +655,62 @@ xpath_vec_ctx(cxobj      *xcur,
     return retval;
 }
 
+/*! Given XML tree and XPath, returns the first node of the resulting nodeset
+ *
+ * Location paths are evaluated lazily and evaluation stops at the first node
+ * found, see xp_eval_first. Other expressions are evaluated completely.
+ * @param[in]  xcur      XML-tree where to search
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  xpath     String with XPath 1.0 syntax
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xfirst    First node, or NULL if not found
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+xpath_first_ctx(cxobj      *xcur,
+                cvec       *nsc,
+                const char *xpath,
+                int         localonly,
+                cxobj     **xfirst)
+{
+    int         retval = -1;
+    xpath_tree *xptree = NULL;
+    xp_ctx      xc = {0,};
+    xp_ctx     *xr = NULL;
+    cxobj      *xf = NULL;
+    int         ret;
+
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
+    if (xpath_parse(xpath, &xptree) < 0)
+        goto done;
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+        goto done;
+    if ((ret = xp_eval_first(&xc, xptree, nsc, localonly, &xf)) < 0)
+        goto done;
+    if (ret == 0){
+        if (xp_eval(&xc, xptree, nsc, localonly, &xr) < 0)
+            goto done;
+        if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
+            xf = xr->xc_nodeset[0];
+    }
+    *xfirst = xf;
+    retval = 0;
+ done:
+    if (xr)
+        ctx_free(xr);
+    if (xc.xc_nodeset){
+        free(xc.xc_nodeset);
+        xc.xc_nodeset = NULL;
+    }
+    if (xptree)
+        xpath_tree_free(xptree);
+    return retval;
+}
+
 /*! XPath nodeset function where only the first matching entry is returned
  *
  * @param[in]  xcur      XML tree where to search
@@ -686,7 +742,6 @@ xpath_first(cxobj      *xcur,
     va_list    ap;
     size_t     len;
     char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
 
     va_start(ap, xpformat);
     len = vsnprintf(NULL, 0, xpformat, ap);
@@ -704,13 +759,9 @@ xpath_first(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_first_ctx(xcur, nsc, xpath, 0, &cx) < 0)
         goto done;
-    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
-        cx = xr->xc_nodeset[0];
  done:
-    if (xr)
-        ctx_free(xr);
     if (xpath)
         free(xpath);
     return cx;
@@ -745,7 +796,6 @@ xpath_first_localonly(cxobj      *xcur,
     va_list    ap;
     size_t     len;
     char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
 
     va_start(ap, xpformat);
     len = vsnprintf(NULL, 0, xpformat, ap);
@@ -763,13 +813,9 @@ xpath_first_localonly(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
+    if (xpath_first_ctx(xcur, NULL, xpath, 1, &cx) < 0)
         goto done;
-    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
-        cx = xr->xc_nodeset[0];
  done:
-    if (xr)
-        ctx_free(xr);
     if (xpath)
         free(xpath);
     return cx;
@@ -929,6 +975,7 @@ xpath_vec_flag(cxobj      *xcur,
 /*! Given XML tree and XPath, returns boolean
  *
  * Returns true if the nodeset is non-empty
+ * Evaluation stops as soon as the result is known, see xp_eval_bool
  * @param[in]  xcur     xml-tree where to search
  * @param[in]  nsc      External XML namespace context, or NULL
  * @param[in]  xpformat Format string for XPath syntax
@@ -942,11 +989,12 @@ xpath_vec_bool(cxobj      *xcur,
                const char *xpformat,
                ...)
 {
-    int        retval = -1;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
+    int         retval = -1;
+    va_list     ap;
+    size_t      len;
+    char       *xpath = NULL;
+    xpath_tree *xptree = NULL;
+    xp_ctx      xc = {0,};
 
     va_start(ap, xpformat);
     len = vsnprintf(NULL, 0, xpformat, ap);
@@ -964,13 +1012,20 @@ xpath_vec_bool(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
+    if (xpath_parse(xpath, &xptree) < 0)
         goto done;
-    if (xr)
-        retval = ctx2boolean(xr);
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+        goto done;
+    retval = xp_eval_bool(&xc, xptree, nsc, 0);
  done:
-    if (xr)
-        ctx_free(xr);
+    if (xc.xc_nodeset)
+        free(xc.xc_nodeset);
+    if (xptree)
+        xpath_tree_free(xptree);
     if (xpath)
         free(xpath);
     return retval;
@@ -1205,6 +1205,7 @@ xp_eval(xp_ctx     *xc,
     xp_ctx    *xr1 = NULL;
     xp_ctx    *xr2 = NULL;
     int        use_xr0 = 0; /* In 2nd child use transitively result of 1st child */
+    int        b;
 
     // ctx_print(stderr, xc, xpath_tree_int2str(xs->xs_type));
     /* Pre-actions before check first child c0
@@ -1371,6 +1372,23 @@ xp_eval(xp_ctx     *xc,
     case XP_EXP:
         break;
     case XP_AND:
+        /* Short-circuit: skip second operand if the first decides the result */
+        if (xs->xs_c1 && xr0 &&
+            (xs->xs_int == XO_AND || xs->xs_int == XO_OR)){
+            if ((b = ctx2boolean(xr0)) < 0)
+                goto done;
+            if ((xs->xs_int == XO_AND && b == 0) ||
+                (xs->xs_int == XO_OR && b == 1)){
+                if ((xr2 = malloc(sizeof(*xr2))) == NULL){
+                    clixon_err(OE_UNIX, errno, "malloc");
+                    goto done;
+                }
+                memset(xr2, 0, sizeof(*xr2));
+                xr2->xc_initial = xr0->xc_initial;
+                xr2->xc_type = XT_BOOL;
+                xr2->xc_bool = b;
+            }
+        }
         break;
     case XP_RELEX: /* relexpr --> addexpr | relexpr relop addexpr */
         break;
@@ -1445,7 +1463,7 @@ xp_eval(xp_ctx     *xc,
     /* Eval second child c1
      * Note, some operators like locationpath, need transitive context (use_xr0)
      */
-    if (xs->xs_c1){
+    if (xs->xs_c1 && xr2 == NULL){
         if (xp_eval(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
             goto done;
         /* Actions after second child
@@ -1503,3 +1521,665 @@ xp_eval(xp_ctx     *xc,
         ctx_free(xr0);
     return retval;
 } /* xp_eval */
+
+/*
+ * Lazy evaluation
+ * A location path consisting of child, self and parent steps is evaluated
+ * depth-first, one node at a time, and evaluation stops at the first node found.
+ * This is used when only the first node or the existence of a node is of
+ * interest, ie xpath_first and boolean contexts such as must and when.
+ * Other expressions are evaluated by xp_eval.
+ */
+
+/*! Max number of steps in a lazily evaluated location path */
+#define XP_LAZY_STEPS_MAX 32
+
+/*! Callback checking a node found by lazy evaluation
+ *
+ * @param[in]  xc    Incoming context
+ * @param[in]  x     Node found
+ * @param[in]  arg   Callback argument
+ * @retval     1     Accept node, stop evaluation
+ * @retval     0     Reject node, continue evaluation
+ * @retval    -1     Error
+ */
+typedef int (xp_lazy_fn)(xp_ctx *xc, cxobj *x, void *arg);
+
+/*! Argument to lazy relational operator callback */
+struct xp_lazy_relop {
+    xp_ctx    *lr_literal; /* Literal operand */
+    int        lr_left;    /* Literal is left operand */
+    enum xp_op lr_op;      /* Relational operator */
+};
+
+/*! Skip wrapper nodes with a single child in the XPath parse-tree
+ *
+ * @param[in]  xs   XPath node tree
+ * @retval     xs   First node in the tree that is not a single-child wrapper
+ */
+static xpath_tree *
+xp_lazy_unwrap(xpath_tree *xs)
+{
+    while (xs != NULL && xs->xs_c0 != NULL && xs->xs_c1 == NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_PATHEXPR:
+        case XP_FILTEREXPR:
+        case XP_LOCPATH:
+        case XP_PRI0:
+            xs = xs->xs_c0;
+            break;
+        default:
+            return xs;
+        }
+    }
+    return xs;
+}
+
+/*! Check if an XPath tree contains a function depending on the context position
+ *
+ * @param[in]  xs   XPath node tree
+ * @retval     1    Yes, position() or last() is used
+ * @retval     0    No
+ */
+static int
+xp_lazy_positional(xpath_tree *xs)
+{
+    if (xs == NULL)
+        return 0;
+    if (xs->xs_type == XP_PRIME_FN &&
+        (xs->xs_int == XPATHFN_POSITION || xs->xs_int == XPATHFN_LAST))
+        return 1;
+    return xp_lazy_positional(xs->xs_c0) || xp_lazy_positional(xs->xs_c1);
+}
+
+/*! Check if predicates can be evaluated one node at a time
+ *
+ * A predicate depending on the context position, or evaluating to a number
+ * (which is compared to the position), requires the complete nodeset.
+ * @param[in]  xs   XPath predicate tree (XP_PRED)
+ * @retval     1    Yes, predicates do not depend on position
+ * @retval     0    No
+ */
+static int
+xp_lazy_pred_ok(xpath_tree *xs)
+{
+    xpath_tree *xe;
+
+    if (xs == NULL)
+        return 1;
+    if (xp_lazy_pred_ok(xs->xs_c0) == 0)
+        return 0;
+    if ((xe = xs->xs_c1) == NULL)
+        return 1;
+    if (xp_lazy_positional(xe))
+        return 0;
+    xe = xp_lazy_unwrap(xe);
+    switch (xe->xs_type){
+    case XP_ADD:
+    case XP_PRIME_NR:
+        return 0;
+    case XP_PRIME_FN:
+        switch (xe->xs_int){
+        case XPATHFN_COUNT:
+        case XPATHFN_STRING_LENGTH:
+        case XPATHFN_NUMBER:
+        case XPATHFN_SUM:
+        case XPATHFN_FLOOR:
+        case XPATHFN_CEILING:
+        case XPATHFN_ROUND:
+            return 0;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+
+/*! Collect steps of a relative location path
+ *
+ * @param[in]     xs      XPath node tree (XP_RELLOCPATH)
+ * @param[out]    steps   Vector of steps
+ * @param[in,out] nsteps  Number of steps
+ * @retval        1       OK, all steps can be lazily evaluated
+ * @retval        0       No, eg descendant axis
+ */
+static int
+xp_lazy_rellocpath(xpath_tree  *xs,
+                   xpath_tree **steps,
+                   int         *nsteps)
+{
+    xpath_tree *xstep;
+
+    if (xs == NULL ||
+        xs->xs_type != XP_RELLOCPATH ||
+        xs->xs_int == A_DESCENDANT_OR_SELF)
+        return 0;
+    if (xs->xs_c1 != NULL){
+        if (xp_lazy_rellocpath(xs->xs_c0, steps, nsteps) == 0)
+            return 0;
+        xstep = xs->xs_c1;
+    }
+    else
+        xstep = xs->xs_c0;
+    if (xstep == NULL || xstep->xs_type != XP_STEP)
+        return 0;
+    switch (xstep->xs_int){
+    case A_CHILD:
+    case A_SELF:
+    case A_PARENT:
+        break;
+    default:
+        return 0;
+    }
+    if (*nsteps >= XP_LAZY_STEPS_MAX)
+        return 0;
+    if (xp_lazy_pred_ok(xstep->xs_c1) == 0)
+        return 0;
+    steps[(*nsteps)++] = xstep;
+    return 1;
+}
+
+/*! Collect steps of a location path if it can be lazily evaluated
+ *
+ * @param[in]  xs      XPath node tree
+ * @param[out] steps   Vector of steps, size XP_LAZY_STEPS_MAX
+ * @param[out] nsteps  Number of steps
+ * @param[out] abs     Absolute location path
+ * @retval     1       OK
+ * @retval     0       No, use regular evaluation
+ */
+static int
+xp_lazy_path(xpath_tree  *xs,
+             xpath_tree **steps,
+             int         *nsteps,
+             int         *abs)
+{
+    *nsteps = 0;
+    *abs = 0;
+    if ((xs = xp_lazy_unwrap(xs)) == NULL)
+        return 0;
+    if (xs->xs_type == XP_ABSPATH){
+        if (xs->xs_int != A_ROOT || xs->xs_c0 == NULL)
+            return 0;
+        *abs = 1;
+        xs = xs->xs_c0;
+    }
+    return xp_lazy_rellocpath(xs, steps, nsteps);
+}
+
+/*! Evaluate predicates of a step for a single node
+ *
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath predicate tree (XP_PRED)
+ * @param[in]  x         Node
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @retval     1         All predicates are true
+ * @retval     0         Some predicate is false
+ * @retval    -1         Error
+ * @see xp_eval_predicate
+ */
+static int
+xp_lazy_pred(xp_ctx     *xc,
+             xpath_tree *xs,
+             cxobj      *x,
+             cvec       *nsc,
+             int         localonly)
+{
+    int     retval = -1;
+    xp_ctx *xcc = NULL;
+    xp_ctx *xrc = NULL;
+    int     ret;
+
+    if (xs == NULL)
+        goto ok;
+    if (xs->xs_c0 != NULL){
+        if ((ret = xp_lazy_pred(xc, xs->xs_c0, x, nsc, localonly)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (xs->xs_c1 != NULL){
+        if ((xcc = malloc(sizeof(*xcc))) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            goto done;
+        }
+        memset(xcc, 0, sizeof(*xcc));
+        xcc->xc_type = XT_NODESET;
+        xcc->xc_initial = xc->xc_initial;
+        xcc->xc_node = x;
+        if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
+            goto done;
+        if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
+            goto done;
+        if (ctx2boolean(xrc) != 1)
+            goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (xrc)
+        ctx_free(xrc);
+    if (xcc)
+        ctx_free(xcc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Evaluate steps of a location path depth-first from a node
+ *
+ * @param[in]  xc        Incoming context
+ * @param[in]  steps     Vector of steps
+ * @param[in]  nsteps    Number of steps
+ * @param[in]  i         Current step
+ * @param[in]  xv        Context node of current step
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  fn        Callback checking found nodes, or NULL
+ * @param[in]  arg       Callback argument
+ * @param[out] xfound    First node found
+ * @retval     1         Found
+ * @retval     0         Not found
+ * @retval    -1         Error
+ */
+static int
+xp_lazy_step(xp_ctx      *xc,
+             xpath_tree **steps,
+             int          nsteps,
+             int          i,
+             cxobj       *xv,
+             cvec        *nsc,
+             int          localonly,
+             xp_lazy_fn  *fn,
+             void        *arg,
+             cxobj      **xfound)
+{
+    int         retval = -1;
+    xpath_tree *xs;
+    cxobj     **vec = NULL;
+    int         veclen = 0;
+    cxobj      *x;
+    int         j;
+    int         ret;
+
+    if (i == nsteps){
+        if (fn != NULL){
+            if ((ret = fn(xc, xv, arg)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        *xfound = xv;
+        goto found;
+    }
+    xs = steps[i];
+    switch (xs->xs_int){
+    case A_CHILD:
+        if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
+            goto done;
+        if (ret == 0){ /* regular code, no optimization made */
+            x = NULL;
+            while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+                if (xs->xs_c0 != NULL &&
+                    nodetest_eval(x, xs->xs_c0, nsc, localonly) != 1)
+                    continue;
+                if ((ret = xp_lazy_pred(xc, xs->xs_c1, x, nsc, localonly)) < 0)
+                    goto done;
+                if (ret == 0)
+                    continue;
+                if ((ret = xp_lazy_step(xc, steps, nsteps, i+1, x, nsc, localonly, fn, arg, xfound)) < 0)
+                    goto done;
+                if (ret == 1)
+                    goto found;
+            }
+            goto fail;
+        }
+        break;
+    case A_PARENT:
+        if ((x = xml_parent(xv)) != NULL
+#ifdef XML_PARENT_CANDIDATE
+            /* Also check "candidate" parent for special when use-case */
+            || (x = xml_parent_candidate(xv)) != NULL
+#endif /* XML_PARENT_CANDIDATE */
+            )
+            if (cxvec_append(x, &vec, &veclen) < 0)
+                goto done;
+        break;
+    case A_SELF:
+        if (cxvec_append(xv, &vec, &veclen) < 0)
+            goto done;
+        break;
+    default:
+        clixon_err(OE_XML, 0, "Unexpected axisname: %d", xs->xs_int);
+        goto done;
+        break;
+    }
+    for (j=0; j<veclen; j++){
+        x = vec[j];
+        if ((ret = xp_lazy_pred(xc, xs->xs_c1, x, nsc, localonly)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        if ((ret = xp_lazy_step(xc, steps, nsteps, i+1, x, nsc, localonly, fn, arg, xfound)) < 0)
+            goto done;
+        if (ret == 1)
+            goto found;
+    }
+ fail:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+ found:
+    retval = 1;
+    goto done;
+}
+
+/*! Lazy evaluation of a location path
+ *
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath node tree
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  fn        Callback checking found nodes, or NULL
+ * @param[in]  arg       Callback argument
+ * @param[out] xfound    First node found, or NULL
+ * @retval     1         Evaluated, result in xfound
+ * @retval     0         Not a lazy location path, use xp_eval
+ * @retval    -1         Error
+ */
+static int
+xp_lazy_eval(xp_ctx     *xc,
+             xpath_tree *xs,
+             cvec       *nsc,
+             int         localonly,
+             xp_lazy_fn *fn,
+             void       *arg,
+             cxobj     **xfound)
+{
+    int         retval = -1;
+    xpath_tree *steps[XP_LAZY_STEPS_MAX];
+    int         nsteps = 0;
+    int         abs = 0;
+    cxobj      *x;
+    int         i;
+    int         ret;
+
+    *xfound = NULL;
+    if (xp_lazy_path(xs, steps, &nsteps, &abs) == 0)
+        goto fail;
+    if (abs){
+        /* Context node is top node, see xp_eval */
+        if ((x = xc->xc_node) == NULL)
+            goto fail;
+#ifdef XML_PARENT_CANDIDATE
+        while (xml_parent(x) != NULL || xml_parent_candidate(x) != NULL)
+            x = xml_parent(x)?xml_parent(x):xml_parent_candidate(x);
+#else
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+#endif
+        if (xp_lazy_step(xc, steps, nsteps, 0, x, nsc, localonly, fn, arg, xfound) < 0)
+            goto done;
+    }
+    else {
+        if (xc->xc_type != XT_NODESET)
+            goto fail;
+        for (i=0; i<xc->xc_size; i++){
+            if ((x = xc->xc_nodeset[i]) == NULL)
+                continue;
+            if ((ret = xp_lazy_step(xc, steps, nsteps, 0, x, nsc, localonly, fn, arg, xfound)) < 0)
+                goto done;
+            if (ret == 1)
+                break;
+        }
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Lazy relational operator callback: compare a single node with a literal
+ *
+ * @see xp_lazy_fn
+ */
+static int
+xp_lazy_relop_fn(xp_ctx *xc,
+                 cxobj  *x,
+                 void   *arg)
+{
+    int                   retval = -1;
+    struct xp_lazy_relop *lr = (struct xp_lazy_relop *)arg;
+    xp_ctx                xn = {0,};
+    xp_ctx               *xr = NULL;
+
+    xn.xc_type = XT_NODESET;
+    xn.xc_initial = xc->xc_initial;
+    xn.xc_node = x;
+    if (cxvec_append(x, &xn.xc_nodeset, &xn.xc_size) < 0)
+        goto done;
+    if (lr->lr_left){
+        if (xp_relop(lr->lr_literal, &xn, lr->lr_op, &xr) < 0)
+            goto done;
+    }
+    else if (xp_relop(&xn, lr->lr_literal, lr->lr_op, &xr) < 0)
+        goto done;
+    retval = ctx2boolean(xr) == 1;
+ done:
+    if (xr)
+        ctx_free(xr);
+    if (xn.xc_nodeset)
+        free(xn.xc_nodeset);
+    return retval;
+}
+
+/*! Lazy evaluation of a relational expression between a location path and a literal
+ *
+ * The comparison is true if it is true for some node in the nodeset, so
+ * evaluation stops at the first such node.
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath node tree (XP_RELEX)
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] result    Boolean result
+ * @retval     1         Evaluated, see result
+ * @retval     0         Not applicable, use xp_eval
+ * @retval    -1         Error
+ */
+static int
+xp_lazy_relex(xp_ctx     *xc,
+              xpath_tree *xs,
+              cvec       *nsc,
+              int         localonly,
+              int        *result)
+{
+    int                  retval = -1;
+    struct xp_lazy_relop lr = {0,};
+    xpath_tree          *steps[XP_LAZY_STEPS_MAX];
+    int                  nsteps;
+    int                  abs;
+    xpath_tree          *xpath;
+    xpath_tree          *xlit;
+    xp_ctx              *xcl = NULL;
+    cxobj               *xfound = NULL;
+    int                  ret;
+
+    if (xs->xs_c0 == NULL || xs->xs_c1 == NULL)
+        goto fail;
+    switch (xs->xs_int){
+    case XO_EQ:
+    case XO_NE:
+    case XO_GE:
+    case XO_LE:
+    case XO_LT:
+    case XO_GT:
+        break;
+    default:
+        goto fail;
+    }
+    if (xp_lazy_path(xs->xs_c0, steps, &nsteps, &abs) == 1){
+        xpath = xs->xs_c0;
+        xlit = xs->xs_c1;
+    }
+    else if (xp_lazy_path(xs->xs_c1, steps, &nsteps, &abs) == 1){
+        xpath = xs->xs_c1;
+        xlit = xs->xs_c0;
+        lr.lr_left = 1;
+    }
+    else
+        goto fail;
+    switch (xp_lazy_unwrap(xlit)->xs_type){
+    case XP_PRIME_STR:
+    case XP_PRIME_NR:
+        break;
+    default:
+        goto fail;
+    }
+    if ((xcl = ctx_dup(xc)) == NULL)
+        goto done;
+    if (xp_eval(xcl, xlit, nsc, localonly, &lr.lr_literal) < 0)
+        goto done;
+    lr.lr_op = xs->xs_int;
+    if ((ret = xp_lazy_eval(xc, xpath, nsc, localonly, xp_lazy_relop_fn, &lr, &xfound)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    *result = xfound != NULL;
+    retval = 1;
+ done:
+    if (lr.lr_literal)
+        ctx_free(lr.lr_literal);
+    if (xcl)
+        ctx_free(xcl);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Evaluate an XPath and return the first node of the resulting nodeset
+ *
+ * Location paths of child, self and parent steps are evaluated lazily and
+ * evaluation stops at the first node found.
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath node tree
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xfirst    First node, or NULL if empty
+ * @retval     1         Evaluated, result in xfirst
+ * @retval     0         Not lazily evaluated, use xp_eval
+ * @retval    -1         Error
+ */
+int
+xp_eval_first(xp_ctx     *xc,
+              xpath_tree *xs,
+              cvec       *nsc,
+              int         localonly,
+              cxobj     **xfirst)
+{
+    return xp_lazy_eval(xc, xs, nsc, localonly, NULL, NULL, xfirst);
+}
+
+/*! Evaluate an XPath in a boolean context
+ *
+ * Evaluation stops as soon as the result is known:
+ * - and/or are short-circuited
+ * - a location path is true if it has one node
+ * - a location path compared with a literal is true if one node matches
+ * Other expressions are evaluated by xp_eval and converted to boolean.
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath node tree
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @retval     1         True
+ * @retval     0         False
+ * @retval    -1         Error
+ */
+int
+xp_eval_bool(xp_ctx     *xc,
+             xpath_tree *xs,
+             cvec       *nsc,
+             int         localonly)
+{
+    int         retval = -1;
+    xpath_tree *xt;
+    xp_ctx     *xc1 = NULL;
+    xp_ctx     *xr = NULL;
+    cxobj      *xfound = NULL;
+    int         b;
+    int         ret;
+
+    if ((xt = xp_lazy_unwrap(xs)) == NULL){
+        clixon_err(OE_XML, EFAULT, "XPath tree is NULL");
+        goto done;
+    }
+    switch (xt->xs_type){
+    case XP_AND:
+        if (xt->xs_c1 == NULL)
+            break;
+        if ((b = xp_eval_bool(xc, xt->xs_c0, nsc, localonly)) < 0)
+            goto done;
+        if ((xt->xs_int == XO_AND && b == 0) ||
+            (xt->xs_int == XO_OR && b == 1)){
+            retval = b;
+            goto done;
+        }
+        retval = xp_eval_bool(xc, xt->xs_c1, nsc, localonly);
+        goto done;
+        break;
+    case XP_RELEX:
+        if ((ret = xp_lazy_relex(xc, xt, nsc, localonly, &b)) < 0)
+            goto done;
+        if (ret == 1){
+            retval = b;
+            goto done;
+        }
+        break;
+    case XP_PRIME_FN:
+        /* not() with a single argument */
+        if (xt->xs_int == XPATHFN_NOT &&
+            xt->xs_c0 != NULL &&
+            xt->xs_c0->xs_type == XP_EXP &&
+            xt->xs_c0->xs_c1 == NULL){
+            if ((b = xp_eval_bool(xc, xt->xs_c0, nsc, localonly)) < 0)
+                goto done;
+            retval = !b;
+            goto done;
+        }
+        break;
+    default:
+        if ((ret = xp_lazy_eval(xc, xt, nsc, localonly, NULL, NULL, &xfound)) < 0)
+            goto done;
+        if (ret == 1){
+            retval = xfound != NULL;
+            goto done;
+        }
+        break;
+    }
+    /* Regular evaluation on a copy since xp_eval may change the context */
+    if ((xc1 = ctx_dup(xc)) == NULL)
+        goto done;
+    if (xp_eval(xc1, xs, nsc, localonly, &xr) < 0)
+        goto done;
+    retval = ctx2boolean(xr);
+ done:
+    if (xr)
+        ctx_free(xr);
+    if (xc1)
+        ctx_free(xc1);
+    return retval;
+}
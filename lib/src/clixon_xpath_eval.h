@@ -46,5 +46,7 @@ extern const map_str2int xpopmap[];
  * Prototypes
  */
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_eval_first(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, cxobj **xfirst);
+int xp_eval_bool(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -60,6 +60,7 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_yang_type.h"
 #include "clixon_xml.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
@@ -71,24 +72,91 @@
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
-static int _optimize_enable = 1;
-static int _optimize_hits = 0;
+/*! Optimized list lookup patterns
+ *
+ * @see xpath_list_optimize_fn
+ */
+enum xpath_optimize_pattern{
+    XPO_KEYS,        /* y[k1='a' and k2='b'], all keys */
+    XPO_KEY_PREFIX,  /* y[k1='a'], first key(s) of several */
+    XPO_INDEX,       /* y[i='a'], explicit search index */
+    XPO_RANGE,       /* y[k1>=3 and k1<10], range of integer first key */
+    XPO_MAX
+};
+
+static const map_str2int xpomap[] = {
+    {"keys",       XPO_KEYS},
+    {"key-prefix", XPO_KEY_PREFIX},
+    {"index",      XPO_INDEX},
+    {"range",      XPO_RANGE},
+    {NULL,         -1}
+};
+
+/* Max number of relational terms in all predicates of a step */
+#define XPO_TERMS_MAX 16
+
+/*! A relational term of a predicate on the form <leaf> <op> <literal>
+ */
+struct xpo_term{
+    char *t_name; /* Name of child leaf */
+    int   t_op;   /* XO_EQ, XO_LT, XO_LE, XO_GT or XO_GE */
+    char *t_val;  /* Literal value */
+    int   t_nr;   /* Literal is a number */
+};
+
+static int      _optimize_enable = 1;
+static uint64_t _optimize_hits[XPO_MAX] = {0,};
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset total number of optimized xpath list lookups
+ *
+ * @param[out] hits  Number of lookups since last call
+ * @retval     0     OK
+ * @see xpath_list_optimize_pattern  for hits per pattern
+ */
 int
 xpath_list_optimize_stats(int *hits)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
-    _optimize_hits = 0;
+    int i;
+
+    *hits = 0;
+    for (i=0; i<XPO_MAX; i++){
+        *hits += _optimize_hits[i];
+        _optimize_hits[i] = 0;
+    }
 #endif
     return 0;
 }
 
+/*! Get hit counter of an optimized xpath list lookup pattern
+ *
+ * @param[in]  i     Pattern number, iterate from 0
+ * @param[out] name  Name of pattern
+ * @param[out] hits  Number of lookups using this pattern
+ * @retval     1     OK
+ * @retval     0     No such pattern, end of iteration
+ * @code
+ *   for (i=0; xpath_list_optimize_pattern(i, &name, &hits) == 1; i++)
+ *      ...
+ * @endcode
+ */
+int
+xpath_list_optimize_pattern(int          i,
+                            const char **name,
+                            uint64_t    *hits)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    if (i < 0 || i >= XPO_MAX)
+        return 0;
+    *name = clicon_int2str(xpomap, i);
+    *hits = _optimize_hits[i];
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 /*! Enable xpath optimize
  *
  * Cant replace this with option since there is no handle in xpath functions,...
@@ -106,209 +174,509 @@ void
 xpath_optimize_exit(void)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-        xpath_tree_free(_xmtop);
+    memset(_optimize_hits, 0, sizeof(_optimize_hits));
 #endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
+/*! Get name of a single child step of a relational operand, eg "k" in k='3'
  *
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+ * @param[in]  xs    XPath tree of type XP_ADD
+ * @retval     name  Name of child node
+ * @retval     NULL  Not a single child step without predicates
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+static char *
+xpo_operand_leaf(xpath_tree *xs)
 {
-    int         retval = -1;
-    xpath_tree *xs;
+    xpath_tree *xn;
 
-    if (_xm == NULL){
-        /* Initialize xpath-tree */
-        if (xpath_parse("_x[_y='_z']", &_xmtop) < 0)
-            goto done;
-        /* Go down two steps */
-        if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-            goto done;
-        /* get nodetest tree (_x) */
-        if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get predicates [_y=_z][z=2] */
-        if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get expression [_y=_z] */
-        if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-            goto done;
-        /* get keyname (_y) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-        /* get keyval (_z) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+    if (xs == NULL || xs->xs_type != XP_ADD || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_UNION || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_PATHEXPR || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_LOCPATH)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_RELLOCPATH ||
+        xs->xs_int != A_NAN || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_STEP || xs->xs_int != A_CHILD)
+        return NULL;
+    if (xs->xs_c1 && (xs->xs_c1->xs_c0 || xs->xs_c1->xs_c1)) /* predicates */
+        return NULL;
+    if ((xn = xs->xs_c0) == NULL || xn->xs_type != XP_NODE)
+        return NULL;
+    return xn->xs_s1;
+}
+
+/*! Get a literal string or number of a relational operand, eg '3' in k='3'
+ *
+ * @param[in]  xs    XPath tree of type XP_ADD
+ * @param[out] nr    Literal is a number
+ * @retval     val   Literal value
+ * @retval     NULL  Not a literal
+ */
+static char *
+xpo_operand_literal(xpath_tree *xs,
+                    int        *nr)
+{
+    if (xs == NULL || xs->xs_type != XP_ADD || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_UNION || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_PATHEXPR || xs->xs_c1)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_FILTEREXPR)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL)
+        return NULL;
+    switch (xs->xs_type){
+    case XP_PRIME_STR:
+        *nr = 0;
+        return xs->xs_s0;
+    case XP_PRIME_NR:
+        *nr = 1;
+        return xs->xs_strnr;
+    default:
+        break;
     }
-    *xm = _xm;
-    *xe = _xe;
-    retval = 0;
+    return NULL;
+}
+
+/*! Get a relational term <leaf> <op> <literal>, or <literal> <op> <leaf>
+ *
+ * @param[in]     xs    XPath tree of type XP_RELEX
+ * @param[in,out] terms Vector of terms
+ * @param[in,out] nr    Length of terms
+ * @retval        1     OK, term added
+ * @retval        0     Not a relational term of this form
+ */
+static int
+xpo_relex(xpath_tree      *xs,
+          struct xpo_term *terms,
+          int             *nr)
+{
+    struct xpo_term *t;
+    xpath_tree      *x0;
+    int              op;
+
+    if (xs == NULL || xs->xs_type != XP_RELEX || xs->xs_c1 == NULL)
+        return 0;
+    op = xs->xs_int;
+    if (op != XO_EQ && op != XO_LT && op != XO_LE && op != XO_GT && op != XO_GE)
+        return 0;
+    /* Left operand is wrapped in a single relexpr */
+    if ((x0 = xs->xs_c0) == NULL || x0->xs_type != XP_RELEX || x0->xs_c1)
+        return 0;
+    if (*nr >= XPO_TERMS_MAX)
+        return 0;
+    t = &terms[*nr];
+    if ((t->t_name = xpo_operand_leaf(x0->xs_c0)) != NULL &&
+        (t->t_val = xpo_operand_literal(xs->xs_c1, &t->t_nr)) != NULL)
+        t->t_op = op;
+    else if ((t->t_name = xpo_operand_leaf(xs->xs_c1)) != NULL &&
+             (t->t_val = xpo_operand_literal(x0->xs_c0, &t->t_nr)) != NULL){
+        switch (op){ /* 3<k is k>3 */
+        case XO_LT: op = XO_GT; break;
+        case XO_LE: op = XO_GE; break;
+        case XO_GT: op = XO_LT; break;
+        case XO_GE: op = XO_LE; break;
+        default: break;
+        }
+        t->t_op = op;
+    }
+    else
+        return 0;
+    (*nr)++;
+    return 1;
+}
+
+/*! Get terms of a conjunction: t1 and t2 and ...
+ *
+ * @param[in]     xs    XPath tree of type XP_AND
+ * @param[in,out] terms Vector of terms
+ * @param[in,out] nr    Length of terms
+ * @retval        1     OK, all terms added
+ * @retval        0     Not a conjunction of relational terms
+ * @note A_NAN and XO_AND are both 0, a conjunction has a second child
+ */
+static int
+xpo_and(xpath_tree      *xs,
+        struct xpo_term *terms,
+        int             *nr)
+{
+    if (xs == NULL || xs->xs_type != XP_AND)
+        return 0;
+    if (xs->xs_c1 == NULL)
+        return xpo_relex(xs->xs_c0, terms, nr);
+    if (xs->xs_int != XO_AND)
+        return 0;
+    if (xpo_and(xs->xs_c0, terms, nr) == 0)
+        return 0;
+    return xpo_relex(xs->xs_c1, terms, nr);
+}
+
+/*! Get terms of all predicates of a step: [t1 and t2][t3]...
+ *
+ * All predicates must be conjunctions of relational terms. Otherwise there may be
+ * positional predicates, such as y[1][k='3'], where a subset of terms can not be used.
+ * @param[in]     xs    XPath tree of type XP_PRED
+ * @param[in,out] terms Vector of terms
+ * @param[in,out] nr    Length of terms
+ * @retval        1     OK, all terms added
+ * @retval        0     Some predicate not of this form
+ */
+static int
+xpo_preds(xpath_tree      *xs,
+          struct xpo_term *terms,
+          int             *nr)
+{
+    xpath_tree *xe;
+
+    if (xs == NULL || xs->xs_type != XP_PRED)
+        return 0;
+    if (xs->xs_c0 && xpo_preds(xs->xs_c0, terms, nr) == 0)
+        return 0;
+    if ((xe = xs->xs_c1) != NULL){
+        if (xe->xs_type != XP_EXP || xe->xs_c1)
+            return 0;
+        if (xpo_and(xe->xs_c0, terms, nr) == 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Check that a term value is a valid value of a leaf
+ *
+ * A number can only be used on integer leafs, since eg k=1 also matches "01" in a string
+ * @param[in]  yk     Yang leaf
+ * @param[in]  t      Term
+ * @param[out] cvtype Cligen type of leaf
+ * @retval     1      Valid
+ * @retval     0      Invalid, do not optimize
+ * @retval    -1      Error
+ */
+static int
+xpo_value_check(yang_stmt       *yk,
+                struct xpo_term *t,
+                enum cv_type    *cvtype)
+{
+    int        retval = -1;
+    yang_stmt *yrestype;
+    cg_var    *cv = NULL;
+    char      *reason = NULL;
+    uint8_t    fraction = 0;
+    int        ret;
+
+    if (yang_type_get(yk, NULL, &yrestype, NULL, NULL, NULL, NULL, &fraction) < 0)
+        goto done;
+    if (yrestype == NULL)
+        goto fail;
+    if (yang2cv_type(yang_argument_get(yrestype), cvtype) < 0)
+        goto done;
+    if (*cvtype == CGV_ERR)
+        goto fail;
+    if (t->t_nr && !cv_isint(*cvtype))
+        goto fail;
+    if ((cv = cv_new(*cvtype)) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_new");
+        goto done;
+    }
+    if (*cvtype == CGV_DEC64)
+        cv_dec64_n_set(cv, fraction);
+    if ((ret = cv_parse1(t->t_val, cv, &reason)) < 0){
+        clixon_err(OE_UNIX, errno, "cv_parse1");
+        goto done;
+    }
+    if (ret == 0)
+        goto fail;
+    retval = 1;
  done:
+    if (reason)
+        free(reason);
+    if (cv)
+        cv_free(cv);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
-/*! Recursive function to loop over all EXPR and pattern match them
+#ifdef XML_EXPLICIT_INDEX
+/*! Find an equality term on an explicit search index leaf of a list
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval     1     Match
- * @retval     0     No match
+ * @param[in]  yc    Yang list
+ * @param[in]  terms Vector of terms
+ * @param[in]  nr    Length of terms
+ * @param[out] jp    Term number
+ * @retval     1     Found, see jp
+ * @retval     0     Not found
  * @retval    -1     Error
- * @see xpath_optimize_init
  */
 static int
-loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
-           cvec       *cvk)
+xpo_index(yang_stmt       *yc,
+          struct xpo_term *terms,
+          int              nr,
+          int             *jp)
 {
-    int          retval = -1;
+    yang_stmt   *yi;
+    enum cv_type cvtype;
     int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
+    int          j;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
+    for (j=0; j<nr; j++){
+        if (terms[j].t_op != XO_EQ)
+            continue;
+        if ((yi = yang_find(yc, Y_LEAF, terms[j].t_name)) == NULL ||
+            yang_flag_get(yi, YANG_FLAG_INDEX) == 0)
+            continue;
+        if ((ret = xpo_value_check(yi, &terms[j], &cvtype)) < 0)
+            return -1;
         if (ret == 0)
-            goto ok;
+            continue;
+        *jp = j;
+        return 1;
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
-        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-            clixon_err(OE_XML, errno, "cvec_add");
-            goto done;
-        }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
+    return 0;
+}
+#endif /* XML_EXPLICIT_INDEX */
+
+/*! Create a list object with a single key value as search object
+ *
+ * @param[in]  yc    Yang list
+ * @param[in]  yk    Yang key leaf
+ * @param[in]  val   Key value or NULL for no key
+ * @retval     xc    Search object, free with xml_free
+ * @retval     NULL  Error
+ */
+static cxobj *
+xpo_search_obj(yang_stmt *yc,
+               yang_stmt *yk,
+               char      *val)
+{
+    cxobj *xc;
+    cxobj *xk;
+    cxobj *xb;
+
+    if ((xc = xml_new(yang_argument_get(yc), NULL, CX_ELMNT)) == NULL)
+        goto err;
+    xml_spec_set(xc, yc);
+    if (val){
+        if ((xk = xml_new(yang_argument_get(yk), xc, CX_ELMNT)) == NULL)
+            goto err;
+        xml_spec_set(xk, yk);
+        if ((xb = xml_new("body", xk, CX_BODY)) == NULL)
+            goto err;
+        if (xml_value_set(xb, val) < 0)
+            goto err;
+    }
+    return xc;
+ err:
+    if (xc)
+        xml_free(xc);
+    return NULL;
+}
+
+/*! Find list entries with first key in a range using binary search of lower bound
+ *
+ * @param[in]  xv    XML parent node
+ * @param[in]  yc    Yang list, must be ordered-by system
+ * @param[in]  yk    Yang first key leaf, must be integer
+ * @param[in]  lo    Lower bound term (> or >=), or NULL
+ * @param[in]  hi    Upper bound term (< or <=), or NULL
+ * @param[out] xvec  Vector of list entries
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpo_range(cxobj           *xv,
+          yang_stmt       *yc,
+          yang_stmt       *yk,
+          struct xpo_term *lo,
+          struct xpo_term *hi,
+          clixon_xvec     *xvec)
+{
+    int    retval = -1;
+    cxobj *xlo = NULL;
+    cxobj *xhi = NULL;
+    cxobj *xc;
+    int    low = 0;
+    int    upper;
+    int    mid;
+    int    cmp;
+    int    i;
+
+    if ((xlo = xpo_search_obj(yc, yk, lo?lo->t_val:NULL)) == NULL)
+        goto done;
+    if (hi && (xhi = xpo_search_obj(yc, yk, hi->t_val)) == NULL)
+        goto done;
+    /* First entry not before lower bound. If no bound, first entry of list */
+    upper = xml_child_nr(xv);
+    while (low < upper){
+        mid = (low + upper) / 2;
+        xc = xml_child_i(xv, mid);
+        cmp = xml_cmp(xlo, xc, 0, 1, NULL);
+        if (cmp > 0 || (cmp == 0 && lo && lo->t_op == XO_GT))
+            low = mid + 1;
         else
-            cv_string_set(cvi, vec[1]->xs_s0);
+            upper = mid;
     }
-    retval = 1;
+    for (i=low; i<xml_child_nr(xv); i++){
+        xc = xml_child_i(xv, i);
+        if (xml_spec(xc) != yc)
+            break;
+        if (xhi){
+            cmp = xml_cmp(xhi, xc, 0, 1, NULL);
+            if (cmp < 0 || (cmp == 0 && hi->t_op == XO_LT))
+                break;
+        }
+        if (clixon_xvec_append(xvec, xc) < 0)
+            goto done;
+    }
+    retval = 0;
  done:
-    if (vec)
-        free(vec);
+    if (xlo)
+        xml_free(xlo);
+    if (xhi)
+        xml_free(xhi);
     return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
 }
 
 /*! Pattern matching to find fastpath
  *
- * @param[in]  xt     XPath tree
+ * Predicates of a list step are rewritten to a search of the child list if all predicates
+ * are conjunctions of <leaf> <op> <literal> terms, and:
+ * - equality terms cover all keys or first key(s) of the list, or
+ * - an equality term is on an explicit search index, or
+ * - range terms are on an integer first key of an ordered-by system list
+ * The result is a superset of the matching entries: all predicates are evaluated on it
+ * @param[in]  xt     XPath tree of type XP_STEP
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
  * @retval     1      Match
  * @retval     0      No match - use non-optimized lookup
  * @retval    -1      Error
  *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k1=3][k2='a'], y[k1=3 and k2='a'], y[k1>=3 and k1<10] # corresponds to: <name>[<keyname>=<keyval>]
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
                        cxobj       *xv,
                        clixon_xvec *xvec)
 {
-    int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
-    char        *name;
-    yang_stmt   *yp;
-    yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
-    int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    int              retval = -1;
+    xpath_tree      *xn;
+    char            *name;
+    yang_stmt       *yp;
+    yang_stmt       *yc;
+    yang_stmt       *yk;
+    cvec            *cvv;
+    cvec            *cvk = NULL; /* vector of index keys */
+    cg_var          *cvi;
+    struct xpo_term  terms[XPO_TERMS_MAX];
+    struct xpo_term *lo = NULL;
+    struct xpo_term *hi = NULL;
+    int              nr = 0;
+    int              i;
+    int              j;
+    int              ret;
+    int              pattern;
+    enum cv_type     cvtype;
 
+    if (xt->xs_type != XP_STEP || xt->xs_int != A_CHILD || xt->xs_c1 == NULL)
+        goto ok;
+    if ((xn = xt->xs_c0) == NULL || xn->xs_type != XP_NODE || (name = xn->xs_s1) == NULL)
+        goto ok;
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
         goto ok;
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-        goto done;
-    if (ret == 0)
-        goto ok; /* no match */
-    if (veclen != 2)
+    if ((yc = yang_find_datanode(yp, name)) == NULL ||
+        yang_keyword_get(yc) != Y_LIST)
         goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
     if ((cvv = yang_cvec_get(yc)) == NULL)
         goto ok;
-    xtp = vec[1];
+    if (xpo_preds(xt->xs_c1, terms, &nr) == 0 || nr == 0)
+        goto ok;
     if ((cvk = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
-        goto done;
-    if (ret == 0)
-        goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-        goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
+    /* 1. Equality terms on keys in key order */
+    for (i=0; i<cvec_len(cvv); i++){
+        yk = yang_find(yc, Y_LEAF, cv_string_get(cvec_i(cvv, i)));
+        for (j=0; j<nr; j++){
+            if (terms[j].t_op != XO_EQ ||
+                strcmp(terms[j].t_name, cv_string_get(cvec_i(cvv, i))) != 0)
+                continue;
+            if (yk == NULL || (ret = xpo_value_check(yk, &terms[j], &cvtype)) == 0)
+                continue;
+            if (ret < 0)
+                goto done;
+            break;
+        }
+        if (j == nr)
+            break;
+        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_add");
+            goto done;
+        }
+        cv_name_set(cvi, terms[j].t_name);
+        cv_string_set(cvi, terms[j].t_val);
+    }
+    if (i == cvec_len(cvv))
+        pattern = XPO_KEYS;
+    else if (i > 0)
+        pattern = XPO_KEY_PREFIX;
+#ifdef XML_EXPLICIT_INDEX
+    /* 2. Single equality term on an explicit search index, see cc:search_index */
+    else if ((ret = xpo_index(yc, terms, nr, &j)) != 0){
+        if (ret < 0)
+            goto done;
+        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_add");
+            goto done;
+        }
+        cv_name_set(cvi, terms[j].t_name);
+        cv_string_set(cvi, terms[j].t_val);
+        pattern = XPO_INDEX;
+    }
+#endif
+    else{
+        /* 3. Range terms on an integer first key */
+        if (yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+            goto ok;
+        if ((yk = yang_find(yc, Y_LEAF, cv_string_get(cvec_i(cvv, 0)))) == NULL)
             goto ok;
-        i++;
+        for (j=0; j<nr; j++){
+            if (strcmp(terms[j].t_name, yang_argument_get(yk)) != 0)
+                continue;
+            if ((ret = xpo_value_check(yk, &terms[j], &cvtype)) < 0)
+                goto done;
+            if (ret == 0 || !cv_isint(cvtype))
+                continue;
+            if (lo == NULL && (terms[j].t_op == XO_GT || terms[j].t_op == XO_GE))
+                lo = &terms[j];
+            else if (hi == NULL && (terms[j].t_op == XO_LT || terms[j].t_op == XO_LE))
+                hi = &terms[j];
+        }
+        if (lo == NULL && hi == NULL)
+            goto ok;
+        if (xpo_range(xv, yc, yk, lo, hi, xvec) < 0)
+            goto done;
+        pattern = XPO_RANGE;
+        goto match;
     }
     /* Use 2a form since yc allready given to compute cvk */
     if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
         goto done;
+ match:
+    _optimize_hits[pattern]++;
     retval = 1; /* match */
  done:
-    if (vec)
-        free(vec);
     if (cvk)
         cvec_free(cvk);
     return retval;
@@ -320,10 +688,15 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 
 /*! Identify XPath special cases and if match, use binary search.
  *
+ * Found nodes are appended to xvec0 since the step is evaluated for each node in the context
+ * @param[in]     xs     XPath tree of type XP_STEP
+ * @param[in]     xv     XML base node
+ * @param[in,out] xvec0  Vector of found nodes
+ * @param[in,out] xlen0  Length of xvec0
  * @retval  1  Optimization made, special case, use x (found if != NULL)
  * @retval  0  Dont optimize: not special case, do normal processing
  * @retval -1  Error
- * XXX Contains glue code between cxobj ** and clixon_xvec code 
+ * XXX Contains glue code between cxobj ** and clixon_xvec code
  */
 int
 xpath_optimize_check(xpath_tree *xs,
@@ -334,6 +707,7 @@ xpath_optimize_check(xpath_tree *xs,
 #ifdef XPATH_LIST_OPTIMIZE
     int          retval = -1;
     int          ret;
+    int          i;
     clixon_xvec *xvec = NULL;
 
     if (!_optimize_enable)
@@ -344,14 +718,9 @@ xpath_optimize_check(xpath_tree *xs,
     else if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
         goto done;
     else if (ret == 1){
-        if (xvec0 && *xvec0){
-            free(*xvec0);
-            *xvec0 = NULL;
-        }
-        if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0){
-            goto done;
-        }
-        _optimize_hits++;
+        for (i=0; i<clixon_xvec_len(xvec); i++)
+            if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+                goto done;
         retval = 1; /* Optimized */
         goto done;
     }
@@ -0,0 +1,678 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Cache of parsed YANG files
+ *
+ * If CLICON_YANG_CACHE_DIR is set, the parse tree of each YANG file is saved in a cache file
+ * after it has been parsed, and later loaded from that file instead of parsing the YANG text.
+ * The cache directory may be shared by all clixon programs using the same YANG files.
+ * Only the result of the parser is cached, ie the statements as they appear in the file and the
+ * variables created by ys_parse_sub. All further processing, such as grouping expansion and
+ * augment, is made by yang_parse_post as usual, since it depends on other modules and features.
+ *
+ * A cache file is named by a digest of the YANG filename, and is valid if the size, modification
+ * time and content digest of the YANG file, and the clixon version, are the same as when the
+ * cache file was written.
+ * The cache directory and files must be owned by the user or root and not be writable by
+ * group or others, otherwise they are not used. A missing cache directory is created with mode 0700.
+ * An invalid or unreadable cache file is silently ignored and the YANG file is parsed instead.
+ *
+ * File layout. All integers are 32-bit unsigned in network byte order unless noted:
+ *   "CLYC" version major minor patch size(64) mtime(64) filename digest   Header
+ *   stmt                                                            Top-level (sub)module
+ * where a stmt is written in pre-order as:
+ *   keyword(1 byte) linenum argument cvtype(1 byte) [cvvalue] nchildren stmt*
+ * and strings are written as: len string\0 where len is 0xffffffff if NULL
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_digest.h"
+#include "clixon_yang_cache.h"
+
+/*
+ * Constants
+ */
+#define YANG_CACHE_MAGIC   "CLYC"
+#define YANG_CACHE_VERSION 2          /* Bump on any layout or parser change */
+#define YANG_CACHE_NOVALUE 0xffffffff /* Length of NULL string */
+
+/*! Decoder state
+ */
+typedef struct {
+    const uint8_t *yd_p;   /* Current position */
+    const uint8_t *yd_end; /* End of input */
+} yang_cache_dec;
+
+/*! Check that a cache file or directory can be trusted
+ *
+ * A planted cache file would be loaded instead of the YANG file, therefore it, and the
+ * directory it is in, must be owned by the effective user or root and not be writable by
+ * group or others.
+ * @param[in]  st   Status of file or directory, see stat(2)
+ * @retval     1    Trusted
+ * @retval     0    Not trusted
+ */
+static int
+yang_cache_trusted(struct stat *st)
+{
+    if (st->st_uid != geteuid() && st->st_uid != 0)
+        return 0;
+    if (st->st_mode & (S_IWGRP|S_IWOTH))
+        return 0;
+    return 1;
+}
+
+/*! Check cache directory, optionally create it
+ *
+ * @param[in]  dir     Cache directory
+ * @param[in]  create  If set, create directory with mode 0700 if it does not exist
+ * @retval     1       Directory exists and is trusted
+ * @retval     0       Directory does not exist or is not trusted
+ */
+static int
+yang_cache_dir_check(const char *dir,
+                     int         create)
+{
+    struct stat st;
+
+    if (stat(dir, &st) < 0){
+        if (errno != ENOENT || !create)
+            return 0;
+        if (mkdir(dir, S_IRWXU) < 0){
+            clixon_debug(CLIXON_DBG_YANG, "mkdir(%s): %s", dir, strerror(errno));
+            return 0;
+        }
+        if (stat(dir, &st) < 0)
+            return 0;
+    }
+    if (!S_ISDIR(st.st_mode) || !yang_cache_trusted(&st)){
+        clixon_debug(CLIXON_DBG_YANG, "Cache dir %s is not trusted", dir);
+        return 0;
+    }
+    return 1;
+}
+
+/*! Compute digest of the content of a YANG file
+ *
+ * @param[in]  filename  YANG filename
+ * @param[in]  size      Size of YANG file
+ * @param[out] hexstr    Digest as hex string, NULL if file could not be read. Free with free()
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_cache_digest(const char *filename,
+                  size_t      size,
+                  char      **hexstr)
+{
+    int   retval = -1;
+    FILE *f = NULL;
+    char *buf = NULL;
+
+    *hexstr = NULL;
+    if ((buf = malloc(size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if ((f = fopen(filename, "r")) == NULL ||
+        fread(buf, 1, size, f) != size)
+        goto ok;
+    buf[size] = '\0';
+    if (clixon_digest_hex(buf, hexstr) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (buf)
+        free(buf);
+    return retval;
+}
+
+/*! Get cache filename of a YANG file
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  filename  YANG filename
+ * @param[out] cachefile Cache filename, NULL if no cache dir. Unallocate after use with free()
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_cache_file(clixon_handle h,
+                const char   *filename,
+                char        **cachefile)
+{
+    int   retval = -1;
+    char *dir;
+    char *hexstr = NULL;
+    cbuf *cb = NULL;
+
+    *cachefile = NULL;
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+        goto ok;
+    if (clixon_digest_hex(filename, &hexstr) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s.yangc", dir, hexstr);
+    if ((*cachefile = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (hexstr)
+        free(hexstr);
+    return retval;
+}
+
+/*! Write 32-bit integer in network byte order
+ */
+static int
+yang_cache_u32(FILE    *f,
+               uint32_t val)
+{
+    uint32_t n = htonl(val);
+
+    return fwrite(&n, sizeof(n), 1, f) == 1 ? 0 : -1;
+}
+
+/*! Write 64-bit integer in network byte order
+ */
+static int
+yang_cache_u64(FILE    *f,
+               uint64_t val)
+{
+    if (yang_cache_u32(f, val >> 32) < 0 ||
+        yang_cache_u32(f, val & 0xffffffff) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Write length-prefixed NULL-terminated string, or NULL
+ */
+static int
+yang_cache_str(FILE       *f,
+               const char *str)
+{
+    size_t len;
+
+    if (str == NULL)
+        return yang_cache_u32(f, YANG_CACHE_NOVALUE);
+    len = strlen(str);
+    if (yang_cache_u32(f, len) < 0 ||
+        fwrite(str, 1, len+1, f) != len+1)
+        return -1;
+    return 0;
+}
+
+/*! Write header of cache file
+ */
+static int
+yang_cache_header(FILE        *f,
+                  const char  *filename,
+                  struct stat *st,
+                  const char  *digest)
+{
+    if (fwrite(YANG_CACHE_MAGIC, 1, strlen(YANG_CACHE_MAGIC), f) != strlen(YANG_CACHE_MAGIC) ||
+        yang_cache_u32(f, YANG_CACHE_VERSION) < 0 ||
+        yang_cache_u32(f, CLIXON_VERSION_MAJOR) < 0 ||
+        yang_cache_u32(f, CLIXON_VERSION_MINOR) < 0 ||
+        yang_cache_u32(f, CLIXON_VERSION_PATCH) < 0 ||
+        yang_cache_u64(f, st->st_size) < 0 ||
+        yang_cache_u64(f, st->st_mtime) < 0 ||
+        yang_cache_str(f, filename) < 0 ||
+        yang_cache_str(f, digest) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Write yang statement and its children in pre-order
+ *
+ * @param[in]  f    Output file
+ * @param[in]  ys   Yang statement
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_cache_encode(FILE      *f,
+                  yang_stmt *ys)
+{
+    int       retval = -1;
+    uint8_t   u8;
+    cg_var   *cv;
+    char     *str = NULL;
+    int       i;
+
+    u8 = yang_keyword_get(ys);
+    if (fwrite(&u8, 1, 1, f) != 1 ||
+        yang_cache_u32(f, yang_linenum_get(ys)) < 0 ||
+        yang_cache_str(f, yang_argument_get(ys)) < 0)
+        goto done;
+    if ((cv = yang_cv_get(ys)) == NULL){
+        u8 = CGV_ERR;
+        if (fwrite(&u8, 1, 1, f) != 1)
+            goto done;
+    }
+    else {
+        u8 = cv_type_get(cv);
+        if ((str = cv2str_dup(cv)) == NULL){
+            clixon_err(OE_UNIX, errno, "cv2str_dup");
+            goto done;
+        }
+        if (fwrite(&u8, 1, 1, f) != 1 ||
+            yang_cache_str(f, str) < 0)
+            goto done;
+    }
+    if (yang_cache_u32(f, yang_len_get(ys)) < 0)
+        goto done;
+    for (i = 0; i < yang_len_get(ys); i++)
+        if (yang_cache_encode(f, yang_child_i(ys, i)) < 0)
+            goto done;
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+}
+
+/*! Save a parsed YANG (sub)module in the cache
+ *
+ * Write to a temporary file and then rename it, so that other processes never see a
+ * partial cache file. Errors are logged but otherwise ignored, the cache is an optimization only.
+ * @param[in]  h         Clixon handle
+ * @param[in]  filename  YANG filename
+ * @param[in]  st        Status of YANG file, see stat(2)
+ * @param[in]  ymod      Parsed YANG (sub)module, before yang_parse_post
+ * @retval     0         OK, or no cache
+ * @retval    -1         Error
+ */
+int
+yang_cache_save(clixon_handle h,
+                const char   *filename,
+                struct stat  *st,
+                yang_stmt    *ymod)
+{
+    int   retval = -1;
+    char *cachefile = NULL;
+    char *digest = NULL;
+    cbuf *cb = NULL;
+    FILE *f = NULL;
+    int   fd;
+
+    if (yang_cache_file(h, filename, &cachefile) < 0)
+        goto done;
+    if (cachefile == NULL)
+        goto ok;
+    if (!yang_cache_dir_check(clicon_option_str(h, "CLICON_YANG_CACHE_DIR"), 1))
+        goto ok;
+    if (yang_cache_digest(filename, st->st_size, &digest) < 0)
+        goto done;
+    if (digest == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.%d", cachefile, getpid());
+    if ((fd = open(cbuf_get(cb), O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW,
+                   S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH)) < 0){
+        clixon_debug(CLIXON_DBG_YANG, "open(%s): %s", cbuf_get(cb), strerror(errno));
+        goto ok;
+    }
+    if ((f = fdopen(fd, "w")) == NULL){
+        clixon_debug(CLIXON_DBG_YANG, "fdopen(%s): %s", cbuf_get(cb), strerror(errno));
+        close(fd);
+        unlink(cbuf_get(cb));
+        goto ok;
+    }
+    if (yang_cache_header(f, filename, st, digest) < 0 ||
+        yang_cache_encode(f, ymod) < 0 ||
+        fclose(f) != 0){
+        f = NULL;
+        clixon_debug(CLIXON_DBG_YANG, "Writing %s failed", cbuf_get(cb));
+        unlink(cbuf_get(cb));
+        clixon_err_reset();
+        goto ok;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cb), cachefile) < 0){
+        clixon_debug(CLIXON_DBG_YANG, "rename(%s): %s", cachefile, strerror(errno));
+        unlink(cbuf_get(cb));
+        goto ok;
+    }
+    clixon_debug(CLIXON_DBG_YANG, "Saved %s in %s", filename, cachefile);
+ ok:
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (cb)
+        cbuf_free(cb);
+    if (digest)
+        free(digest);
+    if (cachefile)
+        free(cachefile);
+    return retval;
+}
+
+/*! Read 32-bit integer in network byte order, return 0 if input is too short
+ */
+static int
+yang_cache_get_u32(yang_cache_dec *yd,
+                   uint32_t       *val)
+{
+    uint32_t n;
+
+    if ((size_t)(yd->yd_end - yd->yd_p) < sizeof(n))
+        return 0;
+    memcpy(&n, yd->yd_p, sizeof(n));
+    yd->yd_p += sizeof(n);
+    *val = ntohl(n);
+    return 1;
+}
+
+/*! Read 64-bit integer in network byte order, return 0 if input is too short
+ */
+static int
+yang_cache_get_u64(yang_cache_dec *yd,
+                   uint64_t       *val)
+{
+    uint32_t hi;
+    uint32_t lo;
+
+    if (yang_cache_get_u32(yd, &hi) == 0 ||
+        yang_cache_get_u32(yd, &lo) == 0)
+        return 0;
+    *val = ((uint64_t)hi << 32) | lo;
+    return 1;
+}
+
+/*! Read length-prefixed string, return pointer into input, return 0 if malformed
+ */
+static int
+yang_cache_get_str(yang_cache_dec *yd,
+                   char          **str)
+{
+    uint32_t len;
+
+    if (yang_cache_get_u32(yd, &len) == 0)
+        return 0;
+    if (len == YANG_CACHE_NOVALUE){
+        *str = NULL;
+        return 1;
+    }
+    if ((size_t)(yd->yd_end - yd->yd_p) <= len || yd->yd_p[len] != '\0')
+        return 0;
+    *str = (char*)yd->yd_p;
+    yd->yd_p += len+1;
+    return 1;
+}
+
+/*! Read a yang statement and its children from cache
+ *
+ * @param[in]  yd    Decoder state
+ * @param[out] ysp   Yang statement, not inserted in any parent
+ * @retval     1     OK
+ * @retval     0     Malformed input
+ * @retval    -1     Error
+ */
+static int
+yang_cache_decode(yang_cache_dec *yd,
+                  yang_stmt     **ysp)
+{
+    int        retval = -1;
+    yang_stmt *ys = NULL;
+    yang_stmt *yc = NULL;
+    uint8_t    keyword;
+    uint8_t    cvtype;
+    uint32_t   linenum;
+    uint32_t   n;
+    uint32_t   i;
+    char      *arg;
+    char      *str;
+    char      *argdup;
+    cg_var    *cv;
+    char      *reason = NULL;
+    int        ret;
+
+    if (yd->yd_p + 1 > yd->yd_end)
+        goto fail;
+    keyword = *yd->yd_p++;
+    if (yang_cache_get_u32(yd, &linenum) == 0 ||
+        yang_cache_get_str(yd, &arg) == 0)
+        goto fail;
+    if (yd->yd_p + 1 > yd->yd_end)
+        goto fail;
+    cvtype = *yd->yd_p++;
+    if ((ys = ys_new(keyword)) == NULL)
+        goto done;
+    if (arg){
+        if ((argdup = strdup(arg)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        yang_argument_set(ys, argdup);
+    }
+    yang_linenum_set(ys, linenum);
+    if (cvtype != CGV_ERR){
+        if (yang_cache_get_str(yd, &str) == 0 || str == NULL)
+            goto fail;
+        if ((cv = cv_new(cvtype)) == NULL){
+            clixon_err(OE_YANG, errno, "cv_new");
+            goto done;
+        }
+        yang_cv_set(ys, cv);
+        if ((ret = cv_parse1(str, cv, &reason)) < 0){
+            clixon_err(OE_YANG, errno, "cv_parse1");
+            goto done;
+        }
+        if (ret == 0)
+            goto fail;
+    }
+    if (yang_cache_get_u32(yd, &n) == 0)
+        goto fail;
+    for (i = 0; i < n; i++){
+        if ((ret = yang_cache_decode(yd, &yc)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (yn_insert(ys, yc) < 0){
+            ys_free(yc);
+            goto done;
+        }
+    }
+    *ysp = ys;
+    ys = NULL;
+    retval = 1;
+ done:
+    if (reason)
+        free(reason);
+    if (ys)
+        ys_free(ys);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load a parsed YANG (sub)module from the cache
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  filename  YANG filename
+ * @param[in]  st        Status of YANG file, see stat(2)
+ * @param[in]  yspec     Yang spec, the module is added here if found
+ * @param[out] ymodp     YANG (sub)module if found
+ * @retval     1         Found in cache
+ * @retval     0         Not found, or cache file is not valid
+ * @retval    -1         Error
+ * @see yang_parse_str  which the loaded module is equivalent to
+ */
+int
+yang_cache_load(clixon_handle h,
+                const char   *filename,
+                struct stat  *st,
+                yang_stmt    *yspec,
+                yang_stmt   **ymodp)
+{
+    int            retval = -1;
+    char          *cachefile = NULL;
+    int            fd = -1;
+    struct stat    cst;
+    void          *map = MAP_FAILED;
+    yang_cache_dec yd = {0,};
+    uint32_t       version;
+    uint32_t       major;
+    uint32_t       minor;
+    uint32_t       patch;
+    uint64_t       size;
+    uint64_t       mtime;
+    char          *fname;
+    char          *cdigest;
+    char          *digest = NULL;
+    yang_stmt     *ymod = NULL;
+    int            ret;
+
+    if (yang_cache_file(h, filename, &cachefile) < 0)
+        goto done;
+    if (cachefile == NULL)
+        goto fail;
+    if (!yang_cache_dir_check(clicon_option_str(h, "CLICON_YANG_CACHE_DIR"), 0))
+        goto fail;
+    if ((fd = open(cachefile, O_RDONLY|O_NOFOLLOW)) < 0)
+        goto fail;
+    if (fstat(fd, &cst) < 0 || cst.st_size == 0)
+        goto fail;
+    if (!S_ISREG(cst.st_mode) || !yang_cache_trusted(&cst)){
+        clixon_debug(CLIXON_DBG_YANG, "Cache %s is not trusted", cachefile);
+        goto fail;
+    }
+    if ((map = mmap(NULL, cst.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        goto fail;
+    yd.yd_p = map;
+    yd.yd_end = yd.yd_p + cst.st_size;
+    if ((size_t)cst.st_size < strlen(YANG_CACHE_MAGIC) ||
+        memcmp(yd.yd_p, YANG_CACHE_MAGIC, strlen(YANG_CACHE_MAGIC)) != 0)
+        goto fail;
+    yd.yd_p += strlen(YANG_CACHE_MAGIC);
+    if (yang_cache_get_u32(&yd, &version) == 0 ||
+        yang_cache_get_u32(&yd, &major) == 0 ||
+        yang_cache_get_u32(&yd, &minor) == 0 ||
+        yang_cache_get_u32(&yd, &patch) == 0 ||
+        yang_cache_get_u64(&yd, &size) == 0 ||
+        yang_cache_get_u64(&yd, &mtime) == 0 ||
+        yang_cache_get_str(&yd, &fname) == 0 ||
+        yang_cache_get_str(&yd, &cdigest) == 0)
+        goto fail;
+    if (version != YANG_CACHE_VERSION ||
+        major != CLIXON_VERSION_MAJOR ||
+        minor != CLIXON_VERSION_MINOR ||
+        patch != CLIXON_VERSION_PATCH ||
+        size != (uint64_t)st->st_size ||
+        mtime != (uint64_t)st->st_mtime ||
+        fname == NULL || strcmp(fname, filename) != 0 ||
+        cdigest == NULL){
+        clixon_debug(CLIXON_DBG_YANG, "Stale cache %s for %s", cachefile, filename);
+        goto fail;
+    }
+    if (yang_cache_digest(filename, st->st_size, &digest) < 0)
+        goto done;
+    if (digest == NULL || strcmp(digest, cdigest) != 0){
+        clixon_debug(CLIXON_DBG_YANG, "Stale cache %s for %s", cachefile, filename);
+        goto fail;
+    }
+    if ((ret = yang_cache_decode(&yd, &ymod)) < 0)
+        goto done;
+    if (ret == 0 || yd.yd_p != yd.yd_end ||
+        (yang_keyword_get(ymod) != Y_MODULE && yang_keyword_get(ymod) != Y_SUBMODULE)){
+        clixon_debug(CLIXON_DBG_YANG, "Malformed cache %s for %s", cachefile, filename);
+        goto fail;
+    }
+    if (yang_filename_set(ymod, filename) < 0)
+        goto done;
+    if (yn_insert(yspec, ymod) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_YANG, "Loaded %s from %s", filename, cachefile);
+    *ymodp = ymod;
+    ymod = NULL;
+    retval = 1;
+ done:
+    if (ymod)
+        ys_free(ymod);
+    if (digest)
+        free(digest);
+    if (map != MAP_FAILED)
+        munmap(map, cst.st_size);
+    if (fd != -1)
+        close(fd);
+    if (cachefile)
+        free(cachefile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
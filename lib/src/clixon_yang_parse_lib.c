@@ -100,6 +100,7 @@
 #include "clixon_plugin.h"
 #include "clixon_yang_internal.h"
 #include "clixon_yang_sub_parse.h"
+#include "clixon_yang_cache.h"
 #include "clixon_yang_parse_lib.h"
 
 /* Size of json read buffer when reading from file*/
@@ -929,36 +930,35 @@ yang_parse_file(FILE       *fp,
                 yang_stmt  *yspec)
 {
     char         *buf = NULL;
-    int           i;
-    char          c;
-    int           len;
+    size_t        len = 0;
+    size_t        buflen = BUFLEN; /* start size */
+    size_t        n;
     yang_stmt    *ymod = NULL;
-    int           ret;
 
-    len = BUFLEN; /* any number is fine */
-    if ((buf = malloc(len)) == NULL){
+    if ((buf = malloc(buflen)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         goto done;
     }
-    memset(buf, 0, len);
-    i = 0; /* position in buf */
-    while (1){ /* read the whole file */
-        if ((ret = fread(&c, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret == 0)
-            break; /* eof */
-        if (i == len-1){
-            if ((buf = realloc(buf, 2*len)) == NULL){
+    /* Read file in chunks, double buffer size when full */
+    while (1){
+        if (len >= buflen-1){ /* Space: one for the null character */
+            buflen *= 2;
+            if ((buf = realloc(buf, buflen)) == NULL){
                 clixon_err(OE_XML, errno, "realloc");
                 goto done;
             }
-            memset(buf+len, 0, len);
-            len *= 2;
         }
-        buf[i++] = (char)(c&0xff);
-    } /* read a line */
+        n = fread(buf+len, 1, buflen-1-len, fp);
+        len += n;
+        if (n == 0){
+            if (ferror(fp)){
+                clixon_err(OE_XML, errno, "read");
+                goto done;
+            }
+            break;
+        }
+    }
+    buf[len] = '\0';
     if ((ymod = yang_parse_str(buf, name, yspec)) < 0)
         goto done;
   done:
@@ -1161,18 +1161,35 @@ yang_parse_filename(clixon_handle h,
     yang_stmt    *ymod = NULL;
     FILE         *fp = NULL;
     struct stat   st;
+    int           ret;
 
     clixon_debug(CLIXON_DBG_YANG, "%s", filename);
     if (stat(filename, &st) < 0){
         clixon_err(OE_YANG, errno, "%s not found", filename);
         goto done;
     }
+    /* Try cache of parsed YANG files first, see CLICON_YANG_CACHE_DIR */
+    if (h){
+        if ((ret = yang_cache_load(h, filename, &st, yspec, &ymod)) < 0)
+            goto done;
+        if (ret == 1){
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
+            yspec_nscache_clear(yspec);
+#endif
+            goto patch;
+        }
+    }
     if ((fp = fopen(filename, "r")) == NULL){
         clixon_err(OE_YANG, errno, "fopen(%s)", filename);
         goto done;
     }
-    if ((ymod = yang_parse_file(fp, filename, yspec)) < 0)
+    if ((ymod = yang_parse_file(fp, filename, yspec)) == NULL)
+        goto done;
+    if (h && yang_cache_save(h, filename, &st, ymod) < 0){
+        ymod = NULL;
         goto done;
+    }
+ patch:
     /* YANG patch hook */
     if (ymod && h && clixon_plugin_yang_patch_all(h, ymod) < 0)
         goto done;
@@ -106,6 +106,17 @@ expectpart "$(echo "set list1 xyz list2 ?" | $clixon_cli -f $cfg 2>&1)" 0 123 ab
 new "Expand <TAB>"
 expectpart "$(echo "set list1 xyz list2 	" | $clixon_cli -f $cfg 2>&1)" 0 123 abc "<key2>"
 
+new "Datastore generation"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore></datastore-generation></rpc>" "" "<rpc-reply $DEFAULTNS><generation xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</generation></rpc-reply>"
+
+new "Expand <TAB> in same session after add, completion cache invalidated"
+ret=$(printf "set list1 xyz list2 \t\nset list1 xyz list2 def\nset list1 xyz list2 \t\n" | $clixon_cli -f $cfg 2>&1)
+# Only the completion list of the second <TAB>, not the echoed add
+expectpart "${ret##*list2 def}" 0 123 abc def "<key2>"
+
+new "Expand <TAB> without completion cache"
+expectpart "$(echo "set list1 xyz list2 	" | $clixon_cli -f $cfg -o CLICON_CLI_EXPAND_CACHE=0 2>&1)" 0 123 abc def "<key2>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
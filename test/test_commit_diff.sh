@@ -0,0 +1,218 @@
+#!/usr/bin/env bash
+# Commit diff of candidate and running when only deep leafs are modified
+# Candidate is a copy of running, and xml_diff skips subtrees with the same content
+# stamp, see xml_stamp. Check that a modified deep leaf under unmodified
+# ancestors is still reported, and that unmodified siblings are not.
+# Also toggle a default leaf between default and explicit value.
+# A backend plugin logs the transaction vectors at commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/diff.yang
+cfile=$dir/diff.c
+pdir=$dir/plugin
+flog=$dir/backend.log
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module diff{
+   yang-version 1.1;
+   namespace "urn:example:diff";
+   prefix ex;
+   container a {
+     container b {
+       list c {
+         key name;
+         leaf name {
+           type string;
+         }
+         container d {
+           leaf e {
+             type int32;
+           }
+           leaf f {
+             type int32;
+           }
+           leaf h {
+             type int32;
+             default 5;
+           }
+         }
+       }
+     }
+     leaf g {
+       type int32;
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+/*! Log transaction vectors at commit
+ */
+static int
+diff_commit(clixon_handle    h,
+            transaction_data td)
+{
+    return transaction_log(h, td, LOG_NOTICE, "diff");
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "diff",                                 /* name */
+    clixon_plugin_init,                     /* init */
+    NULL,                                   /* start */
+    NULL,                                   /* exit */
+    .ca_trans_commit=diff_commit            /* trans commit */
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+# Edit candidate and commit
+# arg1: config
+function editcommit(){
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$1</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Transaction log lines of last commit
+# arg1: number of log lines before the commit
+function commitlog(){
+    tail -n +$(($1+1)) $flog | grep -o "transaction_log [0-9]* diff .*" | cut -d' ' -f3-
+}
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include $cfile -o $pdir/diff.so)" 0 ""
+
+new "test params: -f $cfg -l f$flog"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    rm -f $flog
+    new "start backend -s init -f $cfg -l f$flog"
+    start_backend -s init -f $cfg -l f$flog
+fi
+
+new "wait backend"
+wait_backend
+
+new "Commit base config"
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><e>1</e><f>1</f></d></c><c><name>y</name><d><e>1</e><f>1</f></d></c></b><g>1</g></a>"
+
+new "1. Change deep leaf, ancestors unchanged"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>y</name><d><e>2</e></d></c></b></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "diff change: <e>1</e><e>2</e>" --not-- "<f>" "<name>x</name>" "<g>"
+
+new "2. Delete deep leaf"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><f nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\">1</f></d></c></b></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "diff del: <f>1</f>" --not-- "<e>" "<name>y</name>" "<g>"
+
+new "3. Change deep leaf and back: no change"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><e>3</e></d></c></b></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><e>1</e></d></c></b></a>"
+ret=$(commitlog $n0)
+if [ -n "$ret" ]; then
+    err "" "$ret"
+fi
+
+new "4. Change leaf at top and deep leaf in same commit"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><e>4</e></d></c></b><g>4</g></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "diff change: <e>1</e><e>4</e>" "diff change: <g>1</g><g>4</g>" --not-- "<f>"
+
+new "Running has all changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:diff\"><b><c><name>x</name><d><e>4</e></d></c><c><name>y</name><d><e>2</e><f>1</f></d></c></b><g>4</g></a></data></rpc-reply>"
+
+new "5. Set deep default leaf explicitly"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>y</name><d><h>7</h></d></c></b></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "<h>7</h>" --not-- "<e>" "<f>" "<g>"
+
+new "Set deep default leaf to default value explicitly"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>y</name><d><h>5</h></d></c></b></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "<h>7</h>" --not-- "<e>" "<f>" "<g>"
+
+new "Running has explicit default value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">explicit</with-defaults><filter type=\"xpath\" select=\"/ex:a/ex:b/ex:c[ex:name='y']/ex:d/ex:h\" xmlns:ex=\"urn:example:diff\"/></get-config></rpc>" "" "<h>5</h>"
+
+new "6. Remove explicit value, back to default"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>y</name><d><h nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\">5</h></d></c></b></a>"
+
+new "Running has no explicit value"
+ret=$(echo "$HELLONO11<rpc $DEFAULTNS><get-config><source><running/></source><with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">explicit</with-defaults></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg)
+expectpart "$ret" 0 "<rpc-reply $DEFAULTNS><data>" --not-- "<h>"
+
+new "Set explicit value again is a new commit"
+n0=$(cat $flog | wc -l)
+editcommit "<a xmlns=\"urn:example:diff\"><b><c><name>y</name><d><h>6</h></d></c></b></a>"
+ret=$(commitlog $n0)
+expectpart "$ret" 0 "<h>6</h>" --not-- "<e>" "<f>" "<g>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
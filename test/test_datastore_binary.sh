@@ -0,0 +1,167 @@
+#!/usr/bin/env bash
+# Binary datastore format
+# - Start from XML startup datastore, convert to binary on write
+# - Restart from binary datastore, with and without module-state
+# - Change back to XML and read existing binary datastore
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+            leaf deflt{
+                type string;
+                default "x";
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+commit("Commit the changes"), cli_commit();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("running", "xml", false, false);
+    binary("Binary is a datastore format only"), cli_show_auto_mode("running", "binary", false, false);
+}
+EOF
+
+# Test routine with arguments:
+# 1. modstate: false/true - see CLICON_XMLDB_MODSTATE
+function testrun()
+{
+    modstate=$1
+
+    # XML startup, not sorted
+    cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <table xmlns="urn:example:clixon">
+      <parameter>
+         <name>c</name>
+         <value>3</value>
+      </parameter>
+      <parameter>
+         <name>a</name>
+         <value>1</value>
+      </parameter>
+   </table>
+</${DATASTORE_TOP}>
+EOF
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -z -f $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s startup binary modstate=$modstate"
+        start_backend -s startup -f $cfg -o CLICON_XMLDB_FORMAT=binary -o CLICON_XMLDB_MODSTATE=$modstate
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "show config from XML startup"
+    expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>c</name><value>3</value></parameter></table>$"
+
+    new "binary is not a valid output format"
+    expectpart "$($clixon_cli -1 -f $cfg show binary 2>&1)" 255 "Not valid format: binary"
+
+    new "set parameter b"
+    expectpart "$($clixon_cli -1 -f $cfg set table parameter b value 2)" 0 "^$"
+
+    new "commit"
+    expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+    new "Check running is binary"
+    expectpart "$(sudo head -c 4 $dir/running_db)" 0 "^CLXB$"
+
+    if [ $BE -ne 0 ]; then
+        new "restart backend -s running binary modstate=$modstate"
+        stop_backend -f $cfg
+        start_backend -s running -f $cfg -o CLICON_XMLDB_FORMAT=binary -o CLICON_XMLDB_MODSTATE=$modstate
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "show config from binary running"
+    expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter></table>$"
+
+    new "netconf get default value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']/ex:deflt\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><deflt>x</deflt></parameter></table></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "restart backend -s running xml"
+        stop_backend -f $cfg
+        start_backend -s running -f $cfg -o CLICON_XMLDB_FORMAT=xml -o CLICON_XMLDB_MODSTATE=$modstate
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "show config from binary running with xml format"
+    expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter></table>$"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+new "test params: -f $cfg"
+
+for modstate in false true; do
+    new "test binary db modstate=$modstate"
+    testrun $modstate
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
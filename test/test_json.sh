@@ -174,6 +174,23 @@ JSON='{"text":"bmp:\uFAIL"}'
 new "json escaping unicode BMP fail"
 expecteofx "$clixon_util_json -j -D $DBG" 255 "$JSON" 2> /dev/null
 
+new "json number with leading . expect fail"
+expecteofx "$clixon_util_json" 255 '{"foo": .5}' 2> /dev/null
+
+new "json number with trailing . expect fail"
+expecteofx "$clixon_util_json" 255 '{"foo": 5.}' 2> /dev/null
+
+new "json number with fraction and exponent"
+expecteofx "$clixon_util_json" 0 '{"foo": -0.5e-3}' "<foo>-0.5e-3</foo>"
+
+JSON="{\"a\":$(printf '[%.0s' $(seq 1 100)) 1 $(printf ']%.0s' $(seq 1 100))}"
+new "json nested arrays within depth limit"
+expecteofx "$clixon_util_json" 0 "$JSON" "<a>1</a>"
+
+JSON=$(printf '[%.0s' $(seq 1 100000))
+new "json 100000 nested arrays expect fail"
+expecteofx "$clixon_util_json" 255 "$JSON" 2> /dev/null
+
 rm -rf $dir
 
 new "endtest"
@@ -0,0 +1,122 @@
+#!/usr/bin/env bash
+# Resident netconf daemon, see CLICON_NETCONF_DAEMON_SOCK
+# 1. Start daemon with -S
+# 2. Run netconf sessions via shim -s, they are served by the daemon
+# 3. Idle client that does not send stdin/stdout does not block other sessions
+# 4. Stop daemon, shim falls back to a regular netconf session
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+sock=$dir/netconf.sock
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NETCONF_DAEMON_SOCK>$sock</CLICON_NETCONF_DAEMON_SOCK>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "start netconf daemon"
+$clixon_netconf -f $cfg -S &
+daemonpid=$!
+sleep 1
+
+new "Check daemon socket"
+if [ ! -S $sock ]; then
+    err "$sock" "no socket"
+fi
+
+new "Check daemon socket not accessible by others"
+if [ -n "$(find $sock -perm /o=rwx)" ]; then
+    err "$sock" "accessible by others"
+fi
+
+new "shim edit-config"
+expecteof_netconf "$clixon_netconf -s $sock" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></config></edit-config></rpc>" "<hello $DEFAULTONLY><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "shim get-config"
+expecteof_netconf "$clixon_netconf -s $sock" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>"
+
+if which nc > /dev/null 2>&1; then
+    new "idle client connected to daemon"
+    sleep 20 | nc -U $sock &
+    idlepid=$!
+    sleep 1
+
+    new "shim get-config while idle client is connected"
+    expecteof_netconf "$clixon_netconf -s $sock" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>"
+
+    kill $idlepid 2> /dev/null
+fi
+
+new "Check daemon still running"
+if ! kill -0 $daemonpid 2> /dev/null; then
+    err "daemon $daemonpid" "not running"
+fi
+
+new "stop netconf daemon"
+kill $daemonpid
+wait $daemonpid 2> /dev/null
+
+new "shim fallback get-config"
+expecteof_netconf "$clixon_netconf -qf $cfg -s $sock" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -80,6 +80,17 @@ cat <<EOF > $fyang
            description "Event severity description.";
          }
        }
+       container c {
+         list a {
+           key k;
+           leaf k {
+             type string;
+           }
+           leaf v {
+             type string;
+           }
+         }
+       }
        container state {
          config false;
          description "state data for the example application (must be here for example get operation)";
@@ -127,6 +138,43 @@ expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTN
 new "netconf EXAMPLE subscription with filter classifier"
 expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"event[event-class='fault']\"/></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20" 
 
+new "netconf EXAMPLE subscription with filter classifiers"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"/event[event-class='fault' and severity=&quot;major&quot;]\"/></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20" 
+
+new "netconf EXAMPLE subscription with non-indexed filter"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"event/reportingEntity[card='Ethernet0']\"/></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20" 
+
+new "netconf periodic push subscription of state data"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><datastore>operational</datastore><xpath xmlns:ex=\"urn:example:clixon\">/ex:state</xpath><period>1000</period></create-push-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><id xmlns=\"http://clicon.org/lib\">1</id></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20"
+
+new "netconf on-change push subscription of operational not supported"
+expecteof_netconf "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><datastore>operational</datastore><xpath>/</xpath><on-change/></create-push-subscription></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-not-supported</error-tag>" ""
+
+new "netconf periodic push subscription less than min period"
+expecteof_netconf "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><xpath>/</xpath><period>10</period></create-push-subscription></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>period</bad-element></error-info><error-severity>error</error-severity><error-message>Period less than minimum 100 ms</error-message></rpc-error></rpc-reply>" ""
+
+new "netconf add config entries x and y"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><k>x</k><v>1</v></a><a><k>y</k><v>1</v></a></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+# Subscription ids are allocated in order by the backend, the periodic subscription above is 1
+# The notification is sent before the reply of the commit, after running is written
+EDIT="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><a nc:operation=\"delete\"><k>x</k></a><a><k>y</k><v>2</v></a><a><k>z</k><v>1</v></a></c></config></edit-config></rpc>]]>]]>"
+new "netconf on-change push subscription, commit sends create, delete and replace edits"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$HELLONO11<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><xpath xmlns:ex=\"urn:example:clixon\">/ex:c</xpath><on-change/></create-push-subscription></rpc>]]>]]>$EDIT<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "" $NCWAIT "<rpc-reply $DEFAULTNS><id xmlns=\"http://clicon.org/lib\">2</id></rpc-reply>" "<push-change-update xmlns=\"http://clicon.org/lib\"><id>2</id><datastore-changes>" "<operation>delete</operation><target>/ex:c/ex:a\[ex:k='x'\]</target>" "<operation>create</operation><target>/ex:c/ex:a\[ex:k='z'\]</target>" "<operation>replace</operation><target>/ex:c/ex:a\[ex:k='y'\]/ex:v</target>" "</datastore-changes></push-change-update></notification>\]\]>\]\]><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get running after on-change commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:c\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><k>y</k><v>2</v></a><a><k>z</k><v>1</v></a></c></data></rpc-reply>"
+
+EDIT="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><k>w</k><v>1</v></a></c></config></edit-config></rpc>]]>]]>"
+new "netconf delete-push-subscription, commit sends no push-change-update"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$HELLONO11<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><xpath xmlns:ex=\"urn:example:clixon\">/ex:c</xpath><on-change/></create-push-subscription></rpc>]]>]]><rpc $DEFAULTNS><delete-push-subscription xmlns=\"http://clicon.org/lib\"><id>3</id></delete-push-subscription></rpc>]]>]]>$EDIT<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "" $NCWAIT "<rpc-reply $DEFAULTNS><id xmlns=\"http://clicon.org/lib\">3</id></rpc-reply>\]\]>\]\]><rpc-reply $DEFAULTNS><ok/></rpc-reply>\]\]>\]\]><rpc-reply $DEFAULTNS><ok/></rpc-reply>\]\]>\]\]><rpc-reply $DEFAULTNS><ok/></rpc-reply>" --not-- "push-change-update"
+
+new "netconf delete-push-subscription of unknown id"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><delete-push-subscription xmlns=\"http://clicon.org/lib\"><id>4711</id></delete-push-subscription></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag><error-severity>error</error-severity><error-message>No such subscription</error-message></rpc-error></rpc-reply>"
+
 new "netconf NONEXIST subscription"
 expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>NONEXIST</stream></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag><error-severity>error</error-severity><error-message>No such stream</error-message></rpc-error></rpc-reply>"
 
@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+# Batching of notifications in NETCONF sessions
+# See CLICON_STREAM_BATCH_DELAY and CLICON_STREAM_BATCH_SIZE
+# A periodic push subscription sends a push-update every 200ms to the session.
+# 1. With batch delay, notifications are held and written together, in order
+# 2. With a batch size less than a notification, each is written immediately
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+fout=$dir/batch.txt
+
+# Period of push-update notifications in ms
+period=200
+# Batch delay in ms
+delay=1000
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_BATCH_DELAY>$delay</CLICON_STREAM_BATCH_DELAY>
+  <CLICON_STREAM_BATCH_SIZE>65536</CLICON_STREAM_BATCH_SIZE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c {
+     leaf x {
+       type string;
+     }
+   }
+}
+EOF
+
+# Read netconf output and print arrival time in ms of each notification, "N <ms>",
+# and the eventTime of each notification, "T <eventTime>"
+function batchread(){
+    while IFS= read -r -d '>' tok; do
+        case "$tok" in
+            *"</eventTime")
+                echo "T ${tok%</eventTime}"
+                ;;
+            "</notification")
+                echo "N $(date +%s%3N)"
+                ;;
+        esac
+    done
+}
+
+# Subscribe and read notifications
+# arg1: seconds to keep session open
+# arg2: extra netconf options
+function subscribe(){
+    sec=$1
+    opts=$2
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-push-subscription xmlns=\"http://clicon.org/lib\"><xpath xmlns:ex=\"urn:example:clixon\">/ex:c</xpath><period>$period</period></create-push-subscription></rpc>]]>]]>"; sleep $sec) | timeout $((sec+10)) $clixon_netconf -qef $cfg $opts | batchread > $fout
+}
+
+# Number of batches of notifications, arrival more than 100ms after the previous
+function batches(){
+    grep "^N" $fout | awk 'BEGIN{n=0;p=0} {if ($2-p > 100) n++; p=$2} END{print n}'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf add config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>batch</x></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "1. Session shorter than batch delay: no notifications written"
+subscribe 0.5 ""
+n=$(grep -c "^N" $fout)
+if [ $n -ne 0 ]; then
+    err "0 notifications" "$n"
+fi
+
+new "Session longer than batch delay: several notifications"
+subscribe 3.5 ""
+n=$(grep -c "^N" $fout)
+if [ $n -lt 8 ]; then
+    err "at least 8 notifications" "$n"
+fi
+
+new "Notifications are coalesced in batches"
+b=$(batches)
+if [ $b -lt 2 -o $b -gt $((n/3)) ]; then
+    err "2-$((n/3)) batches of $n notifications" "$b"
+fi
+
+new "Notifications are in order"
+grep "^T" $fout | sort -C -u
+if [ $? -ne 0 ]; then
+    err "increasing eventTime" "$(grep "^T" $fout)"
+fi
+
+new "2. Batch size less than a notification: no batching"
+subscribe 1.5 "-o CLICON_STREAM_BATCH_SIZE=1"
+n=$(grep -c "^N" $fout)
+if [ $n -lt 4 ]; then
+    err "at least 4 notifications" "$n"
+fi
+b=$(batches)
+if [ $b -ne $n ]; then
+    err "$n batches" "$b"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,235 @@
+#!/usr/bin/env bash
+# Indexed subscription filters and subscription removal during notification
+# A backend plugin notifies events on the FILTER stream with text values containing
+# quotes and backslashes, and has two own subscriptions of the stream.
+# 1. Indexed filters with quotes and backslashes in values only match that value
+# 2. A subscription callback removing subscriptions of the same event: removed
+#    subscriptions are not called, and other subscribers get the event
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/filter.yang
+cfile=$dir/filter.c
+pdir=$dir/plugin
+flog=$dir/backend.log
+fout1=$dir/sub1.txt
+fout2=$dir/sub2.txt
+fout3=$dir/sub3.txt
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module filter{
+   yang-version 1.1;
+   namespace "urn:example:filter";
+   prefix ex;
+   notification event {
+     leaf text {
+       type string;
+     }
+   }
+   rpc notify {
+     input {
+       leaf n {
+         description "Index of event text";
+         type uint8;
+       }
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+/* Event texts, index given in notify rpc */
+static char *_events[] = {"it's", "it", "it's']", "a\\\\b"};
+
+/* Arguments of the two plugin subscriptions */
+static char _a[] = "a";
+static char _b[] = "b";
+
+/*! Subscription callback, the first event removes both plugin subscriptions
+ */
+static int
+filter_stream_cb(clixon_handle h,
+                 int           op,
+                 cxobj        *event,
+                 void         *arg)
+{
+    if (op != 0)
+        return 0;
+    clixon_log(h, LOG_NOTICE, "filter_callback_%s", (char*)arg);
+    if (stream_ss_delete_all(h, filter_stream_cb, _a) < 0 ||
+        stream_ss_delete_all(h, filter_stream_cb, _b) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Notify event on FILTER stream
+ */
+static int
+notify_rpc(clixon_handle h,
+           cxobj        *xe,
+           cbuf         *cbret,
+           void         *arg,
+           void         *regarg)
+{
+    cxobj *xn;
+    int    n = 0;
+
+    if ((xn = xml_find_type(xe, NULL, "n", CX_ELMNT)) != NULL)
+        n = atoi(xml_body(xn));
+    if (n < 0 || n >= sizeof(_events)/sizeof(char*)){
+        clixon_err(OE_PLUGIN, EINVAL, "No such event");
+        return -1;
+    }
+    if (stream_notify(h, "FILTER", "<event xmlns=\"urn:example:filter\"><text>%s</text></event>", _events[n]) < 0)
+        return -1;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "filter",                               /* name */
+    clixon_plugin_init,                     /* init */
+    NULL,                                   /* start */
+    NULL,                                   /* exit */
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    if (stream_add(h, "FILTER", "Filter test stream", 0, NULL) < 0)
+        return NULL;
+    if (stream_ss_add(h, "FILTER", NULL, NULL, NULL, filter_stream_cb, _a) == NULL ||
+        stream_ss_add(h, "FILTER", NULL, NULL, NULL, filter_stream_cb, _b) == NULL)
+        return NULL;
+    if (rpc_callback_register(h, notify_rpc, NULL, "urn:example:filter", "notify") < 0)
+        return NULL;
+    return &api;
+}
+EOF
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include $cfile -o $pdir/filter.so)" 0 ""
+
+# Subscribe to FILTER stream and write output to file
+# arg1: output file
+# arg2: extra subscription parameters, eg filter
+function subscribe(){
+    fout=$1
+    params=$2
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>FILTER</stream>$params</create-subscription></rpc>]]>]]>"; sleep 4) | timeout 10 $clixon_netconf -qef $cfg > $fout
+}
+
+# Print text of received events, one per line
+# arg1: output file
+function events(){
+    grep -o "<text>[^<]*</text>" $1 | sed 's/<text>\(.*\)<\/text>/\1/'
+}
+
+new "test params: -f $cfg -l f$flog"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    rm -f $flog
+    new "start backend -s init -f $cfg -l f$flog"
+    start_backend -s init -f $cfg -l f$flog
+fi
+
+new "wait backend"
+wait_backend
+
+new "Start subscribers with quote and backslash filters and without filter"
+subscribe $fout1 "<filter type=\"xpath\" select=\"/event[text=&quot;it's&quot;]\"/>" &
+subscribe $fout2 "<filter type=\"xpath\" select=\"/event[text='a\\b']\"/>" &
+subscribe $fout3 "" &
+sleep 1
+
+for n in 0 1 2 3; do
+    new "Notify event $n"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><notify xmlns=\"urn:example:filter\"><n>$n</n></notify></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+done
+
+wait
+
+new "1. Quote in filter value matches only that value"
+ret=$(events $fout1)
+if [ "$ret" != "it's" ]; then
+    err "it's" "$ret"
+fi
+
+new "Backslash in filter value matches only that value"
+ret=$(events $fout2)
+if [ "$ret" != "a\\b" ]; then
+    err "a\\b" "$ret"
+fi
+
+new "Subscriber without filter gets all events"
+n=$(events $fout3 | wc -l)
+if [ $n -ne 4 ]; then
+    err "4 events" "$(events $fout3)"
+fi
+
+new "2. Only one plugin subscription called, then both removed"
+n=$(grep -c "filter_callback_" $flog)
+if [ $n -ne 1 ]; then
+    err "1 callback" "$(grep filter_callback_ $flog)"
+fi
+
+new "Backend is alive"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><ping $LIBNS/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Notification queue of a stalled subscriber
+# See CLICON_STREAM_QUEUE_SIZE and CLICON_STREAM_QUEUE_POLICY
+# A periodic push subscription sends large push-update notifications to a NETCONF
+# session whose output is not read. When the socket buffers are full, notifications
+# are queued in the backend until the queue is full, then the policy applies:
+# - drop-oldest, coalesce: the queue stays full and notifications are dropped
+# - disconnect: the session is disconnected
+# Queue state is checked in notify-queues of the stats RPC
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+flog=$dir/backend.log
+
+# Max queued notifications
+qsize=5
+# Period of push-update notifications in ms
+period=100
+# Size of selected data, ie of each notification
+: ${size:=100000}
+# Seconds until the queue is full
+: ${stall:=5}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_QUEUE_SIZE>$qsize</CLICON_STREAM_QUEUE_SIZE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c {
+     leaf x {
+       type string;
+     }
+   }
+}
+EOF
+
+# Get notify-queues session stats of the stats RPC, one session per line
+function queuestats(){
+    echo "$HELLONO11<rpc $DEFAULTNS><stats $LIBNS/></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<notify-queues[^>]*>\(.*\)<\/notify-queues>.*/\1/p' | sed 's/<\/session>/<\/session>\n/g' | grep "<session>"
+}
+
+val=$(head -c $size /dev/zero | tr '\0' 'a')
+
+for policy in drop-oldest coalesce disconnect; do
+    new "test params: -f $cfg -o CLICON_STREAM_QUEUE_POLICY=$policy"
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        rm -f $flog
+        new "start backend -s init -f $cfg -l f$flog -o CLICON_STREAM_QUEUE_POLICY=$policy"
+        start_backend -s init -f $cfg -l f$flog -o CLICON_STREAM_QUEUE_POLICY=$policy
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf add large config"
+    echo "$HELLONO11<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>$val</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" > $dir/edit.xml
+    expectpart "$($clixon_netconf -qf $cfg < $dir/edit.xml)" 0 "<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "$policy: stalled subscriber, output not read"
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-push-subscription $LIBNS><xpath xmlns:ex=\"urn:example:clixon\">/ex:c</xpath><period>$period</period></create-push-subscription></rpc>]]>]]>"; sleep $((stall+5))) | $clixon_netconf -qf $cfg | sleep $((stall+5)) &
+    sleep $stall
+
+    stats=$(queuestats)
+    case $policy in
+        drop-oldest|coalesce)
+            new "$policy: queue is full and notifications are dropped"
+            match=$(echo "$stats" | grep -o "<depth>$qsize</depth><max-depth>$qsize</max-depth><sent>[0-9]*</sent><drops>[1-9][0-9]*</drops>")
+            if [ -z "$match" ]; then
+                err "<depth>$qsize</depth><max-depth>$qsize</max-depth><sent>N</sent><drops>N</drops>" "$stats"
+            fi
+            ;;
+        disconnect)
+            new "$policy: session is disconnected"
+            match=$(grep "notification queue full, disconnecting" $flog)
+            if [ -z "$match" ]; then
+                err "notification queue full, disconnecting" "$(cat $flog)"
+            fi
+            new "$policy: no queued notifications"
+            match=$(echo "$stats" | grep "<depth>[1-9]")
+            if [ -n "$match" ]; then
+                err "" "$stats"
+            fi
+            ;;
+    esac
+
+    new "$policy: other sessions are served"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><ping $LIBNS/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+    # Stop subscriber
+    wait
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,168 @@
+#!/usr/bin/env bash
+# Disk-backed stream replay log, see CLICON_STREAM_REPLAY_DIR
+# The example backend plugin sends an event on the EXAMPLE stream every second.
+# 1. Events are appended to segment files in the replay directory
+# 2. Replay with startTime and stopTime only returns events in the window, in order
+# 3. Replay with startTime only returns events from startTime, and then live events
+# 4. After restart, files of the previous run are removed and only new events are replayed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+rdir=$dir/replay
+fout=$dir/replay.txt
+
+NCWAIT=10
+
+mkdir -p $rdir
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_STREAM_RETENTION>3600</CLICON_STREAM_RETENTION>
+  <CLICON_STREAM_REPLAY_DIR>$rdir</CLICON_STREAM_REPLAY_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+     leaf event-class {
+       type string;
+     }
+     container reportingEntity {
+       leaf card {
+         type string;
+       }
+     }
+     leaf severity {
+       type string;
+     }
+   }
+}
+EOF
+
+# Time as date-and-time, arg1: offset in seconds from now (may be negative)
+function timestr(){
+    date -u -d "@$(($(date +%s)+$1))" +"%Y-%m-%dT%H:%M:%SZ"
+}
+
+# Subscribe to EXAMPLE and write eventTime of received events to $fout, one per line
+# arg1: seconds to keep session open
+# arg2: extra subscription parameters
+function subscribe(){
+    sec=$1
+    params=$2
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream>$params</create-subscription></rpc>]]>]]>"; sleep $sec) | timeout $((sec+10)) $clixon_netconf -qef $cfg | grep -o "<event xmlns=[^>]*>\|<eventTime>[^<]*</eventTime>" | grep -B1 "<event " | sed -n 's/<eventTime>\(.*\)<\/eventTime>/\1/p' > $fout
+}
+
+# Check received eventTimes are in order and within a window
+# arg1: min number of events
+# arg2: start, date-and-time without fraction
+# arg3: stop, date-and-time without fraction, or empty
+function checkevents(){
+    min=$1
+    start=$2
+    stop=$3
+    n=$(cat $fout | wc -l)
+    new "At least $min events"
+    if [ $n -lt $min ]; then
+        err "at least $min events" "$(cat $fout)"
+    fi
+    new "Events are in order"
+    sort -C $fout
+    if [ $? -ne 0 ]; then
+        err "increasing eventTime" "$(cat $fout)"
+    fi
+    new "Events are not before $start"
+    first=$(head -1 $fout)
+    if [[ "$first" < "${start%Z}" ]]; then
+        err "not before $start" "$first"
+    fi
+    if [ -n "$stop" ]; then
+        new "Events are not after $stop"
+        last=$(tail -1 $fout)
+        if [[ "${last%%.*}" > "${stop%Z}" ]]; then
+            err "not after $stop" "$last"
+        fi
+    fi
+}
+
+new "test params: -f $cfg -- -n 1"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -n 1"
+    start_backend -s init -f $cfg -- -n 1 # Example event every second
+fi
+
+new "wait backend"
+wait_backend
+
+t0=$(timestr 0)
+sleep 6
+
+new "1. Replay log segment files"
+expectpart "$(ls $rdir)" 0 "EXAMPLE-0000000000.idx" "EXAMPLE-0000000000.log"
+
+new "2. Replay window of two seconds"
+start=$(timestr -4)
+stop=$(timestr -2)
+subscribe 2 "<startTime>$start</startTime><stopTime>$stop</stopTime>"
+checkevents 1 $start $stop
+new "At most 3 events in window"
+if [ $(cat $fout | wc -l) -gt 3 ]; then
+    err "at most 3 events" "$(cat $fout)"
+fi
+
+new "3. Replay from start, then live events"
+subscribe 3 "<startTime>$t0</startTime>"
+checkevents 7 $t0 ""
+
+if [ $BE -ne 0 ]; then
+    new "4. Restart backend"
+    stop_backend -f $cfg
+    t1=$(timestr 0)
+    start_backend -s init -f $cfg -- -n 1
+    wait_backend
+    sleep 3
+
+    new "Replay from before restart: only events after restart"
+    subscribe 1 "<startTime>$t0</startTime>"
+    checkevents 2 $t1 ""
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+
+    new "Replay log files are removed at stop"
+    expectpart "$(ls $rdir)" 0 "" --not-- "EXAMPLE"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,194 @@
+#!/usr/bin/env bash
+# Notifications serialized once and shared by all subscribers, see stream_notify_str
+# A backend plugin notifies an event given as XML text on the SHARED stream, written in
+# a form that differs from how clixon serializes it (single quotes, empty element)
+# 1. Subscribers receive the event text as given, not re-serialized
+# 2. All subscribers, with and without filter, receive the same text
+# 3. The event text is only parsed when needed, eg by a filter, so a malformed event is
+#    reported with a filtered subscriber but not without subscribers
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/shared.yang
+cfile=$dir/shared.c
+pdir=$dir/plugin
+fout1=$dir/sub1.txt
+fout2=$dir/sub2.txt
+
+# Event as notified, not as clixon would print it
+EVENT="<event xmlns='urn:example:shared'><text>a  b</text><flag></flag></event>"
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module shared{
+   yang-version 1.1;
+   namespace "urn:example:shared";
+   prefix ex;
+   notification event {
+     leaf text {
+       type string;
+     }
+     leaf flag {
+       type empty;
+     }
+   }
+   rpc notify {
+     input {
+       leaf malformed {
+         type empty;
+       }
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+/*! Notify event on SHARED stream, malformed if requested
+ */
+static int
+notify_rpc(clixon_handle h,
+           cxobj        *xe,
+           cbuf         *cbret,
+           void         *arg,
+           void         *regarg)
+{
+    char *event = "$EVENT";
+
+    if (xml_find_type(xe, NULL, "malformed", CX_ELMNT) != NULL)
+        event = "<event xmlns='urn:example:shared'><text>";
+    if (stream_notify_str(h, "SHARED", event) < 0)
+        return -1;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "shared",                               /* name */
+    clixon_plugin_init,                     /* init */
+    NULL,                                   /* start */
+    NULL,                                   /* exit */
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    if (stream_add(h, "SHARED", "Shared notification stream", 0, NULL) < 0)
+        return NULL;
+    if (rpc_callback_register(h, notify_rpc, NULL, "urn:example:shared", "notify") < 0)
+        return NULL;
+    return &api;
+}
+EOF
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include $cfile -o $pdir/shared.so)" 0 ""
+
+# Subscribe to SHARED stream and write output to file
+# arg1: output file
+# arg2: extra subscription parameters, eg filter
+function subscribe(){
+    fout=$1
+    params=$2
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>SHARED</stream>$params</create-subscription></rpc>]]>]]>"; sleep 3) | timeout 10 $clixon_netconf -qef $cfg > $fout
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "1. Malformed event without subscribers is not parsed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><notify xmlns=\"urn:example:shared\"><malformed/></notify></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Start two subscribers, one with filter"
+subscribe $fout1 "" &
+subscribe $fout2 "<filter type=\"xpath\" select=\"/ex:event[ex:text='a  b']\" xmlns:ex=\"urn:example:shared\"/>" &
+sleep 1
+
+new "Notify event"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><notify xmlns=\"urn:example:shared\"/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Malformed event with filtered subscriber is reported"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><notify xmlns=\"urn:example:shared\"><malformed/></notify></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>" ""
+
+wait
+
+new "2. Subscriber receives event text as notified"
+n=$(grep -o "$EVENT</notification>" $fout1 | wc -l)
+if [ $n -ne 1 ]; then
+    err "1 x $EVENT" "$(cat $fout1)"
+fi
+
+new "Filtered subscriber receives same event text"
+n=$(grep -o "$EVENT</notification>" $fout2 | wc -l)
+if [ $n -ne 1 ]; then
+    err "1 x $EVENT" "$(cat $fout2)"
+fi
+
+new "Both subscribers receive identical notifications"
+n1=$(grep -o "<notification .*</notification>" $fout1)
+n2=$(grep -o "<notification .*</notification>" $fout2)
+if [ "$n1" != "$n2" ]; then
+    err "$n1" "$n2"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
 # JSON performance test:
 # 1. parse a long string
+# 2. parse throughput of a large list with yang binding
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -11,6 +12,52 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 : ${perfnr:=100000}
 
 fjson=$dir/long.json
+flist=$dir/list.json
+fyang=$dir/scaling.yang
+
+# Time parsing of a file, check exit status and output, print time
+# Args:
+# 1: command
+# 2: input file
+# 3: expected pattern in output
+function timeparse()
+{
+    cmd=$1
+    input=$2
+    expect=$3
+
+    { time -p $cmd < $input > $dir/out 2> $dir/err; } 2> $dir/time
+    r=$?
+    if [ $r -ne 0 ]; then
+        err "0" "$r: $(cat $dir/err)"
+    fi
+    if ! grep -q "$expect" $dir/out; then
+        err "$expect" "$(head -c 256 $dir/out)"
+    fi
+    awk '/real/ {print $2}' $dir/time
+}
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ip;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type string;
+         }
+      }
+      leaf-list c {
+         type string;
+      }
+   }
+}
+EOF
 
 new "generate long file $fjson"
 echo -n '{"foo": "' > $fjson
@@ -21,8 +68,27 @@ echo '"}' >> $fjson
 echo "$fjson"
 
 new "json parse long string"
-#expecteof_file "$clixon_util_json" 0 "$fjson"
-expecteof_file "time -p $clixon_util_json -j" 0 "$fjson" "$fjson" 2>&1 | awk '/real/ {print $2}'
+timeparse "$clixon_util_json -j" $fjson "aaaa"
+
+new "generate list file $flist with $perfnr entries"
+echo -n '{"scaling:x":{"y":[' > $flist
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n "," >> $flist
+    fi
+    echo -n "{\"a\":$i,\"b\":\"value$i\"}" >> $flist
+done
+echo -n '],"c":[' >> $flist
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n "," >> $flist
+    fi
+    echo -n "\"c$i\"" >> $flist
+done
+echo ']}}' >> $flist
+
+new "json parse list throughput with yang binding"
+timeparse "$clixon_util_json -y $fyang" $flist "value$((perfnr-1))"
 
 rm -rf $dir
 
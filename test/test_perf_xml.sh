@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
-# Test: XML performance test (CDATA test only)
-# See https://github.com/clicon/clixon/issues/96
+# Test: XML performance test
+# 1. parse a long CDATA, see https://github.com/clicon/clixon/issues/96
+# 2. parse throughput of a large pretty-printed list with yang binding
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
@@ -10,6 +11,27 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 : ${perfnr:=30000}
 
 fxml=$dir/long.xml
+flist=$dir/list.xml
+fyang=$dir/scaling.yang
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ip;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type string;
+         }
+      }
+   }
+}
+EOF
 
 new "generate long file $fxml"
 echo -n "<rpc-reply><stdout><![CDATA[" > $fxml
@@ -24,6 +46,26 @@ echo "]]></stdout></rpc-reply>" >> $fxml
 new "xml parse long CDATA"
 expecteof_file "time -p $clixon_util_xml" 0 "$fxml" 2>&1 | awk '/real/ {print $2}'
 
+new "generate pretty-printed list file $flist with $perfnr entries"
+echo "<x xmlns=\"urn:example:clixon\">" > $flist
+for (( i=0; i<$perfnr; i++ )); do
+    printf "  <y>\n    <a>%d</a>\n    <b>value%d</b>\n  </y>\n" $i $i >> $flist
+done
+echo "</x>" >> $flist
+
+new "xml parse list throughput with yang binding"
+{ time -p $clixon_util_xml -y $fyang < $flist > $dir/out 2> $dir/err; } 2> $dir/time
+r=$?
+if [ $r -ne 0 ]; then
+    err "0" "$r: $(cat $dir/err)"
+fi
+if ! grep -q "value$((perfnr-1))" $dir/out; then
+    err "value$((perfnr-1))" "$(head -c 256 $dir/out)"
+fi
+t=$(awk '/real/ {print $2}' $dir/time)
+size=$(wc -c < $flist)
+echo "$perfnr entries, $size bytes: ${t}s, $(awk -v t=$t -v n=$perfnr 'BEGIN{if (t>0) printf "%d", n/t; else print "-"}') entries/s"
+
 rm -rf $dir
 
 new "endtest"
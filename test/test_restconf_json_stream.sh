@@ -0,0 +1,170 @@
+#!/usr/bin/env bash
+# Restconf GET of data root as JSON, streamed with chunked transfer-encoding
+# The JSON body is encoded with clixon_json2sink and written to the socket in chunks.
+# Check that the streamed body is the same as the non-streamed JSON encoding:
+# 1. Content-Length of HEAD, where the body is encoded in a buffer, equals streamed length
+# 2. Streamed data root contains the buffered encoding of the same container
+# If both HTTP/1 and /2, force to /1 to test native http/1 implementation
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if ! ${HAVE_HTTP1}; then
+    echo "...skipped: Must run with http/1"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    echo "...skipped: Must run with native restconf"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+if [ ${HAVE_LIBNGHTTP2} = true ]; then
+    # Pin to http/1
+    HAVE_LIBNGHTTP2=false
+    CURLOPTS=${CURLOPTS/http2/http1.1}
+    HVER=1.1
+fi
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+fjson=$dir/large.json
+
+# Number of list entries, large enough for several chunks
+: ${nr:=1000}
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Body of curl reply, ie without headers
+function body(){
+    sed '1,/^\r$/d'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "generate large request"
+echo -n '{"example:table":{"parameter":[' > $fjson
+for (( i=0; i<$nr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n "," >> $fjson
+    fi
+    echo -n "{\"name\":\"A$i\",\"value\":\"value of parameter $i\"}" >> $fjson
+done
+echo -n "]}}" >> $fjson
+
+new "restconf large POST"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d @$fjson $RCPROTO://localhost/restconf/data)" 0 "HTTP/$HVER 201"
+
+new "restconf GET data root is chunked"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data?content=config)" 0 "HTTP/$HVER 200" "Transfer-Encoding: chunked" "Content-Type: application/yang-data+json" --not-- "Content-Length:"
+
+curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data?content=config | body > $dir/root.json
+root=$(cat $dir/root.json)
+table=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:table | body)
+
+new "1. HEAD Content-Length equals streamed length"
+len=$(curl $CURLOPTS -I -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data?content=config | grep -i "^Content-Length:" | tr -dc '0-9')
+slen=$(cat $dir/root.json | wc -c)
+if [ "$len" != "$slen" ]; then
+    err "$len" "$slen"
+fi
+
+new "2. Streamed data root contains buffered encoding of table"
+table=${table#\{}
+table=${table%\}}
+if [[ "$root" != *"$table"* ]]; then
+    err "$table" "$root"
+fi
+
+new "All entries in streamed data root"
+n=$(echo "$root" | grep -o '"name":"A[0-9]*"' | wc -l)
+if [ $n -ne $nr ]; then
+    err "$nr" "$n"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
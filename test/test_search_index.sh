@@ -6,11 +6,14 @@
 #   - not a key int
 #   - key in an ordered-by user
 #   - key in state data
+#   - backend xpath filter on index after add, modify and delete of entries
 # Use instance-id for tests, since api-path can only handle keys, and xpath is too complex.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
+APPNAME=example
+
 : ${clixon_util_path:=clixon_util_path -D $DBG -Y /usr/local/share/clixon}
 
 # Number of list/leaf-list entries
@@ -91,6 +94,75 @@ new "index search latency i=$rndi"
 new "non-index search latency j=$rndi"
 { time -p $clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:j=\"$rndi\"] > /dev/null; }  2>&1 | awk '/real/ {print $2}'
 
+# Backend: index is kept consistent when entries and index values are modified
+cfg=$dir/conf_yang.xml
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit-config a:1 b:2 c:2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>a</k1><i>1</i></y><y><k1>b</k1><i>2</i></y><y><k1>c</k1><i>2</i></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config i=2 multiple"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='2']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>2</i></y><y><k1>c</k1><i>2</i></y></x1></data></rpc-reply>"
+
+new "modify index b:3"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>3</i></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config i=2 after modify"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='2']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>c</k1><i>2</i></y></x1></data></rpc-reply>"
+
+new "get-config i=3 after modify"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='3']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>3</i></y></x1></data></rpc-reply>"
+
+new "delete c"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y nc:operation=\"delete\" xmlns:nc=\"${BASENS}\"><k1>c</k1></y></x1></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config i=2 after delete"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='2']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config running i=3"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='3']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>3</i></y></x1></data></rpc-reply>"
+
+new "stats index counters"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS></stats></rpc>" "" "<datastore><name>running</name><nr>[0-9]*</nr><size>[0-9]*</size><indexes>1</indexes><index-entries>2</index-entries></datastore>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
 rm -rf $dir
 
 new "endtest"
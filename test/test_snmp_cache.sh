@@ -0,0 +1,327 @@
+#!/usr/bin/env bash
+# SNMP table cache of clixon_snmp, see CLICON_SNMP_CACHE_TTL
+# CLIXON-TYPES-MIB is config, IF-MIB ifTable is state data from a slow plugin
+# 1. Multi-varbind GET and GETBULK over many rows of a config table
+# 2. A NETCONF edit of a config table is seen by a following snmpget and snmpwalk
+# 3. A slow read of an uncached table does not stall requests of a cached table
+# 4. If NACM denies the change subscription, tables are read again after the TTL
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+if [ ${ENABLE_NETSNMP} != "yes" ]; then
+    echo "Skipping test, Net-SNMP support not enabled."
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+cfg=$dir/conf.xml
+fyang=$dir/clixon-example.yang
+cfile=$dir/slow.c
+pdir=$dir/plugin
+
+# AgentX unix socket
+SOCK=/var/run/snmp.sock
+
+# Number of rows of config table
+: ${nrows:=50}
+# Seconds to read ifTable
+: ${slowsec:=2}
+# Cache TTL in ms, longer than the test steps
+ttl=5000
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_STANDARD_DIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${MIB_GENERATED_YANG_DIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_SNMP_AGENT_SOCK>unix:$SOCK</CLICON_SNMP_AGENT_SOCK>
+  <CLICON_SNMP_MIB>CLIXON-TYPES-MIB</CLICON_SNMP_MIB>
+  <CLICON_SNMP_MIB>IF-MIB</CLICON_SNMP_MIB>
+  <CLICON_SNMP_CACHE_TTL>$ttl</CLICON_SNMP_CACHE_TTL>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import CLIXON-TYPES-MIB {
+      prefix "clixon-types";
+  }
+  import IF-MIB {
+      prefix "if-mib";
+  }
+  import ietf-netconf-acm {
+      prefix nacm;
+  }
+  deviation "/clixon-types:CLIXON-TYPES-MIB" {
+     deviate replace {
+        config true;
+     }
+  }
+}
+EOF
+
+# State data of ifTable, read slowly
+cat <<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+int
+slow_statedata(clixon_handle h,
+               cvec         *nsc,
+               char         *xpath,
+               cxobj        *xstate)
+{
+    if (xpath == NULL || strstr(xpath, "ifTable") == NULL)
+        return 0;
+    sleep($slowsec);
+    if (clixon_xml_parse_string("<IF-MIB xmlns=\"urn:ietf:params:xml:ns:yang:smiv2:IF-MIB\">"
+                                "<ifTable><ifEntry><ifIndex>1</ifIndex><ifDescr>slow</ifDescr></ifEntry></ifTable>"
+                                "</IF-MIB>", YB_NONE, NULL, &xstate, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "slow",                                 /* name */
+    clixon_plugin_init,                     /* init */
+    NULL,                                   /* start */
+    NULL,                                   /* exit */
+    .ca_statedata=slow_statedata,
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include $cfile -o $pdir/slow.so)" 0 ""
+
+# Startup with nrows of clixonIETFWGTable
+# arg1: extra xml, eg nacm
+function startup(){
+    extra=$1
+    echo "<${DATASTORE_TOP}>" > $dir/startup_db
+    echo "<CLIXON-TYPES-MIB xmlns=\"urn:ietf:params:xml:ns:yang:smiv2:CLIXON-TYPES-MIB\"><clixonIETFWGTable>" >> $dir/startup_db
+    for (( i=1; i<=$nrows; i++ )); do
+        echo "<clixonIETFWGEntry><nsIETFWGName>$i</nsIETFWGName><nsIETFWGChair1>chair$i</nsIETFWGChair1><nsIETFWGChair2>co$i</nsIETFWGChair2></clixonIETFWGEntry>" >> $dir/startup_db
+    done
+    echo "</clixonIETFWGTable></CLIXON-TYPES-MIB>" >> $dir/startup_db
+    echo "$extra</${DATASTORE_TOP}>" >> $dir/startup_db
+}
+
+# arg1: extra backend options
+function testinit(){
+    opts=$1
+    new "test params: -s startup -f $cfg $opts"
+    if [ $BE -ne 0 ]; then
+        # Kill old backend and start a new one
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err "Failed to start backend"
+        fi
+
+        sudo pkill -f clixon_backend
+
+        new "Starting backend"
+        start_backend -s startup -f $cfg $opts
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $SN -ne 0 ]; then
+        # Kill old clixon_snmp, if any
+        new "Terminating any old clixon_snmp processes"
+        sudo killall -q clixon_snmp
+
+        new "Starting clixon_snmp"
+        start_snmp $cfg
+    fi
+
+    new "wait snmp"
+    wait_snmp
+}
+
+function testexit(){
+    stop_snmp
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+# Set nsIETFWGChair1 of row 1 via NETCONF
+# arg1: value
+function netconf_chair(){
+    value=$1
+    new "Set nsIETFWGChair1.1 to $value via NETCONF"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><CLIXON-TYPES-MIB xmlns=\"urn:ietf:params:xml:ns:yang:smiv2:CLIXON-TYPES-MIB\"><clixonIETFWGTable><clixonIETFWGEntry><nsIETFWGName>1</nsIETFWGName><nsIETFWGChair1>$value</nsIETFWGChair1></clixonIETFWGEntry></clixonIETFWGTable></CLIXON-TYPES-MIB></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+snmpbulk="$(type -p snmpbulkget) -On -c public -v2c -Cr$((3*nrows)) localhost "
+snmpwalkn="$(type -p snmpwalk) -On -c public -v2c localhost "
+snmpwalkslow="$(type -p snmpwalk) -c public -t 10 -v2c localhost "
+
+MIB=".1.3.6.1.4.1.8072.200"
+OIDT="${MIB}.2.1"         # netSnmpIETFWGTable
+OIDN="${MIB}.2.1.1.1"     # nsIETFWGName
+OIDC1="${MIB}.2.1.1.2"    # nsIETFWGChair1
+OIDC2="${MIB}.2.1.1.3"    # nsIETFWGChair2
+
+new "SNMP cache tests"
+startup ""
+testinit ""
+
+new "1. Multi-varbind GET of rows and columns"
+expectpart "$($snmpget $OIDC1.1 $OIDC2.1 $OIDC1.25 $OIDN.$nrows $OIDC2.$nrows)" 0 "$OIDC1.1 = STRING: \"chair1\"" "$OIDC2.1 = STRING: \"co1\"" "$OIDC1.25 = STRING: \"chair25\"" "$OIDN.$nrows = INTEGER: $nrows" "$OIDC2.$nrows = STRING: \"co$nrows\""
+
+new "Multi-varbind GET with a missing row"
+expectpart "$($snmpget $OIDC1.2 $OIDC1.$((nrows+1)))" 0 "$OIDC1.2 = STRING: \"chair2\"" "$OIDC1.$((nrows+1)) = No Such Instance"
+
+new "GETBULK over all rows"
+ret=$($snmpbulk $OIDT)
+expectpart "$ret" 0 "$OIDN.1 = INTEGER: 1" "$OIDN.$nrows = INTEGER: $nrows" "$OIDC1.1 = STRING: \"chair1\"" "$OIDC1.$nrows = STRING: \"chair$nrows\"" "$OIDC2.1 = STRING: \"co1\"" "$OIDC2.$nrows = STRING: \"co$nrows\""
+
+new "GETBULK returns all rows in order"
+n=$(echo "$ret" | grep -c "^$MIB.2.1.1")
+if [ $n -ne $((3*nrows)) ]; then
+    err "$((3*nrows)) varbinds" "$n"
+fi
+echo "$ret" | grep "^$OIDC1\." | sed "s/^$OIDC1\.\([0-9]*\) .*/\1/" | sort -n -C
+if [ $? -ne 0 ]; then
+    err "increasing index" "$ret"
+fi
+
+new "2. Edit config table via NETCONF, get via SNMP"
+expectpart "$($snmpget $OIDC1.1)" 0 "$OIDC1.1 = STRING: \"chair1\""
+netconf_chair "netconf1"
+sleep 1
+expectpart "$($snmpget $OIDC1.1)" 0 "$OIDC1.1 = STRING: \"netconf1\""
+
+new "Edit config table via NETCONF, walk via SNMP"
+netconf_chair "netconf2"
+sleep 1
+expectpart "$($snmpwalkn $OIDT)" 0 "$OIDC1.1 = STRING: \"netconf2\"" "$OIDC1.2 = STRING: \"chair2\"" --not-- "netconf1"
+
+new "3. Slow read of uncached ifTable"
+t0=$(date +%s%N)
+$snmpwalkslow IF-MIB::ifTable > $dir/slow.txt &
+sleep 0.5
+
+new "Cached config table is served meanwhile"
+expectpart "$($snmpget $OIDC1.1 $OIDC2.$nrows)" 0 "$OIDC1.1 = STRING: \"netconf2\"" "$OIDC2.$nrows = STRING: \"co$nrows\""
+t1=$(date +%s%N)
+wait
+t2=$(date +%s%N)
+
+new "Cached get returns before slow read"
+if [ $t1 -ge $((t0+slowsec*1000000000)) ]; then
+    err "less than ${slowsec}s" "$(((t1-t0)/1000000))ms"
+fi
+
+new "Slow read returns table"
+expectpart "$(cat $dir/slow.txt)" 0 "IF-MIB::ifDescr.1 = STRING: slow"
+if [ $t2 -lt $((t0+slowsec*1000000000)) ]; then
+    err "at least ${slowsec}s" "$(((t2-t0)/1000000))ms"
+fi
+
+testexit
+
+# Deny change subscription of clixon_snmp with NACM
+NACM=$(cat <<EOF
+<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+  <enable-nacm>true</enable-nacm>
+  <read-default>permit</read-default>
+  <write-default>permit</write-default>
+  <exec-default>permit</exec-default>
+  <groups>
+    <group>
+      <name>snmp</name>
+      <user-name>$(whoami)</user-name>
+    </group>
+  </groups>
+  <rule-list>
+    <name>snmp-acl</name>
+    <group>snmp</group>
+    <rule>
+      <name>deny-push</name>
+      <module-name>clixon-lib</module-name>
+      <rpc-name>create-push-subscription</rpc-name>
+      <access-operations>exec</access-operations>
+      <action>deny</action>
+    </rule>
+  </rule-list>
+</nacm>
+EOF
+)
+
+new "4. NACM denies change subscription"
+startup "$NACM"
+testinit "-o CLICON_NACM_MODE=internal"
+
+new "Read config table into cache"
+expectpart "$($snmpget $OIDC1.1)" 0 "$OIDC1.1 = STRING: \"chair1\""
+
+new "Edit config table via NETCONF"
+t0=$(date +%s)
+netconf_chair "nacm1"
+
+new "Cached value until TTL"
+expectpart "$($snmpget $OIDC1.1)" 0 "$OIDC1.1 = STRING: \"chair1\""
+t1=$(date +%s)
+if [ $((t1-t0)) -ge $((ttl/1000)) ]; then
+    err "less than $((ttl/1000))s" "$((t1-t0))s"
+fi
+
+new "New value after TTL"
+sleep $((ttl/1000+1))
+expectpart "$($snmpget $OIDC1.1)" 0 "$OIDC1.1 = STRING: \"nacm1\""
+
+new "Cleaning up"
+testexit
+
+rm -rf $dir
+
+new "endtest"
+endtest
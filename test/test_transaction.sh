@@ -446,6 +446,18 @@ let line++
 checklog "$nr nacm_end add: <fff><bar/></fff>" $line
 let line++
 
+new "stats commit phase timers"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS></stats></rpc>" "" "<timer><name>phase/total</name><count>"
+
+new "stats plugin commit timer"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS></stats></rpc>" "" "/commit</name><count>"
+
+new "trace slowest request"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><trace $LIBNS><slowest>1</slowest></trace></rpc>" "" "<rpc-reply $DEFAULTNS><traces $LIBNS><trace><seq>"
+
+new "trace invalid slowest"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><trace $LIBNS><slowest>x</slowest></trace></rpc>" "" "<rpc-error>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
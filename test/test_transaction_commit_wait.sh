@@ -0,0 +1,259 @@
+#!/usr/bin/env bash
+# Transaction commit_wait callback: asynchronous plugin commits
+# Compile two backend plugins wait_a and wait_b from the same source. Each starts its
+# commit in a child process in transaction_commit and waits for it in transaction_commit_wait.
+# 1. A commit of both plugins overlaps and calls commit, commit, wait, wait, commit_done
+# 2. A failing wait in wait_a calls commit_failed in wait_a and revert in wait_b
+# 3. restart-plugin of wait_b waits for its commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/wait.yang
+cfile=$dir/wait.c
+pdir=$dir/plugin
+flog=$dir/backend.log
+
+# Seconds a commit of a plugin takes
+: ${commitsec:=2}
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+rm -f $flog
+touch $flog
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module wait{
+   yang-version 1.1;
+   namespace "urn:example:wait";
+   prefix ex;
+   container c {
+     leaf-list y {
+       type int32;
+     }
+     leaf-list fail {
+       description "Name of plugin whose commit fails";
+       type string;
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+
+/* These include signatures for plugin and transaction callbacks. */
+#include <clixon/clixon_backend.h>
+
+/* Child process of an outstanding commit */
+static pid_t _pid = 0;
+
+/*! Start commit in a child process, fail if /c/fail is the name of this plugin
+ */
+int
+wait_commit(clixon_handle    h,
+            transaction_data td)
+{
+    int fail;
+
+    fail = xpath_first(transaction_target(td), NULL, "/c/fail[.='%s']", PLUGIN) != NULL;
+    clixon_log(h, LOG_NOTICE, "%s_commit", PLUGIN);
+    if ((_pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        return -1;
+    }
+    if (_pid == 0){
+        sleep($commitsec);
+        _exit(fail);
+    }
+    return 0;
+}
+
+/*! Wait for commit child process
+ */
+int
+wait_commit_wait(clixon_handle    h,
+                 transaction_data td)
+{
+    int status = 0;
+
+    if (_pid == 0)
+        return 0;
+    while (waitpid(_pid, &status, 0) < 0)
+        if (errno != EINTR){
+            clixon_err(OE_UNIX, errno, "waitpid");
+            _pid = 0;
+            return -1;
+        }
+    _pid = 0;
+    clixon_log(h, LOG_NOTICE, "%s_commit_wait", PLUGIN);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+        clixon_err(OE_PLUGIN, 0, "%s commit failed", PLUGIN);
+        return -1;
+    }
+    return 0;
+}
+
+int
+wait_commit_done(clixon_handle    h,
+                 transaction_data td)
+{
+    clixon_log(h, LOG_NOTICE, "%s_commit_done", PLUGIN);
+    return 0;
+}
+
+int
+wait_commit_failed(clixon_handle    h,
+                   transaction_data td)
+{
+    clixon_log(h, LOG_NOTICE, "%s_commit_failed", PLUGIN);
+    return 0;
+}
+
+int
+wait_revert(clixon_handle    h,
+            transaction_data td)
+{
+    clixon_log(h, LOG_NOTICE, "%s_revert", PLUGIN);
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    PLUGIN,                                 /* name */
+    clixon_plugin_init,                     /* init */
+    NULL,                                   /* start */
+    NULL,                                   /* exit */
+    .ca_trans_commit=wait_commit,
+    .ca_trans_commit_wait=wait_commit_wait,
+    .ca_trans_commit_done=wait_commit_done,
+    .ca_trans_commit_failed=wait_commit_failed,
+    .ca_trans_revert=wait_revert,
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+for p in wait_a wait_b; do
+    new "compile $cfile as $p"
+    # -I /usr/local_include for eg freebsd
+    expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include -DPLUGIN=\"$p\" $cfile -o $pdir/$p.so)" 0 ""
+done
+
+# Check that the plugin log lines after the last run are the expected
+# arg1: expected log lines separated by space
+function checklog(){
+    expect=$1
+    new "Check log: $expect"
+    ret=$(grep -o "wait_[ab]_[a-z_]*" $flog | tr '\n' ' ' | sed 's/ $//')
+    if [ "$ret" != "$expect" ]; then
+        err "$expect" "$ret"
+    fi
+    echo -n > $flog
+}
+
+new "test params: -s init -f $cfg -l f$flog"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -l f$flog"
+    start_backend -s init -f $cfg -l f$flog
+fi
+
+new "wait backend"
+wait_backend
+
+echo -n > $flog
+
+new "1. Add y"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns='urn:example:wait'><y>1</y></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Commit of two plugins overlap"
+t0=$(date +"%s")
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+t1=$(date +"%s")
+let t=t1-t0
+if [ $t -ge $((2*commitsec)) ]; then
+    err "less than $((2*commitsec))s" "${t}s"
+fi
+
+checklog "wait_a_commit wait_b_commit wait_a_commit_wait wait_b_commit_wait wait_a_commit_done wait_b_commit_done"
+
+new "2. Add y and fail wait_a"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns='urn:example:wait'><y>2</y><fail>wait_a</fail></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Commit fails in wait_a wait"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>wait_a commit failed</error-message></rpc-error></rpc-reply>"
+
+checklog "wait_a_commit wait_b_commit wait_a_commit_wait wait_b_commit_wait wait_a_commit_failed wait_b_revert"
+
+new "Running is not changed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:wait\"><y>1</y></c></data></rpc-reply>"
+
+new "Discard changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+echo -n > $flog
+
+new "3. Restart wait_b plugin"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><restart-plugin $LIBNS><plugin>wait_b</plugin></restart-plugin></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+checklog "wait_b_commit wait_b_commit_wait wait_b_commit_done"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
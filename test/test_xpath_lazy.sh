@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Lazy XPath evaluation of xpath_vec_bool compared with full evaluation
+# Each expression is a "must" of a leaf, which is evaluated with xpath_vec_bool, and
+# a predicate of a get-config filter, which is evaluated completely with xpath_vec.
+# Both must give the same result.
+# Expressions: positional predicates, last(), parent steps, relational expressions
+# with literals, and/or with node-set operands
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/lazy.yang
+
+# Expression and expected result on the data below
+# Data: a entries (k,v): (1,x) (2,y) (3,z)
+exprs=(
+    "/ex:c/ex:a[2]"                                  true
+    "/ex:c/ex:a[4]"                                  false
+    "/ex:c/ex:a[last()]/ex:v = 'z'"                  true
+    "/ex:c/ex:a[last()]/ex:v = 'x'"                  false
+    "/ex:c/ex:a[2]/ex:v = 'y'"                       true
+    "/ex:c/ex:a[ex:k=2]/../ex:a[ex:v='z']"           true
+    "/ex:c/ex:a[ex:k=2]/../ex:a[ex:v='w']"           false
+    "/ex:c/ex:a/ex:v/../ex:k = 3"                    true
+    "/ex:c/ex:a/ex:v = 'y'"                          true
+    "/ex:c/ex:a/ex:v = 'w'"                          false
+    "/ex:c/ex:a/ex:v != 'x'"                         true
+    "/ex:c/ex:a/ex:k > 2"                            true
+    "/ex:c/ex:a/ex:k > 3"                            false
+    "'y' = /ex:c/ex:a/ex:v"                          true
+    "/ex:c/ex:a[ex:k=1] and /ex:c/ex:a[ex:k=3]"      true
+    "/ex:c/ex:a[ex:k=1] and /ex:c/ex:a[ex:k=4]"      false
+    "/ex:c/ex:a[ex:k=4] or /ex:c/ex:a[ex:k=3]"       true
+    "/ex:c/ex:a[ex:k=4] or /ex:c/ex:nothere"         false
+    "/ex:c/ex:a[ex:k=4] or /ex:c/ex:a/ex:v = 'z'"    true
+    "/ex:c/ex:nothere or not(/ex:c/ex:a[ex:k=1])"    false
+)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+# One leaf with a must statement for each expression
+cat <<EOF > $fyang
+module lazy{
+   yang-version 1.1;
+   namespace "urn:example:lazy";
+   prefix ex;
+   container c {
+     list a {
+       key k;
+       leaf k {
+         type int32;
+       }
+       leaf v {
+         type string;
+       }
+     }
+EOF
+for ((i=0; i<${#exprs[@]}; i+=2)); do
+    cat <<EOF >> $fyang
+     leaf p$i {
+       type string;
+       must "${exprs[$i]}";
+     }
+EOF
+done
+cat <<EOF >> $fyang
+   }
+}
+EOF
+
+new "test params: -s init -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add data"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:lazy\"><a><k>1</k><v>x</v></a><a><k>2</k><v>y</v></a><a><k>3</k><v>z</v></a></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Commit data"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+for ((i=0; i<${#exprs[@]}; i+=2)); do
+    expr=${exprs[$i]}
+    expect=${exprs[$((i+1))]}
+    # XML-encode the expression for the filter attribute
+    xexpr=$(echo "$expr" | sed -e "s/&/\&amp;/g" -e "s/</\&lt;/g" -e "s/>/\&gt;/g" -e "s/'/\&apos;/g")
+
+    new "Full evaluation: $expr is $expect"
+    if $expect; then
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:c[$xexpr]/ex:a[ex:k=1]/ex:k\" xmlns:ex=\"urn:example:lazy\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:lazy\"><a><k>1</k></a></c></data></rpc-reply>"
+    else
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:c[$xexpr]/ex:a[ex:k=1]/ex:k\" xmlns:ex=\"urn:example:lazy\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+    fi
+
+    new "Lazy evaluation: must $expr is $expect"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:lazy\"><p$i>probe</p$i></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    if $expect; then
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    else
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Failed MUST xpath .* of 'p$i' in module lazy</error-message>" ""
+    fi
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+done
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
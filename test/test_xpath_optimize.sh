@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Optimized xpath list lookups, see XPATH_LIST_OPTIMIZE
+# Binary search on list keys given as predicates:
+# 1. All keys combined with and, in any order
+# 2. First key(s) of several
+# 3. Range of integer first key
+# 4. Nested lists
+# Results should be same as non-optimized evaluation
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container c{
+        list a{
+            key "k1 k2";
+            leaf k1{
+                type int32;
+            }
+            leaf k2{
+                type string;
+            }
+            list b{
+                key k;
+                leaf k{
+                    type int32;
+                }
+            }
+        }
+    }
+}
+EOF
+
+# Get-config of running with xpath filter
+# Args:
+# 1: xpath
+# 2: expected list entries
+function getxpath()
+{
+    xpath=$1
+    expect=$2
+
+    new "get-config $xpath"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\">$expect</c></data></rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><k1>3</k1><k2>z</k2></a><a><k1>1</k1><k2>x</k2><b><k>3</k></b><b><k>1</k></b><b><k>2</k></b></a><a><k1>2</k1><k2>x</k2><b><k>1</k></b></a><a><k1>1</k1><k2>y</k2></a></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+A1X="<a><k1>1</k1><k2>x</k2><b><k>1</k></b><b><k>2</k></b><b><k>3</k></b></a>"
+A1Y="<a><k1>1</k1><k2>y</k2></a>"
+A2X="<a><k1>2</k1><k2>x</k2><b><k>1</k></b></a>"
+A3Z="<a><k1>3</k1><k2>z</k2></a>"
+
+getxpath "/ex:c/ex:a[ex:k1='1'][ex:k2='y']" "$A1Y"
+
+getxpath "/ex:c/ex:a[ex:k2='y' and ex:k1=1]" "$A1Y"
+
+getxpath "/ex:c/ex:a[ex:k1='1']" "$A1X$A1Y"
+
+getxpath "/ex:c/ex:a[ex:k1>=2]" "$A2X$A3Z"
+
+getxpath "/ex:c/ex:a[ex:k1>1 and ex:k1<3]" "$A2X"
+
+getxpath "/ex:c/ex:a[3>ex:k1][ex:k2='x']" "$A1X$A2X"
+
+getxpath "/ex:c/ex:a[ex:k1='1'][ex:k2='x']/ex:b[ex:k>=2]" "<a><k1>1</k1><k2>x</k2><b><k>2</k></b><b><k>3</k></b></a>"
+
+getxpath "/ex:c/ex:a/ex:b[ex:k='1']" "<a><k1>1</k1><k2>x</k2><b><k>1</k></b></a>$A2X"
+
+# Not optimized
+getxpath "/ex:c/ex:a[ex:k1='1' or ex:k1='3']" "$A1X$A1Y$A3Z"
+
+new "stats xpath-optimize range"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS></stats></rpc>" "" "<pattern><name>range</name><hits>[1-9][0-9]*</hits></pattern>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
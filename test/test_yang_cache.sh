@@ -0,0 +1,171 @@
+#!/usr/bin/env bash
+# Cache of parsed YANG files, see CLICON_YANG_CACHE_DIR
+# 1. Start backend, cache files are written
+# 2. Restart backend, YANG is loaded from cache
+# 3. Change YANG file, cache is stale and YANG is parsed again
+# 4. Change YANG file with same size and mtime, cache content digest differs
+# 5. Corrupt cache file, YANG is parsed again
+# 6. Cache directory writable by others, cache is not used
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-cache.yang
+# Created by backend
+cachedir=$dir/cache
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_CACHE_DIR>$cachedir</CLICON_YANG_CACHE_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+# Args:
+# 1: extra leaf
+# 2: fraction-digits (default 2)
+function writeyang()
+{
+    extra=$1
+    fd=${2:-2}
+    cat <<EOF > $fyang
+module example-cache{
+   yang-version 1.1;
+   namespace "urn:example:cache";
+   prefix ex;
+   revision 2024-12-01;
+   extension e1 {
+      argument arg;
+   }
+   grouping pg {
+      leaf value {
+         type decimal64 {
+            fraction-digits $fd;
+         }
+      }
+   }
+   container table{
+      list parameter{
+         key name;
+         max-elements 10;
+         leaf name{
+            type string;
+         }
+         uses pg;
+         ex:e1 "ext";
+      }
+      $extra
+   }
+}
+EOF
+}
+
+# Args:
+# 1: step
+# 2: xml config
+function testrun()
+{
+    step=$1
+    xml=$2
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "$step: Check cache files"
+    expectpart "$(sudo ls $cachedir | grep -c yangc)" 0 "^[1-9]"
+
+    new "$step: edit-config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$xml</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "$step: get-config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$xml</data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+XML="<table xmlns=\"urn:example:cache\"><parameter><name>a</name><value>4.20</value></parameter></table>"
+
+writeyang ""
+
+new "test params: -f $cfg"
+
+testrun "Write cache" "$XML"
+
+testrun "Read cache" "$XML"
+
+new "Check cache dir is created with mode 700"
+expectpart "$(sudo stat -c %a $cachedir)" 0 "^700$"
+
+# Make sure modification time is changed
+sleep 1
+writeyang "leaf extra{ type string; }"
+
+XML2="<table xmlns=\"urn:example:cache\"><parameter><name>a</name><value>4.20</value></parameter><extra>x</extra></table>"
+
+testrun "Stale cache" "$XML2"
+
+# Same size and mtime as previous YANG file, only content differs
+touch -r $fyang $dir/mtime
+writeyang "leaf extra{ type string; }" 3
+touch -r $dir/mtime $fyang
+
+XML3="<table xmlns=\"urn:example:cache\"><parameter><name>a</name><value>4.200</value></parameter><extra>x</extra></table>"
+
+testrun "Same size and mtime" "$XML3"
+
+for f in $(sudo sh -c "ls $cachedir/*.yangc"); do
+    sudo sh -c "echo garbage > $f"
+done
+
+testrun "Corrupt cache" "$XML3"
+
+if [ $BE -ne 0 ]; then
+    sudo sh -c "rm -f $cachedir/*.yangc"
+    sudo chmod 777 $cachedir
+
+    new "start backend with cache dir writable by others"
+    start_backend -s init -f $cfg
+
+    new "wait backend"
+    wait_backend
+
+    new "Check no cache files written"
+    expectpart "$(sudo ls $cachedir | grep -c yangc)" 1 "^0$"
+
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest